@@ -0,0 +1,389 @@
+/*******************************************************************************
+ * Copyright (c) 2013, Sandeep Prakash <123sandy@gmail.com>
+ * All rights reserved.
+ *
+ * \file   cachesim-cli.h
+ * \author sandeepprakash
+ *
+ * \date   Feb 4, 2013
+ *
+ * \brief  What the ch-ca-cache-simulator program uses of the engine beyond
+ *         cachesim.h: the options of its command line and the simulation
+ *         modes that run on the engine itself.
+ *
+ *         This header is not installed and libcachesim does not export
+ *         what it declares; the program links the engine in.
+ *
+ ******************************************************************************/
+
+#ifndef __CACHESIM_CLI_H__
+#define __CACHESIM_CLI_H__
+
+/********************************** INCLUDES **********************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cachesim.h"
+
+#ifdef  __cplusplus
+extern  "C"
+{
+#endif
+
+/********************************* CONSTANTS **********************************/
+
+/*********************************** MACROS ***********************************/
+#define CACHESIM_MAX_CACHE_LEVELS                        (8)
+
+#define CACHESIM_MAX_MSHRS                               (1024)
+
+/******************************** ENUMERATIONS ********************************/
+typedef enum _CACHESIM_REPLACEMENT_POLICY_E
+{
+   eCACHESIM_REPLACEMENT_POLICY_FIFO,
+
+   eCACHESIM_REPLACEMENT_POLICY_LRU,
+
+   eCACHESIM_REPLACEMENT_POLICY_PLRU,
+
+   eCACHESIM_REPLACEMENT_POLICY_SRRIP,
+
+   eCACHESIM_REPLACEMENT_POLICY_BRRIP,
+
+   eCACHESIM_REPLACEMENT_POLICY_RANDOM,
+
+   eCACHESIM_REPLACEMENT_POLICY_LFU,
+
+   eCACHESIM_REPLACEMENT_POLICY_MAX
+} CACHESIM_REPLACEMENT_POLICY_E;
+
+typedef enum _CACHESIM_WRITE_POLICY_E
+{
+   /*
+    * Writes only dirty the block; it goes to memory when it is evicted.
+    */
+   eCACHESIM_WRITE_POLICY_WRITE_BACK,
+
+   /*
+    * Every write also goes to memory; blocks are never dirty.
+    */
+   eCACHESIM_WRITE_POLICY_WRITE_THROUGH,
+
+   eCACHESIM_WRITE_POLICY_MAX
+} CACHESIM_WRITE_POLICY_E;
+
+typedef enum _CACHESIM_PREFETCHER_E
+{
+   eCACHESIM_PREFETCHER_NONE,
+
+   /*
+    * On a miss, or the first hit on a prefetched block, fetches the next
+    * ui_prefetch_degree blocks.
+    */
+   eCACHESIM_PREFETCHER_NEXT_LINE,
+
+   /*
+    * Learns the block stride of each instruction and, once it has repeated,
+    * fetches ui_prefetch_degree strides ahead.
+    */
+   eCACHESIM_PREFETCHER_IP_STRIDE,
+
+   /*
+    * Stream buffers: follows up to CACHESIM_PREFETCH_STREAMS ascending or
+    * descending block streams and runs ui_prefetch_degree blocks ahead of
+    * each.
+    */
+   eCACHESIM_PREFETCHER_STREAM,
+
+   eCACHESIM_PREFETCHER_MAX
+} CACHESIM_PREFETCHER_E;
+
+typedef enum _CACHESIM_HEATMAP_FORMAT_E
+{
+   eCACHESIM_HEATMAP_FORMAT_CSV,
+
+   eCACHESIM_HEATMAP_FORMAT_JSON,
+
+   eCACHESIM_HEATMAP_FORMAT_MAX
+} CACHESIM_HEATMAP_FORMAT_E;
+
+typedef enum _CACHESIM_SIMULATION_ALGORITHM_E
+{
+   eCACHESIM_SIMULATION_ALGORITHM_INVALID,
+
+   eCACHESIM_SIMULATION_ALGORITHM_GENERAL,
+
+   eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT,
+
+   eCACHESIM_SIMULATION_ALGORITHM_MAX_IN_MATRIX,
+
+   eCACHESIM_SIMULATION_ALGORITHM_TRACE,
+
+   eCACHESIM_SIMULATION_ALGORITHM_SWEEP,
+
+   eCACHESIM_SIMULATION_ALGORITHM_MRC,
+
+   eCACHESIM_SIMULATION_ALGORITHM_HIERARCHY,
+
+   eCACHESIM_SIMULATION_ALGORITHM_CONVERT,
+
+   eCACHESIM_SIMULATION_ALGORITHM_RENDER,
+
+   eCACHESIM_SIMULATION_ALGORITHM_MULTICORE,
+
+   eCACHESIM_SIMULATION_ALGORITHM_BENCH,
+
+   eCACHESIM_SIMULATION_ALGORITHM_WORKLOAD,
+
+   eCACHESIM_SIMULATION_ALGORITHM_MAX
+} CACHESIM_SIMULATION_ALGORITHM_E;
+
+typedef enum _CACHESIM_INCLUSION_POLICY_E
+{
+   /*
+    * Every block of a level is also present in all the outer levels; an
+    * outer level evicting a block invalidates the inner copies.
+    */
+   eCACHESIM_INCLUSION_POLICY_INCLUSIVE,
+
+   /*
+    * A block lives in exactly one level. Fills go to the first level only and
+    * the blocks it evicts move outwards.
+    */
+   eCACHESIM_INCLUSION_POLICY_EXCLUSIVE,
+
+   /*
+    * Non-inclusive non-exclusive: misses fill every level on the way, but
+    * evictions are not propagated.
+    */
+   eCACHESIM_INCLUSION_POLICY_NINE,
+
+   eCACHESIM_INCLUSION_POLICY_MAX
+} CACHESIM_INCLUSION_POLICY_E;
+
+typedef enum _CACHESIM_COHERENCE_PROTOCOL_E
+{
+   /*
+    * A dirty block read by another core is written back to memory and
+    * becomes shared.
+    */
+   eCACHESIM_COHERENCE_PROTOCOL_MESI,
+
+   /*
+    * A dirty block read by another core stays dirty in the owner, which
+    * supplies it to the readers until it is evicted.
+    */
+   eCACHESIM_COHERENCE_PROTOCOL_MOESI,
+
+   eCACHESIM_COHERENCE_PROTOCOL_MAX
+} CACHESIM_COHERENCE_PROTOCOL_E;
+
+/************************* STRUCTURE/UNION DATA TYPES *************************/
+typedef struct _CACHESIM_CACHE_ARGS_X
+{
+   uint32_t ui_cache_size_words;
+
+   uint32_t ui_associativity;
+
+   uint32_t ui_block_size_words;
+
+   uint32_t ui_word_size_bytes;
+
+   CACHESIM_SIMULATION_ALGORITHM_E e_algorithm;
+
+   bool b_simulate_pinning;
+
+   bool b_silent;
+
+   uint32_t ui_loop_iterations;
+
+   char *pc_trace_file;
+
+   bool b_huge_pages;
+
+   bool b_no_miss_classification;
+
+   CACHESIM_REPLACEMENT_POLICY_E e_replacement_policy;
+
+   /*
+    * Sweep mode: every combination of the values listed with -a, -b and -c
+    * is simulated against the trace on a pool of ui_threads workers (0 for
+    * one per online CPU).
+    */
+   bool b_sweep;
+
+   uint32_t ui_threads;
+
+   const char *pc_associativity_list;
+
+   const char *pc_block_size_list;
+
+   const char *pc_cache_size_list;
+
+   /*
+    * Miss ratio curves for the block sizes listed with -b instead of a
+    * simulation.
+    */
+   bool b_mrc;
+
+   /*
+    * Replay the trace through a multi-level hierarchy instead of a single
+    * cache.
+    */
+   const char *pc_levels;
+
+   CACHESIM_INCLUSION_POLICY_E e_inclusion;
+
+   CACHESIM_WRITE_POLICY_E e_write_policy;
+
+   bool b_no_write_allocate;
+
+   /*
+    * Write the trace out in the binary format instead of simulating it.
+    */
+   const char *pc_convert_file;
+
+   /*
+    * Trace records skipped before the simulation starts.
+    */
+   uint64_t ull_fast_forward;
+
+   const char *pc_event_log_file;
+
+   uint32_t ui_demo_pause_us;
+
+   /*
+    * Render the table view of this event log instead of simulating.
+    */
+   const char *pc_render_file;
+
+   /*
+    * Run the throughput benchmark and write its results to this file ("-"
+    * for stdout) instead of simulating.
+    */
+   const char *pc_bench_file;
+
+   uint32_t ui_sample_sets;
+
+   /*
+    * Replay the trace on this many cores with coherent private caches; 0
+    * for a single cache.
+    */
+   uint32_t ui_cores;
+
+   CACHESIM_COHERENCE_PROTOCOL_E e_coherence;
+
+   CACHESIM_PREFETCHER_E e_prefetcher;
+
+   uint32_t ui_prefetch_degree;
+
+   uint32_t ui_prefetch_latency;
+
+   uint32_t ui_address_bits;
+
+   const char *pc_heatmap_file;
+
+   const char *pc_heatmap_blocks_file;
+
+   CACHESIM_HEATMAP_FORMAT_E e_heatmap_format;
+
+   const char *pc_checkpoint_file;
+
+   const char *pc_restore_file;
+
+   /*
+    * Trace records simulated before the run stops, 0 for the whole trace.
+    */
+   uint64_t ull_max_records;
+
+   /*
+    * Trace records after the fast-forward that only warm the cache up.
+    */
+   uint64_t ull_warmup;
+
+   bool b_roi_markers;
+
+   /*
+    * Hit latencies and miss penalties of the levels, innermost first, as
+    * given; the levels past them take the defaults.
+    */
+   uint32_t uia_hit_latency [CACHESIM_MAX_CACHE_LEVELS];
+
+   uint32_t ui_no_of_hit_latencies;
+
+   uint32_t uia_miss_penalty [CACHESIM_MAX_CACHE_LEVELS];
+
+   uint32_t ui_no_of_miss_penalties;
+
+   uint32_t ui_memory_latency;
+
+   uint32_t ui_mshrs;
+
+   uint32_t ui_issue_rate;
+
+   /*
+    * Spec of the synthetic workload to simulate, or @ and the file that
+    * holds it; NULL for none.
+    */
+   const char *pc_workload;
+} CACHESIM_CACHE_ARGS_X;
+
+/***************************** FUNCTION PROTOTYPES ****************************/
+CACHESIM_RET_E cachesim_replacement_policy_from_name (
+   const char *pc_name,
+   CACHESIM_REPLACEMENT_POLICY_E *pe_policy);
+
+CACHESIM_RET_E cachesim_prefetcher_from_name (
+   const char *pc_name,
+   CACHESIM_PREFETCHER_E *pe_prefetcher);
+
+/*
+ * The cache of the command line as a configuration of the library
+ * interface.
+ */
+void cachesim_config_from_args (
+   const CACHESIM_CACHE_ARGS_X *px_cache_args,
+   CACHESIM_CONFIG_X *px_config);
+
+/*
+ * The simulation modes. Each runs what px_cache_args selects, prints its
+ * report and fails if the simulation could not be run to the end.
+ */
+CACHESIM_RET_E cachesim_simulate_pinning (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_algorithm (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_trace (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_convert_trace (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_render_events (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_hierarchy (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_multicore (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_sweep (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_mrc (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_bench (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+CACHESIM_RET_E cachesim_simulate_workload (
+   CACHESIM_CACHE_ARGS_X *px_cache_args);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __CACHESIM_CLI_H__ */
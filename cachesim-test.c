@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * Copyright (c) 2013, Sandeep Prakash <123sandy@gmail.com>
+ * All rights reserved.
+ *
+ * \file   cachesim-test.c
+ * \author sandeepprakash
+ *
+ * \date   Feb 4, 2013
+ *
+ * \brief  Checks of the libcachesim interface, run by make check.
+ *
+ ******************************************************************************/
+
+/********************************** INCLUDES **********************************/
+#include <stdio.h>
+
+#include "cachesim.h"
+
+/********************************* CONSTANTS **********************************/
+#define CACHESIM_TEST_CACHE_WORDS                        (1024)
+
+#define CACHESIM_TEST_BLOCK_WORDS                        (4)
+
+#define CACHESIM_TEST_WORD_BYTES                         (4)
+
+#define CACHESIM_TEST_SETS                               \
+   (CACHESIM_TEST_CACHE_WORDS / CACHESIM_TEST_BLOCK_WORDS)
+
+#define CACHESIM_TEST_BLOCK_BYTES                        \
+   (CACHESIM_TEST_BLOCK_WORDS * CACHESIM_TEST_WORD_BYTES)
+
+#define CACHESIM_TEST_TRACE_FILE                         "cachesim-test.trace"
+
+#define CACHESIM_TEST_TRACE_RECORDS                      (8)
+
+/*********************************** MACROS ***********************************/
+#define CACHESIM_TEST_CHECK(x_cond)                                            \
+   do                                                                          \
+   {                                                                           \
+      if (!(x_cond))                                                           \
+      {                                                                        \
+         fprintf (stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+            #x_cond);                                                          \
+         goto CLEAN_RETURN;                                                    \
+      }                                                                        \
+   } while (0)
+
+/****************************** LOCAL FUNCTIONS *******************************/
+/*
+ * With set sampling, an access to a set that is not sampled is dropped. It
+ * must not be reported as a hit, even when it is repeated.
+ */
+static CACHESIM_RET_E cachesim_test_access_sampled (void)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CONFIG_X x_config = {0};
+   CACHESIM_STATS_X x_stats = {0};
+   CACHESIM_X *px_sim = NULL;
+   uint64_t ull_address = 0;
+   uint32_t ui_set = 0;
+   uint32_t ui_hits = 0;
+   bool b_hit = false;
+
+   cachesim_config_init (&x_config);
+   x_config.ui_cache_size_words = CACHESIM_TEST_CACHE_WORDS;
+   x_config.ui_associativity = 1;
+   x_config.ui_block_size_words = CACHESIM_TEST_BLOCK_WORDS;
+   x_config.ui_word_size_bytes = CACHESIM_TEST_WORD_BYTES;
+   x_config.ui_sample_sets = 4;
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_create (&x_config,
+      &px_sim));
+
+   /*
+    * Every set once, to bring the block in, then every set again.
+    */
+   for (ui_set = 0; ui_set < CACHESIM_TEST_SETS; ui_set++)
+   {
+      ull_address = (uint64_t) ui_set * CACHESIM_TEST_BLOCK_BYTES;
+      b_hit = true;
+      CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access (px_sim,
+         ull_address, CACHESIM_TEST_WORD_BYTES, eCACHESIM_ACCESS_TYPE_READ,
+         &b_hit));
+      CACHESIM_TEST_CHECK (false == b_hit);
+   }
+   for (ui_set = 0; ui_set < CACHESIM_TEST_SETS; ui_set++)
+   {
+      ull_address = (uint64_t) ui_set * CACHESIM_TEST_BLOCK_BYTES;
+      CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access (px_sim,
+         ull_address, CACHESIM_TEST_WORD_BYTES, eCACHESIM_ACCESS_TYPE_READ,
+         &b_hit));
+      ui_hits += b_hit;
+   }
+
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_get_stats (px_sim,
+      &x_stats));
+   CACHESIM_TEST_CHECK (0 != ui_hits);
+   CACHESIM_TEST_CHECK (0 != x_stats.ull_sample_skipped);
+   CACHESIM_TEST_CHECK (x_stats.ull_hits == ui_hits);
+   CACHESIM_TEST_CHECK ((2 * ui_hits) + x_stats.ull_sample_skipped
+      == 2 * CACHESIM_TEST_SETS);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (NULL != px_sim)
+   {
+      (void) cachesim_destroy (px_sim);
+   }
+   return e_ret_val;
+}
+
+/*
+ * Instruction fetches and accesses beyond the address width are skipped,
+ * and are not hits either.
+ */
+static CACHESIM_RET_E cachesim_test_access_skipped (void)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CONFIG_X x_config = {0};
+   CACHESIM_STATS_X x_stats = {0};
+   CACHESIM_X *px_sim = NULL;
+   uint64_t ull_beyond = 0;
+   bool b_hit = false;
+
+   cachesim_config_init (&x_config);
+   x_config.ui_address_bits = 32;
+   ull_beyond = (uint64_t) 1 << x_config.ui_address_bits;
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_create (&x_config,
+      &px_sim));
+
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access (px_sim,
+      0, 0, eCACHESIM_ACCESS_TYPE_READ, &b_hit));
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access (px_sim,
+      0, 0, eCACHESIM_ACCESS_TYPE_READ, &b_hit));
+   CACHESIM_TEST_CHECK (true == b_hit);
+
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access (px_sim,
+      0, 0, eCACHESIM_ACCESS_TYPE_IFETCH, &b_hit));
+   CACHESIM_TEST_CHECK (false == b_hit);
+   b_hit = true;
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access (px_sim,
+      ull_beyond, 0, eCACHESIM_ACCESS_TYPE_READ, &b_hit));
+   CACHESIM_TEST_CHECK (false == b_hit);
+
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_get_stats (px_sim,
+      &x_stats));
+   CACHESIM_TEST_CHECK (2 == x_stats.ull_skipped_records);
+   CACHESIM_TEST_CHECK (1 == x_stats.ull_hits);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (NULL != px_sim)
+   {
+      (void) cachesim_destroy (px_sim);
+   }
+   return e_ret_val;
+}
+
+/*
+ * A text trace read back in batches, from the start and after a seek, and
+ * replayed into a cache.
+ */
+static CACHESIM_RET_E cachesim_test_read_trace (void)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CONFIG_X x_config = {0};
+   CACHESIM_STATS_X x_stats = {0};
+   CACHESIM_RECORD_X xa_records [CACHESIM_TEST_TRACE_RECORDS] = {{0}};
+   CACHESIM_TRACE_X *px_trace = NULL;
+   CACHESIM_X *px_sim = NULL;
+   FILE *px_file = NULL;
+   uint64_t ull_no_of_records = 0;
+
+   px_file = fopen (CACHESIM_TEST_TRACE_FILE, "w");
+   CACHESIM_TEST_CHECK (NULL != px_file);
+   fprintf (px_file, "r 0x100 4\nw 0x104 4\nr 0x200 8\n");
+   CACHESIM_TEST_CHECK (0 == fclose (px_file));
+
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_open_trace (
+      CACHESIM_TEST_TRACE_FILE, &px_trace));
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_read_trace (px_trace,
+      xa_records, 2, &ull_no_of_records));
+   CACHESIM_TEST_CHECK (2 == ull_no_of_records);
+   CACHESIM_TEST_CHECK (0x104 == xa_records [1].ull_address);
+   CACHESIM_TEST_CHECK (eCACHESIM_ACCESS_TYPE_WRITE == xa_records [1].e_type);
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_read_trace (px_trace,
+      xa_records, CACHESIM_TEST_TRACE_RECORDS, &ull_no_of_records));
+   CACHESIM_TEST_CHECK (1 == ull_no_of_records);
+   CACHESIM_TEST_CHECK (0x200 == xa_records [0].ull_address);
+   CACHESIM_TEST_CHECK (8 == xa_records [0].ui_size_bytes);
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_read_trace (px_trace,
+      xa_records, CACHESIM_TEST_TRACE_RECORDS, &ull_no_of_records));
+   CACHESIM_TEST_CHECK (0 == ull_no_of_records);
+   (void) cachesim_close_trace (px_trace);
+   px_trace = NULL;
+
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_open_trace (
+      CACHESIM_TEST_TRACE_FILE, &px_trace));
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_seek_trace (px_trace,
+      1));
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_read_trace (px_trace,
+      xa_records, CACHESIM_TEST_TRACE_RECORDS, &ull_no_of_records));
+   CACHESIM_TEST_CHECK (2 == ull_no_of_records);
+
+   cachesim_config_init (&x_config);
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_create (&x_config,
+      &px_sim));
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_access_batch (px_sim,
+      xa_records, ull_no_of_records));
+   CACHESIM_TEST_CHECK (eCACHESIM_RET_SUCCESS == cachesim_get_stats (px_sim,
+      &x_stats));
+   CACHESIM_TEST_CHECK (2 == x_stats.ull_records);
+   CACHESIM_TEST_CHECK (1 == x_stats.ull_read_records);
+   CACHESIM_TEST_CHECK (1 == x_stats.ull_write_records);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (NULL != px_sim)
+   {
+      (void) cachesim_destroy (px_sim);
+   }
+   if (NULL != px_trace)
+   {
+      (void) cachesim_close_trace (px_trace);
+   }
+   (void) remove (CACHESIM_TEST_TRACE_FILE);
+   return e_ret_val;
+}
+
+/****************************** GLOBAL FUNCTIONS ******************************/
+int main (void)
+{
+   int i_ret_val = 1;
+
+   if ((eCACHESIM_RET_SUCCESS == cachesim_test_access_sampled ())
+      && (eCACHESIM_RET_SUCCESS == cachesim_test_access_skipped ())
+      && (eCACHESIM_RET_SUCCESS == cachesim_test_read_trace ()))
+   {
+      i_ret_val = 0;
+   }
+   return i_ret_val;
+}
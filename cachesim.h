@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * Copyright (c) 2013, Sandeep Prakash <123sandy@gmail.com>
+ * All rights reserved.
+ *
+ * \file   cachesim.h
+ * \author sandeepprakash
+ *
+ * \date   Feb 4, 2013
+ *
+ * \brief  Public interface of libcachesim, the cache engine of the
+ *         simulator, for running it in-process.
+ *
+ *         A cache is created from a CACHESIM_CONFIG_X, fed byte-addressed
+ *         accesses one at a time or in batches, and its statistics read back
+ *         at any point. Traces in the formats the simulator reads can be
+ *         decoded into such accesses with the *_trace functions. Handles are
+ *         independent of each other; a handle must not be used from two
+ *         threads at the same time.
+ *
+ *         Structures passed across this interface are only ever extended at
+ *         the end, and every change to them bumps the library version.
+ *
+ ******************************************************************************/
+
+#ifndef __CACHESIM_H__
+#define __CACHESIM_H__
+
+/********************************** INCLUDES **********************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef  __cplusplus
+extern  "C"
+{
+#endif
+
+/********************************* CONSTANTS **********************************/
+
+/*********************************** MACROS ***********************************/
+/*
+ * Buckets of the access latency histogram: bucket 0 for no cycles and
+ * bucket k for [2^(k-1), 2^k) cycles, the last one open ended.
+ */
+#define CACHESIM_LATENCY_HISTOGRAM_BUCKETS               (32)
+
+/******************************** ENUMERATIONS ********************************/
+typedef enum _CACHESIM_RET_E
+{
+   eCACHESIM_RET_SUCCESS         = 0x00000000,
+
+   eCACHESIM_RET_FAILURE,
+
+   eCACHESIM_RET_MAX
+} CACHESIM_RET_E;
+
+typedef enum _CACHESIM_ACCESS_TYPE_E
+{
+   eCACHESIM_ACCESS_TYPE_READ,
+
+   eCACHESIM_ACCESS_TYPE_WRITE,
+
+   /*
+    * Instruction fetches do not go through the data cache; they are counted
+    * as skipped records and, with a prefetcher, give the instruction address
+    * of the accesses that follow.
+    */
+   eCACHESIM_ACCESS_TYPE_IFETCH,
+
+   eCACHESIM_ACCESS_TYPE_MAX
+} CACHESIM_ACCESS_TYPE_E;
+
+/************************* STRUCTURE/UNION DATA TYPES *************************/
+/*
+ * Opaque handle of a simulated cache.
+ */
+typedef struct _CACHESIM_X CACHESIM_X;
+
+/*
+ * Opaque handle of an open trace file.
+ */
+typedef struct _CACHESIM_TRACE_X CACHESIM_TRACE_X;
+
+typedef struct _CACHESIM_CONFIG_X
+{
+   uint32_t ui_cache_size_words;
+
+   uint32_t ui_associativity;
+
+   uint32_t ui_block_size_words;
+
+   uint32_t ui_word_size_bytes;
+
+   /*
+    * Width of the byte addresses; accesses beyond it are skipped.
+    */
+   uint32_t ui_address_bits;
+
+   /*
+    * Name of the replacement policy, as taken by the -r option of the
+    * simulator: fifo, lru, plru, random, ...
+    */
+   const char *pc_replacement_policy;
+
+   /*
+    * Write back (dirty blocks go to memory on eviction) or write through.
+    */
+   bool b_write_back;
+
+   bool b_write_allocate;
+
+   /*
+    * Split the non-compulsory misses into capacity and conflict misses.
+    */
+   bool b_classify_misses;
+
+   /*
+    * Simulate only about 1 in ui_sample_sets sets; 0 or 1 for all of them.
+    */
+   uint32_t ui_sample_sets;
+
+   /*
+    * Name of the hardware prefetcher, as taken by the -F option of the
+    * simulator: none, next-line, ip-stride or stream.
+    */
+   const char *pc_prefetcher;
+
+   uint32_t ui_prefetch_degree;
+
+   uint32_t ui_prefetch_latency;
+
+   bool b_huge_pages;
+
+   /*
+    * Latency model, in cycles: a lookup takes ui_hit_latency, and a miss
+    * adds ui_miss_penalty and ui_memory_latency.
+    */
+   uint32_t ui_hit_latency;
+
+   uint32_t ui_miss_penalty;
+
+   uint32_t ui_memory_latency;
+
+   /*
+    * Non-blocking timing with ui_mshrs miss status holding registers, at
+    * ui_issue_rate accesses per cycle; 0 MSHRs for blocking accesses. Not
+    * available with set sampling.
+    */
+   uint32_t ui_mshrs;
+
+   uint32_t ui_issue_rate;
+} CACHESIM_CONFIG_X;
+
+/*
+ * One byte-addressed access. ui_size_bytes of 0 is taken as one word; an
+ * access that spans several blocks is an access to each of them.
+ */
+typedef struct _CACHESIM_RECORD_X
+{
+   uint64_t ull_address;
+
+   uint32_t ui_size_bytes;
+
+   CACHESIM_ACCESS_TYPE_E e_type;
+} CACHESIM_RECORD_X;
+
+typedef struct _CACHESIM_STATS_X
+{
+   /*
+    * Records given to the cache, and those of them that were skipped:
+    * instruction fetches and accesses beyond the address width.
+    */
+   uint64_t ull_records;
+
+   uint64_t ull_skipped_records;
+
+   /*
+    * Block accesses that reached the cache, and their outcome.
+    */
+   uint64_t ull_accesses;
+
+   uint64_t ull_hits;
+
+   uint64_t ull_misses;
+
+   uint64_t ull_compulsory_misses;
+
+   uint64_t ull_capacity_misses;
+
+   uint64_t ull_conflict_misses;
+
+   uint64_t ull_writes;
+
+   uint64_t ull_write_misses;
+
+   uint64_t ull_dirty_evictions;
+
+   uint64_t ull_bytes_from_memory;
+
+   uint64_t ull_bytes_to_memory;
+
+   /*
+    * Block accesses to sets left out by set sampling.
+    */
+   uint64_t ull_sample_skipped;
+
+   uint64_t ull_prefetches_issued;
+
+   uint64_t ull_prefetches_useful;
+
+   uint64_t ull_prefetches_late;
+
+   /*
+    * Cycles of the accesses under the latency model, the part of them
+    * beyond the hit latency, and the latency of every access.
+    */
+   uint64_t ull_cycles;
+
+   uint64_t ull_stall_cycles;
+
+   uint64_t ulla_latency_histogram [CACHESIM_LATENCY_HISTOGRAM_BUCKETS];
+
+   /*
+    * Non-blocking timing only: cycles from the first access to the last
+    * completion, misses that took a register and those that merged into
+    * one, misses that found them all busy and the cycles waited for one.
+    * ull_miss_cycles over ull_miss_busy_cycles, the cycles with a miss in
+    * flight, is the memory-level parallelism.
+    */
+   uint64_t ull_elapsed_cycles;
+
+   uint64_t ull_primary_misses;
+
+   uint64_t ull_merged_misses;
+
+   uint64_t ull_mshr_full_stalls;
+
+   uint64_t ull_mshr_stall_cycles;
+
+   uint64_t ull_miss_cycles;
+
+   uint64_t ull_miss_busy_cycles;
+
+   /*
+    * Records among ull_records that were reads and writes.
+    */
+   uint64_t ull_read_records;
+
+   uint64_t ull_write_records;
+} CACHESIM_STATS_X;
+
+/***************************** FUNCTION PROTOTYPES ****************************/
+/*
+ * Fills px_config with the defaults of the simulator command line.
+ */
+void cachesim_config_init (
+   CACHESIM_CONFIG_X *px_config);
+
+CACHESIM_RET_E cachesim_create (
+   const CACHESIM_CONFIG_X *px_config,
+   CACHESIM_X **ppx_sim);
+
+CACHESIM_RET_E cachesim_destroy (
+   CACHESIM_X *px_sim);
+
+/*
+ * One access. *pb_hit, if given, is set to whether the access was simulated
+ * and hit in every block it touched. It is false for an access that was not
+ * simulated: an instruction fetch or an access beyond the address width,
+ * both counted in ull_skipped_records, or, with set sampling, an access to a
+ * set that is not sampled.
+ */
+CACHESIM_RET_E cachesim_access (
+   CACHESIM_X *px_sim,
+   uint64_t ull_address,
+   uint32_t ui_size_bytes,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   bool *pb_hit);
+
+/*
+ * ull_count accesses in order, through the batched lookup path of the
+ * engine. This is the fast way in for long access streams.
+ */
+CACHESIM_RET_E cachesim_access_batch (
+   CACHESIM_X *px_sim,
+   const CACHESIM_RECORD_X *px_records,
+   uint64_t ull_count);
+
+CACHESIM_RET_E cachesim_get_stats (
+   const CACHESIM_X *px_sim,
+   CACHESIM_STATS_X *px_stats);
+
+/*
+ * Zeroes the statistics and keeps the contents of the cache, so that what
+ * follows is measured on a warm cache. Blocks seen before the reset are not
+ * compulsory misses after it.
+ */
+CACHESIM_RET_E cachesim_reset_stats (
+   CACHESIM_X *px_sim);
+
+/*
+ * Logs every access from now on: as a row of the table view on stdout or,
+ * with pc_event_log_file, to that file in the binary event log format. The
+ * rows are written by a thread of their own; cachesim_stop_log waits for
+ * them.
+ */
+CACHESIM_RET_E cachesim_start_log (
+   CACHESIM_X *px_sim,
+   const char *pc_event_log_file);
+
+CACHESIM_RET_E cachesim_stop_log (
+   CACHESIM_X *px_sim);
+
+/*
+ * Print the configuration and the statistics of the cache to stdout, as the
+ * simulator does in its reports.
+ */
+void cachesim_print_config (
+   const CACHESIM_X *px_sim);
+
+void cachesim_print_stats (
+   const CACHESIM_X *px_sim);
+
+/*
+ * Opens a trace in any of the formats the simulator reads; "-" reads a text
+ * trace from stdin.
+ */
+CACHESIM_RET_E cachesim_open_trace (
+   const char *pc_trace_file,
+   CACHESIM_TRACE_X **ppx_trace);
+
+/*
+ * Skips forward so that the next record read is record ull_record, counted
+ * from 0. Binary traces jump there through their index.
+ */
+CACHESIM_RET_E cachesim_seek_trace (
+   CACHESIM_TRACE_X *px_trace,
+   uint64_t ull_record);
+
+/*
+ * Reads up to ull_max_records records; *pull_records is 0 at the end of the
+ * trace. On a malformed record it fails, with the records before it read.
+ */
+CACHESIM_RET_E cachesim_read_trace (
+   CACHESIM_TRACE_X *px_trace,
+   CACHESIM_RECORD_X *px_records,
+   uint64_t ull_max_records,
+   uint64_t *pull_records);
+
+CACHESIM_RET_E cachesim_close_trace (
+   CACHESIM_TRACE_X *px_trace);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __CACHESIM_H__ */
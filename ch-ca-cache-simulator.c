@@ -16,1616 +16,11614 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <pthread.h>
 #endif
 #include <stdbool.h>
-#include <getopt.h>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+
+#include "cachesim.h"
+#include "cachesim-cli.h"
 
 /********************************* CONSTANTS **********************************/
 
 /*********************************** MACROS ***********************************/
-#define CACHESIM_MAX_NO_OF_BLOCKS_PER_SET                (128)
+#define CACHESIM_BLOCK_SIZE_BYTES                        \
+   (CACHESIM_BLOCK_SIZE_IN_NO_OF_WORDS * CACHESIM_WORD_SIZE_IN_BYTES)
 
-#define CACHESIM_MAX_NO_OF_SETS                          (128)
+#define CACHESIM_MAX_INDEX_VALUE                         (UINT32_MAX)
 
-#define CACHESIM_PAUSE_TIME_BW_ACCESSES                  (0)
+#define CACHESIM_INVALID_TAG                             (UINT64_MAX)
 
-#define CACHESIM_MAX_RAM_BLOCKS                          (1024)
+/*
+ * Highest byte address of an address space of the given width. The last
+ * byte of a 64-bit space is given up so that no RAM block can be numbered
+ * CACHESIM_INVALID_TAG.
+ */
+#define CACHESIM_MAX_ADDRESS(ui_address_bits)                                \
+   (((ui_address_bits) >= 64) ? (UINT64_MAX - 1) :                         \
+      ((UINT64_C(1) << (ui_address_bits)) - 1))
 
-#define CACHESIM_BLOCK_SIZE_BYTES                        \
-   (CACHESIM_BLOCK_SIZE_IN_NO_OF_WORDS * CACHESIM_WORD_SIZE_IN_BYTES)
+#define CACHESIM_DEFAULT_ADDRESS_BITS                    (64)
 
-#define CACHESIM_MAX_INDEX_VALUE                         (UINT32_MAX)
+#define CACHESIM_CACHE_LINE_SIZE_BYTES                   (64)
 
-#define CACHESIM_DIRECT_MAP_MEMORY_TO_RAM_BLOCK(ui_mem_idx,ui_no_of_words)     \
-   (ui_mem_idx / ui_no_of_words)
+#define CACHESIM_TAGS_PER_CACHE_LINE                     \
+   (CACHESIM_CACHE_LINE_SIZE_BYTES / sizeof (uint64_t))
 
-#define CACHESIM_DIRECT_MAP_RAM_BLOCK_TO_CACHE_BLOCK(ui_ram_block)  \
-   (ui_ram_block % CACHESIM_TOTAL_NO_OF_BLOCKS)
+#define CACHESIM_TAGS_PER_VECTOR                         (4)
 
-#define CACHESIM_SET_MAP_RAM_BLOCK_TO_CACHE_SET(ui_ram_block,ui_no_of_sets)  \
-   (ui_ram_block % ui_no_of_sets)
+#define CACHESIM_HASH_MAP_EMPTY_KEY                      (UINT64_MAX)
 
-#define CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params)                    \
-   ((px_cache_params)->ui_associativity)
+#define CACHESIM_HASH_MAP_MIN_CAPACITY                   (1024)
 
-#define CACHESIM_NO_OF_BLOCKS(px_cache_params)                         \
-   ((px_cache_params)->ui_cache_size_words / (px_cache_params)->ui_block_size_words)
+#define CACHESIM_FIRST_TOUCH_BLOCKS_PER_PAGE             (64)
 
-#define CACHESIM_NO_OF_SETS(px_cache_params)  \
-   (CACHESIM_NO_OF_BLOCKS(px_cache_params) / CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params))
+#define CACHESIM_BRRIP_LONG_INSERTION_PERIOD             (32)
 
-#define CACHESIM_BLOCK_SIZE_IN_BYTES(px_cache_params)                        \
-   ((px_cache_params)->ui_block_size_words * (px_cache_params)->ui_word_size_bytes)
+#define CACHESIM_RANDOM_SEED                             (0x9E3779B97F4A7C15ULL)
 
-/******************************** ENUMERATIONS ********************************/
-typedef enum _CACHESIM_RET_E
-{
-   eCACHESIM_RET_SUCCESS         = 0x00000000,
+#define CACHESIM_ARENA_PAGE_SIZE                         (4096)
 
-   eCACHESIM_RET_FAILURE,
+#define CACHESIM_ARENA_HUGE_PAGE_SIZE                    (2 * 1024 * 1024)
 
-   eCACHESIM_RET_MAX
-} CACHESIM_RET_E;
+#define CACHESIM_ROUND_UP(ui_value,ui_multiple)                         \
+   ((((ui_value) + (ui_multiple) - 1) / (ui_multiple)) * (ui_multiple))
 
-/************************* STRUCTURE/UNION DATA TYPES *************************/
-typedef struct _CACHESIM_CACHE_PARAMS_X
-{
-   uint32_t ui_cache_size_words;
+#define CACHESIM_TRACE_READ_BUFFER_SIZE                  (4 * 1024 * 1024)
 
-   uint32_t ui_associativity;
+#define CACHESIM_TRACE_BUFFER_MIN_RECORDS                (64 * 1024)
 
-   uint32_t ui_block_size_words;
+#define CACHESIM_TRACE_BINARY_MAGIC                      "CHCATRCE"
 
-   uint32_t ui_word_size_bytes;
-} CACHESIM_CACHE_PARAMS_X;
+#define CACHESIM_TRACE_BINARY_MAGIC_LEN                  (8)
 
-typedef enum _CACHESIM_SIMULATION_ALGORITHM_E
-{
-   eCACHESIM_SIMULATION_ALGORITHM_INVALID,
+#define CACHESIM_TRACE_BINARY_VERSION                    (2)
 
-   eCACHESIM_SIMULATION_ALGORITHM_GENERAL,
+#define CACHESIM_TRACE_BINARY_HEADER_SIZE                (48)
 
-   eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT,
+#define CACHESIM_TRACE_BINARY_INDEX_INTERVAL             (64 * 1024)
 
-   eCACHESIM_SIMULATION_ALGORITHM_MAX_IN_MATRIX,
+#define CACHESIM_TRACE_BINARY_TYPE_MASK                  (0x3)
 
-   eCACHESIM_SIMULATION_ALGORITHM_MAX
-} CACHESIM_SIMULATION_ALGORITHM_E;
+#define CACHESIM_TRACE_BINARY_TYPE_ESCAPE                (0x3)
 
-typedef struct _CACHESIM_CACHE_ARGS_X
-{
-   uint32_t ui_cache_size_words;
+#define CACHESIM_TRACE_BINARY_SIZE_FLAG                  (0x4)
 
-   uint32_t ui_associativity;
+#define CACHESIM_TRACE_BINARY_KEY_SHIFT                  (3)
 
-   uint32_t ui_block_size_words;
+#define CACHESIM_TRACE_WRITE_BUFFER_SIZE                 (1024 * 1024)
 
-   uint32_t ui_word_size_bytes;
+#define CACHESIM_ACCESS_BATCH_SIZE                       (32)
 
-   CACHESIM_SIMULATION_ALGORITHM_E e_algorithm;
+#define CACHESIM_TRACE_BATCH_RECORDS                     (1024)
 
-   bool b_simulate_pinning;
+#define CACHESIM_EVENT_LOG_MAGIC                         "CHCAEVNT"
 
-   bool b_silent;
+#define CACHESIM_EVENT_LOG_MAGIC_LEN                     (8)
 
-   uint32_t ui_loop_iterations;
-} CACHESIM_CACHE_ARGS_X;
+#define CACHESIM_EVENT_LOG_VERSION                       (2)
 
-typedef struct _CACHESIM_SIM_STATS_X
-{
-   uint32_t ui_total_accesses;
+#define CACHESIM_EVENT_LOG_HEADER_SIZE                   (32)
 
-   uint32_t ui_hit_count;
+#define CACHESIM_EVENT_LOG_RECORD_SIZE                   (24)
 
-   uint32_t ui_miss_count;
+#define CACHESIM_EVENT_LOG_V1_RECORD_SIZE                (16)
 
-   uint32_t ui_capacity_miss;
+#define CACHESIM_EVENT_LOG_RING_SIZE                     (64 * 1024)
 
-   uint32_t ui_compulsory_miss;
+#define CACHESIM_EVENT_LOG_WRITE_BATCH                   (4096)
 
-   uint32_t ui_conflict_miss;
+#define CACHESIM_EVENT_LOG_IDLE_SLEEP_US                 (1000)
 
-   bool     ba_first_access_to_ram_blk[CACHESIM_MAX_RAM_BLOCKS];
-} CACHESIM_SIM_STATS_X;
+#define CACHESIM_EVENT_LOG_FULL_SLEEP_US                 (50)
 
-typedef struct _CACHE_BLOCK_METADATA_X
-{
-   uint32_t ui_cache_block_idx;
+#define CACHESIM_SWEEP_MAX_VALUES                        (64)
 
-   uint32_t ui_data_start_idx;
+#define CACHESIM_MRC_DEFAULT_ASSOC                       "1-16"
 
-   uint32_t ui_data_end_idx;
+#define CACHESIM_MAX_CORES                               (256)
 
-   bool b_is_pinned;
-} CACHE_BLOCK_METADATA_X;
+#define CACHESIM_PREFETCH_IP_ENTRIES                     (256)
 
-typedef struct _CACHE_BLOCK_DATA_X
-{
-   uint32_t *pui_data_ptr;
+#define CACHESIM_PREFETCH_STREAMS                        (16)
 
-   uint32_t ui_data_size_words;
-} CACHE_BLOCK_DATA_X;
+#define CACHESIM_PREFETCH_STREAM_WINDOW                  (4)
 
-typedef struct _CACHE_BLOCK_X
-{
-   CACHE_BLOCK_METADATA_X  x_metadata;
+#define CACHESIM_PREFETCH_STRIDE_CONFIDENT               (2)
 
-   CACHE_BLOCK_DATA_X      x_data;
-} CACHE_BLOCK_X;
+#define CACHESIM_PREFETCH_STRIDE_MAX_CONFIDENCE          (3)
 
-typedef struct _CACHE_SET_DATA_X
-{
-   uint32_t ui_set_idx;
+#define CACHESIM_PREFETCH_DEFAULT_DEGREE                 (2)
 
-   uint32_t ui_last_fetched_block;
+#define CACHESIM_PREFETCH_DEFAULT_LATENCY                (16)
 
-   CACHE_BLOCK_X     xa_blocks[CACHESIM_MAX_NO_OF_BLOCKS_PER_SET];
-} CACHE_SET_DATA_X;
+#define CACHESIM_DEFAULT_MEMORY_LATENCY                  (200)
 
-typedef struct _CACHE_SET_X
-{
-   CACHE_SET_DATA_X        xa_sets[CACHESIM_MAX_NO_OF_SETS];
+#define CACHESIM_DEFAULT_ISSUE_RATE                      (1)
 
-   uint32_t                ui_configured_no_of_sets;
+#define CACHESIM_FALSE_SHARING_TOP_BLOCKS                (10)
 
-   uint32_t                ui_no_of_blocks_per_set;
+#define CACHESIM_BENCH_ACCESSES                          (1 << 20)
 
-   CACHESIM_CACHE_PARAMS_X x_cache_params;
-} CACHE_SET_X;
+/*
+ * Bytes touched by the benchmark streams: twice the largest cache of the
+ * matrix with the default block size, so that no stream fits entirely.
+ */
+#define CACHESIM_BENCH_FOOTPRINT_BYTES                   (64ULL * 1024 * 1024)
 
-/************************ STATIC FUNCTION PROTOTYPES **************************/
-static CACHESIM_RET_E cachesim_set_alloc_cache(
-   CACHE_SET_X **ppx_cache,
-   CACHESIM_CACHE_PARAMS_X *px_cache_params);
+/*
+ * Odd, so that the strided stream visits every set.
+ */
+#define CACHESIM_BENCH_STRIDE_BLOCKS                     (33)
 
-static CACHESIM_RET_E cachesim_set_free_cache(
-   CACHE_SET_X *px_cache);
+#define CACHESIM_BENCH_ZIPF_THETA                        (0.99)
 
-static CACHESIM_RET_E cachesim_set_fetch_data_to_cache(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_data_index,
-   uint32_t *pui_cache_set);
+#define CACHESIM_BENCH_SEED                              (0x9E3779B97F4A7C15ULL)
 
-static CACHESIM_RET_E cachesim_set_fetch_data_to_cache_v2(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_data_index,
-   bool b_pin_block,
-   uint32_t *pui_cache_set,
-   uint32_t *pui_block_idx);
+/*
+ * Streams of a --workload take the settings of the benchmark streams above
+ * unless the spec says otherwise.
+ */
+#define CACHESIM_WORKLOAD_MAX_STREAMS                    (8)
 
-static bool cachesim_set_lookup_cache(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_array_idx,
-   uint32_t *pui_cache_set);
+#define CACHESIM_WORKLOAD_DEFAULT_WRITE_PERCENT          (25)
 
-static bool cachesim_set_lookup_cache_v2(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_array_idx,
-   uint32_t *pui_cache_set,
-   uint32_t *pui_block_idx);
+#define CACHESIM_WORKLOAD_MAX_WEIGHT                     (1000000)
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_simulate(
-   CACHE_SET_X *px_cache,
-   bool b_use_pinning,
-   bool b_silent);
+#define CACHESIM_WORKLOAD_MAX_FOOTPRINT_BYTES            (1ULL << 56)
 
-static CACHESIM_RET_E cachesim_set_handle_cache_hit (
-   CACHE_SET_X *px_cache,
-   CACHESIM_SIM_STATS_X *px_stats);
+/*
+ * Terms of the Zipfian zeta sum that are added up one by one; the rest is
+ * approximated, so that streams over GBs start at once.
+ */
+#define CACHESIM_WORKLOAD_ZETA_EXACT_TERMS               (1ULL << 22)
 
-static CACHESIM_RET_E cachesim_set_handle_cache_miss (
-	CACHE_SET_X *px_cache,
-	uint32_t ui_index,
-	bool b_use_pinning,
-	bool *pb_compulsory,
-    uint32_t *pui_cache_set,
-    uint32_t *pui_block_idx,
-	CACHESIM_SIM_STATS_X *px_stats);
+#define CACHESIM_CHECKPOINT_MAGIC                        "CHCACKPT"
 
-static void cachesim_set_log_cache_access (
-   CACHE_SET_X *px_cache,
-   uint32_t ui_cache_set,
-   uint32_t ui_block_idx,
-   bool b_cache_hit,
-   bool b_compulsory,
-   bool b_silent);
+#define CACHESIM_CHECKPOINT_MAGIC_LEN                    (8)
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_access (
-   CACHE_SET_X *px_cache,
-   uint32_t ui_index,
-   bool b_use_pinning,
-   uint32_t ui_total_data_words,
-   bool b_silent,
-   CACHESIM_SIM_STATS_X *px_stats);
+#define CACHESIM_CHECKPOINT_VERSION                      (2)
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_bubble_sort(
-   CACHE_SET_X *px_cache,
-   bool b_silent,
-   uint32_t ui_n);
+/*
+ * Two-sided 95% quantile of the normal distribution, for the confidence
+ * intervals of sampled runs.
+ */
+#define CACHESIM_SAMPLE_Z95                              (1.959964)
 
-#ifdef _WIN32
-void usleep(unsigned int usec);
-#endif
+#define CACHESIM_DIRECT_MAP_MEMORY_TO_RAM_BLOCK(ui_mem_idx,ui_no_of_words)     \
+   (ui_mem_idx / ui_no_of_words)
 
-/****************************** LOCAL FUNCTIONS *******************************/
-#ifdef _WIN32
-void usleep(unsigned int usec)
-{
-	HANDLE timer;
-	LARGE_INTEGER ft;
+#define CACHESIM_DIRECT_MAP_RAM_BLOCK_TO_CACHE_BLOCK(ull_ram_block)  \
+   (ull_ram_block % CACHESIM_TOTAL_NO_OF_BLOCKS)
 
-	ft.QuadPart = -(10 * (__int64)usec);
+#define CACHESIM_SET_MAP_RAM_BLOCK_TO_CACHE_SET(ull_ram_block,ui_no_of_sets)  \
+   (ull_ram_block % ui_no_of_sets)
 
-	timer = CreateWaitableTimer(NULL, TRUE, NULL);
-	SetWaitableTimer(timer, &ft, 0, NULL, NULL, 0);
-	WaitForSingleObject(timer, INFINITE);
-	CloseHandle(timer);
-}
+#define CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params)                    \
+   ((px_cache_params)->ui_associativity)
+
+#define CACHESIM_NO_OF_BLOCKS(px_cache_params)                         \
+   ((px_cache_params)->ui_cache_size_words / (px_cache_params)->ui_block_size_words)
+
+#define CACHESIM_NO_OF_SETS(px_cache_params)  \
+   (CACHESIM_NO_OF_BLOCKS(px_cache_params) / CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params))
+
+#define CACHESIM_BLOCK_SIZE_IN_BYTES(px_cache_params)                        \
+   ((px_cache_params)->ui_block_size_words * (px_cache_params)->ui_word_size_bytes)
+
+/*
+ * Hint that the cache line holding the address is about to be read and
+ * written. A prefetch never faults, so any address may be passed.
+ */
+#if defined(__GNUC__)
+#define CACHESIM_PREFETCH(pv_addr)                                           \
+   __builtin_prefetch ((pv_addr), 1, 3)
+#elif defined(_M_X64) || defined(_M_IX86)
+#define CACHESIM_PREFETCH(pv_addr)                                           \
+   _mm_prefetch ((const char *) (pv_addr), _MM_HINT_T0)
+#else
+#define CACHESIM_PREFETCH(pv_addr)                                           \
+   ((void) (pv_addr))
 #endif
 
-static void cachesim_print_cache_params (CACHE_SET_X *px_cache)
-{
-	if (NULL != px_cache)
-	{
-		CACHESIM_CACHE_PARAMS_X *px_cache_params = &(px_cache->x_cache_params);
-		printf ("Cache Params:\n"
-			  "\tui_cache_size_words     : %d\n"
-			  "\tui_associativity        : %d\n"
-			  "\tui_block_size_words     : %d\n"
-			  "\tui_word_size_bytes      : %d\n"
-			  "\tui_no_of_sets           : %d\n"
-			  "\tui_no_of_blocks_per_set : %d\n", px_cache_params->ui_cache_size_words,
-			  px_cache_params->ui_associativity, px_cache_params->ui_block_size_words,
-			  px_cache_params->ui_word_size_bytes, px_cache->ui_configured_no_of_sets,
-			  px_cache->ui_no_of_blocks_per_set);
-	}
-}
+/*
+ * Loads and stores of the uint64_t counters shared between the two ends of
+ * the event log ring. Volatile accesses already have acquire and release
+ * semantics with MSVC.
+ */
+#if defined(__GNUC__)
+#define CACHESIM_LOAD_ACQUIRE(pull_var)                                      \
+   __atomic_load_n ((pull_var), __ATOMIC_ACQUIRE)
+#define CACHESIM_STORE_RELEASE(pull_var,ull_value)                           \
+   __atomic_store_n ((pull_var), (ull_value), __ATOMIC_RELEASE)
+#else
+#define CACHESIM_LOAD_ACQUIRE(pull_var)                                      \
+   (*(volatile const uint64_t *) (pull_var))
+#define CACHESIM_STORE_RELEASE(pull_var,ull_value)                           \
+   (*(volatile uint64_t *) (pull_var) = (ull_value))
+#endif
 
-static CACHESIM_RET_E cachesim_set_alloc_cache(
-   CACHE_SET_X **ppx_cache,
-   CACHESIM_CACHE_PARAMS_X *px_cache_params)
+/******************************** ENUMERATIONS ********************************/
+/************************* STRUCTURE/UNION DATA TYPES *************************/
+typedef struct _CACHESIM_CACHE_PARAMS_X
 {
-   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   CACHE_SET_X *px_cache = NULL;
-   CACHE_SET_DATA_X *px_set_data = NULL;
-   CACHE_BLOCK_X *px_block = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-   CACHE_BLOCK_DATA_X      *px_data = NULL;
-   uint32_t ui_no_of_sets = 0;
+   uint32_t ui_cache_size_words;
 
-   if ((NULL == ppx_cache) || (NULL == px_cache_params))
-   {
-      goto CLEAN_RETURN;
-   }
+   uint32_t ui_associativity;
+
+   uint32_t ui_block_size_words;
+
+   uint32_t ui_word_size_bytes;
 
    /*
-    * Calculate the number of sets in the cache. If the associativity is 1
-    * then (ui_cache_size_words / ui_block_size_words) will be the number of
-    * sets and (ui_cache_size_words / ui_block_size_words) / ui_associativity)
-    * otherwise.
+    * Back the cache arena with huge pages when the system provides them.
     */
-   ui_no_of_sets = CACHESIM_NO_OF_SETS(px_cache_params);
-   if (ui_no_of_sets > CACHESIM_MAX_NO_OF_SETS)
-   {
-      goto CLEAN_RETURN;
-   }
+   bool b_huge_pages;
 
-   px_cache = malloc (sizeof(CACHE_SET_X));
-   if (NULL == px_cache)
-   {
-      goto CLEAN_RETURN;
-   }
+   /*
+    * Allocate storage for the contents of the blocks. The simulation only
+    * needs the tags, so this is off unless a caller wants the data buffers.
+    */
+   bool b_store_data;
 
-   (void) memmove (&(px_cache->x_cache_params), px_cache_params,
-      sizeof (px_cache->x_cache_params));
+   /*
+    * Run a fully associative LRU shadow of the cache to split the
+    * non-compulsory misses into capacity and conflict misses. Without it
+    * they are all counted as capacity misses.
+    */
+   bool b_classify_misses;
 
-   px_cache->ui_configured_no_of_sets = ui_no_of_sets;
+   CACHESIM_REPLACEMENT_POLICY_E e_replacement_policy;
+
+   CACHESIM_WRITE_POLICY_E e_write_policy;
 
    /*
-    * Calculate number of blocks per set. This is directly related to
-    * associativity.
+    * Whether a write miss fetches the block into the cache. Without it the
+    * write goes straight to memory and the cache is left as it was.
     */
-   px_cache->ui_no_of_blocks_per_set =
-      CACHESIM_NO_OF_BLOCKS_PER_SET(&(px_cache->x_cache_params));
+   bool b_write_allocate;
 
-   // cachesim_print_cache_params (px_cache);
    /*
-    * Initialize each set of the cache.
+    * Logged runs write their events to this file in the binary event log
+    * format; without it the table is rendered to stdout as they run.
     */
-   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
-   {
-      px_set_data = &(px_cache->xa_sets[ui_i]);
-      px_set_data->ui_set_idx = ui_i;
-      px_set_data->ui_last_fetched_block = CACHESIM_MAX_INDEX_VALUE;
-
-      /*
-       * Initialize each block in the set.
-       */
-      for (ui_j = 0; ui_j < px_cache->ui_no_of_blocks_per_set; ui_j++)
-      {
-         px_block = &(px_set_data->xa_blocks[ui_j]);
-         px_metadata = &(px_block->x_metadata);
-         px_data = &(px_block->x_data);
+   const char *pc_event_log_file;
 
-         px_metadata->ui_cache_block_idx = ui_j;
-         px_metadata->ui_data_start_idx = CACHESIM_MAX_INDEX_VALUE;
-         px_metadata->ui_data_end_idx = CACHESIM_MAX_INDEX_VALUE;
+   /*
+    * Demo mode: the built-in algorithms pause this long between accesses so
+    * the log can be watched as it grows. 0 runs them at full speed.
+    */
+   uint32_t ui_demo_pause_us;
 
-         px_data->ui_data_size_words = px_cache_params->ui_block_size_words;
-         px_data->pui_data_ptr = malloc(CACHESIM_BLOCK_SIZE_IN_BYTES(px_cache_params));
-         if (NULL == px_data->pui_data_ptr)
-         {
-            break;
-         }
-      }
+   /*
+    * Set sampling: only about 1 in ui_sample_sets sets is simulated and the
+    * accesses to the others are dropped before the lookup. 0 or 1 simulates
+    * every set.
+    */
+   uint32_t ui_sample_sets;
 
-      if (px_cache->ui_no_of_blocks_per_set != ui_j)
-      {
-         break;
-      }
-   }
+   CACHESIM_PREFETCHER_E e_prefetcher;
 
-   if (px_cache->ui_configured_no_of_sets != ui_i)
-   {
-      e_ret_val = eCACHESIM_RET_FAILURE;
-   }
-   else
-   {
-      *ppx_cache = px_cache;
-      e_ret_val = eCACHESIM_RET_SUCCESS;
-   }
+   /*
+    * Blocks fetched ahead per prefetch decision.
+    */
+   uint32_t ui_prefetch_degree;
 
-CLEAN_RETURN:
-   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-   {
-      (void) cachesim_set_free_cache (px_cache);
-   }
-   return e_ret_val;
-}
+   /*
+    * Accesses a prefetch takes to arrive; a demand access to the block
+    * before then is a late prefetch.
+    */
+   uint32_t ui_prefetch_latency;
 
-static CACHESIM_RET_E cachesim_set_free_cache(
-   CACHE_SET_X *px_cache)
-{
-   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   CACHE_SET_DATA_X *px_set_data = NULL;
-   CACHE_BLOCK_X *px_block = NULL;
-   CACHE_BLOCK_DATA_X      *px_data = NULL;
+   /*
+    * Width of the byte addresses of the trace; accesses beyond it are
+    * skipped.
+    */
+   uint32_t ui_address_bits;
 
-   if (NULL == px_cache)
-   {
-      goto CLEAN_RETURN;
-   }
+   /*
+    * Write the per-set hit, miss and eviction counts to this file at the end
+    * of the run; NULL to leave them out.
+    */
+   const char *pc_heatmap_file;
 
    /*
-    * Deinitialize each set of the cache.
+    * Write the number of misses of every RAM block to this file at the end
+    * of the run; NULL to leave them out.
     */
-   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
-   {
-      px_set_data = &(px_cache->xa_sets[ui_i]);
+   const char *pc_heatmap_blocks_file;
 
-      /*
-       * Deinitialize each block of the set.
-       */
-      for (ui_j = 0; ui_j < px_cache->ui_no_of_blocks_per_set; ui_j++)
-      {
-         px_block = &(px_set_data->xa_blocks[ui_j]);
-         px_data = &(px_block->x_data);
+   CACHESIM_HEATMAP_FORMAT_E e_heatmap_format;
 
-         if (NULL != px_data->pui_data_ptr)
+   /*
+    * Trace runs: write the state of the cache to pc_checkpoint_file at the
+    * end of the run, start from the state in pc_restore_file. NULL to do
+    * neither.
+    */
+   const char *pc_checkpoint_file;
+
+   const char *pc_restore_file;
+
+   /*
+    * Latency model, in cycles: a lookup takes ui_hit_latency, and a miss
+    * adds ui_miss_penalty and then the latency of what is below, the next
+    * level or ui_memory_latency for memory.
+    */
+   uint32_t ui_hit_latency;
+
+   uint32_t ui_miss_penalty;
+
+   uint32_t ui_memory_latency;
+
+   /*
+    * Non-blocking timing: misses in flight are tracked in ui_mshrs miss
+    * status holding registers while the core issues ui_issue_rate accesses
+    * per cycle. 0 MSHRs for the blocking latency model.
+    */
+   uint32_t ui_mshrs;
+
+   uint32_t ui_issue_rate;
+} CACHESIM_CACHE_PARAMS_X;
+
+typedef enum _CACHESIM_MISS_TYPE_E
+{
+   eCACHESIM_MISS_TYPE_NONE,
+
+   eCACHESIM_MISS_TYPE_COMPULSORY,
+
+   eCACHESIM_MISS_TYPE_CAPACITY,
+
+   eCACHESIM_MISS_TYPE_CONFLICT,
+
+   eCACHESIM_MISS_TYPE_MAX
+} CACHESIM_MISS_TYPE_E;
+
+typedef enum _CACHESIM_COHERENCE_STATE_E
+{
+   eCACHESIM_COHERENCE_STATE_INVALID,
+
+   eCACHESIM_COHERENCE_STATE_SHARED,
+
+   eCACHESIM_COHERENCE_STATE_EXCLUSIVE,
+
+   eCACHESIM_COHERENCE_STATE_OWNED,
+
+   eCACHESIM_COHERENCE_STATE_MODIFIED,
+
+   eCACHESIM_COHERENCE_STATE_MAX
+} CACHESIM_COHERENCE_STATE_E;
+
+typedef enum _CACHESIM_WORKLOAD_E
+{
+   /*
+    * Every word of the footprint in order, wrapping around at the end.
+    */
+   eCACHESIM_WORKLOAD_SEQUENTIAL,
+
+   /*
+    * One word every ull_stride_blocks blocks.
+    */
+   eCACHESIM_WORKLOAD_STRIDED,
+
+   /*
+    * Words drawn uniformly from the footprint.
+    */
+   eCACHESIM_WORKLOAD_UNIFORM,
+
+   /*
+    * Blocks drawn from a Zipfian distribution, the popular ones scattered
+    * over the footprint.
+    */
+   eCACHESIM_WORKLOAD_ZIPFIAN,
+
+   /*
+    * The blocks of a linked list: each block names the next, and the chain
+    * visits every block of the footprint once, in a scattered order, before
+    * it starts over.
+    */
+   eCACHESIM_WORKLOAD_POINTER_CHASE,
+
+   eCACHESIM_WORKLOAD_MAX
+} CACHESIM_WORKLOAD_E;
+
+/*
+ * Open addressing (linear probing) hash map from 64-bit keys to 64-bit
+ * values. The capacity is a power of 2 and the load factor is kept at or
+ * below 1/2. CACHESIM_HASH_MAP_EMPTY_KEY cannot be used as a key. A zeroed
+ * map is a valid empty map; its tables are allocated on the first insert.
+ */
+typedef struct _CACHESIM_HASH_MAP_X
+{
+   uint64_t *pull_keys;
+
+   uint64_t *pull_values;
+
+   uint64_t ull_capacity;
+
+   uint64_t ull_count;
+} CACHESIM_HASH_MAP_X;
+
+/*
+ * Set of the RAM blocks touched so far, used to tell compulsory misses
+ * apart. It is a bitmap split into pages of CACHESIM_FIRST_TOUCH_BLOCKS_PER_PAGE
+ * blocks, and only the pages with at least one touched block exist: the
+ * hash map goes from page number to the 64-bit bitmap of the page. This
+ * costs about half a byte per touched block for dense footprints and is
+ * bounded by one map entry per touched block for fully sparse ones,
+ * whatever the size of the address space.
+ */
+typedef struct _CACHESIM_FIRST_TOUCH_X
+{
+   CACHESIM_HASH_MAP_X x_pages;
+} CACHESIM_FIRST_TOUCH_X;
+
+/*
+ * Fully associative LRU cache of the same capacity as the simulated cache,
+ * holding RAM block numbers. The hash map goes from RAM block to node and the
+ * nodes form a doubly linked list from the most to the least recently used.
+ * Nodes are indices into the pull_blocks/pui_prev/pui_next arrays;
+ * CACHESIM_MAX_INDEX_VALUE is the end of the list. The map never holds more
+ * than ui_capacity keys and is sized for that up front, so it never grows.
+ */
+typedef struct _CACHESIM_SHADOW_CACHE_X
+{
+   CACHESIM_HASH_MAP_X x_map;
+
+   uint64_t *pull_blocks;
+
+   uint32_t *pui_prev;
+
+   uint32_t *pui_next;
+
+   uint32_t ui_capacity;
+
+   uint32_t ui_count;
+
+   uint32_t ui_mru;
+
+   uint32_t ui_lru;
+} CACHESIM_SHADOW_CACHE_X;
+
+typedef struct _CACHESIM_SIM_STATS_X
+{
+   uint64_t ull_total_accesses;
+
+   uint64_t ull_hit_count;
+
+   uint64_t ull_miss_count;
+
+   uint64_t ull_capacity_miss;
+
+   uint64_t ull_compulsory_miss;
+
+   uint64_t ull_conflict_miss;
+
+   uint64_t ull_writes;
+
+   uint64_t ull_write_misses;
+
+   /*
+    * Evictions of dirty blocks, each written back to memory.
+    */
+   uint64_t ull_dirty_evictions;
+
+   /*
+    * Traffic between the cache and memory: block fills one way, write backs
+    * and written through or non-allocated writes the other.
+    */
+   uint64_t ull_bytes_from_memory;
+
+   uint64_t ull_bytes_to_memory;
+
+   /*
+    * Cycles the accesses took under the latency model, counted from the
+    * cache down, and the part of them beyond the hit latency. The latency
+    * of each access is also counted in the histogram: bucket 0 for no
+    * cycles and bucket k for [2^(k-1), 2^k).
+    */
+   uint64_t ull_cycles;
+
+   uint64_t ull_stall_cycles;
+
+   uint64_t ulla_latency_histogram [CACHESIM_LATENCY_HISTOGRAM_BUCKETS];
+
+   CACHESIM_FIRST_TOUCH_X x_first_touch;
+} CACHESIM_SIM_STATS_X;
+
+typedef struct _CACHESIM_SAMPLE_COUNTS_X
+{
+   uint64_t ull_accesses;
+
+   uint64_t ull_misses;
+} CACHESIM_SAMPLE_COUNTS_X;
+
+typedef struct _CACHESIM_HEATMAP_SET_X
+{
+   uint64_t ull_hits;
+
+   uint64_t ull_misses;
+
+   uint64_t ull_evictions;
+} CACHESIM_HEATMAP_SET_X;
+
+/*
+ * Where in the cache the activity is: counts per set, and optionally the
+ * misses of every RAM block (a map from RAM block to misses).
+ */
+typedef struct _CACHESIM_HEATMAP_X
+{
+   CACHESIM_HEATMAP_SET_X *px_sets;
+
+   bool b_blocks;
+
+   CACHESIM_HASH_MAP_X x_block_misses;
+} CACHESIM_HEATMAP_X;
+
+typedef struct _CACHESIM_HEATMAP_BLOCK_X
+{
+   uint64_t ull_ram_block;
+
+   uint64_t ull_misses;
+} CACHESIM_HEATMAP_BLOCK_X;
+
+/*
+ * Whole-cache estimates of a set sampled run. The access count is exact;
+ * misses, evictions and memory traffic of the sampled sets scale by d_scale
+ * (total sets over sampled sets) and the hits are whatever is left. The
+ * confidence interval comes from the spread of the per-set miss counts.
+ */
+typedef struct _CACHESIM_SAMPLE_ESTIMATE_X
+{
+   uint32_t ui_sampled_sets;
+
+   uint32_t ui_total_sets;
+
+   uint64_t ull_sampled_accesses;
+
+   uint64_t ull_skipped_accesses;
+
+   double d_scale;
+
+   double d_miss_rate;
+
+   /*
+    * Half width of the 95% confidence interval of d_miss_rate; negative
+    * when fewer than 2 sets were sampled.
+    */
+   double d_miss_rate_ci95;
+} CACHESIM_SAMPLE_ESTIMATE_X;
+
+/*
+ * One access of a batch: ui_size_bytes bytes within the block holding word
+ * ull_index.
+ */
+typedef struct _CACHESIM_ACCESS_X
+{
+   uint64_t ull_index;
+
+   uint32_t ui_size_bytes;
+
+   CACHESIM_ACCESS_TYPE_E e_type;
+
+   /*
+    * Address of the instruction making the access, 0 when unknown.
+    */
+   uint64_t ull_pc;
+} CACHESIM_ACCESS_X;
+
+typedef struct _CACHESIM_TRACE_RECORD_X
+{
+   uint64_t ull_address;
+
+   uint32_t ui_size_bytes;
+
+   CACHESIM_ACCESS_TYPE_E e_type;
+
+   /*
+    * Core that made the access, 0 in traces that do not say.
+    */
+   uint32_t ui_core;
+} CACHESIM_TRACE_RECORD_X;
+
+typedef struct _CACHESIM_TRACE_READER_X
+{
+   FILE *px_file;
+
+   char *pc_buffer;
+
+   size_t sz_buffer_len;
+
+   size_t sz_buffer_pos;
+
+   bool b_eof;
+
+   uint64_t ull_line_no;
+
+   /*
+    * Binary traces are decoded in place from a read-only mapping of the whole
+    * file; px_file and pc_buffer are then unused.
+    */
+   bool b_binary;
+
+   const uint8_t *puc_map;
+
+   size_t sz_map_len;
+
+   const uint8_t *puc_pos;
+
+   /*
+    * End of the encoded records, where the block index starts.
+    */
+   const uint8_t *puc_end;
+
+   const uint8_t *puc_index;
+
+   uint64_t ull_index_entries;
+
+   uint32_t ui_index_interval;
+
+   uint64_t ull_records;
+
+   uint64_t ull_record_no;
+
+   uint64_t ulla_prev_address [eCACHESIM_ACCESS_TYPE_MAX];
+
+   uint32_t uia_prev_size [eCACHESIM_ACCESS_TYPE_MAX];
+
+   uint32_t ui_core;
+
+   uint32_t ui_word_size_bytes;
+
+   uint32_t ui_block_size_bytes;
+
+   /*
+    * Whether the record last read lies between a roi-begin and a roi-end
+    * marker line of a text trace.
+    */
+   bool b_in_roi;
+} CACHESIM_TRACE_READER_X;
+
+/*
+ * Binary trace layout (all integers little-endian):
+ *
+ *    0  magic "CHCATRCE"              24  u64 number of records
+ *    8  u32 format version            32  u64 offset of the block index
+ *   12  u32 word size in bytes        40  u64 number of index entries
+ *   16  u32 block size in bytes       48  records
+ *   20  u32 records per index entry
+ *
+ * Each record is a varint key, optionally followed by a varint size. The
+ * two low bits of the key are the access type and the next bit says a size
+ * follows; otherwise the size is that of the previous record of the same
+ * type. The rest of the key is the zigzag encoded address delta from the
+ * previous record of the same type, so interleaved instruction fetches and
+ * data accesses each keep their own locality. Addresses and sizes restart
+ * from 0 every ui_index_interval records, and the block index holds the u64
+ * file offset of each of those records, so decoding can start at any of
+ * them. Deltas too large for the key use the escape type: the key then
+ * carries the access type and the address follows as a raw u64.
+ *
+ * Version 2 adds the core of the access. An escape key carrying
+ * eCACHESIM_ACCESS_TYPE_MAX + N instead of an access type switches to core N
+ * and is followed by the key of the record it belongs to; the core also
+ * restarts from 0 at every index entry. Version 1 traces are all core 0.
+ */
+typedef struct _CACHESIM_TRACE_WRITER_X
+{
+   FILE *px_file;
+
+   uint8_t *puc_buffer;
+
+   size_t sz_buffer_len;
+
+   uint64_t ull_offset;
+
+   uint64_t ull_records;
+
+   uint64_t ulla_prev_address [eCACHESIM_ACCESS_TYPE_MAX];
+
+   uint32_t uia_prev_size [eCACHESIM_ACCESS_TYPE_MAX];
+
+   uint32_t ui_core;
+
+   uint64_t *pull_index;
+
+   uint64_t ull_index_entries;
+
+   uint64_t ull_index_capacity;
+
+   uint32_t ui_word_size_bytes;
+
+   uint32_t ui_block_size_bytes;
+} CACHESIM_TRACE_WRITER_X;
+
+typedef struct _CACHESIM_TRACE_STATS_X
+{
+   uint64_t ull_records;
+
+   uint64_t ull_reads;
+
+   uint64_t ull_writes;
+
+   uint64_t ull_skipped;
+
+   /*
+    * Records that only warmed the cache up; they are not in the counts above.
+    */
+   uint64_t ull_warmup_records;
+} CACHESIM_TRACE_STATS_X;
+
+/*
+ * Phases of a trace run. The first ull_fast_forward records are skipped, the
+ * next ull_warmup records only warm the cache up and the rest are measured.
+ * With b_roi_markers only the records between roi-begin and roi-end markers
+ * are measured and the others warm the cache up. ull_max_records, when not 0,
+ * caps the records warmed up and measured.
+ */
+typedef struct _CACHESIM_TRACE_PHASES_X
+{
+   uint64_t ull_fast_forward;
+
+   uint64_t ull_warmup;
+
+   uint64_t ull_max_records;
+
+   bool b_roi_markers;
+} CACHESIM_TRACE_PHASES_X;
+
+/*
+ * A whole trace decoded into memory, shared read-only by the sweep workers.
+ */
+typedef struct _CACHESIM_TRACE_BUFFER_X
+{
+   CACHESIM_TRACE_RECORD_X *px_records;
+
+   uint64_t ull_count;
+
+   uint64_t ull_capacity;
+} CACHESIM_TRACE_BUFFER_X;
+
+/*
+ * Header of a checkpoint file. A checkpoint is a raw image of the state of a
+ * cache, to be restored by the same build on the same host only. The header
+ * is followed by the arena of the cache from its sets onwards, the per set
+ * counts of a sampled run and the keys and values of the first touch table.
+ */
+typedef struct _CACHESIM_CHECKPOINT_HEADER_X
+{
+   uint8_t uca_magic [CACHESIM_CHECKPOINT_MAGIC_LEN];
+
+   uint32_t ui_version;
+
+   uint32_t ui_header_size;
+
+   /*
+    * The configuration the state was built with; the restoring run has to
+    * use the same one.
+    */
+   uint32_t ui_cache_size_words;
+
+   uint32_t ui_associativity;
+
+   uint32_t ui_block_size_words;
+
+   uint32_t ui_word_size_bytes;
+
+   uint32_t ui_replacement_policy;
+
+   uint32_t ui_write_policy;
+
+   uint32_t ui_address_bits;
+
+   uint32_t ui_sample_sets;
+
+   uint32_t ui_hit_latency;
+
+   uint32_t ui_miss_penalty;
+
+   uint32_t ui_memory_latency;
+
+   uint8_t uc_classify_misses;
+
+   uint8_t uc_store_data;
+
+   uint64_t ull_arena_bytes;
+
+   /*
+    * State of the cache kept outside the arena.
+    */
+   uint64_t ull_random_state;
+
+   uint64_t ull_sample_skipped;
+
+   uint64_t ull_shadow_map_count;
+
+   uint32_t ui_shadow_count;
+
+   uint32_t ui_shadow_mru;
+
+   uint32_t ui_shadow_lru;
+
+   /*
+    * Trace records consumed so far, fast-forwarded ones included; the
+    * restored run resumes the trace after them.
+    */
+   uint64_t ull_trace_position;
+
+   CACHESIM_TRACE_STATS_X x_trace_stats;
+
+   /*
+    * x_first_touch is zeroed, its tables follow the sampling counts.
+    */
+   CACHESIM_SIM_STATS_X x_stats;
+
+   uint64_t ull_first_touch_capacity;
+
+   uint64_t ull_first_touch_count;
+} CACHESIM_CHECKPOINT_HEADER_X;
+
+/*
+ * Generator of a synthetic access stream over a footprint of
+ * ull_footprint_blocks blocks, a power of 2, starting at byte ull_base.
+ */
+typedef struct _CACHESIM_WORKLOAD_X
+{
+   CACHESIM_WORKLOAD_E e_workload;
+
+   /*
+    * Settings of the stream. d_zipf_theta is the skew of a Zipfian stream,
+    * between 0 and 1 excluded; ui_write_percent the share of its accesses
+    * that are writes; ui_weight its share of the accesses of a mix.
+    */
+   uint64_t ull_footprint_bytes;
+
+   uint64_t ull_stride_blocks;
+
+   double d_zipf_theta;
+
+   uint32_t ui_write_percent;
+
+   uint32_t ui_weight;
+
+   uint64_t ull_seed;
+
+   uint32_t ui_word_size_bytes;
+
+   uint32_t ui_block_size_bytes;
+
+   uint64_t ull_footprint_blocks;
+
+   uint32_t ui_footprint_bits;
+
+   uint64_t ull_base;
+
+   /*
+    * Accesses so far, or the current node of a pointer chase.
+    */
+   uint64_t ull_position;
+
+   uint64_t ull_random_state;
+
+   /*
+    * Percent of a write owed: an access is a write whenever it reaches 100.
+    */
+   uint32_t ui_write_credit;
+
+   /*
+    * Constants of the Zipfian generator of Gray et al., "Quickly generating
+    * billion-record synthetic databases".
+    */
+   double d_zipf_zetan;
+
+   double d_zipf_zeta2;
+
+   double d_zipf_alpha;
+
+   double d_zipf_eta;
+} CACHESIM_WORKLOAD_X;
+
+/*
+ * Workload given with --workload: ull_accesses accesses, each from one of
+ * the streams, picked at random in proportion to their weights. The streams
+ * lie one after the other in memory, each aligned to its footprint.
+ */
+typedef struct _CACHESIM_WORKLOAD_MIX_X
+{
+   CACHESIM_WORKLOAD_X xa_streams [CACHESIM_WORKLOAD_MAX_STREAMS];
+
+   uint32_t ui_no_of_streams;
+
+   uint32_t ui_total_weight;
+
+   uint64_t ull_accesses;
+
+   uint64_t ull_seed;
+
+   uint64_t ull_random_state;
+} CACHESIM_WORKLOAD_MIX_X;
+
+/*
+ * LRU stack distance histogram: pull_histogram [d] is the number of reuses
+ * that found d distinct other blocks touched since the previous access to
+ * the same block.
+ */
+typedef struct _CACHESIM_MRC_X
+{
+   uint64_t ull_accesses;
+
+   uint64_t ull_cold;
+
+   uint64_t *pull_histogram;
+
+   uint64_t ull_histogram_len;
+} CACHESIM_MRC_X;
+
+#ifdef _WIN32
+typedef HANDLE CACHESIM_THREAD_T;
+
+typedef CRITICAL_SECTION CACHESIM_MUTEX_T;
+
+#define CACHESIM_THREAD_RETURN                           DWORD WINAPI
+#else
+typedef pthread_t CACHESIM_THREAD_T;
+
+typedef pthread_mutex_t CACHESIM_MUTEX_T;
+
+#define CACHESIM_THREAD_RETURN                           void *
+#endif
+
+typedef struct _CACHESIM_SWEEP_RESULT_X
+{
+   CACHESIM_CACHE_PARAMS_X x_cache_params;
+
+   CACHESIM_RET_E e_ret_val;
+
+   /*
+    * Counters only; the first touch tracking is released once the
+    * configuration has been simulated.
+    */
+   CACHESIM_SIM_STATS_X x_stats;
+
+   CACHESIM_TRACE_STATS_X x_trace_stats;
+
+   /*
+    * Estimates of a set sampled sweep.
+    */
+   CACHESIM_SAMPLE_ESTIMATE_X x_sample;
+
+   double d_seconds;
+} CACHESIM_SWEEP_RESULT_X;
+
+/*
+ * Work queue of one sweep worker. The owner pops configurations from the
+ * bottom, idle workers steal from the top.
+ */
+typedef struct _CACHESIM_SWEEP_DEQUE_X
+{
+   CACHESIM_MUTEX_T x_lock;
+
+   uint32_t *pui_tasks;
+
+   uint32_t ui_top;
+
+   uint32_t ui_bottom;
+} CACHESIM_SWEEP_DEQUE_X;
+
+typedef struct _CACHESIM_SWEEP_X
+{
+   const CACHESIM_TRACE_BUFFER_X *px_trace;
+
+   CACHESIM_SWEEP_RESULT_X *px_results;
+
+   uint32_t ui_no_of_results;
+
+   CACHESIM_SWEEP_DEQUE_X *px_deques;
+
+   uint32_t ui_no_of_workers;
+} CACHESIM_SWEEP_X;
+
+typedef struct _CACHESIM_SWEEP_WORKER_X
+{
+   CACHESIM_SWEEP_X *px_sweep;
+
+   uint32_t ui_worker_idx;
+
+   uint32_t ui_steals;
+
+   CACHESIM_THREAD_T x_thread;
+} CACHESIM_SWEEP_WORKER_X;
+
+typedef enum _CACHESIM_EVENT_OUTCOME_E
+{
+   eCACHESIM_EVENT_OUTCOME_HIT,
+
+   /*
+    * Miss that brought the block into the cache.
+    */
+   eCACHESIM_EVENT_OUTCOME_FILL,
+
+   /*
+    * Miss that left the cache unchanged: a write miss without write-allocate
+    * or a block that could not be cached because its set is pinned.
+    */
+   eCACHESIM_EVENT_OUTCOME_BYPASS,
+
+   eCACHESIM_EVENT_OUTCOME_MAX
+} CACHESIM_EVENT_OUTCOME_E;
+
+/*
+ * One logged access. In an event log file each event is a 24-byte record:
+ * ull_index as LE u64, ui_cache_set and ui_block_idx as LE u32, then the
+ * outcome and the miss type as bytes and 6 reserved bytes. Version 1 logs
+ * have 16-byte records with a LE u32 ull_index and 2 reserved bytes. The
+ * 32-byte header holds the magic, the version and the number of sets, the
+ * associativity, the block size in words and the word size in bytes as LE
+ * u32, then a reserved u32.
+ */
+typedef struct _CACHESIM_EVENT_X
+{
+   uint64_t ull_index;
+
+   uint32_t ui_cache_set;
+
+   uint32_t ui_block_idx;
+
+   uint8_t uc_outcome;
+
+   uint8_t uc_miss_type;
+} CACHESIM_EVENT_X;
+
+/*
+ * Turns events back into the per-access table. It keeps its own copy of the
+ * tags, updated from the fills, so a row needs nothing from the cache.
+ */
+typedef struct _CACHESIM_EVENT_RENDERER_X
+{
+   FILE *px_out;
+
+   uint32_t ui_sets;
+
+   uint32_t ui_ways;
+
+   uint32_t ui_block_size_words;
+
+   uint64_t *pull_tags;
+} CACHESIM_EVENT_RENDERER_X;
+
+/*
+ * Single producer, single consumer ring between the simulation thread and
+ * the writer thread that drains it, either to an event log file or through
+ * the renderer to stdout. Each side owns a cache line of counters so that
+ * the producer only reads the consumer's position when the ring looks full.
+ */
+typedef struct _CACHESIM_EVENT_LOG_X
+{
+   /*
+    * Written by the simulation thread only.
+    */
+   uint64_t ull_head;
+
+   uint64_t ull_tail_seen;
+
+   uint8_t uca_producer_pad [CACHESIM_CACHE_LINE_SIZE_BYTES - (2 * sizeof (uint64_t))];
+
+   /*
+    * Written by the writer thread only.
+    */
+   uint64_t ull_tail;
+
+   uint8_t uca_consumer_pad [CACHESIM_CACHE_LINE_SIZE_BYTES - sizeof (uint64_t)];
+
+   /*
+    * Non-zero once the simulation thread is done; the writer then drains
+    * what is left and exits.
+    */
+   uint64_t ull_stop;
+
+   CACHESIM_EVENT_X *px_ring;
+
+   uint32_t ui_ring_mask;
+
+   /*
+    * Event log file, or NULL when the events are rendered to stdout.
+    */
+   FILE *px_file;
+
+   uint8_t *puc_buffer;
+
+   bool b_write_failed;
+
+   CACHESIM_EVENT_RENDERER_X x_renderer;
+
+   CACHESIM_THREAD_T x_thread;
+} CACHESIM_EVENT_LOG_X;
+
+typedef struct _CACHE_BLOCK_METADATA_X
+{
+   bool b_is_pinned;
+
+   /*
+    * The block was written since it was fetched (write-back caches only).
+    */
+   bool b_is_dirty;
+
+   /*
+    * CACHESIM_COHERENCE_STATE_E of the block in the private caches of a
+    * multicore run; unused otherwise.
+    */
+   uint8_t uc_coherence_state;
+
+   /*
+    * The block was brought in by the prefetcher and no demand access has
+    * used it yet. It arrives at prefetch clock ui_prefetch_ready (low 32
+    * bits).
+    */
+   bool b_is_prefetched;
+
+   uint32_t ui_prefetch_ready;
+} CACHE_BLOCK_METADATA_X;
+
+typedef struct _CACHE_BLOCK_X
+{
+   CACHE_BLOCK_METADATA_X  x_metadata;
+} CACHE_BLOCK_X;
+
+typedef struct _CACHE_SET_DATA_X
+{
+   uint32_t ui_set_idx;
+
+   uint32_t ui_last_fetched_block;
+
+   /*
+    * ui_no_of_blocks_per_set blocks, carved from the cache arena.
+    */
+   CACHE_BLOCK_X     *px_blocks;
+} CACHE_SET_DATA_X;
+
+typedef struct _CACHESIM_PREFETCH_IP_ENTRY_X
+{
+   uint64_t ull_pc;
+
+   uint64_t ull_last_block;
+
+   int64_t i_stride;
+
+   uint32_t ui_confidence;
+} CACHESIM_PREFETCH_IP_ENTRY_X;
+
+typedef struct _CACHESIM_PREFETCH_STREAM_X
+{
+   bool b_valid;
+
+   uint64_t ull_last_block;
+
+   /*
+    * +1 or -1 once the stream has moved, 0 until then.
+    */
+   int32_t i_direction;
+
+   uint64_t ull_last_use;
+} CACHESIM_PREFETCH_STREAM_X;
+
+/*
+ * Prefetcher state and counters of a cache. A prefetch is useful when a
+ * demand access uses the block after it arrived and late when one uses it
+ * before; it is useless when the block is evicted unused. Blocks evicted to
+ * make room for prefetches are remembered in a direct mapped filter of one
+ * entry per cache block, and a demand miss on one of them is counted as
+ * pollution.
+ */
+typedef struct _CACHESIM_PREFETCH_X
+{
+   /*
+    * Demand accesses so far.
+    */
+   uint64_t ull_clock;
+
+   /*
+    * Address of the last instruction fetch of the trace, the instruction
+    * the data accesses that follow are attributed to.
+    */
+   uint64_t ull_last_ifetch;
+
+   uint64_t *pull_pollution;
+
+   uint32_t ui_pollution_mask;
+
+   CACHESIM_PREFETCH_IP_ENTRY_X xa_ip [CACHESIM_PREFETCH_IP_ENTRIES];
+
+   CACHESIM_PREFETCH_STREAM_X xa_streams [CACHESIM_PREFETCH_STREAMS];
+
+   uint64_t ull_issued;
+
+   uint64_t ull_useful;
+
+   uint64_t ull_late;
+
+   uint64_t ull_useless;
+
+   uint64_t ull_pollution;
+} CACHESIM_PREFETCH_X;
+
+/*
+ * Miss status holding register: the RAM block of a miss in flight and the
+ * cycle the block arrives. A register is free once ull_ready is not after
+ * the current cycle.
+ */
+typedef struct _CACHESIM_MSHR_ENTRY_X
+{
+   uint64_t ull_ram_block;
+
+   uint64_t ull_ready;
+} CACHESIM_MSHR_ENTRY_X;
+
+/*
+ * Non-blocking timing of a cache. The core issues ui_issue_rate accesses per
+ * cycle without waiting for them; it only stops when a miss finds every
+ * register busy, until the earliest of them frees. A hit takes the hit
+ * latency, a miss holds a register for the full miss latency, and an access
+ * to a block still in flight merges into its register and waits for the
+ * block instead of missing again.
+ */
+typedef struct _CACHESIM_MSHR_X
+{
+   /*
+    * Current cycle, and the accesses issued in it so far.
+    */
+   uint64_t ull_now;
+
+   uint32_t ui_issued;
+
+   /*
+    * Cycle the counters below start from.
+    */
+   uint64_t ull_start;
+
+   /*
+    * Latest cycle an access completes in.
+    */
+   uint64_t ull_end;
+
+   /*
+    * End of the span of cycles with a miss in flight, as counted so far in
+    * ull_busy_cycles.
+    */
+   uint64_t ull_busy_until;
+
+   uint64_t ull_primary_misses;
+
+   uint64_t ull_merged_misses;
+
+   /*
+    * Misses that found every register busy, and the cycles the core waited
+    * for one.
+    */
+   uint64_t ull_full_stalls;
+
+   uint64_t ull_full_stall_cycles;
+
+   /*
+    * Cycles the misses were in flight, summed over the misses, and the
+    * cycles with at least one miss in flight. Their ratio is the memory-level
+    * parallelism.
+    */
+   uint64_t ull_miss_cycles;
+
+   uint64_t ull_busy_cycles;
+
+   CACHESIM_MSHR_ENTRY_X *px_entries;
+} CACHESIM_MSHR_X;
+
+typedef enum _CACHESIM_ARENA_TYPE_E
+{
+   eCACHESIM_ARENA_TYPE_HEAP,
+
+   eCACHESIM_ARENA_TYPE_MMAP,
+
+   eCACHESIM_ARENA_TYPE_HUGETLB,
+
+   eCACHESIM_ARENA_TYPE_MAX
+} CACHESIM_ARENA_TYPE_E;
+
+/*
+ * Byte offsets of the regions of a cache arena. The arena is a single
+ * allocation laid out as:
+ *
+ *    CACHE_SET_X | sets | blocks | tag store | replacement state |
+ *    block data (optional) | shadow cache (optional)
+ *
+ * with every region starting on a cache line boundary.
+ */
+typedef struct _CACHESIM_ARENA_LAYOUT_X
+{
+   size_t sz_sets_offset;
+
+   size_t sz_blocks_offset;
+
+   size_t sz_tags_offset;
+
+   size_t sz_repl_offset;
+
+   uint32_t ui_repl_stride;
+
+   size_t sz_data_offset;
+
+   size_t sz_shadow_offset;
+
+   uint64_t ull_shadow_map_capacity;
+
+   /*
+    * End of the last region, before rounding up to the page size.
+    */
+   size_t sz_used_size;
+
+   size_t sz_arena_size;
+} CACHESIM_ARENA_LAYOUT_X;
+
+typedef struct _CACHE_SET_X
+{
+   /*
+    * ui_configured_no_of_sets sets, carved from the cache arena.
+    */
+   CACHE_SET_DATA_X        *px_sets;
+
+   uint32_t                ui_configured_no_of_sets;
+
+   uint32_t                ui_no_of_blocks_per_set;
+
+   CACHESIM_CACHE_PARAMS_X x_cache_params;
+
+   /*
+    * Tag store, kept apart from the per-block metadata so that a lookup only
+    * touches the tags of one set. The tag of a block is the number of the RAM
+    * block it holds (CACHESIM_INVALID_TAG when invalid). The tags of set
+    * N start at pull_tags + (N * ui_tag_stride); every row is padded to a
+    * multiple of a cache line and the store itself is cache line aligned, so
+    * the ways of a set can be compared with aligned vector loads.
+    */
+   uint64_t                *pull_tags;
+
+   uint32_t                ui_tag_stride;
+
+   /*
+    * Number of tags compared per lookup: the associativity rounded up to the
+    * vector width. The padding tags are always invalid.
+    */
+   uint32_t                ui_tag_scan_len;
+
+   /*
+    * Per set replacement state, ui_repl_stride bytes per set. Its layout
+    * is private to x_cache_params.e_replacement_policy.
+    */
+   uint8_t                 *puc_repl_state;
+
+   uint32_t                ui_repl_stride;
+
+   uint64_t                ull_random_state;
+
+   /*
+    * When the number of sets (block size) is a power of 2 the set index
+    * (RAM block) is computed with a mask (shift) instead of a division.
+    */
+   bool                    b_pow2_sets;
+
+   uint32_t                ui_set_mask;
+
+   bool                    b_pow2_block;
+
+   uint32_t                ui_block_shift;
+
+   /*
+    * Highest RAM block within x_cache_params.ui_address_bits.
+    */
+   uint64_t                ull_max_ram_block;
+
+   /*
+    * Contents of the blocks, block (N * ui_no_of_blocks_per_set + M) holding
+    * the data of way M of set N. Only allocated when
+    * x_cache_params.b_store_data is set; NULL for tag-only simulation.
+    */
+   uint8_t                 *puc_data;
+
+   /*
+    * Only used when x_cache_params.b_classify_misses is set. Its tables are
+    * carved from the arena too.
+    */
+   CACHESIM_SHADOW_CACHE_X x_shadow;
+
+   /*
+    * Event log of a logged run, NULL otherwise.
+    */
+   CACHESIM_EVENT_LOG_X    *px_event_log;
+
+   /*
+    * Set sampling (x_cache_params.ui_sample_sets > 1): a set is simulated
+    * when its hash is at most ui_sample_threshold. Accesses to the other
+    * sets are counted in ull_sample_skipped and go no further;
+    * px_sample_counts, indexed by set, counts those to the sampled sets.
+    * NULL when every set is simulated.
+    */
+   CACHESIM_SAMPLE_COUNTS_X *px_sample_counts;
+
+   uint32_t                ui_sample_threshold;
+
+   uint32_t                ui_sampled_sets;
+
+   uint64_t                ull_sample_skipped;
+
+   /*
+    * Prefetcher of the cache, NULL when x_cache_params.e_prefetcher is
+    * eCACHESIM_PREFETCHER_NONE.
+    */
+   CACHESIM_PREFETCH_X     *px_prefetch;
+
+   /*
+    * Heatmap counters, NULL unless x_cache_params asks for a heatmap file.
+    */
+   CACHESIM_HEATMAP_X      *px_heatmap;
+
+   /*
+    * Non-blocking timing, NULL unless x_cache_params.ui_mshrs is set.
+    */
+   CACHESIM_MSHR_X         *px_mshr;
+
+   /*
+    * The arena this cache (including this structure) was carved from.
+    */
+   CACHESIM_ARENA_TYPE_E   e_arena_type;
+
+   size_t                  sz_arena_size;
+} CACHE_SET_X;
+
+typedef struct _CACHESIM_REPLACEMENT_POLICY_X
+{
+   const char *pc_name;
+
+   bool b_needs_pow2_ways;
+
+   /*
+    * Bytes of state per set, NULL if the policy keeps none.
+    */
+   size_t (*pfn_state_size) (uint32_t ui_ways);
+
+   /*
+    * Initializes the state of one set, NULL if all zero is the initial state.
+    */
+   void (*pfn_init_set) (uint8_t *puc_state, uint32_t ui_ways);
+
+   /*
+    * Picks the unpinned way to evict from a full set, CACHESIM_MAX_INDEX_VALUE
+    * if every way is pinned.
+    */
+   uint32_t (*pfn_victim) (CACHE_SET_X *px_cache, uint32_t ui_cache_set);
+
+   /*
+    * Updates the state for a block just placed in the way, NULL if nothing
+    * needs to be done.
+    */
+   void (*pfn_fill) (CACHE_SET_X *px_cache, uint32_t ui_cache_set,
+      uint32_t ui_way);
+} CACHESIM_REPLACEMENT_POLICY_X;
+
+typedef struct _CACHESIM_PREFETCHER_X
+{
+   const char *pc_name;
+
+   /*
+    * Sees every demand access to the RAM block; b_trigger is set for misses
+    * and for the first use of a prefetched block. Issues its prefetches
+    * through cachesim_set_prefetch_block. NULL for no prefetching.
+    */
+   void (*pfn_train) (CACHE_SET_X *px_cache, uint64_t ull_ram_block,
+      uint64_t ull_pc, CACHESIM_ACCESS_TYPE_E e_type, bool b_trigger,
+      CACHESIM_SIM_STATS_X *px_stats);
+} CACHESIM_PREFETCHER_X;
+
+typedef struct _CACHESIM_CACHE_LEVEL_X
+{
+   CACHE_SET_X *px_cache;
+
+   CACHESIM_SIM_STATS_X x_stats;
+
+   uint64_t ull_evictions;
+
+   /*
+    * Blocks of the inner levels invalidated because this level evicted the
+    * block holding them.
+    */
+   uint64_t ull_back_invalidations;
+} CACHESIM_CACHE_LEVEL_X;
+
+/*
+ * xa_levels [0] is the level closest to the processor.
+ */
+typedef struct _CACHESIM_HIERARCHY_X
+{
+   CACHESIM_CACHE_LEVEL_X xa_levels [CACHESIM_MAX_CACHE_LEVELS];
+
+   uint32_t ui_no_of_levels;
+
+   CACHESIM_INCLUSION_POLICY_E e_inclusion;
+
+   uint64_t ull_memory_accesses;
+
+   uint64_t ull_bytes_from_memory;
+
+   /*
+    * Dirty blocks written back past the last level.
+    */
+   uint64_t ull_bytes_to_memory;
+} CACHESIM_HIERARCHY_X;
+
+typedef struct _CACHESIM_CORE_X
+{
+   CACHE_SET_X *px_cache;
+
+   CACHESIM_SIM_STATS_X x_stats;
+
+   /*
+    * Misses on blocks that a write of another core invalidated here. They
+    * are true sharing misses when the access wants a word written by
+    * another core since, false sharing misses otherwise.
+    */
+   uint64_t ull_coherence_misses;
+
+   uint64_t ull_true_sharing_misses;
+
+   uint64_t ull_false_sharing_misses;
+
+   /*
+    * Write hits on shared or owned blocks, which invalidate the other
+    * copies without fetching the block.
+    */
+   uint64_t ull_upgrades;
+
+   uint64_t ull_invalidations_sent;
+
+   uint64_t ull_invalidations_received;
+
+   /*
+    * Misses served by the dirty copy of another core instead of memory.
+    */
+   uint64_t ull_cache_to_cache;
+
+   /*
+    * RAM block -> access clock at which another core invalidated the copy
+    * of this core. The entry goes away at the next miss on the block.
+    */
+   CACHESIM_HASH_MAP_X x_invalidated;
+} CACHESIM_CORE_X;
+
+/*
+ * Private caches of px_cores, kept coherent by snooping: every miss and
+ * upgrade is seen by all the other caches.
+ */
+typedef struct _CACHESIM_MULTICORE_X
+{
+   CACHESIM_CORE_X *px_cores;
+
+   uint32_t ui_no_of_cores;
+
+   CACHESIM_COHERENCE_PROTOCOL_E e_protocol;
+
+   /*
+    * Counts the accesses; stamps writes and invalidations.
+    */
+   uint64_t ull_clock;
+
+   /*
+    * Word -> access clock of its last write.
+    */
+   CACHESIM_HASH_MAP_X x_word_writes;
+
+   /*
+    * RAM block -> false sharing misses on it.
+    */
+   CACHESIM_HASH_MAP_X x_false_sharing;
+
+   uint64_t ull_bus_reads;
+
+   uint64_t ull_bus_read_exclusives;
+
+   uint64_t ull_bus_upgrades;
+} CACHESIM_MULTICORE_X;
+
+/*
+ * A cache of the library interface: the cache itself and what has been
+ * counted on it since it was created or its statistics were last reset.
+ */
+struct _CACHESIM_X
+{
+   CACHE_SET_X *px_cache;
+
+   CACHESIM_SIM_STATS_X x_stats;
+
+   CACHESIM_TRACE_STATS_X x_trace_stats;
+};
+
+/*
+ * A trace file opened through the library interface.
+ */
+struct _CACHESIM_TRACE_X
+{
+   CACHESIM_TRACE_READER_X x_reader;
+};
+
+/************************ STATIC FUNCTION PROTOTYPES **************************/
+static CACHESIM_RET_E cachesim_set_alloc_cache(
+   CACHE_SET_X **ppx_cache,
+   CACHESIM_CACHE_PARAMS_X *px_cache_params);
+
+static CACHESIM_RET_E cachesim_set_free_cache(
+   CACHE_SET_X *px_cache);
+
+static void cachesim_hash_map_deinit (
+   CACHESIM_HASH_MAP_X *px_map);
+
+static const CACHESIM_REPLACEMENT_POLICY_X *cachesim_replacement_policy (
+   CACHESIM_REPLACEMENT_POLICY_E e_policy);
+
+static const CACHESIM_PREFETCHER_X *cachesim_prefetcher (
+   CACHESIM_PREFETCHER_E e_prefetcher);
+
+static CACHESIM_RET_E cachesim_set_fetch_data_to_cache_v2(
+   CACHE_SET_X *px_cache,
+   uint64_t ull_data_index,
+   bool b_pin_block,
+   uint32_t *pui_cache_set,
+   uint32_t *pui_block_idx,
+   uint64_t *pull_evicted_block,
+   bool *pb_evicted_dirty);
+
+static bool cachesim_set_lookup_cache_v2(
+   CACHE_SET_X *px_cache,
+   uint64_t ull_array_idx,
+   uint32_t *pui_cache_set,
+   uint32_t *pui_block_idx);
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate(
+   CACHE_SET_X *px_cache,
+   bool b_use_pinning,
+   bool b_silent);
+
+static CACHESIM_RET_E cachesim_set_handle_cache_hit (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   uint32_t ui_cache_set,
+   uint32_t ui_block_idx,
+   CACHESIM_SIM_STATS_X *px_stats);
+
+static CACHESIM_RET_E cachesim_set_classify_cache_miss (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   CACHESIM_MISS_TYPE_E *pe_miss_type,
+   CACHESIM_SIM_STATS_X *px_stats);
+
+static CACHESIM_RET_E cachesim_set_handle_cache_miss (
+	CACHE_SET_X *px_cache,
+	uint64_t ull_index,
+	bool b_use_pinning,
+	CACHESIM_MISS_TYPE_E *pe_miss_type,
+    uint32_t *pui_cache_set,
+    uint32_t *pui_block_idx,
+	CACHESIM_SIM_STATS_X *px_stats);
+
+static inline void cachesim_event_log_put (
+   CACHESIM_EVENT_LOG_X *px_log,
+   uint64_t ull_index,
+   uint32_t ui_cache_set,
+   uint32_t ui_block_idx,
+   CACHESIM_EVENT_OUTCOME_E e_outcome,
+   CACHESIM_MISS_TYPE_E e_miss_type);
+
+static void cachesim_event_log_close (
+   CACHE_SET_X *px_cache);
+
+static CACHESIM_RET_E cachesim_thread_create (
+   CACHESIM_THREAD_T *px_thread,
+   CACHESIM_THREAD_RETURN (*pfn_thread) (void *),
+   void *pv_arg);
+
+static void cachesim_thread_join (CACHESIM_THREAD_T x_thread);
+
+static inline void cachesim_set_log_cache_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   uint32_t ui_cache_set,
+   uint32_t ui_block_idx,
+   bool b_cache_hit,
+   bool b_filled,
+   CACHESIM_MISS_TYPE_E e_miss_type);
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_access_typed (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   uint32_t ui_size_bytes,
+   bool b_use_pinning,
+   CACHESIM_SIM_STATS_X *px_stats);
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   bool b_use_pinning,
+   uint32_t ui_total_data_words,
+   CACHESIM_SIM_STATS_X *px_stats);
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_bubble_sort(
+   CACHE_SET_X *px_cache,
+   bool b_silent,
+   uint32_t ui_n);
+
+static CACHESIM_RET_E cachesim_trace_open (
+   CACHESIM_TRACE_READER_X *px_reader,
+   const char *pc_trace_file);
+
+static void cachesim_trace_close (
+   CACHESIM_TRACE_READER_X *px_reader);
+
+static CACHESIM_RET_E cachesim_trace_read_record (
+   CACHESIM_TRACE_READER_X *px_reader,
+   CACHESIM_TRACE_RECORD_X *px_record,
+   bool *pb_end_of_trace);
+
+static CACHESIM_RET_E cachesim_trace_seek (
+   CACHESIM_TRACE_READER_X *px_reader,
+   uint64_t ull_record);
+
+static void cachesim_set_mapped_cache_access_batch (
+   CACHE_SET_X *px_cache,
+   const CACHESIM_ACCESS_X *px_accesses,
+   uint32_t ui_count,
+   CACHESIM_SIM_STATS_X *px_stats,
+   uint64_t *pull_hits);
+
+static void cachesim_set_mapped_cache_access_records (
+   CACHE_SET_X *px_cache,
+   const CACHESIM_TRACE_RECORD_X *px_records,
+   uint64_t ull_count,
+   CACHESIM_SIM_STATS_X *px_stats,
+   CACHESIM_TRACE_STATS_X *px_trace_stats,
+   bool *pb_hit);
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_trace (
+   CACHE_SET_X *px_cache,
+   bool b_silent,
+   const char *pc_trace_file,
+   const CACHESIM_TRACE_PHASES_X *px_phases);
+
+static void cachesim_params_from_args (
+   CACHESIM_CACHE_ARGS_X *px_cache_args,
+   CACHESIM_CACHE_PARAMS_X *px_cache_params);
+
+#ifdef _WIN32
+void usleep(unsigned int usec);
+#endif
+
+/****************************** LOCAL FUNCTIONS *******************************/
+#ifdef _WIN32
+void usleep(unsigned int usec)
+{
+	HANDLE timer;
+	LARGE_INTEGER ft;
+
+	ft.QuadPart = -(10 * (__int64)usec);
+
+	timer = CreateWaitableTimer(NULL, TRUE, NULL);
+	SetWaitableTimer(timer, &ft, 0, NULL, NULL, 0);
+	WaitForSingleObject(timer, INFINITE);
+	CloseHandle(timer);
+}
+#endif
+
+static void cachesim_print_cache_params (CACHE_SET_X *px_cache)
+{
+	if (NULL != px_cache)
+	{
+		CACHESIM_CACHE_PARAMS_X *px_cache_params = &(px_cache->x_cache_params);
+		printf ("Cache Params:\n"
+			  "\tui_cache_size_words     : %d\n"
+			  "\tui_associativity        : %d\n"
+			  "\tui_block_size_words     : %d\n"
+			  "\tui_word_size_bytes      : %d\n"
+			  "\tui_no_of_sets           : %d\n"
+			  "\tui_no_of_blocks_per_set : %d\n"
+			  "\tsz_arena_size           : %zu\n"
+			  "\treplacement policy      : %s\n"
+			  "\twrite policy            : %s, %s\n", px_cache_params->ui_cache_size_words,
+			  px_cache_params->ui_associativity, px_cache_params->ui_block_size_words,
+			  px_cache_params->ui_word_size_bytes, px_cache->ui_configured_no_of_sets,
+			  px_cache->ui_no_of_blocks_per_set, px_cache->sz_arena_size,
+			  cachesim_replacement_policy (
+			     px_cache_params->e_replacement_policy)->pc_name,
+			  (eCACHESIM_WRITE_POLICY_WRITE_THROUGH == px_cache_params->e_write_policy) ?
+			     "write-through" : "write-back",
+			  (true == px_cache_params->b_write_allocate) ?
+			     "write-allocate" : "no-write-allocate");
+		if (eCACHESIM_PREFETCHER_NONE != px_cache_params->e_prefetcher)
+		{
+			printf ("\tprefetcher              : %s, degree %u, latency %u\n",
+				cachesim_prefetcher (px_cache_params->e_prefetcher)->pc_name,
+				px_cache_params->ui_prefetch_degree,
+				px_cache_params->ui_prefetch_latency);
+		}
+		if (0 != px_cache_params->ui_mshrs)
+		{
+			printf ("\tmshrs                   : %u, issue rate %u\n",
+				px_cache_params->ui_mshrs, px_cache_params->ui_issue_rate);
+		}
+	}
+}
+
+static uint32_t cachesim_log2_if_pow2 (uint32_t ui_value, bool *pb_pow2)
+{
+   uint32_t ui_log2 = 0;
+
+   *pb_pow2 = ((0 != ui_value) && (0 == (ui_value & (ui_value - 1))));
+   if (true == *pb_pow2)
+   {
+      while ((1U << ui_log2) != ui_value)
+      {
+         ui_log2++;
+      }
+   }
+   return ui_log2;
+}
+
+/*
+ * Mixes the bits of a key (the splitmix64 finalizer) so that block numbers
+ * with regular strides spread over the whole table.
+ */
+static inline uint64_t cachesim_hash_u64 (uint64_t ull_key)
+{
+   ull_key ^= ull_key >> 30;
+   ull_key *= 0xBF58476D1CE4E5B9ULL;
+   ull_key ^= ull_key >> 27;
+   ull_key *= 0x94D049BB133111EBULL;
+   ull_key ^= ull_key >> 31;
+   return ull_key;
+}
+
+static CACHESIM_RET_E cachesim_hash_map_init (
+   CACHESIM_HASH_MAP_X *px_map,
+   uint64_t ull_min_capacity)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint64_t ull_capacity = CACHESIM_HASH_MAP_MIN_CAPACITY;
+   uint64_t ull_i = 0;
+
+   if (NULL == px_map)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   (void) memset (px_map, 0x00, sizeof(*px_map));
+   /*
+    * Keep the load factor at or below 1/2 for the requested number of keys.
+    */
+   while (ull_capacity < (ull_min_capacity * 2))
+   {
+      ull_capacity <<= 1;
+   }
+   px_map->pull_keys = malloc (ull_capacity * sizeof(uint64_t));
+   px_map->pull_values = malloc (ull_capacity * sizeof(uint64_t));
+   if ((NULL == px_map->pull_keys) || (NULL == px_map->pull_values))
+   {
+      cachesim_hash_map_deinit (px_map);
+      goto CLEAN_RETURN;
+   }
+   for (ull_i = 0; ull_i < ull_capacity; ull_i++)
+   {
+      px_map->pull_keys [ull_i] = CACHESIM_HASH_MAP_EMPTY_KEY;
+   }
+   px_map->ull_capacity = ull_capacity;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static void cachesim_hash_map_deinit (
+   CACHESIM_HASH_MAP_X *px_map)
+{
+   if (NULL == px_map)
+   {
+      goto CLEAN_RETURN;
+   }
+   if (NULL != px_map->pull_keys)
+   {
+      free (px_map->pull_keys);
+   }
+   if (NULL != px_map->pull_values)
+   {
+      free (px_map->pull_values);
+   }
+   (void) memset (px_map, 0x00, sizeof(*px_map));
+CLEAN_RETURN:
+   return;
+}
+
+/*
+ * Returns the slot holding the key, or the empty slot where it would be
+ * inserted.
+ */
+static inline uint64_t cachesim_hash_map_slot (
+   const CACHESIM_HASH_MAP_X *px_map,
+   uint64_t ull_key)
+{
+   uint64_t ull_mask = px_map->ull_capacity - 1;
+   uint64_t ull_slot = cachesim_hash_u64 (ull_key) & ull_mask;
+
+   while ((CACHESIM_HASH_MAP_EMPTY_KEY != px_map->pull_keys [ull_slot])
+      && (ull_key != px_map->pull_keys [ull_slot]))
+   {
+      ull_slot = (ull_slot + 1) & ull_mask;
+   }
+   return ull_slot;
+}
+
+/*
+ * Returns a pointer to the value of the key, NULL if the key is not present.
+ */
+static inline uint64_t *cachesim_hash_map_find (
+   const CACHESIM_HASH_MAP_X *px_map,
+   uint64_t ull_key)
+{
+   uint64_t ull_slot = 0;
+
+   if (0 == px_map->ull_capacity)
+   {
+      return NULL;
+   }
+   ull_slot = cachesim_hash_map_slot (px_map, ull_key);
+   if (CACHESIM_HASH_MAP_EMPTY_KEY == px_map->pull_keys [ull_slot])
+   {
+      return NULL;
+   }
+   return &(px_map->pull_values [ull_slot]);
+}
+
+/*
+ * Starts loading the home slot of the key, where a lookup or insert of the
+ * key begins probing, and the value next to it.
+ */
+static inline void cachesim_hash_map_prefetch (
+   const CACHESIM_HASH_MAP_X *px_map,
+   uint64_t ull_key)
+{
+   uint64_t ull_slot = 0;
+
+   if (0 != px_map->ull_capacity)
+   {
+      ull_slot = cachesim_hash_u64 (ull_key) & (px_map->ull_capacity - 1);
+      CACHESIM_PREFETCH (px_map->pull_keys + ull_slot);
+      CACHESIM_PREFETCH (px_map->pull_values + ull_slot);
+   }
+}
+
+static CACHESIM_RET_E cachesim_hash_map_grow (
+   CACHESIM_HASH_MAP_X *px_map)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_HASH_MAP_X x_new_map = {0};
+   uint64_t ull_i = 0;
+   uint64_t ull_slot = 0;
+
+   e_ret_val = cachesim_hash_map_init (&x_new_map, px_map->ull_capacity);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+   for (ull_i = 0; ull_i < px_map->ull_capacity; ull_i++)
+   {
+      if (CACHESIM_HASH_MAP_EMPTY_KEY != px_map->pull_keys [ull_i])
+      {
+         ull_slot = cachesim_hash_map_slot (&x_new_map, px_map->pull_keys [ull_i]);
+         x_new_map.pull_keys [ull_slot] = px_map->pull_keys [ull_i];
+         x_new_map.pull_values [ull_slot] = px_map->pull_values [ull_i];
+      }
+   }
+   x_new_map.ull_count = px_map->ull_count;
+   cachesim_hash_map_deinit (px_map);
+   *px_map = x_new_map;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Returns a pointer to the value of the key, inserting the key with a value
+ * of 0 if it is not present yet. *pb_inserted tells which of the two
+ * happened. NULL if the table could not grow.
+ */
+static uint64_t *cachesim_hash_map_insert (
+   CACHESIM_HASH_MAP_X *px_map,
+   uint64_t ull_key,
+   bool *pb_inserted)
+{
+   uint64_t ull_slot = 0;
+
+   *pb_inserted = false;
+   if ((0 == px_map->ull_capacity)
+      && (eCACHESIM_RET_SUCCESS != cachesim_hash_map_init (px_map, 0)))
+   {
+      return NULL;
+   }
+   ull_slot = cachesim_hash_map_slot (px_map, ull_key);
+   if (CACHESIM_HASH_MAP_EMPTY_KEY != px_map->pull_keys [ull_slot])
+   {
+      return &(px_map->pull_values [ull_slot]);
+   }
+   if (((px_map->ull_count + 1) * 2) > px_map->ull_capacity)
+   {
+      if (eCACHESIM_RET_SUCCESS != cachesim_hash_map_grow (px_map))
+      {
+         return NULL;
+      }
+      ull_slot = cachesim_hash_map_slot (px_map, ull_key);
+   }
+   px_map->pull_keys [ull_slot] = ull_key;
+   px_map->pull_values [ull_slot] = 0;
+   px_map->ull_count++;
+   *pb_inserted = true;
+   return &(px_map->pull_values [ull_slot]);
+}
+
+/*
+ * Removes the key if present. Linear probing without tombstones: the entries
+ * following the removed one in its probe run are shifted back into the hole.
+ */
+static void cachesim_hash_map_remove (
+   CACHESIM_HASH_MAP_X *px_map,
+   uint64_t ull_key)
+{
+   uint64_t ull_mask = 0;
+   uint64_t ull_hole = 0;
+   uint64_t ull_slot = 0;
+   uint64_t ull_home = 0;
+
+   if (0 == px_map->ull_capacity)
+   {
+      return;
+   }
+   ull_mask = px_map->ull_capacity - 1;
+   ull_hole = cachesim_hash_map_slot (px_map, ull_key);
+   if (CACHESIM_HASH_MAP_EMPTY_KEY == px_map->pull_keys [ull_hole])
+   {
+      return;
+   }
+   ull_slot = ull_hole;
+   while (1)
+   {
+      ull_slot = (ull_slot + 1) & ull_mask;
+      if (CACHESIM_HASH_MAP_EMPTY_KEY == px_map->pull_keys [ull_slot])
+      {
+         break;
+      }
+      /*
+       * The entry may move into the hole only if its home slot does not lie
+       * cyclically in (hole, slot].
+       */
+      ull_home = cachesim_hash_u64 (px_map->pull_keys [ull_slot]) & ull_mask;
+      if (((ull_slot - ull_home) & ull_mask) >= ((ull_slot - ull_hole) & ull_mask))
+      {
+         px_map->pull_keys [ull_hole] = px_map->pull_keys [ull_slot];
+         px_map->pull_values [ull_hole] = px_map->pull_values [ull_slot];
+         ull_hole = ull_slot;
+      }
+   }
+   px_map->pull_keys [ull_hole] = CACHESIM_HASH_MAP_EMPTY_KEY;
+   px_map->ull_count--;
+}
+
+/*
+ * Marks the RAM block as touched. Returns true if this is the first touch.
+ * *pb_failed is set if the table could not grow, in which case the touch is
+ * reported as a repeated one.
+ */
+static bool cachesim_first_touch_mark (
+   CACHESIM_FIRST_TOUCH_X *px_first_touch,
+   uint64_t ull_ram_block,
+   bool *pb_failed)
+{
+   uint64_t *pull_bitmap = NULL;
+   uint64_t ull_bit = 0;
+   bool b_inserted = false;
+
+   *pb_failed = false;
+   ull_bit = 1ULL << (ull_ram_block % CACHESIM_FIRST_TOUCH_BLOCKS_PER_PAGE);
+   pull_bitmap = cachesim_hash_map_insert (&(px_first_touch->x_pages),
+      ull_ram_block / CACHESIM_FIRST_TOUCH_BLOCKS_PER_PAGE, &b_inserted);
+   if (NULL == pull_bitmap)
+   {
+      *pb_failed = true;
+      return false;
+   }
+   if (0 != (*pull_bitmap & ull_bit))
+   {
+      return false;
+   }
+   *pull_bitmap |= ull_bit;
+   return true;
+}
+
+static void cachesim_first_touch_deinit (
+   CACHESIM_FIRST_TOUCH_X *px_first_touch)
+{
+   cachesim_hash_map_deinit (&(px_first_touch->x_pages));
+}
+
+static void cachesim_sim_stats_deinit (
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   if (NULL != px_stats)
+   {
+      cachesim_first_touch_deinit (&(px_stats->x_first_touch));
+   }
+}
+
+/*
+ * Hit latencies of the levels, innermost first, unless given with
+ * --hit-latency.
+ */
+static const uint32_t gua_default_hit_latencies [CACHESIM_MAX_CACHE_LEVELS] =
+{
+   4, 12, 40, 60, 80, 100, 120, 140
+};
+
+static inline uint32_t cachesim_latency_bucket (uint64_t ull_latency)
+{
+   uint32_t ui_bucket = 0;
+
+   if (0 != ull_latency)
+   {
+#ifdef _MSC_VER
+      unsigned long ul_idx = 0;
+      _BitScanReverse64 (&ul_idx, ull_latency);
+      ui_bucket = (uint32_t) ul_idx + 1;
+#else
+      ui_bucket = 64 - (uint32_t) __builtin_clzll (ull_latency);
+#endif
+   }
+   return (ui_bucket < CACHESIM_LATENCY_HISTOGRAM_BUCKETS) ?
+      ui_bucket : (CACHESIM_LATENCY_HISTOGRAM_BUCKETS - 1);
+}
+
+/*
+ * Counts one access of ull_latency cycles on a cache whose hits take
+ * ui_hit_latency.
+ */
+static inline void cachesim_latency_account (
+   CACHESIM_SIM_STATS_X *px_stats,
+   uint64_t ull_latency,
+   uint32_t ui_hit_latency)
+{
+   px_stats->ull_cycles += ull_latency;
+   px_stats->ull_stall_cycles += ull_latency - ui_hit_latency;
+   px_stats->ulla_latency_histogram [cachesim_latency_bucket (ull_latency)]++;
+}
+
+/*
+ * Latency of an access to a single cache: the lookup, and on a miss the
+ * penalty and the trip to memory.
+ */
+static inline void cachesim_set_latency_account (
+   const CACHE_SET_X *px_cache,
+   bool b_cache_hit,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   const CACHESIM_CACHE_PARAMS_X *px_params = &(px_cache->x_cache_params);
+   uint64_t ull_latency = px_params->ui_hit_latency;
+
+   if (false == b_cache_hit)
+   {
+      ull_latency += (uint64_t) px_params->ui_miss_penalty
+         + px_params->ui_memory_latency;
+   }
+   cachesim_latency_account (px_stats, ull_latency, px_params->ui_hit_latency);
+}
+
+/*
+ * Points the tables of an empty shadow cache at the memory given, which must
+ * be large enough for a map of ull_map_capacity slots and ui_capacity nodes.
+ */
+static void cachesim_shadow_bind (
+   CACHESIM_SHADOW_CACHE_X *px_shadow,
+   uint8_t *puc_memory,
+   uint64_t ull_map_capacity,
+   uint32_t ui_capacity)
+{
+   px_shadow->x_map.pull_keys = (uint64_t *) puc_memory;
+   px_shadow->x_map.pull_values = px_shadow->x_map.pull_keys + ull_map_capacity;
+   px_shadow->x_map.ull_capacity = ull_map_capacity;
+   px_shadow->x_map.ull_count = 0;
+   (void) memset (px_shadow->x_map.pull_keys, 0xFF,
+      ull_map_capacity * sizeof(uint64_t));
+   px_shadow->pull_blocks = px_shadow->x_map.pull_values + ull_map_capacity;
+   px_shadow->pui_prev = (uint32_t *) (px_shadow->pull_blocks + ui_capacity);
+   px_shadow->pui_next = px_shadow->pui_prev + ui_capacity;
+   px_shadow->ui_capacity = ui_capacity;
+   px_shadow->ui_count = 0;
+   px_shadow->ui_mru = CACHESIM_MAX_INDEX_VALUE;
+   px_shadow->ui_lru = CACHESIM_MAX_INDEX_VALUE;
+}
+
+static inline void cachesim_shadow_unlink (
+   CACHESIM_SHADOW_CACHE_X *px_shadow,
+   uint32_t ui_node)
+{
+   uint32_t ui_prev = px_shadow->pui_prev [ui_node];
+   uint32_t ui_next = px_shadow->pui_next [ui_node];
+
+   if (CACHESIM_MAX_INDEX_VALUE != ui_prev)
+      px_shadow->pui_next [ui_prev] = ui_next;
+   else
+      px_shadow->ui_mru = ui_next;
+   if (CACHESIM_MAX_INDEX_VALUE != ui_next)
+      px_shadow->pui_prev [ui_next] = ui_prev;
+   else
+      px_shadow->ui_lru = ui_prev;
+}
+
+static inline void cachesim_shadow_push_mru (
+   CACHESIM_SHADOW_CACHE_X *px_shadow,
+   uint32_t ui_node)
+{
+   px_shadow->pui_prev [ui_node] = CACHESIM_MAX_INDEX_VALUE;
+   px_shadow->pui_next [ui_node] = px_shadow->ui_mru;
+   if (CACHESIM_MAX_INDEX_VALUE != px_shadow->ui_mru)
+      px_shadow->pui_prev [px_shadow->ui_mru] = ui_node;
+   else
+      px_shadow->ui_lru = ui_node;
+   px_shadow->ui_mru = ui_node;
+}
+
+/*
+ * References the RAM block in the fully associative LRU shadow of the cache
+ * and returns whether it was a hit there. A hit in the shadow of a block that
+ * missed in the real cache makes the miss a conflict miss. Both the lookup
+ * (hash map) and the LRU update (intrusive list) are O(1).
+ */
+static bool cachesim_shadow_access (
+   CACHESIM_SHADOW_CACHE_X *px_shadow,
+   uint64_t ull_ram_block)
+{
+   uint64_t *pull_node = NULL;
+   uint32_t ui_node = 0;
+   bool b_inserted = false;
+
+   pull_node = cachesim_hash_map_find (&(px_shadow->x_map), ull_ram_block);
+   if (NULL != pull_node)
+   {
+      ui_node = (uint32_t) *pull_node;
+      if (px_shadow->ui_mru != ui_node)
+      {
+         cachesim_shadow_unlink (px_shadow, ui_node);
+         cachesim_shadow_push_mru (px_shadow, ui_node);
+      }
+      return true;
+   }
+
+   if (px_shadow->ui_count < px_shadow->ui_capacity)
+   {
+      ui_node = px_shadow->ui_count++;
+   }
+   else
+   {
+      ui_node = px_shadow->ui_lru;
+      cachesim_shadow_unlink (px_shadow, ui_node);
+      cachesim_hash_map_remove (&(px_shadow->x_map),
+         px_shadow->pull_blocks [ui_node]);
+   }
+   px_shadow->pull_blocks [ui_node] = ull_ram_block;
+   pull_node = cachesim_hash_map_insert (&(px_shadow->x_map), ull_ram_block,
+      &b_inserted);
+   *pull_node = ui_node;
+   cachesim_shadow_push_mru (px_shadow, ui_node);
+   return false;
+}
+
+/*
+ * Computes where each region of the arena of a cache with the given geometry
+ * lives. The layout depends on nothing but the parameters.
+ */
+static void cachesim_set_arena_layout (
+   CACHESIM_CACHE_PARAMS_X *px_cache_params,
+   uint32_t ui_no_of_sets,
+   uint32_t ui_tag_stride,
+   CACHESIM_ARENA_LAYOUT_X *px_layout)
+{
+   size_t sz_offset = 0;
+   size_t sz_no_of_blocks = 0;
+   const CACHESIM_REPLACEMENT_POLICY_X *px_policy =
+      cachesim_replacement_policy (px_cache_params->e_replacement_policy);
+
+   sz_no_of_blocks = (size_t) ui_no_of_sets
+      * CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params);
+
+   sz_offset = CACHESIM_ROUND_UP(sizeof(CACHE_SET_X),
+      CACHESIM_CACHE_LINE_SIZE_BYTES);
+   px_layout->sz_sets_offset = sz_offset;
+   sz_offset += (size_t) ui_no_of_sets * sizeof(CACHE_SET_DATA_X);
+
+   sz_offset = CACHESIM_ROUND_UP(sz_offset, CACHESIM_CACHE_LINE_SIZE_BYTES);
+   px_layout->sz_blocks_offset = sz_offset;
+   sz_offset += sz_no_of_blocks * sizeof(CACHE_BLOCK_X);
+
+   sz_offset = CACHESIM_ROUND_UP(sz_offset, CACHESIM_CACHE_LINE_SIZE_BYTES);
+   px_layout->sz_tags_offset = sz_offset;
+   sz_offset += (size_t) ui_no_of_sets * ui_tag_stride * sizeof(uint64_t);
+
+   sz_offset = CACHESIM_ROUND_UP(sz_offset, CACHESIM_CACHE_LINE_SIZE_BYTES);
+   px_layout->sz_repl_offset = sz_offset;
+   px_layout->ui_repl_stride = 0;
+   if (NULL != px_policy->pfn_state_size)
+   {
+      px_layout->ui_repl_stride = (uint32_t) CACHESIM_ROUND_UP(
+         px_policy->pfn_state_size (
+            CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params)),
+         sizeof(uint16_t));
+   }
+   sz_offset += (size_t) ui_no_of_sets * px_layout->ui_repl_stride;
+
+   sz_offset = CACHESIM_ROUND_UP(sz_offset, CACHESIM_CACHE_LINE_SIZE_BYTES);
+   px_layout->sz_data_offset = sz_offset;
+   if (true == px_cache_params->b_store_data)
+   {
+      sz_offset += sz_no_of_blocks
+         * CACHESIM_BLOCK_SIZE_IN_BYTES(px_cache_params);
+   }
+
+   /*
+    * Shadow cache: map keys, map values, node blocks, node prev and next.
+    */
+   sz_offset = CACHESIM_ROUND_UP(sz_offset, CACHESIM_CACHE_LINE_SIZE_BYTES);
+   px_layout->sz_shadow_offset = sz_offset;
+   if (true == px_cache_params->b_classify_misses)
+   {
+      px_layout->ull_shadow_map_capacity = CACHESIM_HASH_MAP_MIN_CAPACITY;
+      while (px_layout->ull_shadow_map_capacity < (sz_no_of_blocks * 2))
+      {
+         px_layout->ull_shadow_map_capacity <<= 1;
+      }
+      sz_offset += (size_t) px_layout->ull_shadow_map_capacity
+         * 2 * sizeof(uint64_t);
+      sz_offset += sz_no_of_blocks * (sizeof(uint64_t) + 2 * sizeof(uint32_t));
+   }
+
+   px_layout->sz_used_size = sz_offset;
+   px_layout->sz_arena_size = CACHESIM_ROUND_UP(sz_offset,
+      (true == px_cache_params->b_huge_pages) ?
+         CACHESIM_ARENA_HUGE_PAGE_SIZE : CACHESIM_ARENA_PAGE_SIZE);
+}
+
+/*
+ * Allocates a zero filled arena. Huge pages are tried first when asked for:
+ * explicitly reserved ones (MAP_HUGETLB), then transparent huge pages.
+ */
+static void *cachesim_arena_alloc (
+   size_t sz_arena_size,
+   bool b_huge_pages,
+   CACHESIM_ARENA_TYPE_E *pe_arena_type)
+{
+   void *pv_arena = NULL;
+
+#ifndef _WIN32
+#ifdef MAP_HUGETLB
+   if (true == b_huge_pages)
+   {
+      pv_arena = mmap (NULL, sz_arena_size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (MAP_FAILED != pv_arena)
+      {
+         *pe_arena_type = eCACHESIM_ARENA_TYPE_HUGETLB;
+         goto CLEAN_RETURN;
+      }
+   }
+#endif
+   pv_arena = mmap (NULL, sz_arena_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (MAP_FAILED != pv_arena)
+   {
+#ifdef MADV_HUGEPAGE
+      if (true == b_huge_pages)
+      {
+         (void) madvise (pv_arena, sz_arena_size, MADV_HUGEPAGE);
+      }
+#endif
+      *pe_arena_type = eCACHESIM_ARENA_TYPE_MMAP;
+      goto CLEAN_RETURN;
+   }
+   pv_arena = NULL;
+#else
+   (void) b_huge_pages;
+   pv_arena = _aligned_malloc (sz_arena_size, CACHESIM_CACHE_LINE_SIZE_BYTES);
+   if (NULL != pv_arena)
+   {
+      (void) memset (pv_arena, 0x00, sz_arena_size);
+      *pe_arena_type = eCACHESIM_ARENA_TYPE_HEAP;
+   }
+#endif
+CLEAN_RETURN:
+   return pv_arena;
+}
+
+static void cachesim_arena_free (
+   void *pv_arena,
+   size_t sz_arena_size,
+   CACHESIM_ARENA_TYPE_E e_arena_type)
+{
+   switch (e_arena_type)
+   {
+#ifndef _WIN32
+   case eCACHESIM_ARENA_TYPE_MMAP:
+   case eCACHESIM_ARENA_TYPE_HUGETLB:
+      (void) munmap (pv_arena, sz_arena_size);
+      break;
+#else
+   case eCACHESIM_ARENA_TYPE_HEAP:
+      _aligned_free (pv_arena);
+      break;
+#endif
+   default:
+      break;
+   }
+}
+
+/*
+ * Spreads set indices over 32 bits, so that the sampled sets are scattered
+ * across the cache rather than forming a stride an access pattern could
+ * line up with.
+ */
+static inline uint32_t cachesim_sample_hash (uint32_t ui_set)
+{
+   ui_set ^= ui_set >> 16;
+   ui_set *= 0x7FEB352DU;
+   ui_set ^= ui_set >> 15;
+   ui_set *= 0x846CA68BU;
+   ui_set ^= ui_set >> 16;
+   return ui_set;
+}
+
+static inline bool cachesim_set_is_sampled (
+   const CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   return cachesim_sample_hash (ui_cache_set) <= px_cache->ui_sample_threshold;
+}
+
+/*
+ * Picks the sampled sets and allocates their counters. At least one set has
+ * to be picked.
+ */
+static CACHESIM_RET_E cachesim_set_sample_init (
+   CACHE_SET_X *px_cache)
+{
+   uint32_t ui_i = 0;
+
+   px_cache->ui_sample_threshold =
+      UINT32_MAX / px_cache->x_cache_params.ui_sample_sets;
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      px_cache->ui_sampled_sets += cachesim_set_is_sampled (px_cache, ui_i);
+   }
+   if (0 == px_cache->ui_sampled_sets)
+   {
+      fprintf (stderr, "Sampling 1 in %u of %u sets leaves no set to simulate\n",
+         px_cache->x_cache_params.ui_sample_sets,
+         px_cache->ui_configured_no_of_sets);
+      return eCACHESIM_RET_FAILURE;
+   }
+   px_cache->px_sample_counts = (CACHESIM_SAMPLE_COUNTS_X *) calloc (
+      px_cache->ui_configured_no_of_sets, sizeof (CACHESIM_SAMPLE_COUNTS_X));
+   return (NULL != px_cache->px_sample_counts) ?
+      eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+}
+
+/*
+ * Allocates the prefetcher state and a pollution filter of at least one
+ * entry per cache block.
+ */
+static CACHESIM_RET_E cachesim_set_prefetch_init (
+   CACHE_SET_X *px_cache)
+{
+   uint64_t ull_blocks = (uint64_t) px_cache->ui_configured_no_of_sets
+      * px_cache->ui_no_of_blocks_per_set;
+   uint64_t ull_entries = 1;
+
+   px_cache->px_prefetch = (CACHESIM_PREFETCH_X *) calloc (1,
+      sizeof (CACHESIM_PREFETCH_X));
+   if (NULL == px_cache->px_prefetch)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   while (ull_entries < ull_blocks)
+   {
+      ull_entries <<= 1;
+   }
+   px_cache->px_prefetch->pull_pollution = (uint64_t *) malloc (
+      (size_t) ull_entries * sizeof (uint64_t));
+   if (NULL == px_cache->px_prefetch->pull_pollution)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   (void) memset (px_cache->px_prefetch->pull_pollution, 0xFF,
+      (size_t) ull_entries * sizeof (uint64_t));
+   px_cache->px_prefetch->ui_pollution_mask = (uint32_t) (ull_entries - 1);
+   return eCACHESIM_RET_SUCCESS;
+}
+
+/*
+ * Allocates the per-set heatmap counters, and the per-block miss map when
+ * its file is asked for.
+ */
+static CACHESIM_RET_E cachesim_set_heatmap_init (
+   CACHE_SET_X *px_cache)
+{
+#ifdef CACHESIM_NO_HEATMAP
+   (void) px_cache;
+   fprintf (stderr, "Heatmaps are not available in this build "
+      "(CACHESIM_NO_HEATMAP)\n");
+   return eCACHESIM_RET_FAILURE;
+#else
+   px_cache->px_heatmap = (CACHESIM_HEATMAP_X *) calloc (1,
+      sizeof (CACHESIM_HEATMAP_X));
+   if (NULL == px_cache->px_heatmap)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   px_cache->px_heatmap->b_blocks =
+      (NULL != px_cache->x_cache_params.pc_heatmap_blocks_file);
+   px_cache->px_heatmap->px_sets = (CACHESIM_HEATMAP_SET_X *) calloc (
+      px_cache->ui_configured_no_of_sets, sizeof (CACHESIM_HEATMAP_SET_X));
+   return (NULL != px_cache->px_heatmap->px_sets) ?
+      eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+#endif
+}
+
+static CACHESIM_RET_E cachesim_set_mshr_init (
+   CACHE_SET_X *px_cache)
+{
+   px_cache->px_mshr = (CACHESIM_MSHR_X *) calloc (1, sizeof (CACHESIM_MSHR_X));
+   if (NULL == px_cache->px_mshr)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   px_cache->px_mshr->px_entries = (CACHESIM_MSHR_ENTRY_X *) calloc (
+      px_cache->x_cache_params.ui_mshrs, sizeof (CACHESIM_MSHR_ENTRY_X));
+   return (NULL != px_cache->px_mshr->px_entries) ?
+      eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+}
+
+static CACHESIM_RET_E cachesim_set_alloc_cache(
+   CACHE_SET_X **ppx_cache,
+   CACHESIM_CACHE_PARAMS_X *px_cache_params)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+   CACHE_SET_X *px_cache = NULL;
+   CACHE_SET_DATA_X *px_set_data = NULL;
+   CACHE_BLOCK_X *px_blocks = NULL;
+   uint32_t ui_no_of_sets = 0;
+   uint32_t ui_tag_stride = 0;
+   CACHESIM_ARENA_LAYOUT_X x_layout = {0};
+   CACHESIM_ARENA_TYPE_E e_arena_type = eCACHESIM_ARENA_TYPE_HEAP;
+   uint8_t *puc_arena = NULL;
+   const CACHESIM_REPLACEMENT_POLICY_X *px_policy = NULL;
+   bool b_pow2_ways = false;
+
+   if ((NULL == ppx_cache) || (NULL == px_cache_params))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * Calculate the number of sets in the cache. If the associativity is 1
+    * then (ui_cache_size_words / ui_block_size_words) will be the number of
+    * sets and (ui_cache_size_words / ui_block_size_words) / ui_associativity)
+    * otherwise.
+    */
+   if ((0 == px_cache_params->ui_associativity)
+      || (0 == px_cache_params->ui_block_size_words))
+   {
+      goto CLEAN_RETURN;
+   }
+   ui_no_of_sets = CACHESIM_NO_OF_SETS(px_cache_params);
+   if (0 == ui_no_of_sets)
+   {
+      goto CLEAN_RETURN;
+   }
+   if (px_cache_params->e_replacement_policy >= eCACHESIM_REPLACEMENT_POLICY_MAX)
+   {
+      goto CLEAN_RETURN;
+   }
+   px_policy = cachesim_replacement_policy (px_cache_params->e_replacement_policy);
+   (void) cachesim_log2_if_pow2 (px_cache_params->ui_associativity, &b_pow2_ways);
+   if ((true == px_policy->b_needs_pow2_ways) && (false == b_pow2_ways))
+   {
+      fprintf (stderr, "The %s replacement policy needs a power of 2 "
+         "associativity\n", px_policy->pc_name);
+      goto CLEAN_RETURN;
+   }
+   if ((eCACHESIM_REPLACEMENT_POLICY_LRU == px_cache_params->e_replacement_policy)
+      && (px_cache_params->ui_associativity > (UINT16_MAX + 1U)))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * Everything the cache needs is carved from one arena sized from the
+    * geometry, rather than allocated set by set and block by block.
+    */
+   ui_tag_stride = CACHESIM_ROUND_UP(
+      CACHESIM_NO_OF_BLOCKS_PER_SET(px_cache_params),
+      CACHESIM_TAGS_PER_CACHE_LINE);
+   cachesim_set_arena_layout (px_cache_params, ui_no_of_sets, ui_tag_stride,
+      &x_layout);
+   puc_arena = cachesim_arena_alloc (x_layout.sz_arena_size,
+      px_cache_params->b_huge_pages, &e_arena_type);
+   if (NULL == puc_arena)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   px_cache = (CACHE_SET_X *) puc_arena;
+   px_cache->e_arena_type = e_arena_type;
+   px_cache->sz_arena_size = x_layout.sz_arena_size;
+
+   (void) memmove (&(px_cache->x_cache_params), px_cache_params,
+      sizeof (px_cache->x_cache_params));
+
+   px_cache->ui_configured_no_of_sets = ui_no_of_sets;
+
+   /*
+    * Calculate number of blocks per set. This is directly related to
+    * associativity.
+    */
+   px_cache->ui_no_of_blocks_per_set =
+      CACHESIM_NO_OF_BLOCKS_PER_SET(&(px_cache->x_cache_params));
+
+   px_cache->ui_set_mask = ui_no_of_sets - 1;
+   (void) cachesim_log2_if_pow2 (ui_no_of_sets, &(px_cache->b_pow2_sets));
+   px_cache->ui_block_shift = cachesim_log2_if_pow2 (
+      px_cache_params->ui_block_size_words, &(px_cache->b_pow2_block));
+   px_cache->ull_max_ram_block = CACHESIM_MAX_ADDRESS(
+         (0 == px_cache_params->ui_address_bits) ?
+            CACHESIM_DEFAULT_ADDRESS_BITS : px_cache_params->ui_address_bits)
+      / CACHESIM_BLOCK_SIZE_IN_BYTES(px_cache_params);
+
+   px_cache->px_sets = (CACHE_SET_DATA_X *) (puc_arena + x_layout.sz_sets_offset);
+   px_blocks = (CACHE_BLOCK_X *) (puc_arena + x_layout.sz_blocks_offset);
+   px_cache->pull_tags = (uint64_t *) (puc_arena + x_layout.sz_tags_offset);
+   px_cache->ui_tag_stride = ui_tag_stride;
+   px_cache->ui_tag_scan_len = CACHESIM_ROUND_UP(
+      px_cache->ui_no_of_blocks_per_set, CACHESIM_TAGS_PER_VECTOR);
+   px_cache->puc_repl_state = puc_arena + x_layout.sz_repl_offset;
+   px_cache->ui_repl_stride = x_layout.ui_repl_stride;
+   px_cache->ull_random_state = CACHESIM_RANDOM_SEED;
+   if (true == px_cache_params->b_store_data)
+   {
+      px_cache->puc_data = puc_arena + x_layout.sz_data_offset;
+   }
+
+   if (true == px_cache_params->b_classify_misses)
+   {
+      cachesim_shadow_bind (&(px_cache->x_shadow),
+         puc_arena + x_layout.sz_shadow_offset,
+         x_layout.ull_shadow_map_capacity,
+         ui_no_of_sets * px_cache->ui_no_of_blocks_per_set);
+   }
+
+   /*
+    * All tags start out invalid, the padding at the end of every row stays
+    * invalid for the lifetime of the cache.
+    */
+   (void) memset (px_cache->pull_tags, 0xFF,
+      (size_t) ui_no_of_sets * ui_tag_stride * sizeof(uint64_t));
+
+   // cachesim_print_cache_params (px_cache);
+   /*
+    * Initialize each set of the cache. The blocks need no initialization, the
+    * arena comes zero filled.
+    */
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      px_set_data = &(px_cache->px_sets[ui_i]);
+      px_set_data->ui_set_idx = ui_i;
+      px_set_data->ui_last_fetched_block = CACHESIM_MAX_INDEX_VALUE;
+      px_set_data->px_blocks =
+         px_blocks + ((size_t) ui_i * px_cache->ui_no_of_blocks_per_set);
+      if (NULL != px_policy->pfn_init_set)
+      {
+         px_policy->pfn_init_set (
+            px_cache->puc_repl_state + ((size_t) ui_i * px_cache->ui_repl_stride),
+            px_cache->ui_no_of_blocks_per_set);
+      }
+   }
+
+   if ((px_cache_params->ui_sample_sets > 1)
+      && (eCACHESIM_RET_SUCCESS != cachesim_set_sample_init (px_cache)))
+   {
+      (void) cachesim_set_free_cache (px_cache);
+      goto CLEAN_RETURN;
+   }
+   if ((eCACHESIM_PREFETCHER_NONE != px_cache_params->e_prefetcher)
+      && (eCACHESIM_RET_SUCCESS != cachesim_set_prefetch_init (px_cache)))
+   {
+      (void) cachesim_set_free_cache (px_cache);
+      goto CLEAN_RETURN;
+   }
+   if (((NULL != px_cache_params->pc_heatmap_file)
+         || (NULL != px_cache_params->pc_heatmap_blocks_file))
+      && (eCACHESIM_RET_SUCCESS != cachesim_set_heatmap_init (px_cache)))
+   {
+      (void) cachesim_set_free_cache (px_cache);
+      goto CLEAN_RETURN;
+   }
+   if ((0 != px_cache_params->ui_mshrs)
+      && (eCACHESIM_RET_SUCCESS != cachesim_set_mshr_init (px_cache)))
+   {
+      (void) cachesim_set_free_cache (px_cache);
+      goto CLEAN_RETURN;
+   }
+
+   *ppx_cache = px_cache;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_free_cache(
+   CACHE_SET_X *px_cache)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+
+   if (NULL == px_cache)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   cachesim_event_log_close (px_cache);
+   free (px_cache->px_sample_counts);
+   if (NULL != px_cache->px_prefetch)
+   {
+      free (px_cache->px_prefetch->pull_pollution);
+      free (px_cache->px_prefetch);
+   }
+   if (NULL != px_cache->px_heatmap)
+   {
+      cachesim_hash_map_deinit (&(px_cache->px_heatmap->x_block_misses));
+      free (px_cache->px_heatmap->px_sets);
+      free (px_cache->px_heatmap);
+   }
+   if (NULL != px_cache->px_mshr)
+   {
+      free (px_cache->px_mshr->px_entries);
+      free (px_cache->px_mshr);
+   }
+
+   /*
+    * The cache structure lives in its own arena, so releasing the arena
+    * releases everything else.
+    */
+   cachesim_arena_free (px_cache, px_cache->sz_arena_size,
+      px_cache->e_arena_type);
+   px_cache = NULL;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Maps a memory word index to the RAM block holding it.
+ */
+static inline uint64_t cachesim_set_ram_block (
+   const CACHE_SET_X *px_cache,
+   uint64_t ull_index)
+{
+   if (true == px_cache->b_pow2_block)
+   {
+      return ull_index >> px_cache->ui_block_shift;
+   }
+   return CACHESIM_DIRECT_MAP_MEMORY_TO_RAM_BLOCK (ull_index,
+      px_cache->x_cache_params.ui_block_size_words);
+}
+
+/*
+ * Maps a RAM block to the only cache set it can be placed in.
+ */
+static inline uint32_t cachesim_set_cache_set (
+   const CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block)
+{
+   if (true == px_cache->b_pow2_sets)
+   {
+      return (uint32_t) ull_ram_block & px_cache->ui_set_mask;
+   }
+   return (uint32_t) CACHESIM_SET_MAP_RAM_BLOCK_TO_CACHE_SET (ull_ram_block,
+      px_cache->ui_configured_no_of_sets);
+}
+
+static inline uint64_t *cachesim_set_tags (
+   const CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   return px_cache->pull_tags + ((size_t) ui_cache_set * px_cache->ui_tag_stride);
+}
+
+static inline uint32_t cachesim_count_trailing_zeros (uint32_t ui_mask)
+{
+#ifdef _MSC_VER
+   unsigned long ul_idx = 0;
+   _BitScanForward (&ul_idx, ui_mask);
+   return (uint32_t) ul_idx;
+#else
+   return (uint32_t) __builtin_ctz (ui_mask);
+#endif
+}
+
+/*
+ * Compares the tag against every way of one set and returns the matching
+ * way, CACHESIM_MAX_INDEX_VALUE if there is none. pull_tags must be cache line
+ * aligned and ui_scan_len a multiple of CACHESIM_TAGS_PER_VECTOR. The ways
+ * are compared 4 at a time with AVX2, 2 at a time with SSE2 and one at a time
+ * otherwise. SSE2 has no 64-bit compare, so both halves of a tag must match.
+ */
+static inline uint32_t cachesim_set_find_way (
+   const uint64_t *pull_tags,
+   uint32_t ui_scan_len,
+   uint64_t ull_tag)
+{
+   uint32_t ui_way = 0;
+   uint32_t ui_mask = 0;
+#if defined(__AVX2__)
+   __m256i x_key = _mm256_set1_epi64x ((long long) ull_tag);
+   __m256i x_tags;
+
+   for (ui_way = 0; ui_way < ui_scan_len; ui_way += 4)
+   {
+      x_tags = _mm256_load_si256 ((const __m256i *) (pull_tags + ui_way));
+      ui_mask = (uint32_t) _mm256_movemask_pd (
+         _mm256_castsi256_pd (_mm256_cmpeq_epi64 (x_tags, x_key)));
+      if (0 != ui_mask)
+      {
+         return ui_way + cachesim_count_trailing_zeros (ui_mask);
+      }
+   }
+#elif defined(__SSE2__) || defined(_M_X64)
+   __m128i x_key = _mm_set1_epi64x ((long long) ull_tag);
+   __m128i x_equal;
+
+   for (ui_way = 0; ui_way < ui_scan_len; ui_way += 2)
+   {
+      x_equal = _mm_cmpeq_epi32 (
+         _mm_load_si128 ((const __m128i *) (pull_tags + ui_way)), x_key);
+      x_equal = _mm_and_si128 (x_equal,
+         _mm_shuffle_epi32 (x_equal, _MM_SHUFFLE (2, 3, 0, 1)));
+      ui_mask = (uint32_t) _mm_movemask_pd (_mm_castsi128_pd (x_equal));
+      if (0 != ui_mask)
+      {
+         return ui_way + cachesim_count_trailing_zeros (ui_mask);
+      }
+   }
+#else
+   (void) ui_mask;
+   for (ui_way = 0; ui_way < ui_scan_len; ui_way++)
+   {
+      if (ull_tag == pull_tags[ui_way])
+      {
+         return ui_way;
+      }
+   }
+#endif
+   return CACHESIM_MAX_INDEX_VALUE;
+}
+
+static inline uint64_t cachesim_set_next_random (
+   CACHE_SET_X *px_cache)
+{
+   /*
+    * xorshift64*, seeded per cache so that runs are reproducible.
+    */
+   px_cache->ull_random_state ^= px_cache->ull_random_state >> 12;
+   px_cache->ull_random_state ^= px_cache->ull_random_state << 25;
+   px_cache->ull_random_state ^= px_cache->ull_random_state >> 27;
+   return px_cache->ull_random_state * 0x2545F4914F6CDD1DULL;
+}
+
+static inline uint8_t *cachesim_set_repl_state (
+   const CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   return px_cache->puc_repl_state
+      + ((size_t) ui_cache_set * px_cache->ui_repl_stride);
+}
+
+static inline bool cachesim_set_way_is_pinned (
+   const CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   return px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.b_is_pinned;
+}
+
+/*
+ * First unpinned way at or after ui_way (wrapping), CACHESIM_MAX_INDEX_VALUE
+ * if every way of the set is pinned.
+ */
+static uint32_t cachesim_set_next_unpinned_way (
+   const CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   uint32_t ui_i = 0;
+   uint32_t ui_ways = px_cache->ui_no_of_blocks_per_set;
+
+   for (ui_i = 0; ui_i < ui_ways; ui_i++, ui_way = (ui_way + 1) % ui_ways)
+   {
+      if (false == cachesim_set_way_is_pinned (px_cache, ui_cache_set, ui_way))
+      {
+         return ui_way;
+      }
+   }
+   return CACHESIM_MAX_INDEX_VALUE;
+}
+
+/*
+ * LRU: a 16-bit recency rank per way, 0 for the most recently used way and
+ * (ways - 1) for the least recently used one.
+ */
+static size_t cachesim_repl_lru_state_size (uint32_t ui_ways)
+{
+   return (size_t) ui_ways * sizeof(uint16_t);
+}
+
+static void cachesim_repl_lru_init (uint8_t *puc_state, uint32_t ui_ways)
+{
+   uint16_t *pus_rank = (uint16_t *) puc_state;
+   uint32_t ui_way = 0;
+
+   for (ui_way = 0; ui_way < ui_ways; ui_way++)
+   {
+      pus_rank [ui_way] = (uint16_t) ui_way;
+   }
+}
+
+static inline void cachesim_repl_lru_touch (
+   uint8_t *puc_state,
+   uint32_t ui_ways,
+   uint32_t ui_way)
+{
+   uint16_t *pus_rank = (uint16_t *) puc_state;
+   uint16_t us_rank = pus_rank [ui_way];
+   uint32_t ui_i = 0;
+
+   for (ui_i = 0; ui_i < ui_ways; ui_i++)
+   {
+      pus_rank [ui_i] += (pus_rank [ui_i] < us_rank);
+   }
+   pus_rank [ui_way] = 0;
+}
+
+static uint32_t cachesim_repl_lru_victim (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   uint16_t *pus_rank = (uint16_t *) cachesim_set_repl_state (px_cache,
+      ui_cache_set);
+   uint32_t ui_victim = CACHESIM_MAX_INDEX_VALUE;
+   uint32_t ui_way = 0;
+
+   for (ui_way = 0; ui_way < px_cache->ui_no_of_blocks_per_set; ui_way++)
+   {
+      if ((false == cachesim_set_way_is_pinned (px_cache, ui_cache_set, ui_way))
+         && ((CACHESIM_MAX_INDEX_VALUE == ui_victim)
+            || (pus_rank [ui_way] > pus_rank [ui_victim])))
+      {
+         ui_victim = ui_way;
+      }
+   }
+   return ui_victim;
+}
+
+static void cachesim_repl_lru_fill (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   cachesim_repl_lru_touch (cachesim_set_repl_state (px_cache, ui_cache_set),
+      px_cache->ui_no_of_blocks_per_set, ui_way);
+}
+
+/*
+ * Tree PLRU: (ways - 1) bits per set forming a binary tree in heap order
+ * (children of node N are 2N+1 and 2N+2). A bit points at the half of its
+ * subtree to evict from: 0 left, 1 right. Needs a power of 2 associativity.
+ */
+static size_t cachesim_repl_plru_state_size (uint32_t ui_ways)
+{
+   return ((size_t) ui_ways + 7) / 8;
+}
+
+static inline void cachesim_repl_plru_touch (
+   uint8_t *puc_state,
+   uint32_t ui_ways,
+   uint32_t ui_way)
+{
+   uint32_t ui_node = 0;
+   uint32_t ui_half = ui_ways / 2;
+   uint32_t ui_lo = 0;
+
+   /*
+    * Walk down to the leaf, pointing every node on the path away from it.
+    */
+   while (ui_half > 0)
+   {
+      if (ui_way < (ui_lo + ui_half))
+      {
+         puc_state [ui_node / 8] |= (uint8_t) (1U << (ui_node % 8));
+         ui_node = (2 * ui_node) + 1;
+      }
+      else
+      {
+         puc_state [ui_node / 8] &= (uint8_t) ~(1U << (ui_node % 8));
+         ui_node = (2 * ui_node) + 2;
+         ui_lo += ui_half;
+      }
+      ui_half /= 2;
+   }
+}
+
+static uint32_t cachesim_repl_plru_victim (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   uint8_t *puc_state = cachesim_set_repl_state (px_cache, ui_cache_set);
+   uint32_t ui_node = 0;
+   uint32_t ui_half = px_cache->ui_no_of_blocks_per_set / 2;
+   uint32_t ui_lo = 0;
+
+   while (ui_half > 0)
+   {
+      if (0 == (puc_state [ui_node / 8] & (1U << (ui_node % 8))))
+      {
+         ui_node = (2 * ui_node) + 1;
+      }
+      else
+      {
+         ui_node = (2 * ui_node) + 2;
+         ui_lo += ui_half;
+      }
+      ui_half /= 2;
+   }
+   return cachesim_set_next_unpinned_way (px_cache, ui_cache_set, ui_lo);
+}
+
+static void cachesim_repl_plru_fill (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   cachesim_repl_plru_touch (cachesim_set_repl_state (px_cache, ui_cache_set),
+      px_cache->ui_no_of_blocks_per_set, ui_way);
+}
+
+/*
+ * SRRIP/BRRIP: a 2-bit re-reference prediction value per way, 4 ways per
+ * byte. A hit predicts a near re-reference (0); the victim is a way
+ * predicted to be re-referenced in the distant future (3), ageing the set
+ * until there is one. SRRIP inserts with a long prediction (2), BRRIP
+ * mostly with a distant one (3) and with a long one once every
+ * CACHESIM_BRRIP_LONG_INSERTION_PERIOD fills on average.
+ */
+static size_t cachesim_repl_rrip_state_size (uint32_t ui_ways)
+{
+   return ((size_t) ui_ways + 3) / 4;
+}
+
+static inline uint32_t cachesim_repl_rrpv_get (
+   const uint8_t *puc_state,
+   uint32_t ui_way)
+{
+   return (puc_state [ui_way / 4] >> ((ui_way % 4) * 2)) & 0x3;
+}
+
+static inline void cachesim_repl_rrpv_set (
+   uint8_t *puc_state,
+   uint32_t ui_way,
+   uint32_t ui_rrpv)
+{
+   uint32_t ui_shift = (ui_way % 4) * 2;
+
+   puc_state [ui_way / 4] = (uint8_t) ((puc_state [ui_way / 4]
+      & ~(0x3U << ui_shift)) | (ui_rrpv << ui_shift));
+}
+
+static void cachesim_repl_rrip_init (uint8_t *puc_state, uint32_t ui_ways)
+{
+   (void) memset (puc_state, 0xFF, cachesim_repl_rrip_state_size (ui_ways));
+}
+
+static uint32_t cachesim_repl_rrip_victim (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   uint8_t *puc_state = cachesim_set_repl_state (px_cache, ui_cache_set);
+   uint32_t ui_ways = px_cache->ui_no_of_blocks_per_set;
+   uint32_t ui_way = 0;
+   uint32_t ui_max_rrpv = 0;
+   uint32_t ui_rrpv = 0;
+   uint32_t ui_victim = CACHESIM_MAX_INDEX_VALUE;
+
+   for (ui_way = 0; ui_way < ui_ways; ui_way++)
+   {
+      if (true == cachesim_set_way_is_pinned (px_cache, ui_cache_set, ui_way))
+      {
+         continue;
+      }
+      ui_rrpv = cachesim_repl_rrpv_get (puc_state, ui_way);
+      if ((CACHESIM_MAX_INDEX_VALUE == ui_victim) || (ui_rrpv > ui_max_rrpv))
+      {
+         ui_victim = ui_way;
+         ui_max_rrpv = ui_rrpv;
+      }
+   }
+   /*
+    * Ageing every way until the first candidate reaches 3 is the same as
+    * adding the distance of the oldest candidate to 3 to all of them.
+    */
+   if ((CACHESIM_MAX_INDEX_VALUE != ui_victim) && (ui_max_rrpv < 3))
+   {
+      for (ui_way = 0; ui_way < ui_ways; ui_way++)
+      {
+         ui_rrpv = cachesim_repl_rrpv_get (puc_state, ui_way) + (3 - ui_max_rrpv);
+         cachesim_repl_rrpv_set (puc_state, ui_way, (ui_rrpv > 3) ? 3 : ui_rrpv);
+      }
+   }
+   return ui_victim;
+}
+
+static void cachesim_repl_srrip_fill (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   cachesim_repl_rrpv_set (cachesim_set_repl_state (px_cache, ui_cache_set),
+      ui_way, 2);
+}
+
+static void cachesim_repl_brrip_fill (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   uint32_t ui_rrpv = 3;
+
+   if (0 == (cachesim_set_next_random (px_cache)
+      % CACHESIM_BRRIP_LONG_INSERTION_PERIOD))
+   {
+      ui_rrpv = 2;
+   }
+   cachesim_repl_rrpv_set (cachesim_set_repl_state (px_cache, ui_cache_set),
+      ui_way, ui_rrpv);
+}
+
+/*
+ * Random: no state, the victim is drawn from the per cache generator.
+ */
+static uint32_t cachesim_repl_random_victim (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   return cachesim_set_next_unpinned_way (px_cache, ui_cache_set,
+      (uint32_t) (cachesim_set_next_random (px_cache)
+         % px_cache->ui_no_of_blocks_per_set));
+}
+
+/*
+ * LFU: a saturating 16-bit reference count per way. The victim is the least
+ * referenced way, the lowest one on a tie.
+ */
+static size_t cachesim_repl_lfu_state_size (uint32_t ui_ways)
+{
+   return (size_t) ui_ways * sizeof(uint16_t);
+}
+
+static inline void cachesim_repl_lfu_touch (
+   uint8_t *puc_state,
+   uint32_t ui_way)
+{
+   uint16_t *pus_count = (uint16_t *) puc_state;
+
+   pus_count [ui_way] += (UINT16_MAX != pus_count [ui_way]);
+}
+
+static uint32_t cachesim_repl_lfu_victim (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   uint16_t *pus_count = (uint16_t *) cachesim_set_repl_state (px_cache,
+      ui_cache_set);
+   uint32_t ui_victim = CACHESIM_MAX_INDEX_VALUE;
+   uint32_t ui_way = 0;
+
+   for (ui_way = 0; ui_way < px_cache->ui_no_of_blocks_per_set; ui_way++)
+   {
+      if ((false == cachesim_set_way_is_pinned (px_cache, ui_cache_set, ui_way))
+         && ((CACHESIM_MAX_INDEX_VALUE == ui_victim)
+            || (pus_count [ui_way] < pus_count [ui_victim])))
+      {
+         ui_victim = ui_way;
+      }
+   }
+   return ui_victim;
+}
+
+static void cachesim_repl_lfu_fill (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   uint16_t *pus_count = (uint16_t *) cachesim_set_repl_state (px_cache,
+      ui_cache_set);
+
+   pus_count [ui_way] = 1;
+}
+
+/*
+ * The replacement policies, indexed by CACHESIM_REPLACEMENT_POLICY_E. Only
+ * the miss path goes through this table; hits update the state through
+ * cachesim_set_repl_touch which switches on the policy directly. FIFO keeps
+ * its queue head in CACHE_SET_DATA_X and is handled by the fetch itself.
+ */
+static const CACHESIM_REPLACEMENT_POLICY_X gxa_replacement_policies [] =
+{
+   /* eCACHESIM_REPLACEMENT_POLICY_FIFO */
+   { "fifo",   false, NULL, NULL, NULL, NULL },
+   /* eCACHESIM_REPLACEMENT_POLICY_LRU */
+   { "lru",    false, cachesim_repl_lru_state_size, cachesim_repl_lru_init,
+     cachesim_repl_lru_victim, cachesim_repl_lru_fill },
+   /* eCACHESIM_REPLACEMENT_POLICY_PLRU */
+   { "plru",   true, cachesim_repl_plru_state_size, NULL,
+     cachesim_repl_plru_victim, cachesim_repl_plru_fill },
+   /* eCACHESIM_REPLACEMENT_POLICY_SRRIP */
+   { "srrip",  false, cachesim_repl_rrip_state_size, cachesim_repl_rrip_init,
+     cachesim_repl_rrip_victim, cachesim_repl_srrip_fill },
+   /* eCACHESIM_REPLACEMENT_POLICY_BRRIP */
+   { "brrip",  false, cachesim_repl_rrip_state_size, cachesim_repl_rrip_init,
+     cachesim_repl_rrip_victim, cachesim_repl_brrip_fill },
+   /* eCACHESIM_REPLACEMENT_POLICY_RANDOM */
+   { "random", false, NULL, NULL, cachesim_repl_random_victim, NULL },
+   /* eCACHESIM_REPLACEMENT_POLICY_LFU */
+   { "lfu",    false, cachesim_repl_lfu_state_size, NULL,
+     cachesim_repl_lfu_victim, cachesim_repl_lfu_fill },
+};
+
+static const CACHESIM_REPLACEMENT_POLICY_X *cachesim_replacement_policy (
+   CACHESIM_REPLACEMENT_POLICY_E e_policy)
+{
+   return &(gxa_replacement_policies [e_policy]);
+}
+
+/*
+ * Updates the replacement state of a set for a hit on one of its ways.
+ */
+static inline void cachesim_set_repl_touch (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   uint32_t ui_way)
+{
+   switch (px_cache->x_cache_params.e_replacement_policy)
+   {
+   case eCACHESIM_REPLACEMENT_POLICY_LRU:
+      cachesim_repl_lru_touch (cachesim_set_repl_state (px_cache, ui_cache_set),
+         px_cache->ui_no_of_blocks_per_set, ui_way);
+      break;
+   case eCACHESIM_REPLACEMENT_POLICY_PLRU:
+      cachesim_repl_plru_touch (cachesim_set_repl_state (px_cache, ui_cache_set),
+         px_cache->ui_no_of_blocks_per_set, ui_way);
+      break;
+   case eCACHESIM_REPLACEMENT_POLICY_SRRIP:
+   case eCACHESIM_REPLACEMENT_POLICY_BRRIP:
+      cachesim_repl_rrpv_set (cachesim_set_repl_state (px_cache, ui_cache_set),
+         ui_way, 0);
+      break;
+   case eCACHESIM_REPLACEMENT_POLICY_LFU:
+      cachesim_repl_lfu_touch (cachesim_set_repl_state (px_cache, ui_cache_set),
+         ui_way);
+      break;
+   default:
+      break;
+   }
+}
+
+CACHESIM_RET_E cachesim_replacement_policy_from_name (
+   const char *pc_name,
+   CACHESIM_REPLACEMENT_POLICY_E *pe_policy)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+
+   for (ui_i = 0; ui_i < eCACHESIM_REPLACEMENT_POLICY_MAX; ui_i++)
+   {
+      if (0 == strcmp (pc_name, gxa_replacement_policies [ui_i].pc_name))
+      {
+         *pe_policy = (CACHESIM_REPLACEMENT_POLICY_E) ui_i;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+         break;
+      }
+   }
+   return e_ret_val;
+}
+
+/*
+ * Latency of an access under non-blocking timing, from the cycle it is issued
+ * in to the cycle its data is there. A miss that waits for a free register
+ * counts the wait too.
+ */
+static void cachesim_set_mshr_account (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   bool b_cache_hit,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   const CACHESIM_CACHE_PARAMS_X *px_params = &(px_cache->x_cache_params);
+   CACHESIM_MSHR_X *px_mshr = px_cache->px_mshr;
+   CACHESIM_MSHR_ENTRY_X *px_entry = NULL;
+   CACHESIM_MSHR_ENTRY_X *px_merge = NULL;
+   CACHESIM_MSHR_ENTRY_X *px_free = NULL;
+   CACHESIM_MSHR_ENTRY_X *px_earliest = NULL;
+   uint64_t ull_ram_block = cachesim_set_ram_block (px_cache, ull_index);
+   uint64_t ull_issue = 0;
+   uint64_t ull_miss_latency = 0;
+   uint64_t ull_latency = px_params->ui_hit_latency;
+   uint32_t ui_i = 0;
+
+   if (px_mshr->ui_issued == px_params->ui_issue_rate)
+   {
+      px_mshr->ull_now++;
+      px_mshr->ui_issued = 0;
+   }
+   px_mshr->ui_issued++;
+   ull_issue = px_mshr->ull_now;
+
+   for (ui_i = 0; ui_i < px_params->ui_mshrs; ui_i++)
+   {
+      px_entry = &(px_mshr->px_entries [ui_i]);
+      if (px_entry->ull_ready <= ull_issue)
+      {
+         px_free = (NULL == px_free) ? px_entry : px_free;
+      }
+      else if (px_entry->ull_ram_block == ull_ram_block)
+      {
+         px_merge = px_entry;
+         break;
+      }
+      else if ((NULL == px_earliest) || (px_entry->ull_ready < px_earliest->ull_ready))
+      {
+         px_earliest = px_entry;
+      }
+   }
+
+   if (NULL != px_merge)
+   {
+      /*
+       * Secondary miss, or a hit on a block that is still on its way.
+       */
+      px_mshr->ull_merged_misses++;
+      if ((px_merge->ull_ready - ull_issue) > ull_latency)
+      {
+         ull_latency = px_merge->ull_ready - ull_issue;
+      }
+   }
+   else if (false == b_cache_hit)
+   {
+      if (NULL == px_free)
+      {
+         px_mshr->ull_full_stalls++;
+         px_mshr->ull_full_stall_cycles += px_earliest->ull_ready - ull_issue;
+         px_mshr->ull_now = px_earliest->ull_ready;
+         px_mshr->ui_issued = 1;
+         px_free = px_earliest;
+      }
+      ull_miss_latency = (uint64_t) px_params->ui_hit_latency
+         + px_params->ui_miss_penalty + px_params->ui_memory_latency;
+      px_free->ull_ram_block = ull_ram_block;
+      px_free->ull_ready = px_mshr->ull_now + ull_miss_latency;
+      px_mshr->ull_primary_misses++;
+      px_mshr->ull_miss_cycles += ull_miss_latency;
+      if (px_mshr->ull_now >= px_mshr->ull_busy_until)
+      {
+         px_mshr->ull_busy_cycles += ull_miss_latency;
+      }
+      else if (px_free->ull_ready > px_mshr->ull_busy_until)
+      {
+         px_mshr->ull_busy_cycles += px_free->ull_ready - px_mshr->ull_busy_until;
+      }
+      if (px_free->ull_ready > px_mshr->ull_busy_until)
+      {
+         px_mshr->ull_busy_until = px_free->ull_ready;
+      }
+      ull_latency = px_free->ull_ready - ull_issue;
+   }
+   if ((ull_issue + ull_latency) > px_mshr->ull_end)
+   {
+      px_mshr->ull_end = ull_issue + ull_latency;
+   }
+   cachesim_latency_account (px_stats, ull_latency, px_params->ui_hit_latency);
+}
+
+/*
+ * Heatmap counts of an access. A cache without a heatmap pays one test per
+ * access here; building with CACHESIM_NO_HEATMAP defined removes it.
+ */
+static inline void cachesim_set_heatmap_account (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   uint32_t ui_cache_set,
+   bool b_cache_hit)
+{
+#ifndef CACHESIM_NO_HEATMAP
+   CACHESIM_HEATMAP_X *px_heatmap = px_cache->px_heatmap;
+   uint64_t *pull_misses = NULL;
+   bool b_inserted = false;
+
+   if (NULL == px_heatmap)
+   {
+      return;
+   }
+   if (true == b_cache_hit)
+   {
+      px_heatmap->px_sets [ui_cache_set].ull_hits++;
+      return;
+   }
+   px_heatmap->px_sets [ui_cache_set].ull_misses++;
+   if (true == px_heatmap->b_blocks)
+   {
+      pull_misses = cachesim_hash_map_insert (&(px_heatmap->x_block_misses),
+         cachesim_set_ram_block (px_cache, ull_index), &b_inserted);
+      if (NULL != pull_misses)
+      {
+         (*pull_misses)++;
+      }
+   }
+#else
+   (void) px_cache;
+   (void) ull_index;
+   (void) ui_cache_set;
+   (void) b_cache_hit;
+#endif
+}
+
+static inline void cachesim_set_heatmap_evict (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+#ifndef CACHESIM_NO_HEATMAP
+   if (NULL != px_cache->px_heatmap)
+   {
+      px_cache->px_heatmap->px_sets [ui_cache_set].ull_evictions++;
+   }
+#else
+   (void) px_cache;
+   (void) ui_cache_set;
+#endif
+}
+
+/*
+ * The way a miss to the set is placed in: an invalid way if there is one, so
+ * that ways emptied by invalidations are reused before anything valid is
+ * evicted, else the victim of the replacement policy. CACHESIM_MAX_INDEX_VALUE
+ * if every way is pinned.
+ *
+ * The last fetched block keeps track of the head of the FIFO queue. Module
+ * arithmetic is used simulate FIFO. So if its a 4-way associative then the
+ * following is the sequence of blocks in the set that will be replaced:
+ * (initial) 0 - 1 - 2 - 3 - 0 - 1 - 2 - 3 - 0 - ...
+ * The head only moves when a valid block is replaced. A set filled from empty
+ * fills its ways in the same order, so the sequence is unchanged as long as
+ * nothing is invalidated.
+ */
+static uint32_t cachesim_set_fill_way (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set)
+{
+   CACHE_SET_DATA_X *px_cache_set_data = &(px_cache->px_sets[ui_cache_set]);
+   uint32_t ui_way = 0;
+   uint32_t ui_try_counter = 0;
+
+   ui_way = cachesim_set_find_way (cachesim_set_tags (px_cache, ui_cache_set),
+      px_cache->ui_tag_scan_len, CACHESIM_INVALID_TAG);
+   if ((ui_way < px_cache->ui_no_of_blocks_per_set)
+      && (false == cachesim_set_way_is_pinned (px_cache, ui_cache_set, ui_way)))
+   {
+      return ui_way;
+   }
+   if (eCACHESIM_REPLACEMENT_POLICY_FIFO != px_cache->x_cache_params.e_replacement_policy)
+   {
+      return cachesim_replacement_policy (
+         px_cache->x_cache_params.e_replacement_policy)->pfn_victim (px_cache,
+            ui_cache_set);
+   }
+   for (ui_try_counter = 0; ui_try_counter < px_cache->ui_no_of_blocks_per_set;
+      ui_try_counter++)
+   {
+      px_cache_set_data->ui_last_fetched_block =
+         (CACHESIM_MAX_INDEX_VALUE == px_cache_set_data->ui_last_fetched_block) ? 0 :
+         ((px_cache_set_data->ui_last_fetched_block + 1)
+            % px_cache->ui_no_of_blocks_per_set);
+      ui_way = px_cache_set_data->ui_last_fetched_block;
+      if (false == cachesim_set_way_is_pinned (px_cache, ui_cache_set, ui_way))
+      {
+         return ui_way;
+      }
+   }
+   return CACHESIM_MAX_INDEX_VALUE;
+}
+
+static CACHESIM_RET_E cachesim_set_fetch_data_to_cache_v2(
+   CACHE_SET_X *px_cache,
+   uint64_t ull_data_index,
+   bool b_pin_block,
+   uint32_t *pui_cache_set,
+   uint32_t *pui_block_idx,
+   uint64_t *pull_evicted_block,
+   bool *pb_evicted_dirty)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint64_t ull_ram_block = 0;
+   uint32_t ui_cache_set = 0;
+   CACHE_SET_DATA_X *px_cache_set_data = NULL;
+   CACHE_BLOCK_X *px_cache_block = NULL;
+   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
+   uint32_t ui_fetch_index = 0;
+   const CACHESIM_REPLACEMENT_POLICY_X *px_policy = NULL;
+
+   if ((NULL == px_cache) || (NULL == pui_cache_set))
+   {
+      goto CLEAN_RETURN;
+   }
+   px_policy = cachesim_replacement_policy (
+      px_cache->x_cache_params.e_replacement_policy);
+
+   /*
+    * Map the memory word given the index to the block in the RAM. The RAM block
+    * for this dataset is assumed to start from 0th index.
+    */
+   ull_ram_block = cachesim_set_ram_block (px_cache, ull_data_index);
+
+   /*
+    * Map the RAM block to the corresponding cache set. This will only determine
+    * cache set in the cache. The code follows for the FIFO implementation
+    * to kick-out the first block which had come into the cache set.
+    */
+   ui_cache_set = cachesim_set_cache_set (px_cache, ull_ram_block);
+
+   px_cache_set_data = &(px_cache->px_sets[ui_cache_set]);
+
+   ui_fetch_index = cachesim_set_fill_way (px_cache, ui_cache_set);
+   if (CACHESIM_MAX_INDEX_VALUE == ui_fetch_index)
+   {
+      printf ("Tried all blocks in the set. Cannot be cached");
+      goto CLEAN_RETURN;
+   }
+
+   px_cache_block = &(px_cache_set_data->px_blocks[ui_fetch_index]);
+   px_metadata = &(px_cache_block->x_metadata);
+
+   /*
+    * The block now holds the RAM block, which becomes the tag of the way. The
+    * RAM block it held before, if any, is reported back as evicted.
+    */
+   if (NULL != pull_evicted_block)
+   {
+      *pull_evicted_block = cachesim_set_tags (px_cache, ui_cache_set)[ui_fetch_index];
+   }
+   if (NULL != pb_evicted_dirty)
+   {
+      *pb_evicted_dirty = (CACHESIM_INVALID_TAG !=
+            cachesim_set_tags (px_cache, ui_cache_set)[ui_fetch_index])
+         && (true == px_metadata->b_is_dirty);
+   }
+   if (CACHESIM_INVALID_TAG != cachesim_set_tags (px_cache, ui_cache_set)[ui_fetch_index])
+   {
+      cachesim_set_heatmap_evict (px_cache, ui_cache_set);
+   }
+   if (true == px_metadata->b_is_prefetched)
+   {
+      px_cache->px_prefetch->ull_useless++;
+      px_metadata->b_is_prefetched = false;
+   }
+   px_metadata->b_is_dirty = false;
+   cachesim_set_tags (px_cache, ui_cache_set)[ui_fetch_index] = ull_ram_block;
+   if (NULL != px_policy->pfn_fill)
+   {
+      px_policy->pfn_fill (px_cache, ui_cache_set, ui_fetch_index);
+   }
+   if (px_cache->x_cache_params.ui_associativity >= 2 && 0 == ui_fetch_index && true == b_pin_block)
+   {
+	   px_metadata->b_is_pinned = true;
+   }
+   *pui_cache_set = ui_cache_set;
+   *pui_block_idx = ui_fetch_index;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static bool cachesim_set_lookup_cache_v2(
+   CACHE_SET_X *px_cache,
+   uint64_t ull_array_idx,
+   uint32_t *pui_cache_set,
+   uint32_t *pui_block_idx)
+{
+   bool b_cache_hit = false;
+   uint64_t ull_ram_block = 0;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_way = 0;
+
+   if ((NULL == px_cache) || (NULL == pui_cache_set))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * A RAM block can only ever be placed in one set, so only the ways of that
+    * set need to be compared against the RAM block of the array index.
+    */
+   ull_ram_block = cachesim_set_ram_block (px_cache, ull_array_idx);
+   ui_cache_set = cachesim_set_cache_set (px_cache, ull_ram_block);
+   ui_way = cachesim_set_find_way (cachesim_set_tags (px_cache, ui_cache_set),
+      px_cache->ui_tag_scan_len, ull_ram_block);
+   if (CACHESIM_MAX_INDEX_VALUE != ui_way)
+   {
+      *pui_cache_set = ui_cache_set;
+      *pui_block_idx = ui_way;
+      b_cache_hit = true;
+   }
+   /*
+    * If no way holds the RAM block, then it is a miss.
+    */
+CLEAN_RETURN:
+   return b_cache_hit;
+}
+
+/*
+ * Removes the RAM block from the cache if it is there. Returns whether it
+ * was and, through pb_dirty when given, whether the copy removed was dirty.
+ */
+static bool cachesim_set_invalidate_block (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block,
+   bool *pb_dirty)
+{
+   uint32_t ui_cache_set = cachesim_set_cache_set (px_cache, ull_ram_block);
+   uint64_t *pull_tags = cachesim_set_tags (px_cache, ui_cache_set);
+   uint32_t ui_way = cachesim_set_find_way (pull_tags, px_cache->ui_tag_scan_len,
+      ull_ram_block);
+
+   if (CACHESIM_MAX_INDEX_VALUE == ui_way)
+   {
+      return false;
+   }
+   pull_tags [ui_way] = CACHESIM_INVALID_TAG;
+   px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.b_is_pinned = false;
+   if (NULL != pb_dirty)
+   {
+      *pb_dirty = px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.b_is_dirty;
+   }
+   px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.b_is_dirty = false;
+   px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.uc_coherence_state =
+      eCACHESIM_COHERENCE_STATE_INVALID;
+   if (true == px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.b_is_prefetched)
+   {
+      px_cache->px_prefetch->ull_useless++;
+      px_cache->px_sets[ui_cache_set].px_blocks[ui_way].x_metadata.b_is_prefetched = false;
+   }
+   return true;
+}
+
+static CACHESIM_RET_E cachesim_set_handle_cache_hit (
+	CACHE_SET_X *px_cache,
+	uint64_t ull_index,
+	uint32_t ui_cache_set,
+	uint32_t ui_block_idx,
+	CACHESIM_SIM_STATS_X *px_stats)
+{
+	CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+
+	if ((NULL == px_cache) || (NULL == px_stats))
+    {
+	    goto CLEAN_RETURN;
+    }
+	/*
+	 * Keep the shadow in step with the real cache, hits included.
+	 */
+	if (true == px_cache->x_cache_params.b_classify_misses)
+	{
+		(void) cachesim_shadow_access (&(px_cache->x_shadow),
+			cachesim_set_ram_block (px_cache, ull_index));
+	}
+	cachesim_set_repl_touch (px_cache, ui_cache_set, ui_block_idx);
+	px_stats->ull_hit_count++;
+	e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+    return e_ret_val;
+}
+
+/*
+ * Counts a miss on the word in px_stats and classifies it as compulsory,
+ * capacity or conflict. The cache itself is not changed.
+ */
+static CACHESIM_RET_E cachesim_set_classify_cache_miss (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   CACHESIM_MISS_TYPE_E *pe_miss_type,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+	CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+    uint64_t ull_ram_block = CACHESIM_INVALID_TAG;
+    bool b_track_failed = false;
+    bool b_shadow_hit = false;
+
+    if ((NULL == px_cache) || (NULL == px_stats) || (NULL == pe_miss_type))
+    {
+       goto CLEAN_RETURN;
+    }
+
+    /*
+     * Get a mapping of the current memory referenced index to the block in
+     * the RAM.
+     */
+    ull_ram_block = cachesim_set_ram_block (px_cache, ull_index);
+
+    /*
+     * The shadow is a fully associative LRU cache of the same capacity, so a
+     * miss that would have hit there is only due to the limited
+     * associativity of the real cache.
+     */
+    if (true == px_cache->x_cache_params.b_classify_misses)
+    {
+       b_shadow_hit = cachesim_shadow_access (&(px_cache->x_shadow),
+          ull_ram_block);
+    }
+
+    /*
+     * The first touch set tells whether the access to the RAM block was for
+     * the first time or not. If it is the first access to that block then a
+     * compulsory miss is noted. Otherwise it is a conflict miss if the shadow
+     * hit and a capacity miss if it did not.
+     */
+    if (true == cachesim_first_touch_mark (&(px_stats->x_first_touch),
+       ull_ram_block, &b_track_failed))
+    {
+       px_stats->ull_compulsory_miss++;
+       *pe_miss_type = eCACHESIM_MISS_TYPE_COMPULSORY;
+    }
+    else if (true == b_track_failed)
+    {
+       fprintf (stderr, "Out of memory tracking RAM block %" PRIu64 "\n", ull_ram_block);
+       goto CLEAN_RETURN;
+    }
+    else if (true == b_shadow_hit)
+    {
+       px_stats->ull_conflict_miss++;
+       *pe_miss_type = eCACHESIM_MISS_TYPE_CONFLICT;
+    }
+    else
+    {
+       px_stats->ull_capacity_miss++;
+       *pe_miss_type = eCACHESIM_MISS_TYPE_CAPACITY;
+    }
+
+    px_stats->ull_miss_count++;
+    e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+    return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_handle_cache_miss (
+	CACHE_SET_X *px_cache,
+	uint64_t ull_index,
+	bool b_use_pinning,
+	CACHESIM_MISS_TYPE_E *pe_miss_type,
+    uint32_t *pui_cache_set,
+    uint32_t *pui_block_idx,
+	CACHESIM_SIM_STATS_X *px_stats)
+{
+	CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+    bool b_evicted_dirty = false;
+
+	if ((NULL == px_cache) || (NULL == px_stats) || (NULL == pe_miss_type) ||
+			(NULL == pui_cache_set) || (NULL == pui_block_idx))
+    {
+	    goto CLEAN_RETURN;
+    }
+
+    e_ret_val = cachesim_set_classify_cache_miss (px_cache, ull_index, pe_miss_type,
+       px_stats);
+    if (eCACHESIM_RET_SUCCESS != e_ret_val)
+    {
+       goto CLEAN_RETURN;
+    }
+
+    /*
+     * Word not present in the cache. Fetch from block from RAM.
+     */
+    e_ret_val = cachesim_set_fetch_data_to_cache_v2 (px_cache, ull_index, b_use_pinning,
+       pui_cache_set, pui_block_idx, NULL, &b_evicted_dirty);
+    if (eCACHESIM_RET_SUCCESS != e_ret_val)
+    {
+       goto CLEAN_RETURN;
+    }
+
+    /*
+     * The block comes in from memory, and a dirty block it replaces goes
+     * back out.
+     */
+    px_stats->ull_bytes_from_memory +=
+       CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+    if (true == b_evicted_dirty)
+    {
+       px_stats->ull_dirty_evictions++;
+       px_stats->ull_bytes_to_memory +=
+          CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+    }
+CLEAN_RETURN:
+    return e_ret_val;
+}
+
+/*
+ * Brings the RAM block into the cache ahead of demand. Blocks already in the
+ * cache, and blocks of sets a sampled run does not simulate, are left alone.
+ * The block a prefetch evicts is remembered so that a later demand miss on it
+ * can be blamed on the prefetch.
+ */
+static void cachesim_set_prefetch_block (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_PREFETCH_X *px_prefetch = px_cache->px_prefetch;
+   uint32_t ui_block_size_words = px_cache->x_cache_params.ui_block_size_words;
+   uint32_t ui_cache_set = cachesim_set_cache_set (px_cache, ull_ram_block);
+   uint32_t ui_block_idx = 0;
+   uint64_t ull_evicted_block = CACHESIM_INVALID_TAG;
+   bool b_evicted_dirty = false;
+   CACHE_BLOCK_METADATA_X *px_metadata = NULL;
+
+   if (((NULL != px_cache->px_sample_counts)
+         && (false == cachesim_set_is_sampled (px_cache, ui_cache_set)))
+      || (CACHESIM_MAX_INDEX_VALUE != cachesim_set_find_way (
+         cachesim_set_tags (px_cache, ui_cache_set), px_cache->ui_tag_scan_len,
+         ull_ram_block)))
+   {
+      return;
+   }
+   if (eCACHESIM_RET_SUCCESS != cachesim_set_fetch_data_to_cache_v2 (px_cache,
+      ull_ram_block * ui_block_size_words, false, &ui_cache_set, &ui_block_idx,
+      &ull_evicted_block, &b_evicted_dirty))
+   {
+      return;
+   }
+
+   px_stats->ull_bytes_from_memory +=
+      CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+   if (true == b_evicted_dirty)
+   {
+      px_stats->ull_dirty_evictions++;
+      px_stats->ull_bytes_to_memory +=
+         CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+   }
+   if (CACHESIM_INVALID_TAG != ull_evicted_block)
+   {
+      px_prefetch->pull_pollution [ull_evicted_block & px_prefetch->ui_pollution_mask] =
+         ull_evicted_block;
+   }
+   px_metadata = &(px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata);
+   px_metadata->b_is_prefetched = true;
+   px_metadata->ui_prefetch_ready = (uint32_t) (px_prefetch->ull_clock
+      + px_cache->x_cache_params.ui_prefetch_latency);
+   px_prefetch->ull_issued++;
+}
+
+/*
+ * Prefetches ui_prefetch_degree blocks at i_stride block steps from the RAM
+ * block, stopping at either end of the address space.
+ */
+static void cachesim_set_prefetch_run (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block,
+   int64_t i_stride,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   uint64_t ull_step = (i_stride < 0) ?
+      ((uint64_t) 0 - (uint64_t) i_stride) : (uint64_t) i_stride;
+   uint32_t ui_k = 0;
+
+   for (ui_k = 0; ui_k < px_cache->x_cache_params.ui_prefetch_degree; ui_k++)
+   {
+      if ((i_stride < 0) ? (ull_ram_block < ull_step)
+         : (px_cache->ull_max_ram_block - ull_ram_block < ull_step))
+      {
+         break;
+      }
+      ull_ram_block = (i_stride < 0) ?
+         (ull_ram_block - ull_step) : (ull_ram_block + ull_step);
+      cachesim_set_prefetch_block (px_cache, ull_ram_block, px_stats);
+   }
+}
+
+static void cachesim_prefetch_next_line_train (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block,
+   uint64_t ull_pc,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   bool b_trigger,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   (void) ull_pc;
+   (void) e_type;
+   if (true == b_trigger)
+   {
+      cachesim_set_prefetch_run (px_cache, ull_ram_block, 1, px_stats);
+   }
+}
+
+/*
+ * A reference prediction table indexed by the instruction address. An entry
+ * prefetches along its stride once the same stride has been seen
+ * CACHESIM_PREFETCH_STRIDE_CONFIDENT times in a row; a different stride first
+ * wears the confidence down and only then replaces the stride. Instruction
+ * fetches do not train it, and accesses without an instruction address all
+ * share the entry of address 0.
+ */
+static void cachesim_prefetch_ip_stride_train (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block,
+   uint64_t ull_pc,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   bool b_trigger,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_PREFETCH_IP_ENTRY_X *px_entry = &(px_cache->px_prefetch->xa_ip [
+      cachesim_hash_u64 (ull_pc) & (CACHESIM_PREFETCH_IP_ENTRIES - 1)]);
+   int64_t i_stride = (int64_t) (ull_ram_block - px_entry->ull_last_block);
+
+   (void) b_trigger;
+   if (eCACHESIM_ACCESS_TYPE_IFETCH == e_type)
+   {
+      return;
+   }
+   if (px_entry->ull_pc != ull_pc)
+   {
+      px_entry->ull_pc = ull_pc;
+      px_entry->ull_last_block = ull_ram_block;
+      px_entry->i_stride = 0;
+      px_entry->ui_confidence = 0;
+      return;
+   }
+   if (0 == i_stride)
+   {
+      return;
+   }
+   if (i_stride == px_entry->i_stride)
+   {
+      if (px_entry->ui_confidence < CACHESIM_PREFETCH_STRIDE_MAX_CONFIDENCE)
+      {
+         px_entry->ui_confidence++;
+      }
+   }
+   else if (px_entry->ui_confidence > 0)
+   {
+      px_entry->ui_confidence--;
+   }
+   else
+   {
+      px_entry->i_stride = i_stride;
+   }
+   px_entry->ull_last_block = ull_ram_block;
+
+   if (px_entry->ui_confidence >= CACHESIM_PREFETCH_STRIDE_CONFIDENT)
+   {
+      cachesim_set_prefetch_run (px_cache, ull_ram_block, px_entry->i_stride,
+         px_stats);
+   }
+}
+
+/*
+ * Stream detection: a trigger within CACHESIM_PREFETCH_STREAM_WINDOW blocks
+ * of a tracked stream moves the stream along and sets its direction, and
+ * the stream then runs ui_prefetch_degree blocks ahead. A trigger that
+ * matches no stream starts one in place of the least recently used.
+ */
+static void cachesim_prefetch_stream_train (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_ram_block,
+   uint64_t ull_pc,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   bool b_trigger,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_PREFETCH_X *px_prefetch = px_cache->px_prefetch;
+   CACHESIM_PREFETCH_STREAM_X *px_stream = NULL;
+   CACHESIM_PREFETCH_STREAM_X *px_victim = &(px_prefetch->xa_streams [0]);
+   int64_t i_delta = 0;
+   uint32_t ui_i = 0;
+
+   (void) ull_pc;
+   (void) e_type;
+   if (false == b_trigger)
+   {
+      return;
+   }
+   for (ui_i = 0; ui_i < CACHESIM_PREFETCH_STREAMS; ui_i++)
+   {
+      px_stream = &(px_prefetch->xa_streams [ui_i]);
+      if (false == px_stream->b_valid)
+      {
+         px_victim = px_stream;
+         continue;
+      }
+      i_delta = (int64_t) (ull_ram_block - px_stream->ull_last_block);
+      if (((0 == px_stream->i_direction) && (0 != i_delta)
+            && (i_delta >= -CACHESIM_PREFETCH_STREAM_WINDOW)
+            && (i_delta <= CACHESIM_PREFETCH_STREAM_WINDOW))
+         || ((i_delta * px_stream->i_direction >= 1)
+            && (i_delta * px_stream->i_direction <= CACHESIM_PREFETCH_STREAM_WINDOW)))
+      {
+         px_stream->i_direction = (i_delta > 0) ? 1 : -1;
+         px_stream->ull_last_block = ull_ram_block;
+         px_stream->ull_last_use = px_prefetch->ull_clock;
+         cachesim_set_prefetch_run (px_cache, ull_ram_block,
+            px_stream->i_direction, px_stats);
+         return;
+      }
+      if ((true == px_victim->b_valid)
+         && (px_stream->ull_last_use < px_victim->ull_last_use))
+      {
+         px_victim = px_stream;
+      }
+   }
+   px_victim->b_valid = true;
+   px_victim->ull_last_block = ull_ram_block;
+   px_victim->i_direction = 0;
+   px_victim->ull_last_use = px_prefetch->ull_clock;
+}
+
+static const CACHESIM_PREFETCHER_X gxa_prefetchers [] =
+{
+   /* eCACHESIM_PREFETCHER_NONE */
+   { "none",      NULL },
+   /* eCACHESIM_PREFETCHER_NEXT_LINE */
+   { "next-line", cachesim_prefetch_next_line_train },
+   /* eCACHESIM_PREFETCHER_IP_STRIDE */
+   { "ip-stride", cachesim_prefetch_ip_stride_train },
+   /* eCACHESIM_PREFETCHER_STREAM */
+   { "stream",    cachesim_prefetch_stream_train },
+};
+
+static const CACHESIM_PREFETCHER_X *cachesim_prefetcher (
+   CACHESIM_PREFETCHER_E e_prefetcher)
+{
+   return &(gxa_prefetchers [e_prefetcher]);
+}
+
+CACHESIM_RET_E cachesim_prefetcher_from_name (
+   const char *pc_name,
+   CACHESIM_PREFETCHER_E *pe_prefetcher)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+
+   for (ui_i = 0; ui_i < eCACHESIM_PREFETCHER_MAX; ui_i++)
+   {
+      if (0 == strcmp (pc_name, gxa_prefetchers [ui_i].pc_name))
+      {
+         *pe_prefetcher = (CACHESIM_PREFETCHER_E) ui_i;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+         break;
+      }
+   }
+   return e_ret_val;
+}
+
+/*
+ * Prefetch bookkeeping of a demand access, once it has been resolved. The
+ * first use of a prefetched block counts as useful, or as late if it comes
+ * before the prefetch would have completed; a miss on a block a prefetch
+ * evicted counts as pollution. The prefetcher then sees the access.
+ */
+static void cachesim_set_prefetch_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   uint64_t ull_pc,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   bool b_cache_hit,
+   uint32_t ui_cache_set,
+   uint32_t ui_block_idx,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_PREFETCH_X *px_prefetch = px_cache->px_prefetch;
+   CACHE_BLOCK_METADATA_X *px_metadata = NULL;
+   uint64_t ull_ram_block = cachesim_set_ram_block (px_cache, ull_index);
+   uint64_t *pull_polluter = NULL;
+   bool b_trigger = false;
+
+   px_prefetch->ull_clock++;
+   if (true == b_cache_hit)
+   {
+      px_metadata = &(px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata);
+      if (true == px_metadata->b_is_prefetched)
+      {
+         px_metadata->b_is_prefetched = false;
+         if ((int32_t) (px_metadata->ui_prefetch_ready
+            - (uint32_t) px_prefetch->ull_clock) > 0)
+         {
+            px_prefetch->ull_late++;
+         }
+         else
+         {
+            px_prefetch->ull_useful++;
+         }
+         b_trigger = true;
+      }
+   }
+   else
+   {
+      pull_polluter = &(px_prefetch->pull_pollution [ull_ram_block
+         & px_prefetch->ui_pollution_mask]);
+      if (*pull_polluter == ull_ram_block)
+      {
+         px_prefetch->ull_pollution++;
+         *pull_polluter = CACHESIM_INVALID_TAG;
+      }
+      b_trigger = true;
+   }
+   cachesim_prefetcher (px_cache->x_cache_params.e_prefetcher)->pfn_train (
+      px_cache, ull_ram_block, ull_pc, e_type, b_trigger, px_stats);
+}
+
+/*
+ * Logged runs hand the access to the event log; nothing is printed here.
+ */
+static inline void cachesim_set_log_cache_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   uint32_t ui_cache_set,
+   uint32_t ui_block_idx,
+   bool b_cache_hit,
+   bool b_filled,
+   CACHESIM_MISS_TYPE_E e_miss_type)
+{
+   if (NULL != px_cache->px_event_log)
+   {
+      cachesim_event_log_put (px_cache->px_event_log, ull_index, ui_cache_set,
+         ui_block_idx,
+         (true == b_cache_hit) ? eCACHESIM_EVENT_OUTCOME_HIT :
+         (true == b_filled) ? eCACHESIM_EVENT_OUTCOME_FILL :
+            eCACHESIM_EVENT_OUTCOME_BYPASS,
+         e_miss_type);
+   }
+}
+
+/*
+ * Per-set counts of a set sampled run, from which the confidence interval
+ * of the miss rate is estimated.
+ */
+static inline void cachesim_set_sample_account (
+   CACHE_SET_X *px_cache,
+   uint32_t ui_cache_set,
+   bool b_cache_hit)
+{
+   if (NULL != px_cache->px_sample_counts)
+   {
+      px_cache->px_sample_counts [ui_cache_set].ull_accesses++;
+      px_cache->px_sample_counts [ui_cache_set].ull_misses += (false == b_cache_hit);
+   }
+}
+
+/*
+ * Everything an access does once the lookup has told whether the block is in
+ * the cache: the hit or miss is handled and counted, and a write then dirties
+ * the block or goes through to memory as the write policy says. A write miss
+ * without write-allocate bypasses the cache altogether and leaves
+ * CACHESIM_MAX_INDEX_VALUE in *pui_block_idx. ull_pc is the address of the
+ * instruction making the access, for the prefetcher, or 0 if unknown.
+ */
+static inline CACHESIM_RET_E cachesim_set_resolve_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   uint64_t ull_pc,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   uint32_t ui_size_bytes,
+   bool b_use_pinning,
+   bool b_cache_hit,
+   uint32_t *pui_cache_set,
+   uint32_t *pui_block_idx,
+   CACHESIM_MISS_TYPE_E *pe_miss_type,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   bool b_write = (eCACHESIM_ACCESS_TYPE_WRITE == e_type);
+
+   px_stats->ull_total_accesses++;
+   if (true == b_write)
+   {
+      px_stats->ull_writes++;
+   }
+
+   if (true == b_cache_hit)
+   {
+      e_ret_val = cachesim_set_handle_cache_hit (px_cache, ull_index, *pui_cache_set,
+         *pui_block_idx, px_stats);
+   }
+   else if ((true == b_write)
+      && (false == px_cache->x_cache_params.b_write_allocate))
+   {
+      e_ret_val = cachesim_set_classify_cache_miss (px_cache, ull_index,
+         pe_miss_type, px_stats);
+      px_stats->ull_write_misses++;
+      px_stats->ull_bytes_to_memory += ui_size_bytes;
+      *pui_cache_set = cachesim_set_cache_set (px_cache,
+         cachesim_set_ram_block (px_cache, ull_index));
+      *pui_block_idx = CACHESIM_MAX_INDEX_VALUE;
+   }
+   else
+   {
+	   e_ret_val = cachesim_set_handle_cache_miss (px_cache, ull_index, b_use_pinning,
+	      pe_miss_type, pui_cache_set, pui_block_idx, px_stats);
+	   px_stats->ull_write_misses += b_write;
+   }
+   if ((true == b_write) && (eCACHESIM_RET_SUCCESS == e_ret_val)
+      && (CACHESIM_MAX_INDEX_VALUE != *pui_block_idx))
+   {
+      if (eCACHESIM_WRITE_POLICY_WRITE_BACK == px_cache->x_cache_params.e_write_policy)
+      {
+         px_cache->px_sets[*pui_cache_set].px_blocks[*pui_block_idx].x_metadata.b_is_dirty = true;
+      }
+      else
+      {
+         px_stats->ull_bytes_to_memory += ui_size_bytes;
+      }
+   }
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      if (NULL != px_cache->px_mshr)
+      {
+         cachesim_set_mshr_account (px_cache, ull_index, b_cache_hit, px_stats);
+      }
+      else
+      {
+         cachesim_set_latency_account (px_cache, b_cache_hit, px_stats);
+      }
+      cachesim_set_heatmap_account (px_cache, ull_index, *pui_cache_set, b_cache_hit);
+   }
+   if ((NULL != px_cache->px_prefetch) && (eCACHESIM_RET_SUCCESS == e_ret_val))
+   {
+      cachesim_set_prefetch_access (px_cache, ull_index, ull_pc, e_type, b_cache_hit,
+         *pui_cache_set, *pui_block_idx, px_stats);
+   }
+   return e_ret_val;
+}
+
+/*
+ * One access of ui_size_bytes bytes within the block holding the word.
+ */
+static CACHESIM_RET_E cachesim_set_mapped_cache_access_typed (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   uint32_t ui_size_bytes,
+   bool b_use_pinning,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   bool b_cache_hit = false;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_block_idx = 0;
+   CACHESIM_MISS_TYPE_E e_miss_type = eCACHESIM_MISS_TYPE_NONE;
+
+   if ((NULL == px_cache) || (NULL == px_stats))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   if (NULL != px_cache->px_sample_counts)
+   {
+      ui_cache_set = cachesim_set_cache_set (px_cache,
+         cachesim_set_ram_block (px_cache, ull_index));
+      if (false == cachesim_set_is_sampled (px_cache, ui_cache_set))
+      {
+         px_cache->ull_sample_skipped++;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+         goto CLEAN_RETURN;
+      }
+   }
+
+   /*
+    * Check is the data word is present in the cache.
+    */
+   b_cache_hit = cachesim_set_lookup_cache_v2 (px_cache, ull_index, &ui_cache_set, &ui_block_idx);
+   e_ret_val = cachesim_set_resolve_access (px_cache, ull_index, 0, e_type,
+      ui_size_bytes, b_use_pinning, b_cache_hit, &ui_cache_set, &ui_block_idx,
+      &e_miss_type, px_stats);
+   cachesim_set_sample_account (px_cache, ui_cache_set, b_cache_hit);
+   cachesim_set_log_cache_access (px_cache, ull_index, ui_cache_set, ui_block_idx,
+      b_cache_hit, (CACHESIM_MAX_INDEX_VALUE != ui_block_idx)
+         && (eCACHESIM_RET_SUCCESS == e_ret_val),
+      e_miss_type);
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * A one word read, as issued by the built-in algorithms.
+ */
+static CACHESIM_RET_E cachesim_set_mapped_cache_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   bool b_use_pinning,
+   uint32_t ui_total_data_words,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   (void) ui_total_data_words;
+   if (NULL == px_cache)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   return cachesim_set_mapped_cache_access_typed (px_cache, ull_index,
+      eCACHESIM_ACCESS_TYPE_READ, px_cache->x_cache_params.ui_word_size_bytes,
+      b_use_pinning, px_stats);
+}
+
+/*
+ * Accesses in bulk. The batch is taken CACHESIM_ACCESS_BATCH_SIZE
+ * accesses at a time: the set of every access is computed first and the
+ * set's tags, replacement state and bookkeeping, along with the hash slots
+ * miss classification will probe, are prefetched. The accesses are then
+ * resolved in order, by which time the lines they need are on their way in,
+ * so the host's cache misses on a large simulated cache overlap instead of
+ * being taken one at a time. In a set sampled run the accesses to unsampled
+ * sets are dropped as soon as their set is known. *pull_hits, if given, is
+ * incremented for every access that was simulated and hit.
+ */
+static void cachesim_set_mapped_cache_access_batch (
+   CACHE_SET_X *px_cache,
+   const CACHESIM_ACCESS_X *px_accesses,
+   uint32_t ui_count,
+   CACHESIM_SIM_STATS_X *px_stats,
+   uint64_t *pull_hits)
+{
+   uint64_t ulla_ram_block [CACHESIM_ACCESS_BATCH_SIZE];
+   uint32_t uia_cache_set [CACHESIM_ACCESS_BATCH_SIZE];
+   const CACHESIM_ACCESS_X *pxa_access [CACHESIM_ACCESS_BATCH_SIZE];
+   const CACHESIM_ACCESS_X *px_access = NULL;
+   uint32_t ui_chunk = 0;
+   uint32_t ui_kept = 0;
+   uint32_t ui_i = 0;
+   uint32_t ui_way = 0;
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_MISS_TYPE_E e_miss_type = eCACHESIM_MISS_TYPE_NONE;
+   bool b_cache_hit = false;
+   bool b_classify = false;
+   bool b_sampling = false;
+
+   if ((NULL == px_cache) || (NULL == px_accesses) || (NULL == px_stats))
+   {
+      return;
+   }
+   b_classify = px_cache->x_cache_params.b_classify_misses;
+   b_sampling = (NULL != px_cache->px_sample_counts);
+
+   for (; 0 != ui_count; ui_count -= ui_chunk, px_accesses += ui_chunk)
+   {
+      ui_chunk = (ui_count < CACHESIM_ACCESS_BATCH_SIZE) ?
+         ui_count : CACHESIM_ACCESS_BATCH_SIZE;
+      for (ui_i = 0, ui_kept = 0; ui_i < ui_chunk; ui_i++)
+      {
+         ulla_ram_block [ui_kept] = cachesim_set_ram_block (px_cache,
+            px_accesses [ui_i].ull_index);
+         uia_cache_set [ui_kept] = cachesim_set_cache_set (px_cache,
+            ulla_ram_block [ui_kept]);
+         if ((true == b_sampling)
+            && (false == cachesim_set_is_sampled (px_cache, uia_cache_set [ui_kept])))
+         {
+            px_cache->ull_sample_skipped++;
+            continue;
+         }
+         pxa_access [ui_kept] = &(px_accesses [ui_i]);
+         CACHESIM_PREFETCH (cachesim_set_tags (px_cache, uia_cache_set [ui_kept]));
+         CACHESIM_PREFETCH (&(px_cache->px_sets [uia_cache_set [ui_kept]]));
+         if (0 != px_cache->ui_repl_stride)
+         {
+            CACHESIM_PREFETCH (cachesim_set_repl_state (px_cache,
+               uia_cache_set [ui_kept]));
+         }
+         cachesim_hash_map_prefetch (&(px_stats->x_first_touch.x_pages),
+            ulla_ram_block [ui_kept] / CACHESIM_FIRST_TOUCH_BLOCKS_PER_PAGE);
+         if (true == b_classify)
+         {
+            cachesim_hash_map_prefetch (&(px_cache->x_shadow.x_map),
+               ulla_ram_block [ui_kept]);
+         }
+         ui_kept++;
+      }
+
+      for (ui_i = 0; ui_i < ui_kept; ui_i++)
+      {
+         px_access = pxa_access [ui_i];
+         ui_way = cachesim_set_find_way (
+            cachesim_set_tags (px_cache, uia_cache_set [ui_i]),
+            px_cache->ui_tag_scan_len, ulla_ram_block [ui_i]);
+         b_cache_hit = (CACHESIM_MAX_INDEX_VALUE != ui_way);
+         e_miss_type = eCACHESIM_MISS_TYPE_NONE;
+         e_ret_val = cachesim_set_resolve_access (px_cache, px_access->ull_index,
+            px_access->ull_pc, px_access->e_type, px_access->ui_size_bytes, false, b_cache_hit,
+            &(uia_cache_set [ui_i]), &ui_way, &e_miss_type, px_stats);
+         if ((NULL != pull_hits) && (true == b_cache_hit)
+            && (eCACHESIM_RET_SUCCESS == e_ret_val))
+         {
+            (*pull_hits)++;
+         }
+         cachesim_set_sample_account (px_cache, uia_cache_set [ui_i], b_cache_hit);
+         cachesim_set_log_cache_access (px_cache, px_access->ull_index,
+            uia_cache_set [ui_i], ui_way, b_cache_hit,
+            (CACHESIM_MAX_INDEX_VALUE != ui_way)
+               && (eCACHESIM_RET_SUCCESS == e_ret_val),
+            e_miss_type);
+      }
+   }
+}
+
+/*
+ * The non-empty buckets of the latency histogram, with their share of the
+ * accesses.
+ */
+static void cachesim_log_latency_histogram (
+   const CACHESIM_SIM_STATS_X *px_stats)
+{
+   uint64_t ull_accesses = 0;
+   uint32_t ui_bucket = 0;
+   char ca_range [48];
+
+   for (ui_bucket = 0; ui_bucket < CACHESIM_LATENCY_HISTOGRAM_BUCKETS; ui_bucket++)
+   {
+      ull_accesses += px_stats->ulla_latency_histogram [ui_bucket];
+   }
+   if (0 == ull_accesses)
+   {
+      return;
+   }
+   printf ("Latency (cycles):\n");
+   for (ui_bucket = 0; ui_bucket < CACHESIM_LATENCY_HISTOGRAM_BUCKETS; ui_bucket++)
+   {
+      if (0 == px_stats->ulla_latency_histogram [ui_bucket])
+      {
+         continue;
+      }
+      if (0 == ui_bucket)
+      {
+         snprintf (ca_range, sizeof(ca_range), "0");
+      }
+      else if ((CACHESIM_LATENCY_HISTOGRAM_BUCKETS - 1) == ui_bucket)
+      {
+         snprintf (ca_range, sizeof(ca_range), ">= %" PRIu64,
+            UINT64_C(1) << (ui_bucket - 1));
+      }
+      else
+      {
+         snprintf (ca_range, sizeof(ca_range), "%" PRIu64 "-%" PRIu64,
+            UINT64_C(1) << (ui_bucket - 1), (UINT64_C(1) << ui_bucket) - 1);
+      }
+      printf ("\t %-25s : %" PRIu64 " (%.2f%%)\n", ca_range,
+         px_stats->ulla_latency_histogram [ui_bucket],
+         100.0 * (double) px_stats->ulla_latency_histogram [ui_bucket]
+            / (double) ull_accesses);
+   }
+}
+
+static void cache_sim_log_summary (
+	const CACHESIM_SIM_STATS_X *px_stats)
+{
+	   printf ("Stats:\n"
+	      "\t ull_total_accesses        : %" PRIu64 "\n"
+	      "\t ull_hit_count             : %" PRIu64 "\n"
+	      "\t ull_miss_count            : %" PRIu64 "\n"
+	      "\t ull_capacity_miss         : %" PRIu64 "\n"
+	      "\t ull_compulsory_miss       : %" PRIu64 "\n"
+	      "\t ull_conflict_miss         : %" PRIu64 "\n", px_stats->ull_total_accesses,
+	      px_stats->ull_hit_count, px_stats->ull_miss_count, px_stats->ull_capacity_miss,
+	      px_stats->ull_compulsory_miss, px_stats->ull_conflict_miss);
+
+	   double d_hit_rate = (double) px_stats->ull_hit_count / (double) px_stats->ull_total_accesses;
+	   double d_miss_rate = (double) px_stats->ull_miss_count / (double) px_stats->ull_total_accesses;
+	   /*
+	    * Average memory access time in cycles, from the latency model.
+	    */
+	   double d_avg_memory_access_time = (0 == px_stats->ull_total_accesses) ? 0.0 :
+	      (double) px_stats->ull_cycles / (double) px_stats->ull_total_accesses;
+	   printf ("\t ull_writes                : %" PRIu64 "\n"
+	      "\t ull_write_misses          : %" PRIu64 "\n"
+	      "\t ull_dirty_evictions       : %" PRIu64 "\n"
+	      "\t ull_bytes_from_memory     : %" PRIu64 "\n"
+	      "\t ull_bytes_to_memory       : %" PRIu64 "\n"
+	      "\t ull_cycles                : %" PRIu64 "\n"
+	      "\t ull_stall_cycles          : %" PRIu64 "\n", px_stats->ull_writes,
+	      px_stats->ull_write_misses, px_stats->ull_dirty_evictions,
+	      px_stats->ull_bytes_from_memory, px_stats->ull_bytes_to_memory,
+	      px_stats->ull_cycles, px_stats->ull_stall_cycles);
+	   printf ("\t\t d_hit_rate               : %f\n", d_hit_rate);
+	   printf ("\t\t d_miss_rate              : %f\n", d_miss_rate);
+	   printf ("\t\t d_avg_memory_access_time : %f\n", d_avg_memory_access_time);
+	   cachesim_log_latency_histogram (px_stats);
+	   printf ("\n");
+}
+
+/*
+ * Whole-cache estimates from the sampled sets. Every access is counted, so
+ * the total is exact; the misses of the k of N sets sampled are scaled by
+ * N / k. Misses are spread far more evenly over the sets than accesses are
+ * (a hot set mostly hits), so this holds up where the miss ratio of the
+ * sampled sets would be thrown off by the few hot sets it missed. The
+ * variance of the scaled misses is N^2 * (1 - k/N) * s^2 / k, s^2 being the
+ * variance of the per-set misses.
+ */
+static void cachesim_set_sample_estimate (
+   const CACHE_SET_X *px_cache,
+   CACHESIM_SAMPLE_ESTIMATE_X *px_estimate)
+{
+   const CACHESIM_SAMPLE_COUNTS_X *px_counts = NULL;
+   uint64_t ull_misses = 0;
+   uint32_t ui_i = 0;
+   double d_k = 0.0;
+   double d_n = 0.0;
+   double d_accesses = 0.0;
+   double d_mean_misses = 0.0;
+   double d_deviation = 0.0;
+   double d_sum_squares = 0.0;
+
+   (void) memset (px_estimate, 0x00, sizeof (*px_estimate));
+   px_estimate->d_miss_rate_ci95 = -1.0;
+   if (NULL == px_cache->px_sample_counts)
+   {
+      return;
+   }
+   px_estimate->ui_sampled_sets = px_cache->ui_sampled_sets;
+   px_estimate->ui_total_sets = px_cache->ui_configured_no_of_sets;
+   px_estimate->ull_skipped_accesses = px_cache->ull_sample_skipped;
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      px_counts = &(px_cache->px_sample_counts [ui_i]);
+      px_estimate->ull_sampled_accesses += px_counts->ull_accesses;
+      ull_misses += px_counts->ull_misses;
+   }
+   d_k = (double) px_estimate->ui_sampled_sets;
+   d_n = (double) px_estimate->ui_total_sets;
+   px_estimate->d_scale = d_n / d_k;
+   d_accesses = (double) (px_estimate->ull_sampled_accesses
+      + px_estimate->ull_skipped_accesses);
+   if (0.0 == d_accesses)
+   {
+      return;
+   }
+   px_estimate->d_miss_rate = px_estimate->d_scale * (double) ull_misses / d_accesses;
+   if (px_estimate->ui_sampled_sets < 2)
+   {
+      return;
+   }
+
+   d_mean_misses = (double) ull_misses / d_k;
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      if (true == cachesim_set_is_sampled (px_cache, ui_i))
+      {
+         d_deviation = (double) px_cache->px_sample_counts [ui_i].ull_misses
+            - d_mean_misses;
+         d_sum_squares += d_deviation * d_deviation;
+      }
+   }
+   px_estimate->d_miss_rate_ci95 = CACHESIM_SAMPLE_Z95 * d_n * sqrt (
+      (1.0 - (d_k / d_n)) * (d_sum_squares / (d_k - 1.0)) / d_k) / d_accesses;
+}
+
+/*
+ * The counters of a set sampled run scaled up to the whole cache. Prints
+ * nothing when every set was simulated.
+ */
+static void cachesim_set_log_sample_summary (
+   const CACHE_SET_X *px_cache,
+   const CACHESIM_SIM_STATS_X *px_stats)
+{
+   CACHESIM_SAMPLE_ESTIMATE_X x_estimate = {0};
+   double d_scale = 0.0;
+
+   if (NULL == px_cache->px_sample_counts)
+   {
+      return;
+   }
+   cachesim_set_sample_estimate (px_cache, &x_estimate);
+   d_scale = x_estimate.d_scale;
+   printf ("Sampling:\n"
+      "\t ui_sampled_sets           : %u\n"
+      "\t ui_total_sets             : %u\n"
+      "\t ull_sampled_accesses      : %" PRIu64 "\n"
+      "\t ull_skipped_accesses      : %" PRIu64 "\n",
+      x_estimate.ui_sampled_sets, x_estimate.ui_total_sets,
+      x_estimate.ull_sampled_accesses, x_estimate.ull_skipped_accesses);
+   printf ("\t\t d_scale                  : %f\n", d_scale);
+   printf ("\t\t d_est_hit_count          : %.0f\n",
+      (double) (x_estimate.ull_sampled_accesses + x_estimate.ull_skipped_accesses)
+      - (d_scale * px_stats->ull_miss_count));
+   printf ("\t\t d_est_miss_count         : %.0f\n", d_scale * px_stats->ull_miss_count);
+   printf ("\t\t d_est_capacity_miss      : %.0f\n", d_scale * px_stats->ull_capacity_miss);
+   printf ("\t\t d_est_compulsory_miss    : %.0f\n", d_scale * px_stats->ull_compulsory_miss);
+   printf ("\t\t d_est_conflict_miss      : %.0f\n", d_scale * px_stats->ull_conflict_miss);
+   printf ("\t\t d_est_dirty_evictions    : %.0f\n",
+      d_scale * (double) px_stats->ull_dirty_evictions);
+   printf ("\t\t d_est_bytes_from_memory  : %.0f\n",
+      d_scale * (double) px_stats->ull_bytes_from_memory);
+   printf ("\t\t d_est_bytes_to_memory    : %.0f\n",
+      d_scale * (double) px_stats->ull_bytes_to_memory);
+   printf ("\t\t d_est_miss_rate          : %f\n", x_estimate.d_miss_rate);
+   if (x_estimate.d_miss_rate_ci95 >= 0.0)
+   {
+      printf ("\t\t d_est_miss_rate_ci95     : %f\n", x_estimate.d_miss_rate_ci95);
+   }
+   printf ("\n");
+}
+
+/*
+ * Accuracy is the share of issued prefetches that were used, late or not;
+ * coverage is the share of would-be misses that a prefetch removed.
+ */
+static void cachesim_set_log_prefetch_summary (
+   const CACHE_SET_X *px_cache,
+   const CACHESIM_SIM_STATS_X *px_stats)
+{
+   const CACHESIM_PREFETCH_X *px_prefetch = px_cache->px_prefetch;
+   uint64_t ull_used = 0;
+
+   if (NULL == px_prefetch)
+   {
+      return;
+   }
+   ull_used = px_prefetch->ull_useful + px_prefetch->ull_late;
+   printf ("Prefetch:\n"
+      "\t prefetcher                : %s\n"
+      "\t ui_prefetch_degree        : %u\n"
+      "\t ui_prefetch_latency       : %u\n"
+      "\t ull_prefetches            : %" PRIu64 "\n"
+      "\t ull_prefetch_useful       : %" PRIu64 "\n"
+      "\t ull_prefetch_late         : %" PRIu64 "\n"
+      "\t ull_prefetch_useless      : %" PRIu64 "\n"
+      "\t ull_prefetch_pollution    : %" PRIu64 "\n",
+      cachesim_prefetcher (px_cache->x_cache_params.e_prefetcher)->pc_name,
+      px_cache->x_cache_params.ui_prefetch_degree,
+      px_cache->x_cache_params.ui_prefetch_latency,
+      px_prefetch->ull_issued, px_prefetch->ull_useful, px_prefetch->ull_late,
+      px_prefetch->ull_useless, px_prefetch->ull_pollution);
+   printf ("\t\t d_prefetch_accuracy      : %f\n",
+      (0 == px_prefetch->ull_issued) ? 0.0 :
+         (double) ull_used / (double) px_prefetch->ull_issued);
+   printf ("\t\t d_prefetch_coverage      : %f\n\n",
+      (0 == (ull_used + px_stats->ull_miss_count)) ? 0.0 :
+         (double) ull_used / (double) (ull_used + px_stats->ull_miss_count));
+}
+
+static uint64_t cachesim_mshr_elapsed (
+   const CACHESIM_MSHR_X *px_mshr)
+{
+   return ((px_mshr->ull_end > px_mshr->ull_now) ?
+      px_mshr->ull_end : px_mshr->ull_now) - px_mshr->ull_start;
+}
+
+/*
+ * Memory-level parallelism is the average number of misses in flight while
+ * there is at least one; the effective miss latency is the time a miss keeps
+ * memory busy once the overlap is taken out. A low MLP points at latency
+ * bound code, frequent MSHR-full stalls at bandwidth bound code.
+ */
+static void cachesim_set_log_mshr_summary (
+   const CACHE_SET_X *px_cache,
+   const CACHESIM_SIM_STATS_X *px_stats)
+{
+   const CACHESIM_MSHR_X *px_mshr = px_cache->px_mshr;
+   uint64_t ull_elapsed = 0;
+
+   if (NULL == px_mshr)
+   {
+      return;
+   }
+   ull_elapsed = cachesim_mshr_elapsed (px_mshr);
+   printf ("MSHR:\n"
+      "\t ui_mshrs                  : %u\n"
+      "\t ui_issue_rate             : %u\n"
+      "\t ull_elapsed_cycles        : %" PRIu64 "\n"
+      "\t ull_primary_misses        : %" PRIu64 "\n"
+      "\t ull_merged_misses         : %" PRIu64 "\n"
+      "\t ull_mshr_full_stalls      : %" PRIu64 "\n"
+      "\t ull_mshr_stall_cycles     : %" PRIu64 "\n"
+      "\t ull_miss_busy_cycles      : %" PRIu64 "\n",
+      px_cache->x_cache_params.ui_mshrs, px_cache->x_cache_params.ui_issue_rate,
+      ull_elapsed, px_mshr->ull_primary_misses, px_mshr->ull_merged_misses,
+      px_mshr->ull_full_stalls, px_mshr->ull_full_stall_cycles,
+      px_mshr->ull_busy_cycles);
+   printf ("\t\t d_accesses_per_cycle     : %f\n",
+      (0 == ull_elapsed) ? 0.0 :
+         (double) px_stats->ull_total_accesses / (double) ull_elapsed);
+   printf ("\t\t d_mlp                    : %f\n",
+      (0 == px_mshr->ull_busy_cycles) ? 0.0 :
+         (double) px_mshr->ull_miss_cycles / (double) px_mshr->ull_busy_cycles);
+   printf ("\t\t d_effective_miss_latency : %f\n",
+      (0 == px_mshr->ull_primary_misses) ? 0.0 :
+         (double) px_mshr->ull_busy_cycles / (double) px_mshr->ull_primary_misses);
+   printf ("\t\t d_mshr_stall_share       : %f\n\n",
+      (0 == ull_elapsed) ? 0.0 :
+         (double) px_mshr->ull_full_stall_cycles / (double) ull_elapsed);
+}
+
+static int cachesim_heatmap_block_compare (
+   const void *pv_a,
+   const void *pv_b)
+{
+   const CACHESIM_HEATMAP_BLOCK_X *px_a = (const CACHESIM_HEATMAP_BLOCK_X *) pv_a;
+   const CACHESIM_HEATMAP_BLOCK_X *px_b = (const CACHESIM_HEATMAP_BLOCK_X *) pv_b;
+
+   return (px_a->ull_ram_block > px_b->ull_ram_block)
+      - (px_a->ull_ram_block < px_b->ull_ram_block);
+}
+
+static CACHESIM_RET_E cachesim_heatmap_write_sets (
+   const CACHE_SET_X *px_cache,
+   FILE *px_file)
+{
+   const CACHESIM_HEATMAP_SET_X *px_set = NULL;
+   uint32_t ui_i = 0;
+
+   if (eCACHESIM_HEATMAP_FORMAT_JSON == px_cache->x_cache_params.e_heatmap_format)
+   {
+      fprintf (px_file, "{\"sets\": [\n");
+   }
+   else
+   {
+      fprintf (px_file, "set,hits,misses,evictions\n");
+   }
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      px_set = &(px_cache->px_heatmap->px_sets [ui_i]);
+      if (eCACHESIM_HEATMAP_FORMAT_JSON == px_cache->x_cache_params.e_heatmap_format)
+      {
+         fprintf (px_file, "  {\"set\": %u, \"hits\": %" PRIu64 ", \"misses\": %"
+            PRIu64 ", \"evictions\": %" PRIu64 "}%s\n", ui_i, px_set->ull_hits,
+            px_set->ull_misses, px_set->ull_evictions,
+            ((ui_i + 1) < px_cache->ui_configured_no_of_sets) ? "," : "");
+      }
+      else
+      {
+         fprintf (px_file, "%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", ui_i,
+            px_set->ull_hits, px_set->ull_misses, px_set->ull_evictions);
+      }
+   }
+   if (eCACHESIM_HEATMAP_FORMAT_JSON == px_cache->x_cache_params.e_heatmap_format)
+   {
+      fprintf (px_file, "]}\n");
+   }
+   return (0 == ferror (px_file)) ? eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+}
+
+/*
+ * The RAM blocks that missed, in address order.
+ */
+static CACHESIM_RET_E cachesim_heatmap_write_blocks (
+   const CACHE_SET_X *px_cache,
+   FILE *px_file)
+{
+   const CACHESIM_HASH_MAP_X *px_map = &(px_cache->px_heatmap->x_block_misses);
+   CACHESIM_HEATMAP_BLOCK_X *px_blocks = NULL;
+   uint64_t ull_block_bytes =
+      CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+   uint64_t ull_count = 0;
+   uint64_t ull_i = 0;
+   bool b_json =
+      (eCACHESIM_HEATMAP_FORMAT_JSON == px_cache->x_cache_params.e_heatmap_format);
+
+   px_blocks = (CACHESIM_HEATMAP_BLOCK_X *) malloc (
+      (size_t) (px_map->ull_count + 1) * sizeof (CACHESIM_HEATMAP_BLOCK_X));
+   if (NULL == px_blocks)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   for (ull_i = 0; ull_i < px_map->ull_capacity; ull_i++)
+   {
+      if (CACHESIM_HASH_MAP_EMPTY_KEY != px_map->pull_keys [ull_i])
+      {
+         px_blocks [ull_count].ull_ram_block = px_map->pull_keys [ull_i];
+         px_blocks [ull_count].ull_misses = px_map->pull_values [ull_i];
+         ull_count++;
+      }
+   }
+   qsort (px_blocks, (size_t) ull_count, sizeof (CACHESIM_HEATMAP_BLOCK_X),
+      cachesim_heatmap_block_compare);
+
+   fprintf (px_file, (true == b_json) ? "{\"blocks\": [\n" :
+      "block,address,set,misses\n");
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      fprintf (px_file, (true == b_json) ?
+         "  {\"block\": %" PRIu64 ", \"address\": %" PRIu64 ", \"set\": %u, "
+            "\"misses\": %" PRIu64 "}%s\n" :
+         "%" PRIu64 ",%" PRIu64 ",%u,%" PRIu64 "%s\n",
+         px_blocks [ull_i].ull_ram_block,
+         px_blocks [ull_i].ull_ram_block * ull_block_bytes,
+         cachesim_set_cache_set (px_cache, px_blocks [ull_i].ull_ram_block),
+         px_blocks [ull_i].ull_misses,
+         ((true == b_json) && ((ull_i + 1) < ull_count)) ? "," : "");
+   }
+   if (true == b_json)
+   {
+      fprintf (px_file, "]}\n");
+   }
+   free (px_blocks);
+   return (0 == ferror (px_file)) ? eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+}
+
+static void cachesim_heatmap_write_file (
+   const CACHE_SET_X *px_cache,
+   const char *pc_file,
+   CACHESIM_RET_E (*pfn_write) (const CACHE_SET_X *, FILE *))
+{
+   FILE *px_file = NULL;
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+
+   if (NULL == pc_file)
+   {
+      return;
+   }
+   px_file = fopen (pc_file, "w");
+   if (NULL != px_file)
+   {
+      e_ret_val = pfn_write (px_cache, px_file);
+      if (0 != fclose (px_file))
+      {
+         e_ret_val = eCACHESIM_RET_FAILURE;
+      }
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Unable to write the heatmap to %s\n", pc_file);
+   }
+}
+
+/*
+ * Says how unevenly the misses spread over the sets and writes the heatmap
+ * files. The imbalance is the misses of the hottest set over the mean of all
+ * sets: 1 for a perfectly even spread.
+ */
+static void cachesim_set_log_heatmap (
+   const CACHE_SET_X *px_cache)
+{
+   const CACHESIM_HEATMAP_X *px_heatmap = px_cache->px_heatmap;
+   uint64_t ull_misses = 0;
+   uint32_t ui_sets_with_misses = 0;
+   uint32_t ui_hottest_set = 0;
+   uint32_t ui_i = 0;
+
+   if (NULL == px_heatmap)
+   {
+      return;
+   }
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      ull_misses += px_heatmap->px_sets [ui_i].ull_misses;
+      ui_sets_with_misses += (0 != px_heatmap->px_sets [ui_i].ull_misses);
+      if (px_heatmap->px_sets [ui_i].ull_misses
+         > px_heatmap->px_sets [ui_hottest_set].ull_misses)
+      {
+         ui_hottest_set = ui_i;
+      }
+   }
+   printf ("Heatmap:\n"
+      "\t ui_sets_with_misses       : %u\n"
+      "\t ui_hottest_set            : %u\n"
+      "\t ull_hottest_set_misses    : %" PRIu64 "\n",
+      ui_sets_with_misses, ui_hottest_set,
+      px_heatmap->px_sets [ui_hottest_set].ull_misses);
+   if (true == px_heatmap->b_blocks)
+   {
+      printf ("\t ull_blocks_with_misses    : %" PRIu64 "\n",
+         px_heatmap->x_block_misses.ull_count);
+   }
+   printf ("\t\t d_miss_imbalance         : %f\n\n",
+      (0 == ull_misses) ? 0.0 :
+         (double) px_heatmap->px_sets [ui_hottest_set].ull_misses
+         * px_cache->ui_configured_no_of_sets / (double) ull_misses);
+
+   cachesim_heatmap_write_file (px_cache,
+      px_cache->x_cache_params.pc_heatmap_file, cachesim_heatmap_write_sets);
+   cachesim_heatmap_write_file (px_cache,
+      px_cache->x_cache_params.pc_heatmap_blocks_file,
+      cachesim_heatmap_write_blocks);
+}
+
+static inline uint32_t cachesim_get_le32 (
+   const uint8_t *puc_bytes)
+{
+   return ((uint32_t) puc_bytes [0]) | ((uint32_t) puc_bytes [1] << 8)
+      | ((uint32_t) puc_bytes [2] << 16) | ((uint32_t) puc_bytes [3] << 24);
+}
+
+static inline uint64_t cachesim_get_le64 (
+   const uint8_t *puc_bytes)
+{
+   return ((uint64_t) cachesim_get_le32 (puc_bytes + 4) << 32)
+      | cachesim_get_le32 (puc_bytes);
+}
+
+static inline void cachesim_put_le32 (
+   uint8_t *puc_bytes,
+   uint32_t ui_value)
+{
+   puc_bytes [0] = (uint8_t) ui_value;
+   puc_bytes [1] = (uint8_t) (ui_value >> 8);
+   puc_bytes [2] = (uint8_t) (ui_value >> 16);
+   puc_bytes [3] = (uint8_t) (ui_value >> 24);
+}
+
+static inline void cachesim_put_le64 (
+   uint8_t *puc_bytes,
+   uint64_t ull_value)
+{
+   cachesim_put_le32 (puc_bytes, (uint32_t) ull_value);
+   cachesim_put_le32 (puc_bytes + 4, (uint32_t) (ull_value >> 32));
+}
+
+static CACHESIM_RET_E cachesim_event_renderer_init (
+   CACHESIM_EVENT_RENDERER_X *px_renderer,
+   FILE *px_out,
+   uint32_t ui_sets,
+   uint32_t ui_ways,
+   uint32_t ui_block_size_words)
+{
+   size_t sz_tags = (size_t) ui_sets * ui_ways;
+
+   px_renderer->px_out = px_out;
+   px_renderer->ui_sets = ui_sets;
+   px_renderer->ui_ways = ui_ways;
+   px_renderer->ui_block_size_words = ui_block_size_words;
+   px_renderer->pull_tags = NULL;
+   if ((0 == sz_tags) || (0 == ui_block_size_words))
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   px_renderer->pull_tags = (uint64_t *) malloc (sz_tags * sizeof (uint64_t));
+   if (NULL == px_renderer->pull_tags)
+   {
+      return eCACHESIM_RET_FAILURE;
+   }
+   (void) memset (px_renderer->pull_tags, 0xFF, sz_tags * sizeof (uint64_t));
+   return eCACHESIM_RET_SUCCESS;
+}
+
+static void cachesim_event_renderer_deinit (
+   CACHESIM_EVENT_RENDERER_X *px_renderer)
+{
+   free (px_renderer->pull_tags);
+   px_renderer->pull_tags = NULL;
+}
+
+static void cachesim_event_render_header (
+   CACHESIM_EVENT_RENDERER_X *px_renderer)
+{
+   uint32_t ui_i = 0;
+   uint32_t ui_l = 0;
+   FILE *px_out = px_renderer->px_out;
+   char uca_format_string [256] = { '\0' };
+   char uca_line_str[256] = { '\0' };
+   uint32_t ui_line_str_len = 0;
+   uint32_t ui_width_qualifier = 0;
+
+   ui_width_qualifier = px_renderer->ui_ways * 9; //strlen ("%4d-%4d");
+   ui_width_qualifier += (px_renderer->ui_ways - 1);
+
+   fprintf (px_out, "%7s |", " RAM Idx");
+
+   snprintf ((uca_format_string), sizeof(uca_format_string), " %%%dd |",
+      ui_width_qualifier);
+
+   for (ui_i = 0; ui_i < px_renderer->ui_sets; ui_i++)
+   {
+      fprintf (px_out, uca_format_string, ui_i);
+   }
+
+   fprintf (px_out, " Hit/Miss | Set/Blk Idx |\n");
+
+
+   fprintf (px_out, "%8s-+", "--------");
+
+   (void) memset (uca_format_string, 0x00, sizeof(uca_format_string));
+
+   snprintf ((uca_format_string), sizeof(uca_format_string), "-%%%ds-",
+      ui_width_qualifier);
+   for (ui_l = 0; ui_l < ui_width_qualifier; ui_l++)
+   {
+      ui_line_str_len = strnlen ((uca_line_str), sizeof(uca_line_str));
+      snprintf ((uca_line_str + ui_line_str_len), sizeof(uca_line_str), "-");
+   }
+   for (ui_l = 0; ui_l < px_renderer->ui_sets; ui_l++)
+   {
+      fprintf (px_out, uca_format_string, uca_line_str);
+
+      if (ui_l < (px_renderer->ui_sets - 1))
+      {
+         fprintf (px_out, "+");
+      }
+   }
+
+   fprintf (px_out, "+-%8s-+", "--------");
+   fprintf (px_out, "-%11s-+", "-----------");
+
+   fprintf (px_out, "\n");
+}
+
+/*
+ * One row of the table: the contents of the cache after the access, whether
+ * it hit and the set and way it used.
+ */
+static void cachesim_event_render (
+   CACHESIM_EVENT_RENDERER_X *px_renderer,
+   const CACHESIM_EVENT_X *px_event)
+{
+   uint32_t ui_k = 0;
+   uint32_t ui_l = 0;
+   uint64_t *pull_tags = NULL;
+   uint64_t ull_start_idx = 0;
+   uint32_t ui_block_size_words = px_renderer->ui_block_size_words;
+   FILE *px_out = px_renderer->px_out;
+   const char *pc_outcome = "Hit";
+
+   if ((eCACHESIM_EVENT_OUTCOME_FILL == px_event->uc_outcome)
+      && (px_event->ui_cache_set < px_renderer->ui_sets)
+      && (px_event->ui_block_idx < px_renderer->ui_ways))
+   {
+      px_renderer->pull_tags [((size_t) px_event->ui_cache_set * px_renderer->ui_ways)
+         + px_event->ui_block_idx] = px_event->ull_index / ui_block_size_words;
+   }
+
+   fprintf (px_out, "%8" PRIu64 " | ", px_event->ull_index);
+   for (ui_l = 0; ui_l < px_renderer->ui_sets; ui_l++)
+   {
+      pull_tags = px_renderer->pull_tags + ((size_t) ui_l * px_renderer->ui_ways);
+      for (ui_k = 0; ui_k < px_renderer->ui_ways; ui_k++)
+      {
+         ull_start_idx = pull_tags [ui_k] * ui_block_size_words;
+         fprintf (px_out, "%4" PRIu64 "-%4" PRIu64,
+            (CACHESIM_INVALID_TAG == pull_tags [ui_k]) ?
+                  9999 : ull_start_idx,
+            (CACHESIM_INVALID_TAG == pull_tags [ui_k]) ?
+                  9999 : ull_start_idx + ui_block_size_words - 1);
+         if (ui_k < px_renderer->ui_ways - 1)
+            fprintf (px_out, "/");
+      }
+      fprintf (px_out, " | ");
+   }
+
+   if (eCACHESIM_EVENT_OUTCOME_HIT != px_event->uc_outcome)
+   {
+      pc_outcome =
+         (eCACHESIM_MISS_TYPE_COMPULSORY == px_event->uc_miss_type) ? "Com Miss" :
+         (eCACHESIM_MISS_TYPE_CONFLICT == px_event->uc_miss_type) ? "Con Miss" : "Cap Miss";
+   }
+   if (CACHESIM_MAX_INDEX_VALUE == px_event->ui_block_idx)
+   {
+      /*
+       * Write miss that bypassed the cache (no-write-allocate).
+       */
+      fprintf (px_out, "%8s | %5d/%5s |\n", pc_outcome, px_event->ui_cache_set, "-");
+   }
+   else
+   {
+      fprintf (px_out, "%8s | %5d/%5d |\n", pc_outcome, px_event->ui_cache_set,
+         px_event->ui_block_idx);
+   }
+}
+
+static void cachesim_event_encode (
+   const CACHESIM_EVENT_X *px_event,
+   uint8_t *puc_record)
+{
+   cachesim_put_le64 (puc_record, px_event->ull_index);
+   cachesim_put_le32 (puc_record + 8, px_event->ui_cache_set);
+   cachesim_put_le32 (puc_record + 12, px_event->ui_block_idx);
+   puc_record [16] = px_event->uc_outcome;
+   puc_record [17] = px_event->uc_miss_type;
+   (void) memset (puc_record + 18, 0, 6);
+}
+
+static bool cachesim_event_decode (
+   const uint8_t *puc_record,
+   uint32_t ui_version,
+   CACHESIM_EVENT_X *px_event)
+{
+   size_t sz_index_size = (1 == ui_version) ? 4 : 8;
+
+   px_event->ull_index = (1 == ui_version) ?
+      cachesim_get_le32 (puc_record) : cachesim_get_le64 (puc_record);
+   px_event->ui_cache_set = cachesim_get_le32 (puc_record + sz_index_size);
+   px_event->ui_block_idx = cachesim_get_le32 (puc_record + sz_index_size + 4);
+   px_event->uc_outcome = puc_record [sz_index_size + 8];
+   px_event->uc_miss_type = puc_record [sz_index_size + 9];
+   return (px_event->uc_outcome < eCACHESIM_EVENT_OUTCOME_MAX)
+      && (px_event->uc_miss_type < eCACHESIM_MISS_TYPE_MAX);
+}
+
+/*
+ * Drains the ring in chunks of at most CACHESIM_EVENT_LOG_WRITE_BATCH
+ * events, handing each chunk back to the producer as soon as it has been
+ * written. An idle writer flushes what it wrote and naps.
+ */
+static CACHESIM_THREAD_RETURN cachesim_event_log_writer (void *pv_arg)
+{
+   CACHESIM_EVENT_LOG_X *px_log = (CACHESIM_EVENT_LOG_X *) pv_arg;
+   const CACHESIM_EVENT_X *px_event = NULL;
+   uint64_t ull_tail = 0;
+   uint64_t ull_head = 0;
+   uint64_t ull_stop = 0;
+   uint32_t ui_count = 0;
+   uint32_t ui_i = 0;
+
+   while (1)
+   {
+      /*
+       * The producer publishes its last event before it sets ull_stop, so a
+       * head loaded after seeing the stop holds every event.
+       */
+      ull_stop = CACHESIM_LOAD_ACQUIRE (&(px_log->ull_stop));
+      ull_head = CACHESIM_LOAD_ACQUIRE (&(px_log->ull_head));
+      if (ull_tail == ull_head)
+      {
+         if (0 != ull_stop)
+         {
+            break;
+         }
+         (void) fflush ((NULL != px_log->px_file) ?
+            px_log->px_file : px_log->x_renderer.px_out);
+         usleep (CACHESIM_EVENT_LOG_IDLE_SLEEP_US);
+         continue;
+      }
+      ui_count = (ull_head - ull_tail > CACHESIM_EVENT_LOG_WRITE_BATCH) ?
+         CACHESIM_EVENT_LOG_WRITE_BATCH : (uint32_t) (ull_head - ull_tail);
+      for (ui_i = 0; ui_i < ui_count; ui_i++)
+      {
+         px_event = &(px_log->px_ring [(ull_tail + ui_i) & px_log->ui_ring_mask]);
+         if (NULL != px_log->px_file)
+         {
+            cachesim_event_encode (px_event,
+               px_log->puc_buffer + ((size_t) ui_i * CACHESIM_EVENT_LOG_RECORD_SIZE));
+         }
+         else
+         {
+            cachesim_event_render (&(px_log->x_renderer), px_event);
+         }
+      }
+      if ((NULL != px_log->px_file)
+         && (ui_count != fwrite (px_log->puc_buffer, CACHESIM_EVENT_LOG_RECORD_SIZE,
+            ui_count, px_log->px_file)))
+      {
+         px_log->b_write_failed = true;
+      }
+      ull_tail += ui_count;
+      CACHESIM_STORE_RELEASE (&(px_log->ull_tail), ull_tail);
+   }
+   return 0;
+}
+
+static void cachesim_event_log_free (
+   CACHESIM_EVENT_LOG_X *px_log)
+{
+   if (NULL != px_log->px_file)
+   {
+      if (0 != fclose (px_log->px_file))
+      {
+         px_log->b_write_failed = true;
+      }
+      if (true == px_log->b_write_failed)
+      {
+         fprintf (stderr, "Writing the event log failed\n");
+      }
+   }
+   cachesim_event_renderer_deinit (&(px_log->x_renderer));
+   free (px_log->puc_buffer);
+   free (px_log->px_ring);
+   free (px_log);
+}
+
+/*
+ * Starts logging the accesses to the cache: from here on every access is
+ * appended to the ring and written out by a background thread, to the file
+ * named by x_cache_params.pc_event_log_file or rendered to stdout.
+ */
+static CACHESIM_RET_E cachesim_event_log_open (
+   CACHE_SET_X *px_cache)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_EVENT_LOG_X *px_log = NULL;
+   const char *pc_file = NULL;
+   uint8_t uca_header [CACHESIM_EVENT_LOG_HEADER_SIZE] = {0};
+
+   if ((NULL == px_cache) || (NULL != px_cache->px_event_log))
+   {
+      goto CLEAN_RETURN;
+   }
+   px_log = (CACHESIM_EVENT_LOG_X *) calloc (1, sizeof (*px_log));
+   if (NULL == px_log)
+   {
+      goto CLEAN_RETURN;
+   }
+   px_log->px_ring = (CACHESIM_EVENT_X *) malloc (
+      CACHESIM_EVENT_LOG_RING_SIZE * sizeof (CACHESIM_EVENT_X));
+   if (NULL == px_log->px_ring)
+   {
+      goto CLEAN_RETURN;
+   }
+   px_log->ui_ring_mask = CACHESIM_EVENT_LOG_RING_SIZE - 1;
+
+   pc_file = px_cache->x_cache_params.pc_event_log_file;
+   if (NULL != pc_file)
+   {
+      px_log->puc_buffer = (uint8_t *) malloc (
+         CACHESIM_EVENT_LOG_WRITE_BATCH * CACHESIM_EVENT_LOG_RECORD_SIZE);
+      if (NULL == px_log->puc_buffer)
+      {
+         goto CLEAN_RETURN;
+      }
+      px_log->px_file = fopen (pc_file, "wb");
+      if (NULL == px_log->px_file)
+      {
+         fprintf (stderr, "Unable to create %s: %s\n", pc_file, strerror (errno));
+         goto CLEAN_RETURN;
+      }
+      (void) memcpy (uca_header, CACHESIM_EVENT_LOG_MAGIC,
+         CACHESIM_EVENT_LOG_MAGIC_LEN);
+      cachesim_put_le32 (uca_header + 8, CACHESIM_EVENT_LOG_VERSION);
+      cachesim_put_le32 (uca_header + 12, px_cache->ui_configured_no_of_sets);
+      cachesim_put_le32 (uca_header + 16, px_cache->ui_no_of_blocks_per_set);
+      cachesim_put_le32 (uca_header + 20,
+         px_cache->x_cache_params.ui_block_size_words);
+      cachesim_put_le32 (uca_header + 24,
+         px_cache->x_cache_params.ui_word_size_bytes);
+      if (1 != fwrite (uca_header, sizeof (uca_header), 1, px_log->px_file))
+      {
+         fprintf (stderr, "Unable to write %s\n", pc_file);
+         goto CLEAN_RETURN;
+      }
+   }
+   else
+   {
+      if (eCACHESIM_RET_SUCCESS != cachesim_event_renderer_init (
+         &(px_log->x_renderer), stdout, px_cache->ui_configured_no_of_sets,
+         px_cache->ui_no_of_blocks_per_set,
+         px_cache->x_cache_params.ui_block_size_words))
+      {
+         goto CLEAN_RETURN;
+      }
+      cachesim_event_render_header (&(px_log->x_renderer));
+   }
+
+   /*
+    * Whatever the simulation printed so far goes out ahead of the rows.
+    */
+   (void) fflush (stdout);
+   if (eCACHESIM_RET_SUCCESS != cachesim_thread_create (&(px_log->x_thread),
+      cachesim_event_log_writer, px_log))
+   {
+      goto CLEAN_RETURN;
+   }
+   px_cache->px_event_log = px_log;
+   px_log = NULL;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (NULL != px_log)
+   {
+      cachesim_event_log_free (px_log);
+   }
+   return e_ret_val;
+}
+
+/*
+ * Stops logging: waits for the writer to drain the ring and closes the log.
+ * Nothing to do when the cache is not logged.
+ */
+static void cachesim_event_log_close (
+   CACHE_SET_X *px_cache)
+{
+   CACHESIM_EVENT_LOG_X *px_log = px_cache->px_event_log;
+
+   if (NULL == px_log)
+   {
+      return;
+   }
+   CACHESIM_STORE_RELEASE (&(px_log->ull_stop), 1);
+   cachesim_thread_join (px_log->x_thread);
+   (void) fflush (stdout);
+   cachesim_event_log_free (px_log);
+   px_cache->px_event_log = NULL;
+}
+
+/*
+ * Waits until every event logged so far has been written, so that output
+ * printed next by the simulation comes after their rows.
+ */
+static void cachesim_event_log_sync (
+   CACHE_SET_X *px_cache)
+{
+   CACHESIM_EVENT_LOG_X *px_log = px_cache->px_event_log;
+
+   if (NULL == px_log)
+   {
+      return;
+   }
+   while (CACHESIM_LOAD_ACQUIRE (&(px_log->ull_tail)) != px_log->ull_head)
+   {
+      usleep (CACHESIM_EVENT_LOG_FULL_SLEEP_US);
+   }
+   (void) fflush (stdout);
+}
+
+/*
+ * Appends an event to the ring. Only when the ring looks full is the
+ * writer's position loaded again; if it really is full the simulation waits
+ * for the writer rather than dropping events.
+ */
+static inline void cachesim_event_log_put (
+   CACHESIM_EVENT_LOG_X *px_log,
+   uint64_t ull_index,
+   uint32_t ui_cache_set,
+   uint32_t ui_block_idx,
+   CACHESIM_EVENT_OUTCOME_E e_outcome,
+   CACHESIM_MISS_TYPE_E e_miss_type)
+{
+   uint64_t ull_head = px_log->ull_head;
+   CACHESIM_EVENT_X *px_event = NULL;
+
+   while ((ull_head - px_log->ull_tail_seen) > px_log->ui_ring_mask)
+   {
+      px_log->ull_tail_seen = CACHESIM_LOAD_ACQUIRE (&(px_log->ull_tail));
+      if ((ull_head - px_log->ull_tail_seen) > px_log->ui_ring_mask)
+      {
+         usleep (CACHESIM_EVENT_LOG_FULL_SLEEP_US);
+      }
+   }
+   px_event = &(px_log->px_ring [ull_head & px_log->ui_ring_mask]);
+   px_event->ull_index = ull_index;
+   px_event->ui_cache_set = ui_cache_set;
+   px_event->ui_block_idx = ui_block_idx;
+   px_event->uc_outcome = (uint8_t) e_outcome;
+   px_event->uc_miss_type = (uint8_t) e_miss_type;
+   CACHESIM_STORE_RELEASE (&(px_log->ull_head), ull_head + 1);
+}
+
+/*
+ * Demo mode pacing of the built-in algorithms. The rows logged so far are
+ * shown before the pause so the table grows one access at a time.
+ */
+static void cachesim_demo_pause (
+   CACHE_SET_X *px_cache)
+{
+   if (0 != px_cache->x_cache_params.ui_demo_pause_us)
+   {
+      cachesim_event_log_sync (px_cache);
+      usleep (px_cache->x_cache_params.ui_demo_pause_us);
+   }
+}
+
+/*
+ * Maps the whole file read-only, for a single front to back pass.
+ */
+static CACHESIM_RET_E cachesim_map_file (
+   const char *pc_file,
+   const uint8_t **ppuc_map,
+   size_t *psz_map_len)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+#ifdef _WIN32
+   HANDLE h_file = INVALID_HANDLE_VALUE;
+   HANDLE h_mapping = NULL;
+   LARGE_INTEGER x_size = {0};
+
+   h_file = CreateFileA (pc_file, GENERIC_READ, FILE_SHARE_READ, NULL,
+      OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+   if ((INVALID_HANDLE_VALUE == h_file) || (0 == GetFileSizeEx (h_file, &x_size))
+      || ((uint64_t) x_size.QuadPart > SIZE_MAX))
+   {
+      goto CLEAN_RETURN;
+   }
+   h_mapping = CreateFileMappingA (h_file, NULL, PAGE_READONLY, 0, 0, NULL);
+   if (NULL == h_mapping)
+   {
+      goto CLEAN_RETURN;
+   }
+   *ppuc_map = MapViewOfFile (h_mapping, FILE_MAP_READ, 0, 0, 0);
+   if (NULL == *ppuc_map)
+   {
+      goto CLEAN_RETURN;
+   }
+   *psz_map_len = (size_t) x_size.QuadPart;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   /*
+    * The view keeps the file mapped once both handles are closed.
+    */
+   if (NULL != h_mapping)
+   {
+      CloseHandle (h_mapping);
+   }
+   if (INVALID_HANDLE_VALUE != h_file)
+   {
+      CloseHandle (h_file);
+   }
+#else
+   int i_fd = -1;
+   struct stat x_stat;
+   void *pv_map = NULL;
+
+   i_fd = open (pc_file, O_RDONLY);
+   if ((i_fd < 0) || (0 != fstat (i_fd, &x_stat))
+      || ((uint64_t) x_stat.st_size > SIZE_MAX))
+   {
+      goto CLEAN_RETURN;
+   }
+   pv_map = mmap (NULL, (size_t) x_stat.st_size, PROT_READ, MAP_PRIVATE, i_fd, 0);
+   if (MAP_FAILED == pv_map)
+   {
+      goto CLEAN_RETURN;
+   }
+#ifdef MADV_SEQUENTIAL
+   (void) madvise (pv_map, (size_t) x_stat.st_size, MADV_SEQUENTIAL);
+#endif
+   *ppuc_map = pv_map;
+   *psz_map_len = (size_t) x_stat.st_size;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (i_fd >= 0)
+   {
+      close (i_fd);
+   }
+#endif
+   return e_ret_val;
+}
+
+static void cachesim_unmap_file (
+   const uint8_t *puc_map,
+   size_t sz_map_len)
+{
+#ifdef _WIN32
+   (void) sz_map_len;
+   (void) UnmapViewOfFile (puc_map);
+#else
+   (void) munmap ((void *) puc_map, sz_map_len);
+#endif
+}
+
+/*
+ * Maps the whole file read-only into px_reader->puc_map.
+ */
+static CACHESIM_RET_E cachesim_trace_map_file (
+   CACHESIM_TRACE_READER_X *px_reader,
+   const char *pc_trace_file)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+
+   e_ret_val = cachesim_map_file (pc_trace_file, &(px_reader->puc_map),
+      &(px_reader->sz_map_len));
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Unable to map trace file \"%s\"\n", pc_trace_file);
+   }
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_trace_open_binary (
+   CACHESIM_TRACE_READER_X *px_reader,
+   const char *pc_trace_file)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   const uint8_t *puc_header = NULL;
+   uint64_t ull_index_offset = 0;
+
+   e_ret_val = cachesim_trace_map_file (px_reader, pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = eCACHESIM_RET_FAILURE;
+   puc_header = px_reader->puc_map;
+   if ((px_reader->sz_map_len < CACHESIM_TRACE_BINARY_HEADER_SIZE)
+      || (0 == cachesim_get_le32 (puc_header + 8))
+      || (CACHESIM_TRACE_BINARY_VERSION < cachesim_get_le32 (puc_header + 8)))
+   {
+      fprintf (stderr, "Unsupported binary trace \"%s\"\n", pc_trace_file);
+      goto CLEAN_RETURN;
+   }
+   px_reader->ui_word_size_bytes = cachesim_get_le32 (puc_header + 12);
+   px_reader->ui_block_size_bytes = cachesim_get_le32 (puc_header + 16);
+   px_reader->ui_index_interval = cachesim_get_le32 (puc_header + 20);
+   px_reader->ull_records = cachesim_get_le64 (puc_header + 24);
+   ull_index_offset = cachesim_get_le64 (puc_header + 32);
+   px_reader->ull_index_entries = cachesim_get_le64 (puc_header + 40);
+   if ((0 == px_reader->ui_index_interval)
+      || (ull_index_offset < CACHESIM_TRACE_BINARY_HEADER_SIZE)
+      || (ull_index_offset > px_reader->sz_map_len)
+      || (px_reader->ull_index_entries
+         > ((px_reader->sz_map_len - ull_index_offset) / sizeof(uint64_t)))
+      || (px_reader->ull_index_entries
+         != ((px_reader->ull_records + px_reader->ui_index_interval - 1)
+            / px_reader->ui_index_interval)))
+   {
+      fprintf (stderr, "Corrupt binary trace header in \"%s\"\n", pc_trace_file);
+      goto CLEAN_RETURN;
+   }
+   px_reader->puc_pos = puc_header + CACHESIM_TRACE_BINARY_HEADER_SIZE;
+   px_reader->puc_end = puc_header + ull_index_offset;
+   px_reader->puc_index = px_reader->puc_end;
+   px_reader->b_binary = true;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_trace_open (
+   CACHESIM_TRACE_READER_X *px_reader,
+   const char *pc_trace_file)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+
+   if ((NULL == px_reader) || (NULL == pc_trace_file))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   (void) memset (px_reader, 0x00, sizeof(*px_reader));
+
+   /*
+    * "-" reads the trace from stdin so that compressed traces can be piped
+    * in without ever being unpacked to disk.
+    */
+   if (0 == strcmp (pc_trace_file, "-"))
+   {
+      px_reader->px_file = stdin;
+   }
+   else
+   {
+      px_reader->px_file = fopen (pc_trace_file, "rb");
+   }
+   if (NULL == px_reader->px_file)
+   {
+      fprintf (stderr, "Unable to open trace file \"%s\": %s\n", pc_trace_file,
+         strerror (errno));
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * Binary traces are recognised by their magic. They need a file that can
+    * be mapped, so stdin is always read as text.
+    */
+   if (stdin != px_reader->px_file)
+   {
+      char ca_magic [CACHESIM_TRACE_BINARY_MAGIC_LEN] = { '\0' };
+
+      if ((CACHESIM_TRACE_BINARY_MAGIC_LEN == fread (ca_magic, 1,
+            CACHESIM_TRACE_BINARY_MAGIC_LEN, px_reader->px_file))
+         && (0 == memcmp (ca_magic, CACHESIM_TRACE_BINARY_MAGIC,
+            CACHESIM_TRACE_BINARY_MAGIC_LEN)))
+      {
+         fclose (px_reader->px_file);
+         px_reader->px_file = NULL;
+         e_ret_val = cachesim_trace_open_binary (px_reader, pc_trace_file);
+         goto CLEAN_RETURN;
+      }
+      rewind (px_reader->px_file);
+   }
+
+   /*
+    * The trace is never loaded as a whole. It is consumed through one large
+    * buffer which is refilled with a single fread call at a time, so the
+    * memory footprint is independent of the trace size.
+    */
+   px_reader->pc_buffer = malloc (CACHESIM_TRACE_READ_BUFFER_SIZE);
+   if (NULL == px_reader->pc_buffer)
+   {
+      goto CLEAN_RETURN;
+   }
+   (void) setvbuf (px_reader->px_file, NULL, _IONBF, 0);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      cachesim_trace_close (px_reader);
+   }
+   return e_ret_val;
+}
+
+static void cachesim_trace_close (
+   CACHESIM_TRACE_READER_X *px_reader)
+{
+   if (NULL == px_reader)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   if ((NULL != px_reader->px_file) && (stdin != px_reader->px_file))
+   {
+      fclose (px_reader->px_file);
+   }
+   px_reader->px_file = NULL;
+
+   if (NULL != px_reader->puc_map)
+   {
+      cachesim_unmap_file (px_reader->puc_map, px_reader->sz_map_len);
+      px_reader->puc_map = NULL;
+   }
+
+   if (NULL != px_reader->pc_buffer)
+   {
+      free (px_reader->pc_buffer);
+      px_reader->pc_buffer = NULL;
+   }
+CLEAN_RETURN:
+   return;
+}
+
+static CACHESIM_RET_E cachesim_trace_refill (
+   CACHESIM_TRACE_READER_X *px_reader)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   size_t sz_remaining = 0;
+   size_t sz_read = 0;
+
+   /*
+    * Move the unconsumed tail (a partial line) to the front of the buffer and
+    * fill the rest of it from the file.
+    */
+   sz_remaining = px_reader->sz_buffer_len - px_reader->sz_buffer_pos;
+   if ((0 != sz_remaining) && (0 != px_reader->sz_buffer_pos))
+   {
+      (void) memmove (px_reader->pc_buffer,
+         px_reader->pc_buffer + px_reader->sz_buffer_pos, sz_remaining);
+   }
+   px_reader->sz_buffer_pos = 0;
+   px_reader->sz_buffer_len = sz_remaining;
+
+   if (CACHESIM_TRACE_READ_BUFFER_SIZE == sz_remaining)
+   {
+      fprintf (stderr, "Trace line %" PRIu64 " is too long\n",
+         px_reader->ull_line_no + 1);
+      goto CLEAN_RETURN;
+   }
+
+   sz_read = fread (px_reader->pc_buffer + sz_remaining, 1,
+      CACHESIM_TRACE_READ_BUFFER_SIZE - sz_remaining, px_reader->px_file);
+   if (0 == sz_read)
+   {
+      if (0 != ferror (px_reader->px_file))
+      {
+         fprintf (stderr, "Error reading trace: %s\n", strerror (errno));
+         goto CLEAN_RETURN;
+      }
+      px_reader->b_eof = true;
+   }
+   px_reader->sz_buffer_len += sz_read;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static inline bool cachesim_trace_is_separator (char c_char)
+{
+   return ((' ' == c_char) || ('\t' == c_char) || (',' == c_char)
+      || ('\r' == c_char));
+}
+
+static inline const char *cachesim_trace_skip_separators (
+   const char *pc_pos,
+   const char *pc_end)
+{
+   while ((pc_pos < pc_end) && (true == cachesim_trace_is_separator (*pc_pos)))
+   {
+      pc_pos++;
+   }
+   return pc_pos;
+}
+
+/*
+ * Marker lines of a text trace delimit its region of interest:
+ *
+ *    roi-begin
+ *    roi-end
+ *
+ * Returns false if the line is not a marker.
+ */
+static bool cachesim_trace_parse_marker (
+   const char *pc_pos,
+   const char *pc_end,
+   bool *pb_in_roi)
+{
+   static const char ac_begin[] = "roi-begin";
+   static const char ac_end[] = "roi-end";
+   size_t sz_len = 0;
+
+   pc_pos = cachesim_trace_skip_separators (pc_pos, pc_end);
+   if ((pc_pos == pc_end) || ('r' != *pc_pos))
+   {
+      return false;
+   }
+   if (((size_t) (pc_end - pc_pos) >= (sizeof(ac_begin) - 1))
+      && (0 == memcmp (pc_pos, ac_begin, sizeof(ac_begin) - 1)))
+   {
+      sz_len = sizeof(ac_begin) - 1;
+   }
+   else if (((size_t) (pc_end - pc_pos) >= (sizeof(ac_end) - 1))
+      && (0 == memcmp (pc_pos, ac_end, sizeof(ac_end) - 1)))
+   {
+      sz_len = sizeof(ac_end) - 1;
+   }
+   else
+   {
+      return false;
+   }
+   pc_pos = cachesim_trace_skip_separators (pc_pos + sz_len, pc_end);
+   if ((pc_pos != pc_end) && ('#' != *pc_pos))
+   {
+      return false;
+   }
+   *pb_in_roi = ((sizeof(ac_begin) - 1) == sz_len);
+   return true;
+}
+
+/*
+ * Parses one line of a text trace. A line looks like
+ *
+ *    [<core>:] <type> <address> [<size>]
+ *
+ * where the address is hexadecimal (the 0x prefix is optional) and the size
+ * is in bytes and decimal. The decimal core of multithreaded traces defaults
+ * to 0. Fields may be separated by blanks or commas, which
+ * accepts the usual "R 0x7ffd1040 8" form as well as valgrind lackey output
+ * (" L 7ffd1040,8") and dinero (0/1/2) type codes. Returns false for blank and
+ * comment ('#') lines; *pb_valid tells whether a non-empty line was malformed.
+ */
+static bool cachesim_trace_parse_line (
+   const char *pc_pos,
+   const char *pc_end,
+   CACHESIM_TRACE_RECORD_X *px_record,
+   bool *pb_valid)
+{
+   bool b_record = false;
+   uint64_t ull_address = 0;
+   uint32_t ui_size = 0;
+   uint32_t ui_digits = 0;
+   uint32_t ui_nibble = 0;
+   uint64_t ull_core = 0;
+   const char *pc_core_end = NULL;
+   char c_char = '\0';
+
+   *pb_valid = true;
+   pc_pos = cachesim_trace_skip_separators (pc_pos, pc_end);
+   if ((pc_pos == pc_end) || ('#' == *pc_pos))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * Digits followed by a colon are the core; dinero type codes are digits
+    * too but are followed by a separator.
+    */
+   for (pc_core_end = pc_pos; (pc_core_end < pc_end) && (*pc_core_end >= '0')
+      && (*pc_core_end <= '9') && (ull_core <= UINT32_MAX); pc_core_end++)
+   {
+      ull_core = (ull_core * 10) + (*pc_core_end - '0');
+   }
+   px_record->ui_core = 0;
+   if ((pc_core_end != pc_pos) && (pc_core_end < pc_end) && (':' == *pc_core_end))
+   {
+      if (ull_core > UINT32_MAX)
+      {
+         *pb_valid = false;
+         goto CLEAN_RETURN;
+      }
+      px_record->ui_core = (uint32_t) ull_core;
+      pc_pos = cachesim_trace_skip_separators (pc_core_end + 1, pc_end);
+      if (pc_pos == pc_end)
+      {
+         *pb_valid = false;
+         goto CLEAN_RETURN;
+      }
+   }
+
+   switch (*pc_pos)
+   {
+   case 'R': case 'r': case 'L': case 'l': case '0':
+      px_record->e_type = eCACHESIM_ACCESS_TYPE_READ;
+      break;
+   case 'W': case 'w': case 'S': case 's': case 'M': case 'm': case '1':
+      px_record->e_type = eCACHESIM_ACCESS_TYPE_WRITE;
+      break;
+   case 'I': case 'i': case '2':
+      px_record->e_type = eCACHESIM_ACCESS_TYPE_IFETCH;
+      break;
+   default:
+      *pb_valid = false;
+      goto CLEAN_RETURN;
+   }
+   pc_pos++;
+   if ((pc_pos < pc_end) && (false == cachesim_trace_is_separator (*pc_pos)))
+   {
+      *pb_valid = false;
+      goto CLEAN_RETURN;
+   }
+
+   pc_pos = cachesim_trace_skip_separators (pc_pos, pc_end);
+   if (((pc_end - pc_pos) > 2) && ('0' == pc_pos[0])
+      && (('x' == pc_pos[1]) || ('X' == pc_pos[1])))
+   {
+      pc_pos += 2;
+   }
+   for (; pc_pos < pc_end; pc_pos++)
+   {
+      c_char = *pc_pos;
+      if ((c_char >= '0') && (c_char <= '9'))
+         ui_nibble = c_char - '0';
+      else if ((c_char >= 'a') && (c_char <= 'f'))
+         ui_nibble = c_char - 'a' + 10;
+      else if ((c_char >= 'A') && (c_char <= 'F'))
+         ui_nibble = c_char - 'A' + 10;
+      else
+         break;
+      ull_address = (ull_address << 4) | ui_nibble;
+      ui_digits++;
+   }
+   if ((0 == ui_digits) || (ui_digits > 16))
+   {
+      *pb_valid = false;
+      goto CLEAN_RETURN;
+   }
+
+   pc_pos = cachesim_trace_skip_separators (pc_pos, pc_end);
+   for (; (pc_pos < pc_end) && (*pc_pos >= '0') && (*pc_pos <= '9'); pc_pos++)
+   {
+      ui_size = (ui_size * 10) + (*pc_pos - '0');
+   }
+   pc_pos = cachesim_trace_skip_separators (pc_pos, pc_end);
+   if ((pc_pos != pc_end) && ('#' != *pc_pos))
+   {
+      *pb_valid = false;
+      goto CLEAN_RETURN;
+   }
+
+   px_record->ull_address = ull_address;
+   px_record->ui_size_bytes = ui_size;
+   b_record = true;
+CLEAN_RETURN:
+   return b_record;
+}
+
+static inline bool cachesim_trace_get_varint (
+   const uint8_t **ppuc_pos,
+   const uint8_t *puc_end,
+   uint64_t *pull_value)
+{
+   const uint8_t *puc_pos = *ppuc_pos;
+   uint64_t ull_value = 0;
+   uint32_t ui_shift = 0;
+   uint8_t uc_byte = 0;
+
+   while ((puc_pos < puc_end) && (ui_shift < 64))
+   {
+      uc_byte = *puc_pos++;
+      ull_value |= (uint64_t) (uc_byte & 0x7F) << ui_shift;
+      if (0 == (uc_byte & 0x80))
+      {
+         *ppuc_pos = puc_pos;
+         *pull_value = ull_value;
+         return true;
+      }
+      ui_shift += 7;
+   }
+   return false;
+}
+
+static inline size_t cachesim_trace_put_varint (
+   uint8_t *puc_bytes,
+   uint64_t ull_value)
+{
+   size_t sz_len = 0;
+
+   while (ull_value >= 0x80)
+   {
+      puc_bytes [sz_len++] = (uint8_t) (ull_value | 0x80);
+      ull_value >>= 7;
+   }
+   puc_bytes [sz_len++] = (uint8_t) ull_value;
+   return sz_len;
+}
+
+static CACHESIM_RET_E cachesim_trace_read_binary_record (
+   CACHESIM_TRACE_READER_X *px_reader,
+   CACHESIM_TRACE_RECORD_X *px_record,
+   bool *pb_end_of_trace)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint64_t ull_key = 0;
+   uint64_t ull_key_next = 0;
+   uint64_t ull_delta = 0;
+   uint64_t ull_size = 0;
+   uint32_t ui_type = 0;
+
+   if (px_reader->ull_record_no == px_reader->ull_records)
+   {
+      *pb_end_of_trace = true;
+      e_ret_val = eCACHESIM_RET_SUCCESS;
+      goto CLEAN_RETURN;
+   }
+   if (0 == (px_reader->ull_record_no % px_reader->ui_index_interval))
+   {
+      (void) memset (px_reader->ulla_prev_address, 0x00,
+         sizeof(px_reader->ulla_prev_address));
+      (void) memset (px_reader->uia_prev_size, 0x00,
+         sizeof(px_reader->uia_prev_size));
+      px_reader->ui_core = 0;
+   }
+   if (false == cachesim_trace_get_varint (&(px_reader->puc_pos),
+      px_reader->puc_end, &ull_key))
+   {
+      goto MALFORMED;
+   }
+   ui_type = (uint32_t) (ull_key & CACHESIM_TRACE_BINARY_TYPE_MASK);
+   if ((CACHESIM_TRACE_BINARY_TYPE_ESCAPE == ui_type)
+      && ((ull_key >> CACHESIM_TRACE_BINARY_KEY_SHIFT) >= eCACHESIM_ACCESS_TYPE_MAX))
+   {
+      ull_key = (ull_key >> CACHESIM_TRACE_BINARY_KEY_SHIFT) - eCACHESIM_ACCESS_TYPE_MAX;
+      if ((ull_key > UINT32_MAX)
+         || (false == cachesim_trace_get_varint (&(px_reader->puc_pos),
+            px_reader->puc_end, &ull_key_next)))
+      {
+         goto MALFORMED;
+      }
+      px_reader->ui_core = (uint32_t) ull_key;
+      ull_key = ull_key_next;
+      ui_type = (uint32_t) (ull_key & CACHESIM_TRACE_BINARY_TYPE_MASK);
+   }
+   if (CACHESIM_TRACE_BINARY_TYPE_ESCAPE == ui_type)
+   {
+      ui_type = (uint32_t) (ull_key >> CACHESIM_TRACE_BINARY_KEY_SHIFT);
+      if ((ui_type >= eCACHESIM_ACCESS_TYPE_MAX)
+         || ((px_reader->puc_end - px_reader->puc_pos) < (ptrdiff_t) sizeof(uint64_t)))
+      {
+         goto MALFORMED;
+      }
+      px_record->ull_address = cachesim_get_le64 (px_reader->puc_pos);
+      px_reader->puc_pos += sizeof(uint64_t);
+   }
+   else
+   {
+      ull_delta = ull_key >> CACHESIM_TRACE_BINARY_KEY_SHIFT;
+      px_record->ull_address = px_reader->ulla_prev_address [ui_type]
+         + ((ull_delta >> 1) ^ (0 - (ull_delta & 1)));
+   }
+   px_reader->ulla_prev_address [ui_type] = px_record->ull_address;
+   switch (ui_type)
+   {
+   case 0:
+      px_record->e_type = eCACHESIM_ACCESS_TYPE_READ;
+      break;
+   case 1:
+      px_record->e_type = eCACHESIM_ACCESS_TYPE_WRITE;
+      break;
+   case 2:
+      px_record->e_type = eCACHESIM_ACCESS_TYPE_IFETCH;
+      break;
+   default:
+      goto MALFORMED;
+   }
+   if (0 != (ull_key & CACHESIM_TRACE_BINARY_SIZE_FLAG))
+   {
+      if ((false == cachesim_trace_get_varint (&(px_reader->puc_pos),
+            px_reader->puc_end, &ull_size)) || (ull_size > UINT32_MAX))
+      {
+         goto MALFORMED;
+      }
+      px_reader->uia_prev_size [ui_type] = (uint32_t) ull_size;
+   }
+   px_record->ui_size_bytes = px_reader->uia_prev_size [ui_type];
+   px_record->ui_core = px_reader->ui_core;
+   px_reader->ull_record_no++;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+   goto CLEAN_RETURN;
+MALFORMED:
+   fprintf (stderr, "Malformed binary trace record %" PRIu64 "\n",
+      px_reader->ull_record_no + 1);
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_trace_read_record (
+   CACHESIM_TRACE_READER_X *px_reader,
+   CACHESIM_TRACE_RECORD_X *px_record,
+   bool *pb_end_of_trace)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   const char *pc_line = NULL;
+   const char *pc_end = NULL;
+   const char *pc_newline = NULL;
+   bool b_valid = false;
+
+   if ((NULL == px_reader) || (NULL == px_record) || (NULL == pb_end_of_trace))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   *pb_end_of_trace = false;
+   if (true == px_reader->b_binary)
+   {
+      e_ret_val = cachesim_trace_read_binary_record (px_reader, px_record,
+         pb_end_of_trace);
+      goto CLEAN_RETURN;
+   }
+   while (1)
+   {
+      pc_line = px_reader->pc_buffer + px_reader->sz_buffer_pos;
+      pc_end = px_reader->pc_buffer + px_reader->sz_buffer_len;
+      pc_newline = memchr (pc_line, '\n', pc_end - pc_line);
+      if (NULL == pc_newline)
+      {
+         if (false == px_reader->b_eof)
+         {
+            e_ret_val = cachesim_trace_refill (px_reader);
+            if (eCACHESIM_RET_SUCCESS != e_ret_val)
+            {
+               goto CLEAN_RETURN;
+            }
+            continue;
+         }
+         if (pc_line == pc_end)
+         {
+            *pb_end_of_trace = true;
+            e_ret_val = eCACHESIM_RET_SUCCESS;
+            goto CLEAN_RETURN;
+         }
+         /*
+          * Last line of the trace without a terminating newline.
+          */
+         pc_newline = pc_end;
+      }
+
+      px_reader->ull_line_no++;
+      px_reader->sz_buffer_pos = (pc_newline - px_reader->pc_buffer);
+      if (pc_newline != pc_end)
+      {
+         px_reader->sz_buffer_pos++;
+      }
+
+      if (true == cachesim_trace_parse_marker (pc_line, pc_newline,
+         &(px_reader->b_in_roi)))
+      {
+         continue;
+      }
+      if (true == cachesim_trace_parse_line (pc_line, pc_newline, px_record,
+         &b_valid))
+      {
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+         break;
+      }
+      if (false == b_valid)
+      {
+         fprintf (stderr, "Malformed trace record at line %" PRIu64 ": \"%.*s\"\n",
+            px_reader->ull_line_no, (int) (pc_newline - pc_line), pc_line);
+         e_ret_val = eCACHESIM_RET_FAILURE;
+         break;
+      }
+   }
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Skips forward so that the next record read is record ull_record (counted
+ * from 0). Binary traces jump to the last index entry at or before it; text
+ * traces are read through. Seeking past the end is not an error, the next
+ * read then reports the end of the trace.
+ */
+static CACHESIM_RET_E cachesim_trace_seek (
+   CACHESIM_TRACE_READER_X *px_reader,
+   uint64_t ull_record)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_SUCCESS;
+   CACHESIM_TRACE_RECORD_X x_record = {0};
+   uint64_t ull_entry = 0;
+   uint64_t ull_offset = 0;
+   uint64_t ull_skipped = 0;
+   bool b_end_of_trace = false;
+
+   if (NULL == px_reader)
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+      goto CLEAN_RETURN;
+   }
+   if (true == px_reader->b_binary)
+   {
+      if (ull_record >= px_reader->ull_records)
+      {
+         px_reader->ull_record_no = px_reader->ull_records;
+         goto CLEAN_RETURN;
+      }
+      ull_entry = ull_record / px_reader->ui_index_interval;
+      if (ull_entry > (px_reader->ull_record_no / px_reader->ui_index_interval))
+      {
+         ull_offset = cachesim_get_le64 (px_reader->puc_index
+            + (ull_entry * sizeof(uint64_t)));
+         if ((ull_offset < CACHESIM_TRACE_BINARY_HEADER_SIZE)
+            || (ull_offset > (uint64_t) (px_reader->puc_end - px_reader->puc_map)))
+         {
+            fprintf (stderr, "Corrupt binary trace index entry %" PRIu64 "\n",
+               ull_entry);
+            e_ret_val = eCACHESIM_RET_FAILURE;
+            goto CLEAN_RETURN;
+         }
+         px_reader->puc_pos = px_reader->puc_map + ull_offset;
+         px_reader->ull_record_no = ull_entry * px_reader->ui_index_interval;
+      }
+      ull_skipped = px_reader->ull_record_no;
+   }
+   for (; ull_skipped < ull_record; ull_skipped++)
+   {
+      e_ret_val = cachesim_trace_read_record (px_reader, &x_record,
+         &b_end_of_trace);
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+      {
+         break;
+      }
+   }
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Decodes the trace into px_buffer, from record ull_fast_forward on and at
+ * most ull_max_records records of it (all of them when 0).
+ */
+static CACHESIM_RET_E cachesim_trace_load (
+   CACHESIM_TRACE_BUFFER_X *px_buffer,
+   const char *pc_trace_file,
+   uint64_t ull_fast_forward,
+   uint64_t ull_max_records)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_READER_X x_reader = {0};
+   CACHESIM_TRACE_RECORD_X *px_records = NULL;
+   uint64_t ull_capacity = 0;
+   bool b_end_of_trace = false;
+
+   if ((NULL == px_buffer) || (NULL == pc_trace_file))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   e_ret_val = cachesim_trace_open (&x_reader, pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      e_ret_val = cachesim_trace_seek (&x_reader, ull_fast_forward);
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      cachesim_trace_close (&x_reader);
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * A binary trace knows its length, so the buffer is sized once.
+    */
+   if ((true == x_reader.b_binary)
+      && (x_reader.ull_records > x_reader.ull_record_no))
+   {
+      px_buffer->ull_capacity = x_reader.ull_records - x_reader.ull_record_no;
+      if ((0 != ull_max_records) && (ull_max_records < px_buffer->ull_capacity))
+      {
+         px_buffer->ull_capacity = ull_max_records;
+      }
+      px_buffer->px_records = malloc (
+         (size_t) px_buffer->ull_capacity * sizeof(CACHESIM_TRACE_RECORD_X));
+      if (NULL == px_buffer->px_records)
+      {
+         fprintf (stderr, "Unable to hold %" PRIu64 " trace records\n",
+            px_buffer->ull_capacity);
+         px_buffer->ull_capacity = 0;
+         e_ret_val = eCACHESIM_RET_FAILURE;
+         cachesim_trace_close (&x_reader);
+         goto CLEAN_RETURN;
+      }
+   }
+   while ((0 == ull_max_records) || (px_buffer->ull_count < ull_max_records))
+   {
+      if (px_buffer->ull_count == px_buffer->ull_capacity)
+      {
+         ull_capacity = (0 == px_buffer->ull_capacity) ?
+            CACHESIM_TRACE_BUFFER_MIN_RECORDS : (px_buffer->ull_capacity * 2);
+         px_records = realloc (px_buffer->px_records,
+            (size_t) ull_capacity * sizeof(CACHESIM_TRACE_RECORD_X));
+         if (NULL == px_records)
+         {
+            fprintf (stderr, "Unable to hold %" PRIu64 " trace records\n",
+               ull_capacity);
+            e_ret_val = eCACHESIM_RET_FAILURE;
+            break;
+         }
+         px_buffer->px_records = px_records;
+         px_buffer->ull_capacity = ull_capacity;
+      }
+      e_ret_val = cachesim_trace_read_record (&x_reader,
+         &(px_buffer->px_records[px_buffer->ull_count]), &b_end_of_trace);
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+      {
+         break;
+      }
+      px_buffer->ull_count++;
+   }
+   cachesim_trace_close (&x_reader);
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static void cachesim_trace_buffer_free (
+   CACHESIM_TRACE_BUFFER_X *px_buffer)
+{
+   if (NULL != px_buffer)
+   {
+      free (px_buffer->px_records);
+      memset (px_buffer, 0x00, sizeof(*px_buffer));
+   }
+}
+
+static CACHESIM_RET_E cachesim_trace_writer_flush (
+   CACHESIM_TRACE_WRITER_X *px_writer)
+{
+   if ((0 != px_writer->sz_buffer_len)
+      && (px_writer->sz_buffer_len != fwrite (px_writer->puc_buffer, 1,
+         px_writer->sz_buffer_len, px_writer->px_file)))
+   {
+      fprintf (stderr, "Error writing binary trace: %s\n", strerror (errno));
+      return eCACHESIM_RET_FAILURE;
+   }
+   px_writer->sz_buffer_len = 0;
+   return eCACHESIM_RET_SUCCESS;
+}
+
+static CACHESIM_RET_E cachesim_trace_writer_open (
+   CACHESIM_TRACE_WRITER_X *px_writer,
+   const char *pc_file,
+   uint32_t ui_word_size_bytes,
+   uint32_t ui_block_size_bytes)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+
+   (void) memset (px_writer, 0x00, sizeof(*px_writer));
+   px_writer->ui_word_size_bytes = ui_word_size_bytes;
+   px_writer->ui_block_size_bytes = ui_block_size_bytes;
+   px_writer->px_file = fopen (pc_file, "wb");
+   if (NULL == px_writer->px_file)
+   {
+      fprintf (stderr, "Unable to create binary trace \"%s\": %s\n", pc_file,
+         strerror (errno));
+      goto CLEAN_RETURN;
+   }
+   px_writer->puc_buffer = malloc (CACHESIM_TRACE_WRITE_BUFFER_SIZE);
+   if (NULL == px_writer->puc_buffer)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * The header is rewritten with the final counts once the trace is done.
+    */
+   (void) memset (px_writer->puc_buffer, 0x00, CACHESIM_TRACE_BINARY_HEADER_SIZE);
+   px_writer->sz_buffer_len = CACHESIM_TRACE_BINARY_HEADER_SIZE;
+   px_writer->ull_offset = CACHESIM_TRACE_BINARY_HEADER_SIZE;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_trace_writer_put (
+   CACHESIM_TRACE_WRITER_X *px_writer,
+   const CACHESIM_TRACE_RECORD_X *px_record)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_SUCCESS;
+   uint64_t *pull_index = NULL;
+   uint64_t ull_delta = 0;
+   uint64_t ull_key = 0;
+   uint8_t *puc_pos = NULL;
+   uint8_t *puc_start = NULL;
+
+   /*
+    * A record takes at most three 10 byte varints and a raw address.
+    */
+   if ((CACHESIM_TRACE_WRITE_BUFFER_SIZE - px_writer->sz_buffer_len) < 48)
+   {
+      e_ret_val = cachesim_trace_writer_flush (px_writer);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         goto CLEAN_RETURN;
+      }
+   }
+   if (0 == (px_writer->ull_records % CACHESIM_TRACE_BINARY_INDEX_INTERVAL))
+   {
+      if (px_writer->ull_index_entries == px_writer->ull_index_capacity)
+      {
+         px_writer->ull_index_capacity = (0 == px_writer->ull_index_capacity) ?
+            64 : (px_writer->ull_index_capacity * 2);
+         pull_index = realloc (px_writer->pull_index,
+            (size_t) px_writer->ull_index_capacity * sizeof(uint64_t));
+         if (NULL == pull_index)
+         {
+            e_ret_val = eCACHESIM_RET_FAILURE;
+            goto CLEAN_RETURN;
+         }
+         px_writer->pull_index = pull_index;
+      }
+      px_writer->pull_index [px_writer->ull_index_entries++] = px_writer->ull_offset;
+      (void) memset (px_writer->ulla_prev_address, 0x00,
+         sizeof(px_writer->ulla_prev_address));
+      (void) memset (px_writer->uia_prev_size, 0x00,
+         sizeof(px_writer->uia_prev_size));
+      px_writer->ui_core = 0;
+   }
+
+   puc_start = px_writer->puc_buffer + px_writer->sz_buffer_len;
+   puc_pos = puc_start;
+   if (px_record->ui_core != px_writer->ui_core)
+   {
+      puc_pos += cachesim_trace_put_varint (puc_pos,
+         (((uint64_t) px_record->ui_core + eCACHESIM_ACCESS_TYPE_MAX)
+            << CACHESIM_TRACE_BINARY_KEY_SHIFT) | CACHESIM_TRACE_BINARY_TYPE_ESCAPE);
+      px_writer->ui_core = px_record->ui_core;
+   }
+   ull_delta = px_record->ull_address
+      - px_writer->ulla_prev_address [px_record->e_type];
+   ull_delta = (ull_delta << 1) ^ (0 - (ull_delta >> 63));
+   if (px_record->ui_size_bytes != px_writer->uia_prev_size [px_record->e_type])
+   {
+      ull_key |= CACHESIM_TRACE_BINARY_SIZE_FLAG;
+   }
+   if (ull_delta > (UINT64_MAX >> CACHESIM_TRACE_BINARY_KEY_SHIFT))
+   {
+      ull_key |= ((uint64_t) px_record->e_type << CACHESIM_TRACE_BINARY_KEY_SHIFT)
+         | CACHESIM_TRACE_BINARY_TYPE_ESCAPE;
+      puc_pos += cachesim_trace_put_varint (puc_pos, ull_key);
+      cachesim_put_le64 (puc_pos, px_record->ull_address);
+      puc_pos += sizeof(uint64_t);
+   }
+   else
+   {
+      ull_key |= (ull_delta << CACHESIM_TRACE_BINARY_KEY_SHIFT)
+         | (uint64_t) px_record->e_type;
+      puc_pos += cachesim_trace_put_varint (puc_pos, ull_key);
+   }
+   if (0 != (ull_key & CACHESIM_TRACE_BINARY_SIZE_FLAG))
+   {
+      puc_pos += cachesim_trace_put_varint (puc_pos, px_record->ui_size_bytes);
+      px_writer->uia_prev_size [px_record->e_type] = px_record->ui_size_bytes;
+   }
+   px_writer->sz_buffer_len += (size_t) (puc_pos - puc_start);
+   px_writer->ull_offset += (uint64_t) (puc_pos - puc_start);
+   px_writer->ulla_prev_address [px_record->e_type] = px_record->ull_address;
+   px_writer->ull_records++;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Appends the block index, fills in the header and closes the file.
+ */
+static CACHESIM_RET_E cachesim_trace_writer_close (
+   CACHESIM_TRACE_WRITER_X *px_writer)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint8_t uca_header [CACHESIM_TRACE_BINARY_HEADER_SIZE] = {0};
+   uint8_t uca_entry [sizeof(uint64_t)] = {0};
+   uint64_t ull_entry = 0;
+
+   if (NULL == px_writer->px_file)
+   {
+      goto CLEAN_RETURN;
+   }
+   if (NULL == px_writer->puc_buffer)
+   {
+      goto CLOSE_RETURN;
+   }
+   e_ret_val = cachesim_trace_writer_flush (px_writer);
+   for (ull_entry = 0; (eCACHESIM_RET_SUCCESS == e_ret_val)
+      && (ull_entry < px_writer->ull_index_entries); ull_entry++)
+   {
+      cachesim_put_le64 (uca_entry, px_writer->pull_index [ull_entry]);
+      if (sizeof(uca_entry) != fwrite (uca_entry, 1, sizeof(uca_entry),
+         px_writer->px_file))
+      {
+         e_ret_val = eCACHESIM_RET_FAILURE;
+      }
+   }
+   (void) memcpy (uca_header, CACHESIM_TRACE_BINARY_MAGIC,
+      CACHESIM_TRACE_BINARY_MAGIC_LEN);
+   cachesim_put_le32 (uca_header + 8, CACHESIM_TRACE_BINARY_VERSION);
+   cachesim_put_le32 (uca_header + 12, px_writer->ui_word_size_bytes);
+   cachesim_put_le32 (uca_header + 16, px_writer->ui_block_size_bytes);
+   cachesim_put_le32 (uca_header + 20, CACHESIM_TRACE_BINARY_INDEX_INTERVAL);
+   cachesim_put_le64 (uca_header + 24, px_writer->ull_records);
+   cachesim_put_le64 (uca_header + 32, px_writer->ull_offset);
+   cachesim_put_le64 (uca_header + 40, px_writer->ull_index_entries);
+   if ((eCACHESIM_RET_SUCCESS != e_ret_val)
+      || (0 != fseek (px_writer->px_file, 0, SEEK_SET))
+      || (sizeof(uca_header) != fwrite (uca_header, 1, sizeof(uca_header),
+         px_writer->px_file)))
+   {
+      fprintf (stderr, "Error writing binary trace: %s\n", strerror (errno));
+      e_ret_val = eCACHESIM_RET_FAILURE;
+   }
+CLOSE_RETURN:
+   if (0 != fclose (px_writer->px_file))
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+   }
+   px_writer->px_file = NULL;
+CLEAN_RETURN:
+   free (px_writer->puc_buffer);
+   free (px_writer->pull_index);
+   px_writer->puc_buffer = NULL;
+   px_writer->pull_index = NULL;
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate(
+   CACHE_SET_X *px_cache,
+   bool b_use_pinning,
+   bool b_silent)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+   uint32_t ui_j = 0;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+
+   if (NULL == px_cache)
+   {
+      goto CLEAN_RETURN;
+   }
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("+++++++++++++General Simulator++++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (px_cache);
+   if ((false == b_silent)
+      && (eCACHESIM_RET_SUCCESS != cachesim_event_log_open (px_cache)))
+   {
+      goto CLEAN_RETURN;
+   }
+#if 0
+   for (ui_i = 0; ui_i < 6; ui_i++)
+   {
+      for (ui_j = ui_i; ui_j < 64; ui_j += 6)
+      {
+         usleep (250);
+         cachesim_set_mapped_cache_access (px_cache, ui_j, 64, &x_stats);
+      }
+   }
+#endif
+   for (ui_i = 0; ui_i < 32; ui_i++)
+   {
+	   cachesim_demo_pause (px_cache);
+	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+   }
+   for (ui_i = 33; ui_i < 128; ui_i++)
+   {
+       cachesim_demo_pause (px_cache);
+       cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+   }
+   for (ui_i = 0; ui_i < 32; ui_i++)
+      {
+   	   cachesim_demo_pause (px_cache);
+   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+      }
+   for (ui_i = 33; ui_i < 128; ui_i++)
+      {
+          cachesim_demo_pause (px_cache);
+          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+      }
+   for (ui_i = 0; ui_i < 32; ui_i++)
+      {
+   	   cachesim_demo_pause (px_cache);
+   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+      }
+   cachesim_event_log_close (px_cache);
+   cache_sim_log_summary (&x_stats);
+   cachesim_set_log_sample_summary (px_cache, &x_stats);
+   cachesim_set_log_prefetch_summary (px_cache, &x_stats);
+   cachesim_set_log_mshr_summary (px_cache, &x_stats);
+   cachesim_set_log_heatmap (px_cache);
+   cachesim_sim_stats_deinit (&x_stats);
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_pinning(
+   CACHE_SET_X *px_cache,
+   bool b_use_pinning,
+   bool b_silent,
+   uint32_t ui_loop_iterations)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_k = 0;
+   uint32_t ui_i = 0;
+   uint32_t ui_j = 0;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+
+   if (NULL == px_cache)
+   {
+      goto CLEAN_RETURN;
+   }
+   printf ("\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("+++++++++++++General Simulator++++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (px_cache);
+   if ((false == b_silent)
+      && (eCACHESIM_RET_SUCCESS != cachesim_event_log_open (px_cache)))
+   {
+      goto CLEAN_RETURN;
+   }
+#if 0
+   for (ui_i = 0; ui_i < 6; ui_i++)
+   {
+      for (ui_j = ui_i; ui_j < 64; ui_j += 6)
+      {
+         usleep (250);
+         cachesim_set_mapped_cache_access (px_cache, ui_j, 64, &x_stats);
+      }
+   }
+#endif
+
+   for (ui_k = 0; ui_k < ui_loop_iterations; ui_k++)
+   {
+	   for (ui_i = 0; ui_i < 32; ui_i++)
+	      {
+	   	   cachesim_demo_pause (px_cache);
+	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	      }
+	   for (ui_i = 32 + ui_k; ui_i < (64 + ui_k); ui_i++)
+	      {
+	          cachesim_demo_pause (px_cache);
+	          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	      }
+	   for (ui_i = 0; ui_i < 32; ui_i++)
+	      {
+	   	   cachesim_demo_pause (px_cache);
+	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	      }
+	   for (ui_i = 65 + ui_k; ui_i < (96 + ui_k); ui_i++)
+	   	      {
+	   	          cachesim_demo_pause (px_cache);
+	   	          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	   	      }
+	   for (ui_i = 0; ui_i < 32; ui_i++)
+	      {
+	   	   cachesim_demo_pause (px_cache);
+	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	      }
+	   for (ui_i = 97 + ui_k; ui_i < (128 + ui_k); ui_i++)
+	   	   	      {
+	   	   	          cachesim_demo_pause (px_cache);
+	   	   	          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	   	   	      }
+	   for (ui_i = 0; ui_i < 32; ui_i++)
+	      {
+	   	   cachesim_demo_pause (px_cache);
+	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+	      }
+   }
+
+
+#if 0
+   for (ui_i = 0; ui_i < 32; ui_i++)
+   {
+	   cachesim_demo_pause (px_cache);
+	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+   }
+   for (ui_i = 33; ui_i < 128; ui_i++)
+   {
+       cachesim_demo_pause (px_cache);
+       cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+   }
+   for (ui_i = 0; ui_i < 32; ui_i++)
+      {
+   	   cachesim_demo_pause (px_cache);
+   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+      }
+   for (ui_i = 33; ui_i < 128; ui_i++)
+      {
+          cachesim_demo_pause (px_cache);
+          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+      }
+   for (ui_i = 0; ui_i < 32; ui_i++)
+      {
+   	   cachesim_demo_pause (px_cache);
+   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, &x_stats);
+      }
+#endif
+   cachesim_event_log_close (px_cache);
+   cache_sim_log_summary (&x_stats);
+   cachesim_set_log_sample_summary (px_cache, &x_stats);
+   cachesim_set_log_prefetch_summary (px_cache, &x_stats);
+   cachesim_set_log_mshr_summary (px_cache, &x_stats);
+   cachesim_set_log_heatmap (px_cache);
+   cachesim_sim_stats_deinit (&x_stats);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_bubble_sort(
+   CACHE_SET_X *px_cache,
+   bool b_silent,
+   uint32_t ui_n)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+   uint32_t ui_j = 0;
+   // uint32_t ui_n = 4096;
+   uint64_t ull_prev_miss_count = 0;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+
+   if (NULL == px_cache)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("+++++++++++++++Bubble Sort Simulator++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (px_cache);
+
+   if ((false == b_silent)
+      && (eCACHESIM_RET_SUCCESS != cachesim_event_log_open (px_cache)))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   for (ui_i = 0; ui_i < ui_n; ui_i++)
+   {
+      for (ui_j = 0; ui_j < ui_n - ui_i - 1; ui_j++)
+      {
+         cachesim_demo_pause (px_cache);
+         cachesim_set_mapped_cache_access (px_cache, ui_j, false, ui_n, &x_stats);
+         cachesim_set_mapped_cache_access (px_cache, ui_j + 1, false, ui_n, &x_stats);
+      }
+      if (false == b_silent)
+      {
+         cachesim_event_log_sync (px_cache);
+         printf ("%d \nStats:\n"
+            "\t ull_total_accesses        : %" PRIu64 "\n"
+            "\t ull_hit_count             : %" PRIu64 "\n"
+            "\t ull_miss_count            : %" PRIu64 "\n"
+            "\t ull_capacity_miss         : %" PRIu64 "\n"
+            "\t ull_compulsory_miss       : %" PRIu64 "\n"
+            "\t ull_conflict_miss         : %" PRIu64 "\n", ui_i,
+            x_stats.ull_total_accesses, x_stats.ull_hit_count,
+            x_stats.ull_miss_count, x_stats.ull_capacity_miss,
+            x_stats.ull_compulsory_miss, x_stats.ull_conflict_miss);
+
+         printf ("Outer Loop: %d, Diff Miss Count: %" PRIu64 "\n", ui_i,
+            x_stats.ull_miss_count - ull_prev_miss_count);
+      }
+      ull_prev_miss_count = x_stats.ull_miss_count;
+   }
+   cachesim_event_log_close (px_cache);
+   cache_sim_log_summary (&x_stats);
+   cachesim_set_log_sample_summary (px_cache, &x_stats);
+   cachesim_set_log_prefetch_summary (px_cache, &x_stats);
+   cachesim_set_log_mshr_summary (px_cache, &x_stats);
+   cachesim_set_log_heatmap (px_cache);
+   cachesim_sim_stats_deinit (&x_stats);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_max_in_matrix (
+   CACHE_SET_X *px_cache,
+   bool b_silent,
+   uint32_t ui_n)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+   uint32_t ui_j = 0;
+   uint32_t ui_k = 0;
+   // uint32_t ui_n = 4096;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+
+   if (NULL == px_cache)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("+++++++++++++Max In Matrix Simulator++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (px_cache);
+
+   if ((false == b_silent)
+      && (eCACHESIM_RET_SUCCESS != cachesim_event_log_open (px_cache)))
+   {
+      goto CLEAN_RETURN;
+   }
+
+#if 0
+   for (ui_i = 0; ui_i < ui_n; ui_i++)
+   {
+      for (ui_j = 0; ui_j < ui_n; ui_j++)
+      {
+         // cachesim_demo_pause (px_cache);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+      }
+   }
+#endif
+
+   for (ui_k = 0; ui_k < ui_n / 4; ui_k++)
+   {
+      for (ui_i = ((ui_k / 2) * (ui_n / 2));
+            ui_i < ((ui_n / 2) + ((ui_k / 2) * (ui_n / 2))); ui_i++)
+      {
+         for (ui_j = ((ui_k % 2) * (ui_n / 2));
+               ui_j < (ui_n / 2) + ((ui_k % 2) * (ui_n / 2)); ui_j++)
+         {
+            cachesim_demo_pause (px_cache);
+            cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j), false,
+               (ui_n * ui_n), &x_stats);
+            cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j), false,
+               (ui_n * ui_n), &x_stats);
+         }
+      }
+   }
+
+#if 0
+   for (ui_i = 0; ui_i < ui_n / 2; ui_i++)
+   {
+      for (ui_j = 0; ui_j < ui_n / 2; ui_j++)
+      {
+         // cachesim_demo_pause (px_cache);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+      }
+   }
+
+   for (ui_i = 0; ui_i < ui_n / 2; ui_i++)
+   {
+      for (ui_j = ui_n / 2; ui_j < ui_n; ui_j++)
+      {
+         // cachesim_demo_pause (px_cache);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+      }
+   }
+
+   for (ui_i = ui_n / 2; ui_i < ui_n; ui_i++)
+   {
+      for (ui_j = 0; ui_j < ui_n / 2; ui_j++)
+      {
+         // cachesim_demo_pause (px_cache);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+      }
+   }
+
+   for (ui_i = ui_n / 2; ui_i < ui_n; ui_i++)
+   {
+      for (ui_j = ui_n / 2; ui_j < ui_n; ui_j++)
+      {
+         // cachesim_demo_pause (px_cache);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
+            (ui_n * ui_n), &x_stats);
+      }
+   }
+#endif
+
+   cachesim_event_log_close (px_cache);
+   cache_sim_log_summary (&x_stats);
+   cachesim_set_log_sample_summary (px_cache, &x_stats);
+   cachesim_set_log_prefetch_summary (px_cache, &x_stats);
+   cachesim_set_log_mshr_summary (px_cache, &x_stats);
+   cachesim_set_log_heatmap (px_cache);
+   cachesim_sim_stats_deinit (&x_stats);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Word range of a trace record, counted in px_trace_stats. Returns false if
+ * the record does not go through the data cache or falls outside the
+ * simulated address space.
+ */
+static bool cachesim_trace_record_words (
+   const CACHESIM_TRACE_RECORD_X *px_record,
+   uint32_t ui_word_size,
+   uint32_t ui_address_bits,
+   uint64_t *pull_first_word,
+   uint64_t *pull_last_word,
+   CACHESIM_TRACE_STATS_X *px_trace_stats)
+{
+   uint32_t ui_size_bytes = px_record->ui_size_bytes;
+
+   px_trace_stats->ull_records++;
+
+   /*
+    * Instruction fetches do not go through a data cache.
+    */
+   if (eCACHESIM_ACCESS_TYPE_IFETCH == px_record->e_type)
+   {
+      px_trace_stats->ull_skipped++;
+      return false;
+   }
+   if (eCACHESIM_ACCESS_TYPE_WRITE == px_record->e_type)
+   {
+      px_trace_stats->ull_writes++;
+   }
+   else
+   {
+      px_trace_stats->ull_reads++;
+   }
+   if (0 == ui_size_bytes)
+   {
+      ui_size_bytes = ui_word_size;
+   }
+
+   /*
+    * The cache is indexed by word. Convert the byte range of the record to
+    * words; the callers issue one access per cache block the range touches,
+    * so an unaligned access that straddles two blocks is counted against
+    * both. A range that runs past the address width is skipped.
+    */
+   if ((px_record->ull_address > CACHESIM_MAX_ADDRESS(ui_address_bits))
+      || (ui_size_bytes - 1 > CACHESIM_MAX_ADDRESS(ui_address_bits)
+         - px_record->ull_address))
+   {
+      px_trace_stats->ull_skipped++;
+      return false;
+   }
+   *pull_first_word = px_record->ull_address / ui_word_size;
+   *pull_last_word = (px_record->ull_address + ui_size_bytes - 1) / ui_word_size;
+   return true;
+}
+
+/*
+ * Bytes of the word range [ull_first_word, ull_last_word] that fall in the
+ * block holding ull_first_word.
+ */
+static inline uint32_t cachesim_block_overlap_bytes (
+   const CACHE_SET_X *px_cache,
+   uint64_t ull_first_word,
+   uint64_t ull_last_word)
+{
+   uint32_t ui_block_size_words = px_cache->x_cache_params.ui_block_size_words;
+   uint64_t ull_block_last_word =
+      ((ull_first_word / ui_block_size_words) + 1) * ui_block_size_words - 1;
+
+   if (ull_last_word > ull_block_last_word)
+   {
+      ull_last_word = ull_block_last_word;
+   }
+   return (uint32_t) ((ull_last_word - ull_first_word + 1)
+      * px_cache->x_cache_params.ui_word_size_bytes);
+}
+
+/*
+ * Replays decoded trace records through the batch path: one access per
+ * cache block each record touches. With a prefetcher, each access carries
+ * the address of the latest instruction fetch as its instruction address.
+ * *pb_hit, if given, is set to whether every block the records touched was
+ * simulated and hit. A skipped record or an access dropped by set sampling
+ * makes it false, as does an empty batch.
+ */
+static void cachesim_set_mapped_cache_access_records (
+   CACHE_SET_X *px_cache,
+   const CACHESIM_TRACE_RECORD_X *px_records,
+   uint64_t ull_count,
+   CACHESIM_SIM_STATS_X *px_stats,
+   CACHESIM_TRACE_STATS_X *px_trace_stats,
+   bool *pb_hit)
+{
+   CACHESIM_ACCESS_X xa_accesses [CACHESIM_ACCESS_BATCH_SIZE * 8];
+   uint32_t ui_no_of_accesses = 0;
+   uint32_t ui_block_size_words = px_cache->x_cache_params.ui_block_size_words;
+   uint64_t ull_first_word = 0;
+   uint64_t ull_last_word = 0;
+   uint64_t ull_i = 0;
+   uint64_t ull_no_of_blocks = 0;
+   uint64_t ull_hits = 0;
+   bool b_skipped = false;
+
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      if ((NULL != px_cache->px_prefetch)
+         && (eCACHESIM_ACCESS_TYPE_IFETCH == px_records [ull_i].e_type))
+      {
+         px_cache->px_prefetch->ull_last_ifetch = px_records [ull_i].ull_address;
+      }
+      if (false == cachesim_trace_record_words (&(px_records [ull_i]),
+         px_cache->x_cache_params.ui_word_size_bytes,
+         px_cache->x_cache_params.ui_address_bits, &ull_first_word,
+         &ull_last_word, px_trace_stats))
+      {
+         b_skipped = true;
+         continue;
+      }
+      while (1)
+      {
+         if ((sizeof(xa_accesses) / sizeof(xa_accesses [0])) == ui_no_of_accesses)
+         {
+            cachesim_set_mapped_cache_access_batch (px_cache, xa_accesses,
+               ui_no_of_accesses, px_stats, &ull_hits);
+            ui_no_of_accesses = 0;
+         }
+         xa_accesses [ui_no_of_accesses].ull_index = ull_first_word;
+         xa_accesses [ui_no_of_accesses].ui_size_bytes =
+            cachesim_block_overlap_bytes (px_cache, ull_first_word, ull_last_word);
+         xa_accesses [ui_no_of_accesses].e_type = px_records [ull_i].e_type;
+         xa_accesses [ui_no_of_accesses].ull_pc = (NULL != px_cache->px_prefetch) ?
+            px_cache->px_prefetch->ull_last_ifetch : 0;
+         ui_no_of_accesses++;
+         ull_no_of_blocks++;
+         ull_first_word = ((ull_first_word / ui_block_size_words) + 1)
+            * ui_block_size_words;
+         if (ull_first_word > ull_last_word)
+         {
+            break;
+         }
+      }
+   }
+   if (0 != ui_no_of_accesses)
+   {
+      cachesim_set_mapped_cache_access_batch (px_cache, xa_accesses,
+         ui_no_of_accesses, px_stats, &ull_hits);
+   }
+   if (NULL != pb_hit)
+   {
+      *pb_hit = (false == b_skipped) && (0 != ull_no_of_blocks)
+         && (ull_hits == ull_no_of_blocks);
+   }
+}
+
+/*
+ * Functional warmup of one access. The tags, replacement state and dirty
+ * bits change as on the measured path. Misses mark the first touch table, so
+ * that blocks seen during warmup do not count as compulsory misses later, but
+ * the shadow cache of the miss classification is left alone: it costs more
+ * than everything else together. Nothing is counted, logged or prefetched.
+ * Trace runs never pin blocks, so pinning is not looked at.
+ */
+static inline void cachesim_set_warm_access (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   uint64_t ull_ram_block = cachesim_set_ram_block (px_cache, ull_index);
+   uint32_t ui_cache_set = cachesim_set_cache_set (px_cache, ull_ram_block);
+   uint64_t *pull_tags = cachesim_set_tags (px_cache, ui_cache_set);
+   CACHE_SET_DATA_X *px_set_data = &(px_cache->px_sets[ui_cache_set]);
+   CACHE_BLOCK_METADATA_X *px_metadata = NULL;
+   const CACHESIM_REPLACEMENT_POLICY_X *px_policy = NULL;
+   bool b_write = (eCACHESIM_ACCESS_TYPE_WRITE == e_type);
+   bool b_track_failed = false;
+   uint32_t ui_way = 0;
+
+   if ((NULL != px_cache->px_sample_counts)
+      && (false == cachesim_set_is_sampled (px_cache, ui_cache_set)))
+   {
+      return;
+   }
+   ui_way = cachesim_set_find_way (pull_tags, px_cache->ui_tag_scan_len,
+      ull_ram_block);
+   if (CACHESIM_MAX_INDEX_VALUE != ui_way)
+   {
+      cachesim_set_repl_touch (px_cache, ui_cache_set, ui_way);
+   }
+   else
+   {
+      (void) cachesim_first_touch_mark (&(px_stats->x_first_touch),
+         ull_ram_block, &b_track_failed);
+      if ((true == b_write) && (false == px_cache->x_cache_params.b_write_allocate))
+      {
+         return;
+      }
+      px_policy = cachesim_replacement_policy (
+         px_cache->x_cache_params.e_replacement_policy);
+      ui_way = cachesim_set_fill_way (px_cache, ui_cache_set);
+      if (CACHESIM_MAX_INDEX_VALUE == ui_way)
+      {
+         return;
+      }
+      px_metadata = &(px_set_data->px_blocks[ui_way].x_metadata);
+      px_metadata->b_is_dirty = false;
+      px_metadata->b_is_prefetched = false;
+      pull_tags [ui_way] = ull_ram_block;
+      if (NULL != px_policy->pfn_fill)
+      {
+         px_policy->pfn_fill (px_cache, ui_cache_set, ui_way);
+      }
+   }
+   if ((true == b_write)
+      && (eCACHESIM_WRITE_POLICY_WRITE_BACK == px_cache->x_cache_params.e_write_policy))
+   {
+      px_set_data->px_blocks[ui_way].x_metadata.b_is_dirty = true;
+   }
+}
+
+/*
+ * Functional warmup of a batch of accesses, with the lines each access will
+ * need prefetched a chunk ahead as on the measured batch path.
+ */
+static void cachesim_set_warm_batch (
+   CACHE_SET_X *px_cache,
+   const CACHESIM_ACCESS_X *px_accesses,
+   uint32_t ui_count,
+   CACHESIM_SIM_STATS_X *px_stats)
+{
+   uint64_t ull_ram_block = 0;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_chunk = 0;
+   uint32_t ui_i = 0;
+
+   for (; 0 != ui_count; ui_count -= ui_chunk, px_accesses += ui_chunk)
+   {
+      ui_chunk = (ui_count < CACHESIM_ACCESS_BATCH_SIZE) ?
+         ui_count : CACHESIM_ACCESS_BATCH_SIZE;
+      for (ui_i = 0; ui_i < ui_chunk; ui_i++)
+      {
+         ull_ram_block = cachesim_set_ram_block (px_cache,
+            px_accesses [ui_i].ull_index);
+         ui_cache_set = cachesim_set_cache_set (px_cache, ull_ram_block);
+         CACHESIM_PREFETCH (cachesim_set_tags (px_cache, ui_cache_set));
+         if (0 != px_cache->ui_repl_stride)
+         {
+            CACHESIM_PREFETCH (cachesim_set_repl_state (px_cache, ui_cache_set));
+         }
+      }
+      for (ui_i = 0; ui_i < ui_chunk; ui_i++)
+      {
+         cachesim_set_warm_access (px_cache, px_accesses [ui_i].ull_index,
+            px_accesses [ui_i].e_type, px_stats);
+      }
+   }
+}
+
+/*
+ * Warms the cache up with decoded trace records, one access per cache block
+ * each record touches. The records are counted in
+ * px_trace_stats->ull_warmup_records only.
+ */
+static void cachesim_set_mapped_cache_warm_records (
+   CACHE_SET_X *px_cache,
+   const CACHESIM_TRACE_RECORD_X *px_records,
+   uint64_t ull_count,
+   CACHESIM_SIM_STATS_X *px_stats,
+   CACHESIM_TRACE_STATS_X *px_trace_stats)
+{
+   CACHESIM_ACCESS_X xa_accesses [CACHESIM_ACCESS_BATCH_SIZE * 8];
+   CACHESIM_TRACE_STATS_X x_warm_stats = {0};
+   uint32_t ui_no_of_accesses = 0;
+   uint32_t ui_block_size_words = px_cache->x_cache_params.ui_block_size_words;
+   uint64_t ull_first_word = 0;
+   uint64_t ull_last_word = 0;
+   uint64_t ull_i = 0;
+
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      if (false == cachesim_trace_record_words (&(px_records [ull_i]),
+         px_cache->x_cache_params.ui_word_size_bytes,
+         px_cache->x_cache_params.ui_address_bits, &ull_first_word,
+         &ull_last_word, &x_warm_stats))
+      {
+         continue;
+      }
+      while (1)
+      {
+         if ((sizeof(xa_accesses) / sizeof(xa_accesses [0])) == ui_no_of_accesses)
+         {
+            cachesim_set_warm_batch (px_cache, xa_accesses, ui_no_of_accesses,
+               px_stats);
+            ui_no_of_accesses = 0;
+         }
+         xa_accesses [ui_no_of_accesses].ull_index = ull_first_word;
+         xa_accesses [ui_no_of_accesses].e_type = px_records [ull_i].e_type;
+         ui_no_of_accesses++;
+         ull_first_word = ((ull_first_word / ui_block_size_words) + 1)
+            * ui_block_size_words;
+         if (ull_first_word > ull_last_word)
+         {
+            break;
+         }
+      }
+   }
+   cachesim_set_warm_batch (px_cache, xa_accesses, ui_no_of_accesses, px_stats);
+   px_trace_stats->ull_warmup_records += x_warm_stats.ull_records;
+}
+
+/*
+ * Fills in the identification and configuration part of a checkpoint header
+ * for the cache, the part a checkpoint has to match to be restored into it.
+ */
+static void cachesim_set_checkpoint_header (
+   CACHE_SET_X *px_cache,
+   CACHESIM_CHECKPOINT_HEADER_X *px_header,
+   CACHESIM_ARENA_LAYOUT_X *px_layout)
+{
+   CACHESIM_CACHE_PARAMS_X *px_params = &(px_cache->x_cache_params);
+
+   cachesim_set_arena_layout (px_params, px_cache->ui_configured_no_of_sets,
+      px_cache->ui_tag_stride, px_layout);
+
+   (void) memset (px_header, 0x00, sizeof(*px_header));
+   (void) memcpy (px_header->uca_magic, CACHESIM_CHECKPOINT_MAGIC,
+      CACHESIM_CHECKPOINT_MAGIC_LEN);
+   px_header->ui_version = CACHESIM_CHECKPOINT_VERSION;
+   px_header->ui_header_size = sizeof(*px_header);
+   px_header->ui_cache_size_words = px_params->ui_cache_size_words;
+   px_header->ui_associativity = px_params->ui_associativity;
+   px_header->ui_block_size_words = px_params->ui_block_size_words;
+   px_header->ui_word_size_bytes = px_params->ui_word_size_bytes;
+   px_header->ui_replacement_policy = px_params->e_replacement_policy;
+   px_header->ui_write_policy = px_params->e_write_policy;
+   px_header->ui_address_bits = px_params->ui_address_bits;
+   px_header->ui_sample_sets = px_params->ui_sample_sets;
+   px_header->ui_hit_latency = px_params->ui_hit_latency;
+   px_header->ui_miss_penalty = px_params->ui_miss_penalty;
+   px_header->ui_memory_latency = px_params->ui_memory_latency;
+   px_header->uc_classify_misses = px_params->b_classify_misses;
+   px_header->uc_store_data = px_params->b_store_data;
+   px_header->ull_arena_bytes = px_layout->sz_used_size - px_layout->sz_sets_offset;
+}
+
+static size_t cachesim_set_sample_counts_size (
+   CACHE_SET_X *px_cache)
+{
+   return (NULL == px_cache->px_sample_counts) ? 0 :
+      ((size_t) px_cache->ui_configured_no_of_sets
+         * sizeof(CACHESIM_SAMPLE_COUNTS_X));
+}
+
+/*
+ * Writes the state of the cache and of the trace run to
+ * x_cache_params.pc_checkpoint_file.
+ */
+static CACHESIM_RET_E cachesim_set_checkpoint_save (
+   CACHE_SET_X *px_cache,
+   CACHESIM_SIM_STATS_X *px_stats,
+   CACHESIM_TRACE_STATS_X *px_trace_stats,
+   uint64_t ull_trace_position)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CHECKPOINT_HEADER_X x_header;
+   CACHESIM_ARENA_LAYOUT_X x_layout = {0};
+   CACHESIM_HASH_MAP_X *px_first_touch = &(px_stats->x_first_touch.x_pages);
+   const char *pc_file = px_cache->x_cache_params.pc_checkpoint_file;
+   size_t sz_sample_bytes = cachesim_set_sample_counts_size (px_cache);
+   size_t sz_map_bytes = (size_t) px_first_touch->ull_capacity * sizeof(uint64_t);
+   FILE *px_file = NULL;
+   bool b_written = false;
+
+   cachesim_set_checkpoint_header (px_cache, &x_header, &x_layout);
+   x_header.ull_random_state = px_cache->ull_random_state;
+   x_header.ull_sample_skipped = px_cache->ull_sample_skipped;
+   x_header.ull_shadow_map_count = px_cache->x_shadow.x_map.ull_count;
+   x_header.ui_shadow_count = px_cache->x_shadow.ui_count;
+   x_header.ui_shadow_mru = px_cache->x_shadow.ui_mru;
+   x_header.ui_shadow_lru = px_cache->x_shadow.ui_lru;
+   x_header.ull_trace_position = ull_trace_position;
+   x_header.x_trace_stats = *px_trace_stats;
+   x_header.x_stats = *px_stats;
+   (void) memset (&(x_header.x_stats.x_first_touch), 0x00,
+      sizeof(x_header.x_stats.x_first_touch));
+   x_header.ull_first_touch_capacity = px_first_touch->ull_capacity;
+   x_header.ull_first_touch_count = px_first_touch->ull_count;
+
+   px_file = fopen (pc_file, "wb");
+   if (NULL == px_file)
+   {
+      fprintf (stderr, "Unable to open %s: %s\n", pc_file, strerror (errno));
+      goto CLEAN_RETURN;
+   }
+   b_written = (1 == fwrite (&x_header, sizeof(x_header), 1, px_file))
+      && (x_header.ull_arena_bytes == fwrite (
+         (uint8_t *) px_cache + x_layout.sz_sets_offset, 1,
+         (size_t) x_header.ull_arena_bytes, px_file))
+      && (sz_sample_bytes == fwrite (px_cache->px_sample_counts, 1,
+         sz_sample_bytes, px_file))
+      && (sz_map_bytes == fwrite (px_first_touch->pull_keys, 1, sz_map_bytes,
+         px_file))
+      && (sz_map_bytes == fwrite (px_first_touch->pull_values, 1, sz_map_bytes,
+         px_file));
+   if ((0 != fclose (px_file)) || (false == b_written))
+   {
+      fprintf (stderr, "Unable to write checkpoint %s\n", pc_file);
+      goto CLEAN_RETURN;
+   }
+
+   printf ("Checkpoint:\n"
+      "\t pc_file                   : %s\n"
+      "\t ull_trace_position        : %" PRIu64 "\n",
+      pc_file, ull_trace_position);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Loads the state saved by cachesim_set_checkpoint_save from
+ * x_cache_params.pc_restore_file into a freshly allocated cache. The file is
+ * mapped rather than read, the arena image is copied straight from the
+ * mapping.
+ */
+static CACHESIM_RET_E cachesim_set_checkpoint_restore (
+   CACHE_SET_X *px_cache,
+   CACHESIM_SIM_STATS_X *px_stats,
+   CACHESIM_TRACE_STATS_X *px_trace_stats,
+   uint64_t *pull_trace_position)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CHECKPOINT_HEADER_X x_expected;
+   CACHESIM_CHECKPOINT_HEADER_X x_header;
+   CACHESIM_ARENA_LAYOUT_X x_layout = {0};
+   CACHESIM_HASH_MAP_X *px_first_touch = &(px_stats->x_first_touch.x_pages);
+   const char *pc_file = px_cache->x_cache_params.pc_restore_file;
+   const uint8_t *puc_map = NULL;
+   const uint8_t *puc_pos = NULL;
+   size_t sz_map_len = 0;
+   size_t sz_sample_bytes = cachesim_set_sample_counts_size (px_cache);
+   size_t sz_map_bytes = 0;
+   CACHE_BLOCK_X *px_blocks = NULL;
+   uint32_t ui_i = 0;
+
+   if (eCACHESIM_RET_SUCCESS != cachesim_map_file (pc_file, &puc_map,
+      &sz_map_len))
+   {
+      fprintf (stderr, "Unable to map checkpoint file \"%s\"\n", pc_file);
+      goto CLEAN_RETURN;
+   }
+   cachesim_set_checkpoint_header (px_cache, &x_expected, &x_layout);
+   if ((sz_map_len < sizeof(x_header))
+      || (0 != memcmp (puc_map, &x_expected,
+         offsetof(CACHESIM_CHECKPOINT_HEADER_X, ui_cache_size_words))))
+   {
+      fprintf (stderr, "\"%s\" is not a checkpoint of this build\n", pc_file);
+      goto CLEAN_RETURN;
+   }
+   (void) memcpy (&x_header, puc_map, sizeof(x_header));
+   if (0 != memcmp (&x_header, &x_expected,
+      offsetof(CACHESIM_CHECKPOINT_HEADER_X, ull_random_state)))
+   {
+      fprintf (stderr, "Checkpoint \"%s\" was saved from a different cache "
+         "configuration\n", pc_file);
+      goto CLEAN_RETURN;
+   }
+   sz_map_bytes = (size_t) x_header.ull_first_touch_capacity * sizeof(uint64_t);
+   if (sz_map_len != (sizeof(x_header) + (size_t) x_header.ull_arena_bytes
+      + sz_sample_bytes + (2 * sz_map_bytes)))
+   {
+      fprintf (stderr, "Checkpoint \"%s\" is truncated\n", pc_file);
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * The image carries the block pointers of the saving run; point them at
+    * the blocks of this arena again.
+    */
+   puc_pos = puc_map + sizeof(x_header);
+   (void) memcpy ((uint8_t *) px_cache + x_layout.sz_sets_offset, puc_pos,
+      (size_t) x_header.ull_arena_bytes);
+   puc_pos += x_header.ull_arena_bytes;
+   px_blocks = (CACHE_BLOCK_X *) ((uint8_t *) px_cache + x_layout.sz_blocks_offset);
+   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   {
+      px_cache->px_sets[ui_i].px_blocks =
+         px_blocks + ((size_t) ui_i * px_cache->ui_no_of_blocks_per_set);
+   }
+   px_cache->ull_random_state = x_header.ull_random_state;
+   px_cache->ull_sample_skipped = x_header.ull_sample_skipped;
+   px_cache->x_shadow.x_map.ull_count = x_header.ull_shadow_map_count;
+   px_cache->x_shadow.ui_count = x_header.ui_shadow_count;
+   px_cache->x_shadow.ui_mru = x_header.ui_shadow_mru;
+   px_cache->x_shadow.ui_lru = x_header.ui_shadow_lru;
+   if (0 != sz_sample_bytes)
+   {
+      (void) memcpy (px_cache->px_sample_counts, puc_pos, sz_sample_bytes);
+      puc_pos += sz_sample_bytes;
+   }
+
+   *px_stats = x_header.x_stats;
+   if (0 != x_header.ull_first_touch_capacity)
+   {
+      /*
+       * Same capacity as the saved table, so every key keeps its slot.
+       */
+      if (eCACHESIM_RET_SUCCESS != cachesim_hash_map_init (px_first_touch,
+         x_header.ull_first_touch_capacity / 2))
+      {
+         goto CLEAN_RETURN;
+      }
+      (void) memcpy (px_first_touch->pull_keys, puc_pos, sz_map_bytes);
+      (void) memcpy (px_first_touch->pull_values, puc_pos + sz_map_bytes,
+         sz_map_bytes);
+      px_first_touch->ull_count = x_header.ull_first_touch_count;
+   }
+   *px_trace_stats = x_header.x_trace_stats;
+   *pull_trace_position = x_header.ull_trace_position;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (NULL != puc_map)
+   {
+      cachesim_unmap_file (puc_map, sz_map_len);
+   }
+   return e_ret_val;
+}
+
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_trace (
+   CACHE_SET_X *px_cache,
+   bool b_silent,
+   const char *pc_trace_file,
+   const CACHESIM_TRACE_PHASES_X *px_phases)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+   CACHESIM_TRACE_STATS_X x_trace_stats = {0};
+   CACHESIM_TRACE_READER_X x_reader = {0};
+   CACHESIM_TRACE_RECORD_X xa_records [CACHESIM_TRACE_BATCH_RECORDS];
+   CACHESIM_TRACE_RECORD_X x_pending = {0};
+   uint32_t ui_no_of_records = 0;
+   uint32_t ui_batch_records = 0;
+   uint64_t ull_records_read = 0;
+   uint64_t ull_trace_position = 0;
+   uint64_t ull_restored_accesses = 0;
+   uint64_t ull_max_records = 0;
+   bool b_end_of_trace = false;
+   bool b_pending = false;
+   bool b_batch_warm = false;
+   bool b_record_warm = false;
+   clock_t x_start = 0;
+   double d_elapsed = 0.0;
+
+   if ((NULL == px_cache) || (NULL == pc_trace_file) || (NULL == px_phases))
+   {
+      goto CLEAN_RETURN;
+   }
+   ull_max_records = px_phases->ull_max_records;
+
+   if (NULL != px_cache->x_cache_params.pc_restore_file)
+   {
+      e_ret_val = cachesim_set_checkpoint_restore (px_cache, &x_stats,
+         &x_trace_stats, &ull_trace_position);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         goto CLEAN_RETURN;
+      }
+      ull_restored_accesses = x_stats.ull_total_accesses
+         + px_cache->ull_sample_skipped;
+   }
+   ull_trace_position += px_phases->ull_fast_forward;
+
+   e_ret_val = cachesim_trace_open (&x_reader, pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      e_ret_val = cachesim_trace_seek (&x_reader, ull_trace_position);
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("++++++++++++++++Trace Simulator+++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (px_cache);
+
+   if ((false == b_silent)
+      && (eCACHESIM_RET_SUCCESS != cachesim_event_log_open (px_cache)))
+   {
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * A batch holds records of one phase only. The record that starts the
+    * other phase is held back in x_pending and begins the next batch.
+    */
+   x_start = clock ();
+   while (((false == b_end_of_trace) || (true == b_pending))
+      && ((0 == ull_max_records) || (ull_records_read < ull_max_records)))
+   {
+      ui_batch_records = CACHESIM_TRACE_BATCH_RECORDS;
+      if ((0 != ull_max_records)
+         && ((ull_max_records - ull_records_read) < ui_batch_records))
+      {
+         ui_batch_records = (uint32_t) (ull_max_records - ull_records_read);
+      }
+      ui_no_of_records = 0;
+      if (true == b_pending)
+      {
+         xa_records [ui_no_of_records++] = x_pending;
+         b_batch_warm = b_record_warm;
+         b_pending = false;
+      }
+      for (; ui_no_of_records < ui_batch_records; ui_no_of_records++)
+      {
+         e_ret_val = cachesim_trace_read_record (&x_reader,
+            &(xa_records [ui_no_of_records]), &b_end_of_trace);
+         if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+         {
+            break;
+         }
+         b_record_warm = ((ull_records_read + ui_no_of_records) < px_phases->ull_warmup)
+            || ((true == px_phases->b_roi_markers) && (false == x_reader.b_in_roi));
+         if (0 == ui_no_of_records)
+         {
+            b_batch_warm = b_record_warm;
+         }
+         else if (b_record_warm != b_batch_warm)
+         {
+            x_pending = xa_records [ui_no_of_records];
+            b_pending = true;
+            break;
+         }
+      }
+      if (true == b_batch_warm)
+      {
+         cachesim_set_mapped_cache_warm_records (px_cache, xa_records,
+            ui_no_of_records, &x_stats, &x_trace_stats);
+      }
+      else
+      {
+         cachesim_set_mapped_cache_access_records (px_cache, xa_records,
+            ui_no_of_records, &x_stats, &x_trace_stats, NULL);
+      }
+      ull_records_read += ui_no_of_records;
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         break;
+      }
+   }
+   d_elapsed = (double) (clock () - x_start) / CLOCKS_PER_SEC;
+   cachesim_event_log_close (px_cache);
+
+   printf ("Trace:\n"
+      "\t ull_records               : %" PRIu64 "\n"
+      "\t ull_reads                 : %" PRIu64 "\n"
+      "\t ull_writes                : %" PRIu64 "\n"
+      "\t ull_skipped               : %" PRIu64 "\n",
+      x_trace_stats.ull_records, x_trace_stats.ull_reads,
+      x_trace_stats.ull_writes, x_trace_stats.ull_skipped);
+   if (0 != x_trace_stats.ull_warmup_records)
+   {
+      printf ("\t ull_warmup_records        : %" PRIu64 "\n",
+         x_trace_stats.ull_warmup_records);
+   }
+   if (d_elapsed > 0.0)
+   {
+      printf ("\t\t d_accesses_per_sec       : %f\n",
+         (double) (x_stats.ull_total_accesses + px_cache->ull_sample_skipped
+            - ull_restored_accesses) / d_elapsed);
+   }
+   cache_sim_log_summary (&x_stats);
+   cachesim_set_log_sample_summary (px_cache, &x_stats);
+   cachesim_set_log_prefetch_summary (px_cache, &x_stats);
+   cachesim_set_log_mshr_summary (px_cache, &x_stats);
+   cachesim_set_log_heatmap (px_cache);
+   if ((eCACHESIM_RET_SUCCESS == e_ret_val)
+      && (NULL != px_cache->x_cache_params.pc_checkpoint_file))
+   {
+      e_ret_val = cachesim_set_checkpoint_save (px_cache, &x_stats,
+         &x_trace_stats, ull_trace_position + ull_records_read);
+   }
+CLEAN_RETURN:
+   cachesim_sim_stats_deinit (&x_stats);
+   cachesim_trace_close (&x_reader);
+   return e_ret_val;
+}
+
+/*
+ * Latency model of level ui_level (0 for a single cache) from the command
+ * line.
+ */
+static void cachesim_latency_from_args (
+   const CACHESIM_CACHE_ARGS_X *px_cache_args,
+   uint32_t ui_level,
+   CACHESIM_CACHE_PARAMS_X *px_cache_params)
+{
+   px_cache_params->ui_hit_latency = (ui_level < px_cache_args->ui_no_of_hit_latencies) ?
+      px_cache_args->uia_hit_latency [ui_level] : gua_default_hit_latencies [ui_level];
+   px_cache_params->ui_miss_penalty = (ui_level < px_cache_args->ui_no_of_miss_penalties) ?
+      px_cache_args->uia_miss_penalty [ui_level] : 0;
+   px_cache_params->ui_memory_latency = px_cache_args->ui_memory_latency;
+}
+
+static void cachesim_params_from_args (
+   CACHESIM_CACHE_ARGS_X *px_cache_args,
+   CACHESIM_CACHE_PARAMS_X *px_cache_params)
+{
+   px_cache_params->ui_associativity = px_cache_args->ui_associativity;
+   px_cache_params->ui_block_size_words = px_cache_args->ui_block_size_words;
+   px_cache_params->ui_cache_size_words = px_cache_args->ui_cache_size_words;
+   px_cache_params->ui_word_size_bytes = px_cache_args->ui_word_size_bytes;
+   px_cache_params->b_huge_pages = px_cache_args->b_huge_pages;
+   px_cache_params->b_classify_misses =
+      (false == px_cache_args->b_no_miss_classification);
+   px_cache_params->e_replacement_policy = px_cache_args->e_replacement_policy;
+   px_cache_params->e_write_policy = px_cache_args->e_write_policy;
+   px_cache_params->b_write_allocate =
+      (false == px_cache_args->b_no_write_allocate);
+   px_cache_params->pc_event_log_file = px_cache_args->pc_event_log_file;
+   px_cache_params->ui_demo_pause_us = px_cache_args->ui_demo_pause_us;
+   px_cache_params->ui_sample_sets = px_cache_args->ui_sample_sets;
+   px_cache_params->e_prefetcher = px_cache_args->e_prefetcher;
+   px_cache_params->ui_prefetch_degree = px_cache_args->ui_prefetch_degree;
+   px_cache_params->ui_prefetch_latency = px_cache_args->ui_prefetch_latency;
+   px_cache_params->ui_address_bits = px_cache_args->ui_address_bits;
+   px_cache_params->pc_heatmap_file = px_cache_args->pc_heatmap_file;
+   px_cache_params->pc_heatmap_blocks_file = px_cache_args->pc_heatmap_blocks_file;
+   px_cache_params->e_heatmap_format = px_cache_args->e_heatmap_format;
+   px_cache_params->pc_checkpoint_file = px_cache_args->pc_checkpoint_file;
+   px_cache_params->pc_restore_file = px_cache_args->pc_restore_file;
+   cachesim_latency_from_args (px_cache_args, 0, px_cache_params);
+   px_cache_params->ui_mshrs = px_cache_args->ui_mshrs;
+   px_cache_params->ui_issue_rate = px_cache_args->ui_issue_rate;
+}
+
+void cachesim_config_from_args (
+   const CACHESIM_CACHE_ARGS_X *px_cache_args,
+   CACHESIM_CONFIG_X *px_config)
+{
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+
+   cachesim_config_init (px_config);
+   px_config->ui_cache_size_words = px_cache_args->ui_cache_size_words;
+   px_config->ui_associativity = px_cache_args->ui_associativity;
+   px_config->ui_block_size_words = px_cache_args->ui_block_size_words;
+   px_config->ui_word_size_bytes = px_cache_args->ui_word_size_bytes;
+   px_config->ui_address_bits = px_cache_args->ui_address_bits;
+   px_config->pc_replacement_policy = cachesim_replacement_policy (
+      px_cache_args->e_replacement_policy)->pc_name;
+   px_config->b_write_back =
+      (eCACHESIM_WRITE_POLICY_WRITE_BACK == px_cache_args->e_write_policy);
+   px_config->b_write_allocate = (false == px_cache_args->b_no_write_allocate);
+   px_config->b_classify_misses =
+      (false == px_cache_args->b_no_miss_classification);
+   px_config->ui_sample_sets = px_cache_args->ui_sample_sets;
+   px_config->pc_prefetcher = cachesim_prefetcher (
+      px_cache_args->e_prefetcher)->pc_name;
+   px_config->ui_prefetch_degree = px_cache_args->ui_prefetch_degree;
+   px_config->ui_prefetch_latency = px_cache_args->ui_prefetch_latency;
+   px_config->b_huge_pages = px_cache_args->b_huge_pages;
+   cachesim_latency_from_args (px_cache_args, 0, &x_cache_param);
+   px_config->ui_hit_latency = x_cache_param.ui_hit_latency;
+   px_config->ui_miss_penalty = x_cache_param.ui_miss_penalty;
+   px_config->ui_memory_latency = x_cache_param.ui_memory_latency;
+   px_config->ui_mshrs = px_cache_args->ui_mshrs;
+   px_config->ui_issue_rate = px_cache_args->ui_issue_rate;
+}
+
+/*
+ * Runs the general algorithm without pinning and, with -p true, once more
+ * with pinning.
+ */
+CACHESIM_RET_E cachesim_simulate_pinning (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHE_SET_X    *px_set_cache = NULL;
+   bool b_silent = px_cache_args->b_silent;
+   bool b_pinning = false;
+
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   while (1)
+   {
+      e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         fprintf (stderr, "Unable to allocate the cache\n");
+         break;
+      }
+
+      e_ret_val = cachesim_set_mapped_cache_simulate_pinning (px_set_cache,
+         b_pinning, b_silent, px_cache_args->ui_loop_iterations);
+      if (eCACHESIM_RET_SUCCESS != cachesim_set_free_cache (px_set_cache))
+      {
+         e_ret_val = eCACHESIM_RET_FAILURE;
+      }
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_pinning)
+         || (false == px_cache_args->b_simulate_pinning))
+      {
+         break;
+      }
+      b_pinning = true;
+   }
+   return e_ret_val;
+}
+
+/*
+ * Runs the bubble sort or the max in matrix algorithm.
+ */
+CACHESIM_RET_E cachesim_simulate_algorithm (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHE_SET_X    *px_set_cache = NULL;
+
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Unable to allocate the cache\n");
+      goto CLEAN_RETURN;
+   }
+
+   if (eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT == px_cache_args->e_algorithm)
+   {
+      e_ret_val = cachesim_set_mapped_cache_simulate_bubble_sort (px_set_cache,
+         px_cache_args->b_silent, 128);
+   }
+   else
+   {
+      e_ret_val = cachesim_set_mapped_cache_simulate_max_in_matrix (
+         px_set_cache, px_cache_args->b_silent, 16);
+   }
+
+   if (eCACHESIM_RET_SUCCESS != cachesim_set_free_cache (px_set_cache))
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+   }
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+CACHESIM_RET_E cachesim_simulate_trace (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_TRACE_PHASES_X x_phases = {0};
+   CACHE_SET_X    *px_set_cache = NULL;
+
+   /*
+    * The prefetcher and MSHR state are not part of a checkpoint.
+    */
+   if (((NULL != px_cache_args->pc_checkpoint_file)
+         || (NULL != px_cache_args->pc_restore_file))
+      && (eCACHESIM_PREFETCHER_NONE != px_cache_args->e_prefetcher))
+   {
+      fprintf (stderr, "--checkpoint and --restore are not supported with "
+         "--prefetcher\n");
+      goto CLEAN_RETURN;
+   }
+   if (((NULL != px_cache_args->pc_checkpoint_file)
+         || (NULL != px_cache_args->pc_restore_file))
+      && (0 != px_cache_args->ui_mshrs))
+   {
+      fprintf (stderr, "--checkpoint and --restore are not supported with "
+         "--mshrs\n");
+      goto CLEAN_RETURN;
+   }
+   /*
+    * Only accesses to the sampled sets would advance the clock and take a
+    * register, and the timing is not scaled like the counts.
+    */
+   if ((px_cache_args->ui_sample_sets > 1) && (0 != px_cache_args->ui_mshrs))
+   {
+      fprintf (stderr, "--mshrs is not supported with --sample-sets\n");
+      goto CLEAN_RETURN;
+   }
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Unable to allocate the cache\n");
+      goto CLEAN_RETURN;
+   }
+
+   x_phases.ull_fast_forward = px_cache_args->ull_fast_forward;
+   x_phases.ull_warmup = px_cache_args->ull_warmup;
+   x_phases.ull_max_records = px_cache_args->ull_max_records;
+   x_phases.b_roi_markers = px_cache_args->b_roi_markers;
+   e_ret_val = cachesim_set_mapped_cache_simulate_trace (px_set_cache,
+      px_cache_args->b_silent, px_cache_args->pc_trace_file, &x_phases);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Trace simulation failed\n");
+   }
+
+   (void) cachesim_set_free_cache (px_set_cache);
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Rewrites the trace given with --trace in the binary format. The word and
+ * block size recorded in the header are the ones given with -w and -b.
+ */
+CACHESIM_RET_E cachesim_convert_trace (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_READER_X x_reader = {0};
+   CACHESIM_TRACE_WRITER_X x_writer = {0};
+   CACHESIM_TRACE_RECORD_X x_record = {0};
+   bool b_end_of_trace = false;
+
+   if (NULL == px_cache_args->pc_trace_file)
+   {
+      fprintf (stderr, "--convert needs a trace to read (--trace)\n");
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_trace_open (&x_reader, px_cache_args->pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      e_ret_val = cachesim_trace_seek (&x_reader, px_cache_args->ull_fast_forward);
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_trace_writer_open (&x_writer,
+      px_cache_args->pc_convert_file, px_cache_args->ui_word_size_bytes,
+      px_cache_args->ui_block_size_words * px_cache_args->ui_word_size_bytes);
+   while ((eCACHESIM_RET_SUCCESS == e_ret_val)
+      && ((0 == px_cache_args->ull_max_records)
+         || (x_writer.ull_records < px_cache_args->ull_max_records)))
+   {
+      e_ret_val = cachesim_trace_read_record (&x_reader, &x_record,
+         &b_end_of_trace);
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+      {
+         break;
+      }
+      e_ret_val = cachesim_trace_writer_put (&x_writer, &x_record);
+   }
+   if (eCACHESIM_RET_SUCCESS != cachesim_trace_writer_close (&x_writer))
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+   }
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      printf ("Converted %" PRIu64 " records to \"%s\": %" PRIu64 " bytes, "
+         "%.2f bytes per record\n", x_writer.ull_records,
+         px_cache_args->pc_convert_file,
+         x_writer.ull_offset + (x_writer.ull_index_entries * sizeof(uint64_t)),
+         (0 == x_writer.ull_records) ? 0.0 :
+            (double) x_writer.ull_offset / (double) x_writer.ull_records);
+   }
+CLEAN_RETURN:
+   cachesim_trace_close (&x_reader);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Trace conversion failed\n");
+   }
+   return e_ret_val;
+}
+
+/*
+ * Prints the table view of an event log: the same rows a logged run prints
+ * as it goes.
+ */
+CACHESIM_RET_E cachesim_render_events (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   FILE *px_file = NULL;
+   CACHESIM_EVENT_RENDERER_X x_renderer = {0};
+   CACHESIM_EVENT_X x_event = {0};
+   uint8_t uca_header [CACHESIM_EVENT_LOG_HEADER_SIZE] = {0};
+   uint8_t *puc_buffer = NULL;
+   uint32_t ui_version = 0;
+   size_t sz_record_size = 0;
+   size_t sz_read = 0;
+   size_t sz_i = 0;
+
+   px_file = fopen (px_cache_args->pc_render_file, "rb");
+   if (NULL == px_file)
+   {
+      fprintf (stderr, "Unable to open %s: %s\n", px_cache_args->pc_render_file,
+         strerror (errno));
+      goto CLEAN_RETURN;
+   }
+   if ((1 != fread (uca_header, sizeof (uca_header), 1, px_file))
+      || (0 != memcmp (uca_header, CACHESIM_EVENT_LOG_MAGIC,
+         CACHESIM_EVENT_LOG_MAGIC_LEN))
+      || (0 == (ui_version = cachesim_get_le32 (uca_header + 8)))
+      || (ui_version > CACHESIM_EVENT_LOG_VERSION))
+   {
+      fprintf (stderr, "%s is not an event log\n", px_cache_args->pc_render_file);
+      goto CLEAN_RETURN;
+   }
+   sz_record_size = (1 == ui_version) ?
+      CACHESIM_EVENT_LOG_V1_RECORD_SIZE : CACHESIM_EVENT_LOG_RECORD_SIZE;
+   puc_buffer = (uint8_t *) malloc (
+      CACHESIM_EVENT_LOG_WRITE_BATCH * sz_record_size);
+   if ((NULL == puc_buffer)
+      || (eCACHESIM_RET_SUCCESS != cachesim_event_renderer_init (&x_renderer,
+         stdout, cachesim_get_le32 (uca_header + 12),
+         cachesim_get_le32 (uca_header + 16), cachesim_get_le32 (uca_header + 20))))
+   {
+      fprintf (stderr, "Unable to render %s\n", px_cache_args->pc_render_file);
+      goto CLEAN_RETURN;
+   }
+
+   cachesim_event_render_header (&x_renderer);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+   while (0 != (sz_read = fread (puc_buffer, 1,
+      CACHESIM_EVENT_LOG_WRITE_BATCH * sz_record_size, px_file)))
+   {
+      if (0 != (sz_read % sz_record_size))
+      {
+         e_ret_val = eCACHESIM_RET_FAILURE;
+      }
+      for (sz_i = 0; (sz_i + sz_record_size) <= sz_read;
+         sz_i += sz_record_size)
+      {
+         if (false == cachesim_event_decode (puc_buffer + sz_i, ui_version,
+            &x_event))
+         {
+            e_ret_val = eCACHESIM_RET_FAILURE;
+            break;
+         }
+         cachesim_event_render (&x_renderer, &x_event);
+      }
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         fprintf (stderr, "%s is truncated or corrupt\n",
+            px_cache_args->pc_render_file);
+         break;
+      }
+   }
+   if (0 != ferror (px_file))
+   {
+      fprintf (stderr, "Unable to read %s\n", px_cache_args->pc_render_file);
+      e_ret_val = eCACHESIM_RET_FAILURE;
+   }
+CLEAN_RETURN:
+   cachesim_event_renderer_deinit (&x_renderer);
+   free (puc_buffer);
+   if (NULL != px_file)
+   {
+      (void) fclose (px_file);
+   }
+   return e_ret_val;
+}
+
+/*
+ * Parses the hierarchy given with --levels: one
+ * <cache words>:<associativity>:<block words> triple per level, from the
+ * level closest to the processor outwards, separated by commas.
+ */
+static CACHESIM_RET_E cachesim_hierarchy_parse_levels (
+   const char *pc_levels,
+   CACHESIM_CACHE_PARAMS_X *px_level_params,
+   uint32_t *pui_no_of_levels)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   const char *pc_pos = pc_levels;
+   char *pc_end = NULL;
+   uint32_t ua_fields [3] = {0};
+   uint32_t ui_field = 0;
+   unsigned long ul_value = 0;
+
+   *pui_no_of_levels = 0;
+   while ('\0' != *pc_pos)
+   {
+      if (*pui_no_of_levels >= CACHESIM_MAX_CACHE_LEVELS)
+      {
+         goto CLEAN_RETURN;
+      }
+      for (ui_field = 0; ui_field < 3; ui_field++)
+      {
+         ul_value = strtoul (pc_pos, &pc_end, 0);
+         if ((pc_end == pc_pos) || (0 == ul_value) || (ul_value > UINT32_MAX))
+         {
+            goto CLEAN_RETURN;
+         }
+         ua_fields [ui_field] = (uint32_t) ul_value;
+         pc_pos = pc_end;
+         if ((ui_field < 2) && (':' != *pc_pos++))
+         {
+            goto CLEAN_RETURN;
+         }
+      }
+      px_level_params [*pui_no_of_levels].ui_cache_size_words = ua_fields [0];
+      px_level_params [*pui_no_of_levels].ui_associativity = ua_fields [1];
+      px_level_params [*pui_no_of_levels].ui_block_size_words = ua_fields [2];
+      (*pui_no_of_levels)++;
+      if (',' == *pc_pos)
+      {
+         pc_pos++;
+      }
+      else if ('\0' != *pc_pos)
+      {
+         goto CLEAN_RETURN;
+      }
+   }
+   e_ret_val = (0 != *pui_no_of_levels) ? eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static const char *cachesim_inclusion_policy_name (
+   CACHESIM_INCLUSION_POLICY_E e_inclusion)
+{
+   switch (e_inclusion)
+   {
+   case eCACHESIM_INCLUSION_POLICY_INCLUSIVE:
+      return "inclusive";
+   case eCACHESIM_INCLUSION_POLICY_EXCLUSIVE:
+      return "exclusive";
+   case eCACHESIM_INCLUSION_POLICY_NINE:
+      return "nine";
+   default:
+      return "invalid";
+   }
+}
+
+static void cachesim_hierarchy_free (
+   CACHESIM_HIERARCHY_X *px_hierarchy)
+{
+   uint32_t ui_level = 0;
+
+   for (ui_level = 0; ui_level < px_hierarchy->ui_no_of_levels; ui_level++)
+   {
+      if (NULL != px_hierarchy->xa_levels [ui_level].px_cache)
+      {
+         (void) cachesim_set_free_cache (px_hierarchy->xa_levels [ui_level].px_cache);
+      }
+      cachesim_sim_stats_deinit (&(px_hierarchy->xa_levels [ui_level].x_stats));
+   }
+   memset (px_hierarchy, 0x00, sizeof(*px_hierarchy));
+}
+
+static CACHESIM_RET_E cachesim_hierarchy_alloc (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   CACHESIM_CACHE_PARAMS_X *px_level_params,
+   uint32_t ui_no_of_levels,
+   CACHESIM_INCLUSION_POLICY_E e_inclusion)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_level = 0;
+
+   memset (px_hierarchy, 0x00, sizeof(*px_hierarchy));
+   px_hierarchy->e_inclusion = e_inclusion;
+   for (ui_level = 0; ui_level < ui_no_of_levels; ui_level++)
+   {
+      /*
+       * A block of an outer level has to cover whole blocks of the inner
+       * levels, and an exclusive hierarchy moves blocks between levels as
+       * they are, so it needs one block size throughout.
+       */
+      if ((ui_level > 0)
+         && ((px_level_params [ui_level].ui_block_size_words
+               % px_level_params [ui_level - 1].ui_block_size_words)
+            || ((eCACHESIM_INCLUSION_POLICY_EXCLUSIVE == e_inclusion)
+               && (px_level_params [ui_level].ui_block_size_words
+                  != px_level_params [ui_level - 1].ui_block_size_words))))
+      {
+         fprintf (stderr, "The block size of L%u must be a multiple of the "
+            "block size of L%u%s\n", ui_level + 1, ui_level,
+            (eCACHESIM_INCLUSION_POLICY_EXCLUSIVE == e_inclusion) ?
+               " and equal to it in an exclusive hierarchy" : "");
+         e_ret_val = eCACHESIM_RET_FAILURE;
+         goto CLEAN_RETURN;
+      }
+      e_ret_val = cachesim_set_alloc_cache (
+         &(px_hierarchy->xa_levels [ui_level].px_cache),
+         &(px_level_params [ui_level]));
+      px_hierarchy->ui_no_of_levels++;
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         fprintf (stderr, "Unable to allocate L%u\n", ui_level + 1);
+         goto CLEAN_RETURN;
+      }
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      cachesim_hierarchy_free (px_hierarchy);
+   }
+   return e_ret_val;
+}
+
+/*
+ * Inclusive hierarchies: a block evicted from level ui_level takes every
+ * copy of its words out of the inner levels with it. Returns whether any of
+ * those copies was dirty, the evicted block then has to be written back.
+ */
+static bool cachesim_hierarchy_back_invalidate (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   uint32_t ui_level,
+   uint64_t ull_evicted_block)
+{
+   CACHESIM_CACHE_LEVEL_X *px_level = &(px_hierarchy->xa_levels [ui_level]);
+   CACHE_SET_X *px_inner = NULL;
+   uint32_t ui_block_words = px_level->px_cache->x_cache_params.ui_block_size_words;
+   uint64_t ull_word = 0;
+   uint64_t ull_end = ((uint64_t) ull_evicted_block + 1) * ui_block_words;
+   uint32_t ui_inner = 0;
+   bool b_dirty = false;
+   bool b_any_dirty = false;
+
+   for (ui_inner = 0; ui_inner < ui_level; ui_inner++)
+   {
+      px_inner = px_hierarchy->xa_levels [ui_inner].px_cache;
+      for (ull_word = (uint64_t) ull_evicted_block * ui_block_words;
+         ull_word < ull_end;
+         ull_word += px_inner->x_cache_params.ui_block_size_words)
+      {
+         if (true == cachesim_set_invalidate_block (px_inner,
+            cachesim_set_ram_block (px_inner, ull_word), &b_dirty))
+         {
+            px_level->ull_back_invalidations++;
+            b_any_dirty |= b_dirty;
+         }
+      }
+   }
+   return b_any_dirty;
+}
+
+/*
+ * Marks the block holding the word dirty if the cache has it. Returns
+ * whether it did.
+ */
+static bool cachesim_set_mark_dirty (
+   CACHE_SET_X *px_cache,
+   uint64_t ull_index)
+{
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_block_idx = 0;
+
+   if (false == cachesim_set_lookup_cache_v2 (px_cache, ull_index, &ui_cache_set,
+      &ui_block_idx))
+   {
+      return false;
+   }
+   px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata.b_is_dirty = true;
+   return true;
+}
+
+/*
+ * A dirty block evicted from level ui_level is written to the first outer
+ * level holding it, or to memory if none does.
+ */
+static void cachesim_hierarchy_write_back (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   uint32_t ui_level,
+   uint64_t ull_evicted_block)
+{
+   const CACHESIM_CACHE_PARAMS_X *px_params =
+      &(px_hierarchy->xa_levels [ui_level].px_cache->x_cache_params);
+   uint64_t ull_index = ull_evicted_block * px_params->ui_block_size_words;
+   uint32_t ui_outer = 0;
+
+   for (ui_outer = ui_level + 1; ui_outer < px_hierarchy->ui_no_of_levels;
+      ui_outer++)
+   {
+      if (true == cachesim_set_mark_dirty (
+         px_hierarchy->xa_levels [ui_outer].px_cache, ull_index))
+      {
+         return;
+      }
+   }
+   px_hierarchy->ull_bytes_to_memory +=
+      (uint64_t) px_params->ui_block_size_words * px_params->ui_word_size_bytes;
+}
+
+/*
+ * Places the word's block, dirty or not, in the level and deals with the
+ * block it evicts as the inclusion policy requires.
+ */
+static CACHESIM_RET_E cachesim_hierarchy_fill (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   uint32_t ui_level,
+   uint64_t ull_index,
+   bool b_dirty)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_LEVEL_X *px_level = NULL;
+   const CACHESIM_CACHE_PARAMS_X *px_params = NULL;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_block_idx = 0;
+   uint64_t ull_evicted_block = CACHESIM_INVALID_TAG;
+   bool b_evicted_dirty = false;
+
+   /*
+    * In an exclusive hierarchy a victim cascades outwards one level at a
+    * time; past the last level it is dropped.
+    */
+   while (ui_level < px_hierarchy->ui_no_of_levels)
+   {
+      px_level = &(px_hierarchy->xa_levels [ui_level]);
+      px_params = &(px_level->px_cache->x_cache_params);
+      e_ret_val = cachesim_set_fetch_data_to_cache_v2 (px_level->px_cache,
+         ull_index, false, &ui_cache_set, &ui_block_idx, &ull_evicted_block,
+         &b_evicted_dirty);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         break;
+      }
+      px_level->px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata.b_is_dirty = b_dirty;
+      if (CACHESIM_INVALID_TAG == ull_evicted_block)
+      {
+         break;
+      }
+      px_level->ull_evictions++;
+      if (eCACHESIM_INCLUSION_POLICY_INCLUSIVE == px_hierarchy->e_inclusion)
+      {
+         b_evicted_dirty |= cachesim_hierarchy_back_invalidate (px_hierarchy,
+            ui_level, ull_evicted_block);
+      }
+      px_level->x_stats.ull_dirty_evictions += b_evicted_dirty;
+      if (eCACHESIM_INCLUSION_POLICY_EXCLUSIVE != px_hierarchy->e_inclusion)
+      {
+         if (true == b_evicted_dirty)
+         {
+            cachesim_hierarchy_write_back (px_hierarchy, ui_level,
+               ull_evicted_block);
+         }
+         break;
+      }
+      if ((ui_level + 1 == px_hierarchy->ui_no_of_levels)
+         && (true == b_evicted_dirty))
+      {
+         px_hierarchy->ull_bytes_to_memory +=
+            (uint64_t) px_params->ui_block_size_words * px_params->ui_word_size_bytes;
+      }
+      ull_index = ull_evicted_block * px_params->ui_block_size_words;
+      b_dirty = b_evicted_dirty;
+      ui_level++;
+   }
+   return e_ret_val;
+}
+
+/*
+ * Latency of an access that hit in level ui_hit_level (ui_no_of_levels for
+ * memory), counted at every level it went through from that level down:
+ * the lookups on the way, the miss penalties of the levels that missed and
+ * the memory latency if it went that far.
+ */
+static void cachesim_hierarchy_latency_account (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   uint32_t ui_hit_level)
+{
+   const CACHESIM_CACHE_PARAMS_X *px_params = NULL;
+   uint32_t ui_level = ui_hit_level;
+   uint64_t ull_latency = 0;
+
+   if (ui_hit_level == px_hierarchy->ui_no_of_levels)
+   {
+      ui_level = ui_hit_level - 1;
+      ull_latency = px_hierarchy->xa_levels [ui_level].px_cache->
+         x_cache_params.ui_memory_latency;
+   }
+   while (1)
+   {
+      px_params = &(px_hierarchy->xa_levels [ui_level].px_cache->x_cache_params);
+      ull_latency += px_params->ui_hit_latency;
+      if (ui_level < ui_hit_level)
+      {
+         ull_latency += px_params->ui_miss_penalty;
+      }
+      cachesim_latency_account (&(px_hierarchy->xa_levels [ui_level].x_stats),
+         ull_latency, px_params->ui_hit_latency);
+      if (0 == ui_level)
+      {
+         break;
+      }
+      ui_level--;
+   }
+}
+
+/*
+ * One access of the processor to a word. The levels are looked up from the
+ * inside out until one hits or memory is reached. Inclusive and NINE
+ * hierarchies then fill every level that missed, outermost first. An
+ * exclusive hierarchy moves the block out of the level that hit and fills
+ * only the first level, pushing victims outwards. Writes dirty the block in
+ * the first level; the levels are write-back and write-allocate.
+ */
+static CACHESIM_RET_E cachesim_hierarchy_access (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   uint64_t ull_index,
+   CACHESIM_ACCESS_TYPE_E e_type)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_SUCCESS;
+   CACHESIM_CACHE_LEVEL_X *px_level = NULL;
+   CACHESIM_MISS_TYPE_E e_miss_type = eCACHESIM_MISS_TYPE_NONE;
+   uint32_t ui_level = 0;
+   uint32_t ui_hit_level = 0;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_block_idx = 0;
+   const CACHESIM_CACHE_PARAMS_X *px_params = NULL;
+   bool b_write = (eCACHESIM_ACCESS_TYPE_WRITE == e_type);
+   bool b_dirty = false;
+
+   px_hierarchy->xa_levels [0].x_stats.ull_writes += b_write;
+   for (ui_hit_level = 0; ui_hit_level < px_hierarchy->ui_no_of_levels;
+      ui_hit_level++)
+   {
+      px_level = &(px_hierarchy->xa_levels [ui_hit_level]);
+      px_level->x_stats.ull_total_accesses++;
+      if (true == cachesim_set_lookup_cache_v2 (px_level->px_cache, ull_index,
+         &ui_cache_set, &ui_block_idx))
+      {
+         e_ret_val = cachesim_set_handle_cache_hit (px_level->px_cache,
+            ull_index, ui_cache_set, ui_block_idx, &(px_level->x_stats));
+         break;
+      }
+      e_ret_val = cachesim_set_classify_cache_miss (px_level->px_cache,
+         ull_index, &e_miss_type, &(px_level->x_stats));
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         goto CLEAN_RETURN;
+      }
+   }
+   cachesim_hierarchy_latency_account (px_hierarchy, ui_hit_level);
+   if (ui_hit_level == px_hierarchy->ui_no_of_levels)
+   {
+      px_hierarchy->ull_memory_accesses++;
+      px_params = &(px_level->px_cache->x_cache_params);
+      px_hierarchy->ull_bytes_from_memory +=
+         (uint64_t) px_params->ui_block_size_words * px_params->ui_word_size_bytes;
+   }
+   if (0 == ui_hit_level)
+   {
+      goto MARK_DIRTY;
+   }
+   px_hierarchy->xa_levels [0].x_stats.ull_write_misses += b_write;
+
+   if (eCACHESIM_INCLUSION_POLICY_EXCLUSIVE == px_hierarchy->e_inclusion)
+   {
+      if (ui_hit_level < px_hierarchy->ui_no_of_levels)
+      {
+         (void) cachesim_set_invalidate_block (
+            px_hierarchy->xa_levels [ui_hit_level].px_cache,
+            cachesim_set_ram_block (
+               px_hierarchy->xa_levels [ui_hit_level].px_cache, ull_index),
+            &b_dirty);
+      }
+      e_ret_val = cachesim_hierarchy_fill (px_hierarchy, 0, ull_index, b_dirty);
+      goto MARK_DIRTY;
+   }
+   for (ui_level = ui_hit_level; ui_level > 0; ui_level--)
+   {
+      e_ret_val = cachesim_hierarchy_fill (px_hierarchy, ui_level - 1, ull_index,
+         false);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         break;
+      }
+   }
+MARK_DIRTY:
+   if ((true == b_write) && (eCACHESIM_RET_SUCCESS == e_ret_val))
+   {
+      (void) cachesim_set_mark_dirty (px_hierarchy->xa_levels [0].px_cache,
+         ull_index);
+   }
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static void cachesim_hierarchy_access_record (
+   CACHESIM_HIERARCHY_X *px_hierarchy,
+   const CACHESIM_TRACE_RECORD_X *px_record,
+   CACHESIM_TRACE_STATS_X *px_trace_stats)
+{
+   CACHE_SET_X *px_first = px_hierarchy->xa_levels [0].px_cache;
+   uint32_t ui_block_size_words = px_first->x_cache_params.ui_block_size_words;
+   uint64_t ull_first_word = 0;
+   uint64_t ull_last_word = 0;
+   uint64_t ull_block = 0;
+
+   if (false == cachesim_trace_record_words (px_record,
+      px_first->x_cache_params.ui_word_size_bytes,
+      px_first->x_cache_params.ui_address_bits, &ull_first_word,
+      &ull_last_word, px_trace_stats))
+   {
+      return;
+   }
+   (void) cachesim_hierarchy_access (px_hierarchy, ull_first_word,
+      px_record->e_type);
+   for (ull_block = (ull_first_word / ui_block_size_words) + 1;
+      ull_block <= (ull_last_word / ui_block_size_words); ull_block++)
+   {
+      (void) cachesim_hierarchy_access (px_hierarchy,
+         ull_block * ui_block_size_words, px_record->e_type);
+   }
+}
+
+static void cachesim_hierarchy_log_summary (
+   CACHESIM_HIERARCHY_X *px_hierarchy)
+{
+   CACHESIM_CACHE_LEVEL_X *px_level = NULL;
+   const CACHESIM_CACHE_PARAMS_X *px_params = NULL;
+   uint32_t ui_level = 0;
+   const CACHESIM_SIM_STATS_X *px_first_stats = &(px_hierarchy->xa_levels [0].x_stats);
+   uint64_t ull_processor_accesses = px_first_stats->ull_total_accesses;
+
+   /*
+    * The cycles of L1 cover the whole hierarchy.
+    */
+   printf ("Hierarchy:\n"
+      "\t inclusion                 : %s\n"
+      "\t ull_memory_accesses       : %" PRIu64 "\n"
+      "\t ull_bytes_from_memory     : %" PRIu64 "\n"
+      "\t ull_bytes_to_memory       : %" PRIu64 "\n"
+      "\t ull_stall_cycles          : %" PRIu64 "\n"
+      "\t\t d_avg_memory_access_time : %f\n\n",
+      cachesim_inclusion_policy_name (px_hierarchy->e_inclusion),
+      px_hierarchy->ull_memory_accesses, px_hierarchy->ull_bytes_from_memory,
+      px_hierarchy->ull_bytes_to_memory, px_first_stats->ull_stall_cycles,
+      (0 == ull_processor_accesses) ? 0.0 :
+         (double) px_first_stats->ull_cycles / (double) ull_processor_accesses);
+   for (ui_level = 0; ui_level < px_hierarchy->ui_no_of_levels; ui_level++)
+   {
+      px_level = &(px_hierarchy->xa_levels [ui_level]);
+      px_params = &(px_level->px_cache->x_cache_params);
+      printf ("L%u (%u words, %u-way, %u word blocks, %u sets):\n",
+         ui_level + 1, px_params->ui_cache_size_words,
+         px_params->ui_associativity, px_params->ui_block_size_words,
+         px_level->px_cache->ui_configured_no_of_sets);
+      printf ("\t ull_evictions             : %" PRIu64 "\n"
+         "\t ull_back_invalidations    : %" PRIu64 "\n",
+         px_level->ull_evictions, px_level->ull_back_invalidations);
+      /*
+       * The local miss rate is per access reaching the level, the global one
+       * per access of the processor.
+       */
+      printf ("\t\t d_global_miss_rate       : %f\n",
+         (0 == ull_processor_accesses) ? 0.0 :
+            (double) px_level->x_stats.ull_miss_count / (double) ull_processor_accesses);
+      cache_sim_log_summary (&(px_level->x_stats));
+   }
+}
+
+/*
+ * Replays the trace through the multi-level hierarchy given with --levels.
+ */
+CACHESIM_RET_E cachesim_simulate_hierarchy (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_CACHE_PARAMS_X xa_level_params [CACHESIM_MAX_CACHE_LEVELS];
+   CACHESIM_HIERARCHY_X x_hierarchy = {0};
+   CACHESIM_TRACE_READER_X x_reader = {0};
+   CACHESIM_TRACE_RECORD_X x_record = {0};
+   CACHESIM_TRACE_STATS_X x_trace_stats = {0};
+   uint32_t ui_no_of_levels = 0;
+   uint32_t ui_level = 0;
+   uint64_t ull_records_read = 0;
+   bool b_end_of_trace = false;
+
+   if (NULL == px_cache_args->pc_trace_file)
+   {
+      fprintf (stderr, "--levels needs a trace to replay (--trace)\n");
+      goto CLEAN_RETURN;
+   }
+   if (eCACHESIM_RET_SUCCESS != cachesim_hierarchy_parse_levels (
+      px_cache_args->pc_levels, xa_level_params, &ui_no_of_levels))
+   {
+      fprintf (stderr, "Invalid --levels, expected up to %d "
+         "<cache words>:<associativity>:<block words> levels separated by "
+         "commas\n", CACHESIM_MAX_CACHE_LEVELS);
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * Everything but the geometry is shared by all the levels.
+    */
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   if ((eCACHESIM_WRITE_POLICY_WRITE_BACK != x_cache_param.e_write_policy)
+      || (false == x_cache_param.b_write_allocate))
+   {
+      fprintf (stderr, "--levels models write-back, write-allocate levels "
+         "only\n");
+      goto CLEAN_RETURN;
+   }
+   if (x_cache_param.ui_sample_sets > 1)
+   {
+      fprintf (stderr, "--sample-sets is not supported with --levels\n");
+      goto CLEAN_RETURN;
+   }
+   if (eCACHESIM_PREFETCHER_NONE != x_cache_param.e_prefetcher)
+   {
+      fprintf (stderr, "--prefetcher is not supported with --levels\n");
+      goto CLEAN_RETURN;
+   }
+   if ((NULL != x_cache_param.pc_heatmap_file)
+      || (NULL != x_cache_param.pc_heatmap_blocks_file))
+   {
+      fprintf (stderr, "--heatmap is not supported with --levels\n");
+      goto CLEAN_RETURN;
+   }
+   if (0 != x_cache_param.ui_mshrs)
+   {
+      fprintf (stderr, "--mshrs is not supported with --levels\n");
+      goto CLEAN_RETURN;
+   }
+   if ((NULL != x_cache_param.pc_checkpoint_file)
+      || (NULL != x_cache_param.pc_restore_file))
+   {
+      fprintf (stderr, "--checkpoint and --restore are not supported with "
+         "--levels\n");
+      goto CLEAN_RETURN;
+   }
+   if ((0 != px_cache_args->ull_warmup) || (true == px_cache_args->b_roi_markers))
+   {
+      fprintf (stderr, "--warmup and --roi-markers are not supported with "
+         "--levels\n");
+      goto CLEAN_RETURN;
+   }
+   for (ui_level = 0; ui_level < ui_no_of_levels; ui_level++)
+   {
+      x_cache_param.ui_cache_size_words = xa_level_params [ui_level].ui_cache_size_words;
+      x_cache_param.ui_associativity = xa_level_params [ui_level].ui_associativity;
+      x_cache_param.ui_block_size_words = xa_level_params [ui_level].ui_block_size_words;
+      cachesim_latency_from_args (px_cache_args, ui_level, &x_cache_param);
+      xa_level_params [ui_level] = x_cache_param;
+   }
+   e_ret_val = cachesim_hierarchy_alloc (&x_hierarchy, xa_level_params,
+      ui_no_of_levels, px_cache_args->e_inclusion);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_trace_open (&x_reader, px_cache_args->pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      e_ret_val = cachesim_trace_seek (&x_reader, px_cache_args->ull_fast_forward);
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("++++++++++++++Hierarchy Simulator+++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   while ((0 == px_cache_args->ull_max_records)
+      || (ull_records_read < px_cache_args->ull_max_records))
+   {
+      e_ret_val = cachesim_trace_read_record (&x_reader, &x_record,
+         &b_end_of_trace);
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+      {
+         break;
+      }
+      ull_records_read++;
+      cachesim_hierarchy_access_record (&x_hierarchy, &x_record, &x_trace_stats);
+   }
+
+   printf ("Trace:\n"
+      "\t ull_records               : %" PRIu64 "\n"
+      "\t ull_reads                 : %" PRIu64 "\n"
+      "\t ull_writes                : %" PRIu64 "\n"
+      "\t ull_skipped               : %" PRIu64 "\n",
+      x_trace_stats.ull_records, x_trace_stats.ull_reads,
+      x_trace_stats.ull_writes, x_trace_stats.ull_skipped);
+   cachesim_hierarchy_log_summary (&x_hierarchy);
+CLEAN_RETURN:
+   cachesim_trace_close (&x_reader);
+   cachesim_hierarchy_free (&x_hierarchy);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Hierarchy simulation failed\n");
+   }
+   return e_ret_val;
+}
+
+static const char *cachesim_coherence_protocol_name (
+   CACHESIM_COHERENCE_PROTOCOL_E e_protocol)
+{
+   switch (e_protocol)
+   {
+   case eCACHESIM_COHERENCE_PROTOCOL_MESI:
+      return "mesi";
+   case eCACHESIM_COHERENCE_PROTOCOL_MOESI:
+      return "moesi";
+   default:
+      return "invalid";
+   }
+}
+
+static void cachesim_multicore_free (
+   CACHESIM_MULTICORE_X *px_multicore)
+{
+   uint32_t ui_core = 0;
+
+   if (NULL != px_multicore->px_cores)
+   {
+      for (ui_core = 0; ui_core < px_multicore->ui_no_of_cores; ui_core++)
+      {
+         if (NULL != px_multicore->px_cores [ui_core].px_cache)
+         {
+            (void) cachesim_set_free_cache (px_multicore->px_cores [ui_core].px_cache);
+         }
+         cachesim_sim_stats_deinit (&(px_multicore->px_cores [ui_core].x_stats));
+         cachesim_hash_map_deinit (&(px_multicore->px_cores [ui_core].x_invalidated));
+      }
+      free (px_multicore->px_cores);
+   }
+   cachesim_hash_map_deinit (&(px_multicore->x_word_writes));
+   cachesim_hash_map_deinit (&(px_multicore->x_false_sharing));
+   memset (px_multicore, 0x00, sizeof(*px_multicore));
+}
+
+static CACHESIM_RET_E cachesim_multicore_alloc (
+   CACHESIM_MULTICORE_X *px_multicore,
+   CACHESIM_CACHE_PARAMS_X *px_cache_params,
+   uint32_t ui_no_of_cores,
+   CACHESIM_COHERENCE_PROTOCOL_E e_protocol)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_core = 0;
+
+   memset (px_multicore, 0x00, sizeof(*px_multicore));
+   px_multicore->e_protocol = e_protocol;
+   px_multicore->px_cores = calloc (ui_no_of_cores, sizeof(CACHESIM_CORE_X));
+   if (NULL == px_multicore->px_cores)
+   {
+      goto CLEAN_RETURN;
+   }
+   for (ui_core = 0; ui_core < ui_no_of_cores; ui_core++)
+   {
+      e_ret_val = cachesim_set_alloc_cache (
+         &(px_multicore->px_cores [ui_core].px_cache), px_cache_params);
+      px_multicore->ui_no_of_cores++;
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         fprintf (stderr, "Unable to allocate the cache of core %u\n", ui_core);
+         goto CLEAN_RETURN;
+      }
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      cachesim_multicore_free (px_multicore);
+   }
+   return e_ret_val;
+}
+
+/*
+ * Bus transaction of core ui_core for the word's block as seen by the
+ * other caches. A read (b_exclusive false) demotes the other copies to
+ * shared; a dirty copy supplies the block and, under MESI, is written back
+ * on the way, while under MOESI it stays dirty as the owner. An exclusive
+ * transaction invalidates every other copy; a dirty one hands its data to
+ * the requester instead of memory. *pb_shared tells whether any copy is
+ * left elsewhere, *pb_supplied whether a dirty copy provided the block.
+ */
+static void cachesim_multicore_snoop (
+   CACHESIM_MULTICORE_X *px_multicore,
+   uint32_t ui_core,
+   uint64_t ull_index,
+   bool b_exclusive,
+   bool *pb_shared,
+   bool *pb_supplied)
+{
+   CACHESIM_CORE_X *px_other = NULL;
+   CACHE_BLOCK_METADATA_X *px_metadata = NULL;
+   uint64_t *pull_stamp = NULL;
+   uint32_t ui_other = 0;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_block_idx = 0;
+   bool b_inserted = false;
+
+   *pb_shared = false;
+   *pb_supplied = false;
+   for (ui_other = 0; ui_other < px_multicore->ui_no_of_cores; ui_other++)
+   {
+      px_other = &(px_multicore->px_cores [ui_other]);
+      if ((ui_other == ui_core)
+         || (false == cachesim_set_lookup_cache_v2 (px_other->px_cache, ull_index,
+            &ui_cache_set, &ui_block_idx)))
+      {
+         continue;
+      }
+      px_metadata = &(px_other->px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata);
+      *pb_supplied |= (eCACHESIM_COHERENCE_STATE_MODIFIED == px_metadata->uc_coherence_state)
+         || (eCACHESIM_COHERENCE_STATE_OWNED == px_metadata->uc_coherence_state);
+      if (true == b_exclusive)
+      {
+         (void) cachesim_set_invalidate_block (px_other->px_cache,
+            cachesim_set_ram_block (px_other->px_cache, ull_index), NULL);
+         pull_stamp = cachesim_hash_map_insert (&(px_other->x_invalidated),
+            cachesim_set_ram_block (px_other->px_cache, ull_index), &b_inserted);
+         if (NULL != pull_stamp)
+         {
+            *pull_stamp = px_multicore->ull_clock;
+         }
+         px_other->ull_invalidations_received++;
+         px_multicore->px_cores [ui_core].ull_invalidations_sent++;
+         continue;
+      }
+      *pb_shared = true;
+      switch (px_metadata->uc_coherence_state)
+      {
+      case eCACHESIM_COHERENCE_STATE_MODIFIED:
+         if (eCACHESIM_COHERENCE_PROTOCOL_MOESI == px_multicore->e_protocol)
+         {
+            px_metadata->uc_coherence_state = eCACHESIM_COHERENCE_STATE_OWNED;
+            break;
+         }
+         px_other->x_stats.ull_bytes_to_memory +=
+            CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_other->px_cache->x_cache_params));
+         px_metadata->b_is_dirty = false;
+         px_metadata->uc_coherence_state = eCACHESIM_COHERENCE_STATE_SHARED;
+         break;
+      case eCACHESIM_COHERENCE_STATE_EXCLUSIVE:
+         px_metadata->uc_coherence_state = eCACHESIM_COHERENCE_STATE_SHARED;
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+/*
+ * Counts a miss of the core and classifies it. A miss on a block another
+ * core invalidated here is a coherence miss: a true sharing miss if one of
+ * the words [ull_first_word, ull_last_word] was written since, a false
+ * sharing miss if the invalidating writes all went to other words of the
+ * block. Any other miss is compulsory, capacity or conflict as usual.
+ */
+static CACHESIM_RET_E cachesim_multicore_classify_miss (
+   CACHESIM_MULTICORE_X *px_multicore,
+   CACHESIM_CORE_X *px_core,
+   uint64_t ull_first_word,
+   uint64_t ull_last_word,
+   CACHESIM_MISS_TYPE_E *pe_miss_type)
+{
+   CACHE_SET_X *px_cache = px_core->px_cache;
+   uint64_t ull_ram_block = cachesim_set_ram_block (px_cache, ull_first_word);
+   uint64_t *pull_stamp = NULL;
+   uint64_t *pull_count = NULL;
+   uint64_t ull_invalidated = 0;
+   uint64_t ull_word = 0;
+   bool b_true_sharing = false;
+   bool b_inserted = false;
+
+   pull_stamp = cachesim_hash_map_find (&(px_core->x_invalidated), ull_ram_block);
+   if (NULL == pull_stamp)
+   {
+      return cachesim_set_classify_cache_miss (px_cache, ull_first_word,
+         pe_miss_type, &(px_core->x_stats));
+   }
+   ull_invalidated = *pull_stamp;
+   cachesim_hash_map_remove (&(px_core->x_invalidated), ull_ram_block);
+
+   /*
+    * Keep the shadow in step with the real cache; the block is not new.
+    */
+   if (true == px_cache->x_cache_params.b_classify_misses)
+   {
+      (void) cachesim_shadow_access (&(px_cache->x_shadow), ull_ram_block);
+   }
+   for (ull_word = ull_first_word; ull_word <= ull_last_word; ull_word++)
+   {
+      pull_stamp = cachesim_hash_map_find (&(px_multicore->x_word_writes), ull_word);
+      if ((NULL != pull_stamp) && (*pull_stamp >= ull_invalidated))
+      {
+         b_true_sharing = true;
+         break;
+      }
+   }
+   if (true == b_true_sharing)
+   {
+      px_core->ull_true_sharing_misses++;
+   }
+   else
+   {
+      px_core->ull_false_sharing_misses++;
+      pull_count = cachesim_hash_map_insert (&(px_multicore->x_false_sharing),
+         ull_ram_block, &b_inserted);
+      if (NULL == pull_count)
+      {
+         fprintf (stderr, "Out of memory tracking RAM block %" PRIu64 "\n", ull_ram_block);
+         return eCACHESIM_RET_FAILURE;
+      }
+      (*pull_count)++;
+   }
+   px_core->ull_coherence_misses++;
+   px_core->x_stats.ull_miss_count++;
+   *pe_miss_type = eCACHESIM_MISS_TYPE_NONE;
+   return eCACHESIM_RET_SUCCESS;
+}
+
+/*
+ * Access of core ui_core to the words [ull_first_word, ull_last_word] of one
+ * block. Read hits stay local. A write hit on an exclusive block takes it
+ * to modified silently; on a shared or owned block it first invalidates the
+ * other copies. A read miss fetches the block exclusive if no other cache
+ * has it and shared otherwise; a write miss fetches it modified,
+ * invalidating the other copies. The caches are write-back and
+ * write-allocate.
+ */
+static CACHESIM_RET_E cachesim_multicore_access (
+   CACHESIM_MULTICORE_X *px_multicore,
+   uint32_t ui_core,
+   uint64_t ull_first_word,
+   uint64_t ull_last_word,
+   CACHESIM_ACCESS_TYPE_E e_type)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CORE_X *px_core = &(px_multicore->px_cores [ui_core]);
+   CACHE_SET_X *px_cache = px_core->px_cache;
+   CACHE_BLOCK_METADATA_X *px_metadata = NULL;
+   CACHESIM_MISS_TYPE_E e_miss_type = eCACHESIM_MISS_TYPE_NONE;
+   uint64_t *pull_stamp = NULL;
+   uint32_t ui_cache_set = 0;
+   uint32_t ui_block_idx = 0;
+   uint64_t ull_word = 0;
+   bool b_write = (eCACHESIM_ACCESS_TYPE_WRITE == e_type);
+   bool b_shared = false;
+   bool b_supplied = false;
+   bool b_evicted_dirty = false;
+   bool b_inserted = false;
+   bool b_cache_hit = false;
+
+   px_multicore->ull_clock++;
+   px_core->x_stats.ull_total_accesses++;
+   px_core->x_stats.ull_writes += b_write;
+   b_cache_hit = cachesim_set_lookup_cache_v2 (px_cache, ull_first_word,
+      &ui_cache_set, &ui_block_idx);
+   if (true == b_cache_hit)
+   {
+      e_ret_val = cachesim_set_handle_cache_hit (px_cache, ull_first_word,
+         ui_cache_set, ui_block_idx, &(px_core->x_stats));
+      px_metadata = &(px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata);
+      if ((true == b_write)
+         && ((eCACHESIM_COHERENCE_STATE_SHARED == px_metadata->uc_coherence_state)
+            || (eCACHESIM_COHERENCE_STATE_OWNED == px_metadata->uc_coherence_state)))
+      {
+         cachesim_multicore_snoop (px_multicore, ui_core, ull_first_word, true,
+            &b_shared, &b_supplied);
+         px_core->ull_upgrades++;
+         px_multicore->ull_bus_upgrades++;
+      }
+   }
+   else
+   {
+      e_ret_val = cachesim_multicore_classify_miss (px_multicore, px_core,
+         ull_first_word, ull_last_word, &e_miss_type);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         goto CLEAN_RETURN;
+      }
+      px_core->x_stats.ull_write_misses += b_write;
+      if (true == b_write)
+      {
+         px_multicore->ull_bus_read_exclusives++;
+      }
+      else
+      {
+         px_multicore->ull_bus_reads++;
+      }
+      cachesim_multicore_snoop (px_multicore, ui_core, ull_first_word, b_write,
+         &b_shared, &b_supplied);
+      if (true == b_supplied)
+      {
+         px_core->ull_cache_to_cache++;
+      }
+      else
+      {
+         px_core->x_stats.ull_bytes_from_memory +=
+            CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+      }
+      e_ret_val = cachesim_set_fetch_data_to_cache_v2 (px_cache, ull_first_word,
+         false, &ui_cache_set, &ui_block_idx, NULL, &b_evicted_dirty);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         goto CLEAN_RETURN;
+      }
+      if (true == b_evicted_dirty)
+      {
+         px_core->x_stats.ull_dirty_evictions++;
+         px_core->x_stats.ull_bytes_to_memory +=
+            CACHESIM_BLOCK_SIZE_IN_BYTES(&(px_cache->x_cache_params));
+      }
+      px_metadata = &(px_cache->px_sets[ui_cache_set].px_blocks[ui_block_idx].x_metadata);
+      px_metadata->uc_coherence_state = (true == b_shared) ?
+         eCACHESIM_COHERENCE_STATE_SHARED : eCACHESIM_COHERENCE_STATE_EXCLUSIVE;
+   }
+   if (true == b_write)
+   {
+      px_metadata->uc_coherence_state = eCACHESIM_COHERENCE_STATE_MODIFIED;
+      px_metadata->b_is_dirty = true;
+      for (ull_word = ull_first_word; ull_word <= ull_last_word; ull_word++)
+      {
+         pull_stamp = cachesim_hash_map_insert (&(px_multicore->x_word_writes),
+            ull_word, &b_inserted);
+         if (NULL == pull_stamp)
+         {
+            fprintf (stderr, "Out of memory tracking word %" PRIu64 "\n", ull_word);
+            e_ret_val = eCACHESIM_RET_FAILURE;
+            goto CLEAN_RETURN;
+         }
+         *pull_stamp = px_multicore->ull_clock;
+      }
+   }
+   /*
+    * Misses are charged the memory latency whether memory or another cache
+    * supplies the block.
+    */
+   cachesim_set_latency_account (px_cache, b_cache_hit, &(px_core->x_stats));
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Issues one access per cache block the record touches, on the core of the
+ * record.
+ */
+static CACHESIM_RET_E cachesim_multicore_access_record (
+   CACHESIM_MULTICORE_X *px_multicore,
+   const CACHESIM_TRACE_RECORD_X *px_record,
+   CACHESIM_TRACE_STATS_X *px_trace_stats)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_SUCCESS;
+   const CACHESIM_CACHE_PARAMS_X *px_params =
+      &(px_multicore->px_cores [0].px_cache->x_cache_params);
+   uint64_t ull_first_word = 0;
+   uint64_t ull_last_word = 0;
+   uint64_t ull_block_last_word = 0;
+
+   if (px_record->ui_core >= px_multicore->ui_no_of_cores)
+   {
+      fprintf (stderr, "Trace record %" PRIu64 " is from core %u, but only "
+         "%u cores are simulated\n", px_trace_stats->ull_records + 1,
+         px_record->ui_core, px_multicore->ui_no_of_cores);
+      return eCACHESIM_RET_FAILURE;
+   }
+   if (false == cachesim_trace_record_words (px_record,
+      px_params->ui_word_size_bytes, px_params->ui_address_bits,
+      &ull_first_word, &ull_last_word, px_trace_stats))
+   {
+      return eCACHESIM_RET_SUCCESS;
+   }
+   while ((eCACHESIM_RET_SUCCESS == e_ret_val) && (ull_first_word <= ull_last_word))
+   {
+      ull_block_last_word = ((ull_first_word / px_params->ui_block_size_words) + 1)
+         * px_params->ui_block_size_words - 1;
+      if (ull_block_last_word > ull_last_word)
+      {
+         ull_block_last_word = ull_last_word;
+      }
+      e_ret_val = cachesim_multicore_access (px_multicore, px_record->ui_core,
+         ull_first_word, ull_block_last_word,
+         px_record->e_type);
+      ull_first_word = ull_block_last_word + 1;
+   }
+   return e_ret_val;
+}
+
+/*
+ * Prints the blocks with the most false sharing misses, most first.
+ */
+static void cachesim_multicore_log_false_sharing (
+   CACHESIM_MULTICORE_X *px_multicore)
+{
+   const CACHESIM_HASH_MAP_X *px_map = &(px_multicore->x_false_sharing);
+   const CACHESIM_CACHE_PARAMS_X *px_params =
+      &(px_multicore->px_cores [0].px_cache->x_cache_params);
+   uint64_t ulla_blocks [CACHESIM_FALSE_SHARING_TOP_BLOCKS] = {0};
+   uint64_t ulla_counts [CACHESIM_FALSE_SHARING_TOP_BLOCKS] = {0};
+   uint32_t ui_no_of_top = 0;
+   uint32_t ui_pos = 0;
+   uint64_t ull_slot = 0;
+
+   for (ull_slot = 0; ull_slot < px_map->ull_capacity; ull_slot++)
+   {
+      if (CACHESIM_HASH_MAP_EMPTY_KEY == px_map->pull_keys [ull_slot])
+      {
+         continue;
+      }
+      for (ui_pos = ui_no_of_top; ui_pos > 0; ui_pos--)
+      {
+         if (ulla_counts [ui_pos - 1] >= px_map->pull_values [ull_slot])
+         {
+            break;
+         }
+         if (ui_pos < CACHESIM_FALSE_SHARING_TOP_BLOCKS)
+         {
+            ulla_blocks [ui_pos] = ulla_blocks [ui_pos - 1];
+            ulla_counts [ui_pos] = ulla_counts [ui_pos - 1];
+         }
+      }
+      if (ui_pos < CACHESIM_FALSE_SHARING_TOP_BLOCKS)
+      {
+         ulla_blocks [ui_pos] = px_map->pull_keys [ull_slot];
+         ulla_counts [ui_pos] = px_map->pull_values [ull_slot];
+         if (ui_no_of_top < CACHESIM_FALSE_SHARING_TOP_BLOCKS)
+         {
+            ui_no_of_top++;
+         }
+      }
+   }
+   if (0 == ui_no_of_top)
+   {
+      return;
+   }
+   printf ("False sharing (block address, misses):\n");
+   for (ui_pos = 0; ui_pos < ui_no_of_top; ui_pos++)
+   {
+      printf ("\t 0x%016" PRIx64 "        : %" PRIu64 "\n",
+         ulla_blocks [ui_pos] * CACHESIM_BLOCK_SIZE_IN_BYTES(px_params),
+         ulla_counts [ui_pos]);
+   }
+   printf ("\n");
+}
+
+static void cachesim_multicore_log_core (
+   const char *pc_title,
+   CACHESIM_CORE_X *px_core)
+{
+   printf ("%s:\n"
+      "\t ull_coherence_misses      : %" PRIu64 "\n"
+      "\t ull_true_sharing_misses   : %" PRIu64 "\n"
+      "\t ull_false_sharing_misses  : %" PRIu64 "\n"
+      "\t ull_upgrades              : %" PRIu64 "\n"
+      "\t ull_invalidations_sent    : %" PRIu64 "\n"
+      "\t ull_invalidations_received: %" PRIu64 "\n"
+      "\t ull_cache_to_cache        : %" PRIu64 "\n",
+      pc_title, px_core->ull_coherence_misses,
+      px_core->ull_true_sharing_misses, px_core->ull_false_sharing_misses,
+      px_core->ull_upgrades, px_core->ull_invalidations_sent,
+      px_core->ull_invalidations_received, px_core->ull_cache_to_cache);
+   cache_sim_log_summary (&(px_core->x_stats));
+}
+
+static void cachesim_multicore_log_summary (
+   CACHESIM_MULTICORE_X *px_multicore)
+{
+   CACHESIM_CORE_X x_all = {0};
+   CACHESIM_CORE_X *px_core = NULL;
+   uint32_t ui_core = 0;
+   uint32_t ui_bucket = 0;
+   char ca_title [32] = {0};
+
+   printf ("Coherence:\n"
+      "\t protocol                  : %s\n"
+      "\t ui_cores                  : %u\n"
+      "\t ull_bus_reads             : %" PRIu64 "\n"
+      "\t ull_bus_read_exclusives   : %" PRIu64 "\n"
+      "\t ull_bus_upgrades          : %" PRIu64 "\n\n",
+      cachesim_coherence_protocol_name (px_multicore->e_protocol),
+      px_multicore->ui_no_of_cores, px_multicore->ull_bus_reads,
+      px_multicore->ull_bus_read_exclusives, px_multicore->ull_bus_upgrades);
+   cachesim_multicore_log_false_sharing (px_multicore);
+   for (ui_core = 0; ui_core < px_multicore->ui_no_of_cores; ui_core++)
+   {
+      px_core = &(px_multicore->px_cores [ui_core]);
+      (void) snprintf (ca_title, sizeof(ca_title), "Core %u", ui_core);
+      cachesim_multicore_log_core (ca_title, px_core);
+      x_all.ull_coherence_misses += px_core->ull_coherence_misses;
+      x_all.ull_true_sharing_misses += px_core->ull_true_sharing_misses;
+      x_all.ull_false_sharing_misses += px_core->ull_false_sharing_misses;
+      x_all.ull_upgrades += px_core->ull_upgrades;
+      x_all.ull_invalidations_sent += px_core->ull_invalidations_sent;
+      x_all.ull_invalidations_received += px_core->ull_invalidations_received;
+      x_all.ull_cache_to_cache += px_core->ull_cache_to_cache;
+      x_all.x_stats.ull_total_accesses += px_core->x_stats.ull_total_accesses;
+      x_all.x_stats.ull_hit_count += px_core->x_stats.ull_hit_count;
+      x_all.x_stats.ull_miss_count += px_core->x_stats.ull_miss_count;
+      x_all.x_stats.ull_capacity_miss += px_core->x_stats.ull_capacity_miss;
+      x_all.x_stats.ull_compulsory_miss += px_core->x_stats.ull_compulsory_miss;
+      x_all.x_stats.ull_conflict_miss += px_core->x_stats.ull_conflict_miss;
+      x_all.x_stats.ull_writes += px_core->x_stats.ull_writes;
+      x_all.x_stats.ull_write_misses += px_core->x_stats.ull_write_misses;
+      x_all.x_stats.ull_dirty_evictions += px_core->x_stats.ull_dirty_evictions;
+      x_all.x_stats.ull_bytes_from_memory += px_core->x_stats.ull_bytes_from_memory;
+      x_all.x_stats.ull_bytes_to_memory += px_core->x_stats.ull_bytes_to_memory;
+      x_all.x_stats.ull_cycles += px_core->x_stats.ull_cycles;
+      x_all.x_stats.ull_stall_cycles += px_core->x_stats.ull_stall_cycles;
+      for (ui_bucket = 0; ui_bucket < CACHESIM_LATENCY_HISTOGRAM_BUCKETS; ui_bucket++)
+      {
+         x_all.x_stats.ulla_latency_histogram [ui_bucket] +=
+            px_core->x_stats.ulla_latency_histogram [ui_bucket];
+      }
+   }
+   cachesim_multicore_log_core ("All cores", &x_all);
+}
+
+/*
+ * Replays the trace on --cores private caches of the -c/-a/-b geometry,
+ * each record on the cache of its core.
+ */
+CACHESIM_RET_E cachesim_simulate_multicore (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_MULTICORE_X x_multicore = {0};
+   CACHESIM_TRACE_READER_X x_reader = {0};
+   CACHESIM_TRACE_RECORD_X x_record = {0};
+   CACHESIM_TRACE_STATS_X x_trace_stats = {0};
+   uint64_t ull_records_read = 0;
+   bool b_end_of_trace = false;
+
+   if (NULL == px_cache_args->pc_trace_file)
+   {
+      fprintf (stderr, "--cores needs a trace to replay (--trace)\n");
+      goto CLEAN_RETURN;
+   }
+   if (px_cache_args->ui_cores > CACHESIM_MAX_CORES)
+   {
+      fprintf (stderr, "--cores is limited to %d\n", CACHESIM_MAX_CORES);
+      goto CLEAN_RETURN;
+   }
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   if ((eCACHESIM_WRITE_POLICY_WRITE_BACK != x_cache_param.e_write_policy)
+      || (false == x_cache_param.b_write_allocate))
+   {
+      fprintf (stderr, "--cores models write-back, write-allocate caches "
+         "only\n");
+      goto CLEAN_RETURN;
+   }
+   if (x_cache_param.ui_sample_sets > 1)
+   {
+      fprintf (stderr, "--sample-sets is not supported with --cores\n");
+      goto CLEAN_RETURN;
+   }
+   if (eCACHESIM_PREFETCHER_NONE != x_cache_param.e_prefetcher)
+   {
+      fprintf (stderr, "--prefetcher is not supported with --cores\n");
+      goto CLEAN_RETURN;
+   }
+   if ((NULL != x_cache_param.pc_heatmap_file)
+      || (NULL != x_cache_param.pc_heatmap_blocks_file))
+   {
+      fprintf (stderr, "--heatmap is not supported with --cores\n");
+      goto CLEAN_RETURN;
+   }
+   if (0 != x_cache_param.ui_mshrs)
+   {
+      fprintf (stderr, "--mshrs is not supported with --cores\n");
+      goto CLEAN_RETURN;
+   }
+   if ((NULL != x_cache_param.pc_checkpoint_file)
+      || (NULL != x_cache_param.pc_restore_file))
+   {
+      fprintf (stderr, "--checkpoint and --restore are not supported with "
+         "--cores\n");
+      goto CLEAN_RETURN;
+   }
+   if ((0 != px_cache_args->ull_warmup) || (true == px_cache_args->b_roi_markers))
+   {
+      fprintf (stderr, "--warmup and --roi-markers are not supported with "
+         "--cores\n");
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_multicore_alloc (&x_multicore, &x_cache_param,
+      px_cache_args->ui_cores, px_cache_args->e_coherence);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_trace_open (&x_reader, px_cache_args->pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      e_ret_val = cachesim_trace_seek (&x_reader, px_cache_args->ull_fast_forward);
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("+++++++++++++++Multicore Simulator++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (x_multicore.px_cores [0].px_cache);
+   while ((0 == px_cache_args->ull_max_records)
+      || (ull_records_read < px_cache_args->ull_max_records))
+   {
+      e_ret_val = cachesim_trace_read_record (&x_reader, &x_record,
+         &b_end_of_trace);
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+      {
+         break;
+      }
+      ull_records_read++;
+      e_ret_val = cachesim_multicore_access_record (&x_multicore, &x_record,
+         &x_trace_stats);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         break;
+      }
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("Trace:\n"
+      "\t ull_records               : %" PRIu64 "\n"
+      "\t ull_reads                 : %" PRIu64 "\n"
+      "\t ull_writes                : %" PRIu64 "\n"
+      "\t ull_skipped               : %" PRIu64 "\n",
+      x_trace_stats.ull_records, x_trace_stats.ull_reads,
+      x_trace_stats.ull_writes, x_trace_stats.ull_skipped);
+   cachesim_multicore_log_summary (&x_multicore);
+CLEAN_RETURN:
+   cachesim_trace_close (&x_reader);
+   cachesim_multicore_free (&x_multicore);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Multicore simulation failed\n");
+   }
+   return e_ret_val;
+}
+
+static double cachesim_now_seconds (void)
+{
+#ifdef _WIN32
+   return (double) GetTickCount64 () / 1000.0;
+#else
+   struct timespec x_now = {0};
+
+   (void) clock_gettime (CLOCK_MONOTONIC, &x_now);
+   return (double) x_now.tv_sec + ((double) x_now.tv_nsec / 1e9);
+#endif
+}
+
+static uint32_t cachesim_online_cpus (void)
+{
+#ifdef _WIN32
+   SYSTEM_INFO x_info;
+
+   GetSystemInfo (&x_info);
+   return (uint32_t) x_info.dwNumberOfProcessors;
+#else
+   long l_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+   return (l_cpus > 0) ? (uint32_t) l_cpus : 1;
+#endif
+}
+
+static void cachesim_mutex_init (CACHESIM_MUTEX_T *px_mutex)
+{
+#ifdef _WIN32
+   InitializeCriticalSection (px_mutex);
+#else
+   (void) pthread_mutex_init (px_mutex, NULL);
+#endif
+}
+
+static void cachesim_mutex_deinit (CACHESIM_MUTEX_T *px_mutex)
+{
+#ifdef _WIN32
+   DeleteCriticalSection (px_mutex);
+#else
+   (void) pthread_mutex_destroy (px_mutex);
+#endif
+}
+
+static void cachesim_mutex_lock (CACHESIM_MUTEX_T *px_mutex)
+{
+#ifdef _WIN32
+   EnterCriticalSection (px_mutex);
+#else
+   (void) pthread_mutex_lock (px_mutex);
+#endif
+}
+
+static void cachesim_mutex_unlock (CACHESIM_MUTEX_T *px_mutex)
+{
+#ifdef _WIN32
+   LeaveCriticalSection (px_mutex);
+#else
+   (void) pthread_mutex_unlock (px_mutex);
+#endif
+}
+
+static CACHESIM_RET_E cachesim_thread_create (
+   CACHESIM_THREAD_T *px_thread,
+   CACHESIM_THREAD_RETURN (*pfn_thread) (void *),
+   void *pv_arg)
+{
+#ifdef _WIN32
+   *px_thread = CreateThread (NULL, 0, pfn_thread, pv_arg, 0, NULL);
+   return (NULL != *px_thread) ? eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+#else
+   return (0 == pthread_create (px_thread, NULL, pfn_thread, pv_arg)) ?
+      eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+#endif
+}
+
+static void cachesim_thread_join (CACHESIM_THREAD_T x_thread)
+{
+#ifdef _WIN32
+   (void) WaitForSingleObject (x_thread, INFINITE);
+   (void) CloseHandle (x_thread);
+#else
+   (void) pthread_join (x_thread, NULL);
+#endif
+}
+
+/*
+ * Parses a sweep list: comma separated values, where "lo-hi" expands to the
+ * powers of 2 multiples of lo up to hi (e.g. "1-8" is 1,2,4,8). Without a
+ * list the single value ui_default is used.
+ */
+static CACHESIM_RET_E cachesim_sweep_parse_list (
+   const char *pc_list,
+   uint32_t ui_default,
+   uint32_t *pui_values,
+   uint32_t *pui_count)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   const char *pc_pos = pc_list;
+   char *pc_end = NULL;
+   unsigned long ul_lo = 0;
+   unsigned long ul_hi = 0;
+   unsigned long ul_value = 0;
+
+   *pui_count = 0;
+   if (NULL == pc_list)
+   {
+      pui_values [(*pui_count)++] = ui_default;
+      e_ret_val = eCACHESIM_RET_SUCCESS;
+      goto CLEAN_RETURN;
+   }
+
+   while ('\0' != *pc_pos)
+   {
+      ul_lo = strtoul (pc_pos, &pc_end, 0);
+      if ((pc_end == pc_pos) || (0 == ul_lo) || (ul_lo > UINT32_MAX))
+      {
+         goto CLEAN_RETURN;
+      }
+      ul_hi = ul_lo;
+      pc_pos = pc_end;
+      if ('-' == *pc_pos)
+      {
+         pc_pos++;
+         ul_hi = strtoul (pc_pos, &pc_end, 0);
+         if ((pc_end == pc_pos) || (ul_hi < ul_lo) || (ul_hi > UINT32_MAX))
+         {
+            goto CLEAN_RETURN;
+         }
+         pc_pos = pc_end;
+      }
+      for (ul_value = ul_lo; ul_value <= ul_hi; ul_value *= 2)
+      {
+         if (*pui_count >= CACHESIM_SWEEP_MAX_VALUES)
+         {
+            goto CLEAN_RETURN;
+         }
+         pui_values [(*pui_count)++] = (uint32_t) ul_value;
+      }
+      if (',' == *pc_pos)
+      {
+         pc_pos++;
+      }
+      else if ('\0' != *pc_pos)
+      {
+         goto CLEAN_RETURN;
+      }
+   }
+   e_ret_val = (0 != *pui_count) ? eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Simulates one configuration of the sweep against the shared trace.
+ */
+static void cachesim_sweep_run_config (
+   CACHESIM_SWEEP_X *px_sweep,
+   uint32_t ui_config_idx)
+{
+   CACHESIM_SWEEP_RESULT_X *px_result = &(px_sweep->px_results [ui_config_idx]);
+   const CACHESIM_TRACE_BUFFER_X *px_trace = px_sweep->px_trace;
+   CACHE_SET_X *px_cache = NULL;
+   double d_start = cachesim_now_seconds ();
+
+   px_result->e_ret_val = cachesim_set_alloc_cache (&px_cache,
+      &(px_result->x_cache_params));
+   if (eCACHESIM_RET_SUCCESS != px_result->e_ret_val)
+   {
+      return;
+   }
+   cachesim_set_mapped_cache_access_records (px_cache, px_trace->px_records,
+      px_trace->ull_count, &(px_result->x_stats), &(px_result->x_trace_stats),
+      NULL);
+   cachesim_set_sample_estimate (px_cache, &(px_result->x_sample));
+   cachesim_sim_stats_deinit (&(px_result->x_stats));
+   (void) cachesim_set_free_cache (px_cache);
+   px_result->d_seconds = cachesim_now_seconds () - d_start;
+}
+
+static bool cachesim_sweep_pop (
+   CACHESIM_SWEEP_DEQUE_X *px_deque,
+   uint32_t *pui_task)
+{
+   bool b_found = false;
+
+   cachesim_mutex_lock (&(px_deque->x_lock));
+   if (px_deque->ui_bottom > px_deque->ui_top)
+   {
+      *pui_task = px_deque->pui_tasks [--(px_deque->ui_bottom)];
+      b_found = true;
+   }
+   cachesim_mutex_unlock (&(px_deque->x_lock));
+   return b_found;
+}
+
+static bool cachesim_sweep_steal (
+   CACHESIM_SWEEP_DEQUE_X *px_deque,
+   uint32_t *pui_task)
+{
+   bool b_found = false;
+
+   cachesim_mutex_lock (&(px_deque->x_lock));
+   if (px_deque->ui_bottom > px_deque->ui_top)
+   {
+      *pui_task = px_deque->pui_tasks [(px_deque->ui_top)++];
+      b_found = true;
+   }
+   cachesim_mutex_unlock (&(px_deque->x_lock));
+   return b_found;
+}
+
+/*
+ * Sweep worker: drains its own deque, then steals from the others. No new
+ * work is created once the sweep starts, so a worker that finds every deque
+ * empty is done.
+ */
+static CACHESIM_THREAD_RETURN cachesim_sweep_worker (void *pv_arg)
+{
+   CACHESIM_SWEEP_WORKER_X *px_worker = (CACHESIM_SWEEP_WORKER_X *) pv_arg;
+   CACHESIM_SWEEP_X *px_sweep = px_worker->px_sweep;
+   uint32_t ui_no_of_workers = px_sweep->ui_no_of_workers;
+   uint32_t ui_task = 0;
+   uint32_t ui_i = 0;
+   bool b_found = false;
+
+   while (1)
+   {
+      b_found = cachesim_sweep_pop (
+         &(px_sweep->px_deques [px_worker->ui_worker_idx]), &ui_task);
+      for (ui_i = 1; (false == b_found) && (ui_i < ui_no_of_workers); ui_i++)
+      {
+         b_found = cachesim_sweep_steal (&(px_sweep->px_deques [
+            (px_worker->ui_worker_idx + ui_i) % ui_no_of_workers]), &ui_task);
+         px_worker->ui_steals += (true == b_found);
+      }
+      if (false == b_found)
+      {
+         break;
+      }
+      cachesim_sweep_run_config (px_sweep, ui_task);
+   }
+   return 0;
+}
+
+/*
+ * In a set sampled sweep the counts are estimates for the whole cache and
+ * ci95 is the half width of the 95% confidence interval of the hit rate.
+ */
+static void cachesim_sweep_print_results (
+   const CACHESIM_SWEEP_X *px_sweep)
+{
+   const CACHESIM_SWEEP_RESULT_X *px_result = NULL;
+   const CACHESIM_SIM_STATS_X *px_stats = NULL;
+   uint32_t ui_i = 0;
+   bool b_sampled = (0 != px_sweep->ui_no_of_results)
+      && (px_sweep->px_results [0].x_cache_params.ui_sample_sets > 1);
+   double d_scale = 1.0;
+   double d_accesses = 0.0;
+
+   printf ("%11s | %5s | %11s | %8s | %10s | %10s | %10s | %10s | %10s | %10s | %8s | %8s",
+      "cache_words", "assoc", "block_words", "sets", "accesses", "hits",
+      "misses", "compulsory", "capacity", "conflict", "hit_rate", "seconds");
+   printf ((true == b_sampled) ? " | %8s\n" : "\n", "ci95");
+   for (ui_i = 0; ui_i < px_sweep->ui_no_of_results; ui_i++)
+   {
+      px_result = &(px_sweep->px_results [ui_i]);
+      px_stats = &(px_result->x_stats);
+      printf ("%11u | %5u | %11u | %8u | ",
+         px_result->x_cache_params.ui_cache_size_words,
+         px_result->x_cache_params.ui_associativity,
+         px_result->x_cache_params.ui_block_size_words,
+         CACHESIM_NO_OF_SETS(&(px_result->x_cache_params)));
+      if (eCACHESIM_RET_SUCCESS != px_result->e_ret_val)
+      {
+         printf ("%10s\n", "failed");
+         continue;
+      }
+      if (true == b_sampled)
+      {
+         d_scale = px_result->x_sample.d_scale;
+         d_accesses = (double) (px_result->x_sample.ull_sampled_accesses
+            + px_result->x_sample.ull_skipped_accesses);
+         printf ("%10.0f | %10.0f | %10.0f | %10.0f | %10.0f | %10.0f | %8f | %8.3f | %8f\n",
+            d_accesses, d_accesses - (d_scale * px_stats->ull_miss_count),
+            d_scale * px_stats->ull_miss_count, d_scale * px_stats->ull_compulsory_miss,
+            d_scale * px_stats->ull_capacity_miss, d_scale * px_stats->ull_conflict_miss,
+            1.0 - px_result->x_sample.d_miss_rate, px_result->d_seconds,
+            px_result->x_sample.d_miss_rate_ci95);
+         continue;
+      }
+      printf ("%10" PRIu64 " | %10" PRIu64 " | %10" PRIu64 " | %10" PRIu64
+         " | %10" PRIu64 " | %10" PRIu64 " | %8f | %8.3f\n",
+         px_stats->ull_total_accesses, px_stats->ull_hit_count,
+         px_stats->ull_miss_count, px_stats->ull_compulsory_miss,
+         px_stats->ull_capacity_miss, px_stats->ull_conflict_miss,
+         (0 == px_stats->ull_total_accesses) ? 0.0 :
+            (double) px_stats->ull_hit_count
+            / (double) px_stats->ull_total_accesses,
+         px_result->d_seconds);
+   }
+   printf ("\n");
+}
+
+/*
+ * Design space sweep: decodes the trace once and simulates every valid
+ * combination of the -a, -b and -c lists against it on a work stealing pool.
+ */
+CACHESIM_RET_E cachesim_simulate_sweep (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_TRACE_BUFFER_X x_trace = {0};
+   CACHESIM_SWEEP_X x_sweep = {0};
+   CACHESIM_SWEEP_WORKER_X *px_workers = NULL;
+   CACHESIM_SWEEP_DEQUE_X *px_deque = NULL;
+   uint32_t *pui_tasks = NULL;
+   uint32_t ua_assoc [CACHESIM_SWEEP_MAX_VALUES] = {0};
+   uint32_t ua_block [CACHESIM_SWEEP_MAX_VALUES] = {0};
+   uint32_t ua_cache [CACHESIM_SWEEP_MAX_VALUES] = {0};
+   uint32_t ui_no_of_assoc = 0;
+   uint32_t ui_no_of_block = 0;
+   uint32_t ui_no_of_cache = 0;
+   uint32_t ui_a = 0;
+   uint32_t ui_b = 0;
+   uint32_t ui_c = 0;
+   uint32_t ui_i = 0;
+   uint32_t ui_skipped = 0;
+   uint32_t ui_started = 0;
+   uint32_t ui_steals = 0;
+   double d_start = 0.0;
+   double d_decode_seconds = 0.0;
+   double d_sweep_seconds = 0.0;
+
+   if (NULL == px_cache_args->pc_trace_file)
+   {
+      fprintf (stderr, "--sweep needs a trace to replay (--trace)\n");
+      goto CLEAN_RETURN;
+   }
+   if ((NULL != px_cache_args->pc_heatmap_file)
+      || (NULL != px_cache_args->pc_heatmap_blocks_file))
+   {
+      fprintf (stderr, "--heatmap is not supported with --sweep\n");
+      goto CLEAN_RETURN;
+   }
+   if (0 != px_cache_args->ui_mshrs)
+   {
+      fprintf (stderr, "--mshrs is not supported with --sweep\n");
+      goto CLEAN_RETURN;
+   }
+   if ((NULL != px_cache_args->pc_checkpoint_file)
+      || (NULL != px_cache_args->pc_restore_file))
+   {
+      fprintf (stderr, "--checkpoint and --restore are not supported with "
+         "--sweep\n");
+      goto CLEAN_RETURN;
+   }
+   if ((0 != px_cache_args->ull_warmup) || (true == px_cache_args->b_roi_markers))
+   {
+      fprintf (stderr, "--warmup and --roi-markers are not supported with "
+         "--sweep\n");
+      goto CLEAN_RETURN;
+   }
+   if ((eCACHESIM_RET_SUCCESS != cachesim_sweep_parse_list (
+         px_cache_args->pc_associativity_list, px_cache_args->ui_associativity,
+         ua_assoc, &ui_no_of_assoc))
+      || (eCACHESIM_RET_SUCCESS != cachesim_sweep_parse_list (
+         px_cache_args->pc_block_size_list, px_cache_args->ui_block_size_words,
+         ua_block, &ui_no_of_block))
+      || (eCACHESIM_RET_SUCCESS != cachesim_sweep_parse_list (
+         px_cache_args->pc_cache_size_list, px_cache_args->ui_cache_size_words,
+         ua_cache, &ui_no_of_cache)))
+   {
+      fprintf (stderr, "Invalid sweep list, expected values like \"2,4\" or "
+         "\"1-16\" (at most %d values)\n", CACHESIM_SWEEP_MAX_VALUES);
+      goto CLEAN_RETURN;
+   }
+
+   x_sweep.px_results = calloc ((size_t) ui_no_of_assoc * ui_no_of_block
+      * ui_no_of_cache, sizeof(CACHESIM_SWEEP_RESULT_X));
+   if (NULL == x_sweep.px_results)
+   {
+      goto CLEAN_RETURN;
+   }
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   for (ui_c = 0; ui_c < ui_no_of_cache; ui_c++)
+   {
+      for (ui_a = 0; ui_a < ui_no_of_assoc; ui_a++)
+      {
+         for (ui_b = 0; ui_b < ui_no_of_block; ui_b++)
+         {
+            x_cache_param.ui_cache_size_words = ua_cache [ui_c];
+            x_cache_param.ui_associativity = ua_assoc [ui_a];
+            x_cache_param.ui_block_size_words = ua_block [ui_b];
+            if (0 == CACHESIM_NO_OF_SETS(&x_cache_param))
+            {
+               ui_skipped++;
+               continue;
+            }
+            x_sweep.px_results [x_sweep.ui_no_of_results].x_cache_params =
+               x_cache_param;
+            x_sweep.ui_no_of_results++;
+         }
+      }
+   }
+   if (0 == x_sweep.ui_no_of_results)
+   {
+      fprintf (stderr, "No valid cache geometry in the sweep\n");
+      goto CLEAN_RETURN;
+   }
+
+   d_start = cachesim_now_seconds ();
+   e_ret_val = cachesim_trace_load (&x_trace, px_cache_args->pc_trace_file,
+      px_cache_args->ull_fast_forward, px_cache_args->ull_max_records);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+   d_decode_seconds = cachesim_now_seconds () - d_start;
+   x_sweep.px_trace = &x_trace;
+
+   x_sweep.ui_no_of_workers = px_cache_args->ui_threads;
+   if (0 == x_sweep.ui_no_of_workers)
+   {
+      x_sweep.ui_no_of_workers = cachesim_online_cpus ();
+   }
+   if (x_sweep.ui_no_of_workers > x_sweep.ui_no_of_results)
+   {
+      x_sweep.ui_no_of_workers = x_sweep.ui_no_of_results;
+   }
+   px_workers = calloc (x_sweep.ui_no_of_workers, sizeof(CACHESIM_SWEEP_WORKER_X));
+   x_sweep.px_deques = calloc (x_sweep.ui_no_of_workers,
+      sizeof(CACHESIM_SWEEP_DEQUE_X));
+   pui_tasks = calloc (x_sweep.ui_no_of_results, sizeof(uint32_t));
+   if ((NULL == px_workers) || (NULL == x_sweep.px_deques) || (NULL == pui_tasks))
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+      goto CLEAN_RETURN;
+   }
+
+   /*
+    * Deal the configurations round robin so that every worker starts with a
+    * mix of small and large caches; stealing evens out the rest. Deque N
+    * gets every ui_no_of_workers-th configuration starting at N.
+    */
+   ui_a = 0;
+   for (ui_i = 0; ui_i < x_sweep.ui_no_of_workers; ui_i++)
+   {
+      px_deque = &(x_sweep.px_deques [ui_i]);
+      cachesim_mutex_init (&(px_deque->x_lock));
+      px_deque->pui_tasks = pui_tasks + ui_a;
+      ui_a += (x_sweep.ui_no_of_results - ui_i + x_sweep.ui_no_of_workers - 1)
+         / x_sweep.ui_no_of_workers;
+   }
+   for (ui_i = 0; ui_i < x_sweep.ui_no_of_results; ui_i++)
+   {
+      px_deque = &(x_sweep.px_deques [ui_i % x_sweep.ui_no_of_workers]);
+      px_deque->pui_tasks [px_deque->ui_bottom++] = ui_i;
+   }
+
+   d_start = cachesim_now_seconds ();
+   for (ui_started = 0; ui_started < x_sweep.ui_no_of_workers; ui_started++)
+   {
+      px_workers [ui_started].px_sweep = &x_sweep;
+      px_workers [ui_started].ui_worker_idx = ui_started;
+      e_ret_val = cachesim_thread_create (&(px_workers [ui_started].x_thread),
+         cachesim_sweep_worker, &(px_workers [ui_started]));
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         /*
+          * The workers already running steal the configurations of the ones
+          * that could not be started.
+          */
+         fprintf (stderr, "Unable to start sweep worker %u\n", ui_started);
+         break;
+      }
+   }
+   if (0 == ui_started)
+   {
+      goto CLEAN_RETURN;
+   }
+   for (ui_i = 0; ui_i < ui_started; ui_i++)
+   {
+      cachesim_thread_join (px_workers [ui_i].x_thread);
+      ui_steals += px_workers [ui_i].ui_steals;
+   }
+   d_sweep_seconds = cachesim_now_seconds () - d_start;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("++++++++++++++++Sweep Simulator+++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("Sweep:\n"
+      "\t ull_trace_records         : %" PRIu64 "\n"
+      "\t ui_configurations         : %u\n"
+      "\t ui_skipped_configurations : %u\n"
+      "\t ui_workers                : %u\n"
+      "\t ui_steals                 : %u\n"
+      "\t\t d_decode_seconds         : %f\n"
+      "\t\t d_sweep_seconds          : %f\n\n",
+      x_trace.ull_count, x_sweep.ui_no_of_results, ui_skipped, ui_started,
+      ui_steals, d_decode_seconds, d_sweep_seconds);
+   cachesim_sweep_print_results (&x_sweep);
+CLEAN_RETURN:
+   if (NULL != x_sweep.px_deques)
+   {
+      for (ui_i = 0; ui_i < x_sweep.ui_no_of_workers; ui_i++)
+      {
+         if (NULL != x_sweep.px_deques [ui_i].pui_tasks)
+         {
+            cachesim_mutex_deinit (&(x_sweep.px_deques [ui_i].x_lock));
+         }
+      }
+      free (x_sweep.px_deques);
+   }
+   free (pui_tasks);
+   free (px_workers);
+   free (x_sweep.px_results);
+   cachesim_trace_buffer_free (&x_trace);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Sweep failed\n");
+   }
+   return e_ret_val;
+}
+
+static const uint32_t gua_bench_sets [] =
+{
+   64, 256, 1024, 4096, 16384, 32768
+};
+
+static const uint32_t gua_bench_assoc [] =
+{
+   1, 2, 4, 8, 16, 32
+};
+
+static const char *cachesim_workload_name (
+   CACHESIM_WORKLOAD_E e_workload)
+{
+   switch (e_workload)
+   {
+   case eCACHESIM_WORKLOAD_SEQUENTIAL:
+      return "sequential";
+   case eCACHESIM_WORKLOAD_STRIDED:
+      return "strided";
+   case eCACHESIM_WORKLOAD_UNIFORM:
+      return "uniform";
+   case eCACHESIM_WORKLOAD_ZIPFIAN:
+      return "zipfian";
+   case eCACHESIM_WORKLOAD_POINTER_CHASE:
+      return "pointer-chase";
+   default:
+      return "invalid";
+   }
+}
+
+static CACHESIM_RET_E cachesim_workload_from_name (
+   const char *pc_name,
+   CACHESIM_WORKLOAD_E *pe_workload)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint32_t ui_i = 0;
+
+   for (ui_i = 0; ui_i < eCACHESIM_WORKLOAD_MAX; ui_i++)
+   {
+      if (0 == strcmp (pc_name, cachesim_workload_name ((CACHESIM_WORKLOAD_E) ui_i)))
+      {
+         *pe_workload = (CACHESIM_WORKLOAD_E) ui_i;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+         break;
+      }
+   }
+   return e_ret_val;
+}
+
+static inline uint64_t cachesim_workload_next_random (
+   uint64_t *pull_state)
+{
+   *pull_state ^= *pull_state >> 12;
+   *pull_state ^= *pull_state << 25;
+   *pull_state ^= *pull_state >> 27;
+   return *pull_state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * A stream with the settings of the benchmark streams.
+ */
+static void cachesim_workload_defaults (
+   CACHESIM_WORKLOAD_X *px_workload,
+   CACHESIM_WORKLOAD_E e_workload)
+{
+   memset (px_workload, 0x00, sizeof(*px_workload));
+   px_workload->e_workload = e_workload;
+   px_workload->ull_footprint_bytes = CACHESIM_BENCH_FOOTPRINT_BYTES;
+   px_workload->ull_stride_blocks = CACHESIM_BENCH_STRIDE_BLOCKS;
+   px_workload->d_zipf_theta = CACHESIM_BENCH_ZIPF_THETA;
+   px_workload->ui_write_percent = CACHESIM_WORKLOAD_DEFAULT_WRITE_PERCENT;
+   px_workload->ui_weight = 1;
+   px_workload->ull_seed = CACHESIM_BENCH_SEED;
+}
+
+/*
+ * zeta(n, theta), the sum of 1 / i^theta for i from 1 to n. The terms past
+ * CACHESIM_WORKLOAD_ZETA_EXACT_TERMS are summed with the Euler-Maclaurin
+ * formula, which is exact to well within a double for terms that small.
+ */
+static double cachesim_workload_zeta (
+   uint64_t ull_n,
+   double d_theta)
+{
+   uint64_t ull_exact = (ull_n < CACHESIM_WORKLOAD_ZETA_EXACT_TERMS) ?
+      ull_n : CACHESIM_WORKLOAD_ZETA_EXACT_TERMS;
+   uint64_t ull_i = 0;
+   double d_n = (double) ull_n;
+   double d_m = (double) ull_exact;
+   double d_zeta = 0.0;
+
+   for (ull_i = 1; ull_i <= ull_exact; ull_i++)
+   {
+      d_zeta += 1.0 / pow ((double) ull_i, d_theta);
+   }
+   if (ull_n > ull_exact)
+   {
+      d_zeta += ((pow (d_n, 1.0 - d_theta) - pow (d_m, 1.0 - d_theta))
+            / (1.0 - d_theta))
+         + ((pow (d_n, -d_theta) - pow (d_m, -d_theta)) / 2.0)
+         - ((d_theta * (pow (d_n, -d_theta - 1.0) - pow (d_m, -d_theta - 1.0)))
+            / 12.0);
+   }
+   return d_zeta;
+}
+
+/*
+ * Readies a stream to generate from its settings: it runs over the largest
+ * power of 2 number of blocks that fits in ull_footprint_bytes and starts
+ * from its seed, so that runs are reproducible.
+ */
+static void cachesim_workload_start (
+   CACHESIM_WORKLOAD_X *px_workload,
+   uint32_t ui_word_size_bytes,
+   uint32_t ui_block_size_bytes)
+{
+   double d_theta = px_workload->d_zipf_theta;
+
+   px_workload->ui_word_size_bytes = ui_word_size_bytes;
+   px_workload->ui_block_size_bytes = ui_block_size_bytes;
+   px_workload->ull_random_state = (0 != px_workload->ull_seed) ?
+      px_workload->ull_seed : CACHESIM_BENCH_SEED;
+   px_workload->ui_write_credit = 0;
+   px_workload->ull_footprint_blocks = 1;
+   px_workload->ui_footprint_bits = 0;
+   while ((px_workload->ull_footprint_blocks * 2 * ui_block_size_bytes)
+      <= px_workload->ull_footprint_bytes)
+   {
+      px_workload->ull_footprint_blocks *= 2;
+      px_workload->ui_footprint_bits++;
+   }
+   px_workload->ull_position = (eCACHESIM_WORKLOAD_POINTER_CHASE == px_workload->e_workload) ?
+      (px_workload->ull_random_state & (px_workload->ull_footprint_blocks - 1)) : 0;
+
+   if (eCACHESIM_WORKLOAD_ZIPFIAN == px_workload->e_workload)
+   {
+      px_workload->d_zipf_zetan = cachesim_workload_zeta (
+         px_workload->ull_footprint_blocks, d_theta);
+      px_workload->d_zipf_zeta2 = 1.0 + pow (0.5, d_theta);
+      px_workload->d_zipf_alpha = 1.0 / (1.0 - d_theta);
+      px_workload->d_zipf_eta = (1.0 - pow (2.0
+         / (double) px_workload->ull_footprint_blocks, 1.0 - d_theta))
+         / (1.0 - (px_workload->d_zipf_zeta2 / px_workload->d_zipf_zetan));
+   }
+}
+
+/*
+ * A benchmark stream over ull_footprint_bytes.
+ */
+static void cachesim_workload_init (
+   CACHESIM_WORKLOAD_X *px_workload,
+   CACHESIM_WORKLOAD_E e_workload,
+   uint32_t ui_word_size_bytes,
+   uint32_t ui_block_size_bytes,
+   uint64_t ull_footprint_bytes)
+{
+   cachesim_workload_defaults (px_workload, e_workload);
+   px_workload->ull_footprint_bytes = ull_footprint_bytes;
+   cachesim_workload_start (px_workload, ui_word_size_bytes, ui_block_size_bytes);
+}
+
+/*
+ * Block of the node ull_node of a pointer chase. The chain of nodes is a
+ * full period LCG modulo the number of blocks, and the blocks are the nodes
+ * through a bijective mix, so that consecutive nodes land in unrelated sets.
+ */
+static inline uint64_t cachesim_workload_chase_block (
+   const CACHESIM_WORKLOAD_X *px_workload,
+   uint64_t ull_node)
+{
+   uint64_t ull_mask = px_workload->ull_footprint_blocks - 1;
+   uint32_t ui_shift = (px_workload->ui_footprint_bits + 1) / 2;
+
+   ull_node ^= ull_node >> ui_shift;
+   ull_node = (ull_node * 0x9E3779B97F4A7C15ULL) & ull_mask;
+   ull_node ^= ull_node >> ui_shift;
+   return ull_node;
+}
+
+static uint64_t cachesim_workload_next_address (
+   CACHESIM_WORKLOAD_X *px_workload)
+{
+   uint64_t ull_mask = px_workload->ull_footprint_blocks - 1;
+   uint64_t ull_words = px_workload->ull_footprint_blocks
+      * (px_workload->ui_block_size_bytes / px_workload->ui_word_size_bytes);
+   uint64_t ull_block = 0;
+   double d_u = 0.0;
+   double d_uz = 0.0;
+
+   switch (px_workload->e_workload)
+   {
+   case eCACHESIM_WORKLOAD_SEQUENTIAL:
+      return px_workload->ull_base + ((px_workload->ull_position++ % ull_words)
+         * px_workload->ui_word_size_bytes);
+   case eCACHESIM_WORKLOAD_STRIDED:
+      ull_block = (px_workload->ull_position++ * px_workload->ull_stride_blocks)
+         & ull_mask;
+      break;
+   case eCACHESIM_WORKLOAD_UNIFORM:
+      return px_workload->ull_base
+         + ((cachesim_workload_next_random (&(px_workload->ull_random_state))
+            % ull_words) * px_workload->ui_word_size_bytes);
+   case eCACHESIM_WORKLOAD_ZIPFIAN:
+      d_u = (double) (cachesim_workload_next_random (
+            &(px_workload->ull_random_state)) >> 11)
+         / 9007199254740992.0;
+      d_uz = d_u * px_workload->d_zipf_zetan;
+      if (d_uz < 1.0)
+      {
+         ull_block = 0;
+      }
+      else if (d_uz < px_workload->d_zipf_zeta2)
+      {
+         ull_block = 1;
+      }
+      else
+      {
+         ull_block = (uint64_t) ((double) px_workload->ull_footprint_blocks
+            * pow ((px_workload->d_zipf_eta * d_u) - px_workload->d_zipf_eta
+               + 1.0, px_workload->d_zipf_alpha));
+      }
+      /*
+       * ull_block is the popularity rank. Multiplying by an odd constant
+       * permutes the footprint, which scatters the popular blocks over the
+       * sets.
+       */
+      ull_block = (ull_block * 0x9E3779B97F4A7C15ULL) & ull_mask;
+      break;
+   case eCACHESIM_WORKLOAD_POINTER_CHASE:
+      ull_block = cachesim_workload_chase_block (px_workload,
+         px_workload->ull_position);
+      px_workload->ull_position = ((px_workload->ull_position
+            * 6364136223846793005ULL) + 1442695040888963407ULL) & ull_mask;
+      break;
+   default:
+      break;
+   }
+   return px_workload->ull_base + (ull_block * px_workload->ui_block_size_bytes);
+}
+
+static inline CACHESIM_ACCESS_TYPE_E cachesim_workload_next_type (
+   CACHESIM_WORKLOAD_X *px_workload)
+{
+   px_workload->ui_write_credit += px_workload->ui_write_percent;
+   if (px_workload->ui_write_credit >= 100)
+   {
+      px_workload->ui_write_credit -= 100;
+      return eCACHESIM_ACCESS_TYPE_WRITE;
+   }
+   return eCACHESIM_ACCESS_TYPE_READ;
+}
+
+/*
+ * Fills px_records with the next ull_count accesses of the stream, one word
+ * each.
+ */
+static void cachesim_workload_generate (
+   CACHESIM_WORKLOAD_X *px_workload,
+   CACHESIM_TRACE_RECORD_X *px_records,
+   uint64_t ull_count)
+{
+   uint64_t ull_i = 0;
+
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      px_records [ull_i].ull_address = cachesim_workload_next_address (px_workload);
+      px_records [ull_i].ui_size_bytes = px_workload->ui_word_size_bytes;
+      px_records [ull_i].e_type = cachesim_workload_next_type (px_workload);
+      px_records [ull_i].ui_core = 0;
+   }
+}
+
+/*
+ * Lays the streams of a mix out one after the other and readies them. Each
+ * stream draws from its own seed, derived from that of the mix.
+ */
+static void cachesim_workload_mix_start (
+   CACHESIM_WORKLOAD_MIX_X *px_mix,
+   uint32_t ui_word_size_bytes,
+   uint32_t ui_block_size_bytes)
+{
+   CACHESIM_WORKLOAD_X *px_workload = NULL;
+   uint64_t ull_base = 0;
+   uint64_t ull_bytes = 0;
+   uint32_t ui_i = 0;
+
+   px_mix->ui_total_weight = 0;
+   for (ui_i = 0; ui_i < px_mix->ui_no_of_streams; ui_i++)
+   {
+      px_workload = &(px_mix->xa_streams [ui_i]);
+      px_workload->ull_seed = px_mix->ull_seed + (ui_i * 0x9E3779B97F4A7C15ULL);
+      cachesim_workload_start (px_workload, ui_word_size_bytes,
+         ui_block_size_bytes);
+      ull_bytes = px_workload->ull_footprint_blocks * ui_block_size_bytes;
+      ull_base = ((ull_base + ull_bytes - 1) / ull_bytes) * ull_bytes;
+      px_workload->ull_base = ull_base;
+      ull_base += ull_bytes;
+      px_mix->ui_total_weight += px_workload->ui_weight;
+   }
+   px_mix->ull_random_state = px_mix->ull_seed ^ 0xD1B54A32D192ED03ULL;
+   if (0 == px_mix->ull_random_state)
+   {
+      px_mix->ull_random_state = CACHESIM_BENCH_SEED;
+   }
+}
+
+static void cachesim_workload_mix_generate (
+   CACHESIM_WORKLOAD_MIX_X *px_mix,
+   CACHESIM_TRACE_RECORD_X *px_records,
+   uint64_t ull_count)
+{
+   CACHESIM_WORKLOAD_X *px_workload = &(px_mix->xa_streams [0]);
+   uint64_t ull_i = 0;
+   uint32_t ui_pick = 0;
+
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      if (px_mix->ui_no_of_streams > 1)
+      {
+         ui_pick = (uint32_t) (cachesim_workload_next_random (
+            &(px_mix->ull_random_state)) % px_mix->ui_total_weight);
+         px_workload = &(px_mix->xa_streams [0]);
+         while (ui_pick >= px_workload->ui_weight)
+         {
+            ui_pick -= px_workload->ui_weight;
+            px_workload++;
+         }
+      }
+      px_records [ull_i].ull_address = cachesim_workload_next_address (px_workload);
+      px_records [ull_i].ui_size_bytes = px_workload->ui_word_size_bytes;
+      px_records [ull_i].e_type = cachesim_workload_next_type (px_workload);
+      px_records [ull_i].ui_core = 0;
+   }
+}
+
+/*
+ * A count, or a size in bytes, with an optional K, M, G or T suffix for
+ * 2^10, 2^20, 2^30 or 2^40.
+ */
+static CACHESIM_RET_E cachesim_workload_parse_count (
+   const char *pc_value,
+   uint64_t *pull_value)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   char *pc_end = NULL;
+   uint64_t ull_value = 0;
+   uint32_t ui_shift = 0;
+
+   if (('\0' == *pc_value) || ('-' == *pc_value))
+   {
+      goto CLEAN_RETURN;
+   }
+   errno = 0;
+   ull_value = strtoull (pc_value, &pc_end, 0);
+   if ((pc_end == pc_value) || (0 != errno))
+   {
+      goto CLEAN_RETURN;
+   }
+   switch (*pc_end)
+   {
+   case 'K': case 'k':
+      ui_shift = 10;
+      break;
+   case 'M': case 'm':
+      ui_shift = 20;
+      break;
+   case 'G': case 'g':
+      ui_shift = 30;
+      break;
+   case 'T': case 't':
+      ui_shift = 40;
+      break;
+   default:
+      break;
+   }
+   pc_end += (0 != ui_shift);
+   if (('\0' != *pc_end) || (ull_value > (UINT64_MAX >> ui_shift)))
+   {
+      goto CLEAN_RETURN;
+   }
+   *pull_value = ull_value << ui_shift;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static char *cachesim_workload_trim (
+   char *pc_text)
+{
+   char *pc_end = NULL;
+
+   while ((' ' == *pc_text) || ('\t' == *pc_text) || ('\r' == *pc_text))
+   {
+      pc_text++;
+   }
+   pc_end = pc_text + strlen (pc_text);
+   while ((pc_end > pc_text) && ((' ' == pc_end [-1]) || ('\t' == pc_end [-1])
+      || ('\r' == pc_end [-1])))
+   {
+      *--pc_end = '\0';
+   }
+   return pc_text;
+}
+
+/*
+ * One <key>=<value> of a stream (px_workload) or of the whole mix
+ * (px_workload NULL).
+ */
+static CACHESIM_RET_E cachesim_workload_parse_setting (
+   CACHESIM_WORKLOAD_MIX_X *px_mix,
+   CACHESIM_WORKLOAD_X *px_workload,
+   const char *pc_key,
+   const char *pc_value)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   uint64_t ull_value = 0;
+   char *pc_end = NULL;
+   double d_value = 0.0;
+
+   if (0 == strcmp (pc_key, "theta"))
+   {
+      d_value = strtod (pc_value, &pc_end);
+      if ((NULL != px_workload) && (pc_end != pc_value) && ('\0' == *pc_end)
+         && (d_value > 0.0) && (d_value < 1.0))
+      {
+         px_workload->d_zipf_theta = d_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+      goto CLEAN_RETURN;
+   }
+   if (eCACHESIM_RET_SUCCESS != cachesim_workload_parse_count (pc_value,
+      &ull_value))
+   {
+      goto CLEAN_RETURN;
+   }
+   if (NULL == px_workload)
+   {
+      if ((0 == strcmp (pc_key, "accesses")) && (0 != ull_value))
+      {
+         px_mix->ull_accesses = ull_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+      else if (0 == strcmp (pc_key, "seed"))
+      {
+         px_mix->ull_seed = ull_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+   }
+   else if (0 == strcmp (pc_key, "footprint"))
+   {
+      if ((0 != ull_value) && (ull_value <= CACHESIM_WORKLOAD_MAX_FOOTPRINT_BYTES))
+      {
+         px_workload->ull_footprint_bytes = ull_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+   }
+   else if (0 == strcmp (pc_key, "stride"))
+   {
+      if (0 != ull_value)
+      {
+         px_workload->ull_stride_blocks = ull_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+   }
+   else if (0 == strcmp (pc_key, "writes"))
+   {
+      if (ull_value <= 100)
+      {
+         px_workload->ui_write_percent = (uint32_t) ull_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+   }
+   else if (0 == strcmp (pc_key, "weight"))
+   {
+      if ((0 != ull_value) && (ull_value <= CACHESIM_WORKLOAD_MAX_WEIGHT))
+      {
+         px_workload->ui_weight = (uint32_t) ull_value;
+         e_ret_val = eCACHESIM_RET_SUCCESS;
+      }
+   }
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/*
+ * Parses a workload spec into px_mix. Items are separated by ';' or new
+ * lines, and '#' starts a comment that runs to the end of the item. An item
+ * is a stream, <pattern>[:<key>=<value>,...], or settings of the whole mix,
+ * <key>=<value>,... The spec is cut up in place.
+ */
+static CACHESIM_RET_E cachesim_workload_mix_parse (
+   char *pc_spec,
+   CACHESIM_WORKLOAD_MIX_X *px_mix)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_WORKLOAD_X *px_workload = NULL;
+   CACHESIM_WORKLOAD_E e_workload = eCACHESIM_WORKLOAD_MAX;
+   char *pc_item = pc_spec;
+   char *pc_next_item = NULL;
+   char *pc_settings = NULL;
+   char *pc_next = NULL;
+   char *pc_colon = NULL;
+   char *pc_value = NULL;
+   char *pc_key = NULL;
+
+   memset (px_mix, 0x00, sizeof(*px_mix));
+   px_mix->ull_accesses = CACHESIM_BENCH_ACCESSES;
+   px_mix->ull_seed = CACHESIM_BENCH_SEED;
+   for (; NULL != pc_item; pc_item = pc_next_item)
+   {
+      pc_next_item = strpbrk (pc_item, ";\n");
+      if (NULL != pc_next_item)
+      {
+         *pc_next_item++ = '\0';
+      }
+      if (NULL != (pc_next = strchr (pc_item, '#')))
+      {
+         *pc_next = '\0';
+      }
+      pc_item = cachesim_workload_trim (pc_item);
+      if ('\0' == *pc_item)
+      {
+         continue;
+      }
+
+      pc_colon = strchr (pc_item, ':');
+      pc_value = strchr (pc_item, '=');
+      px_workload = NULL;
+      pc_settings = pc_item;
+      if ((NULL == pc_value) || ((NULL != pc_colon) && (pc_colon < pc_value)))
+      {
+         pc_settings = NULL;
+         if (NULL != pc_colon)
          {
-            free (px_data->pui_data_ptr);
-            px_data->pui_data_ptr = NULL;
+            *pc_colon = '\0';
+            pc_settings = pc_colon + 1;
+         }
+         pc_item = cachesim_workload_trim (pc_item);
+         if (eCACHESIM_RET_SUCCESS != cachesim_workload_from_name (pc_item,
+            &e_workload))
+         {
+            fprintf (stderr, "Unknown workload pattern \"%s\"\n", pc_item);
+            goto CLEAN_RETURN;
+         }
+         if (px_mix->ui_no_of_streams >= CACHESIM_WORKLOAD_MAX_STREAMS)
+         {
+            fprintf (stderr, "A workload has at most %d streams\n",
+               CACHESIM_WORKLOAD_MAX_STREAMS);
+            goto CLEAN_RETURN;
+         }
+         px_workload = &(px_mix->xa_streams [px_mix->ui_no_of_streams++]);
+         cachesim_workload_defaults (px_workload, e_workload);
+      }
+
+      for (; NULL != pc_settings; pc_settings = pc_next)
+      {
+         pc_next = strchr (pc_settings, ',');
+         if (NULL != pc_next)
+         {
+            *pc_next++ = '\0';
+         }
+         pc_key = cachesim_workload_trim (pc_settings);
+         if ('\0' == *pc_key)
+         {
+            continue;
+         }
+         pc_value = strchr (pc_key, '=');
+         if (NULL == pc_value)
+         {
+            fprintf (stderr, "Invalid workload setting \"%s\"\n", pc_key);
+            goto CLEAN_RETURN;
+         }
+         *pc_value++ = '\0';
+         pc_key = cachesim_workload_trim (pc_key);
+         pc_value = cachesim_workload_trim (pc_value);
+         if (eCACHESIM_RET_SUCCESS != cachesim_workload_parse_setting (px_mix,
+            px_workload, pc_key, pc_value))
+         {
+            fprintf (stderr, "Invalid workload setting \"%s=%s\"\n", pc_key,
+               pc_value);
+            goto CLEAN_RETURN;
          }
       }
    }
-   free (px_cache);
-   px_cache = NULL;
-   e_ret_val = eCACHESIM_RET_SUCCESS;
+   e_ret_val = (0 != px_mix->ui_no_of_streams) ?
+      eCACHESIM_RET_SUCCESS : eCACHESIM_RET_FAILURE;
 CLEAN_RETURN:
    return e_ret_val;
 }
 
-static CACHESIM_RET_E cachesim_set_fetch_data_to_cache(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_data_index,
-   uint32_t *pui_cache_set)
+/*
+ * A writable copy of the spec given with --workload, read from the file
+ * named after the @ if it starts with one. NULL on failure.
+ */
+static char *cachesim_workload_read_spec (
+   const char *pc_workload)
 {
-   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_ram_block = 0;
-   uint32_t ui_cache_set = 0;
-   uint32_t ui_ram_block_start_idx = 0;
-   uint32_t ui_ram_block_end_idx = 0;
-   CACHE_SET_DATA_X *px_cache_set_data = NULL;
-   CACHE_BLOCK_X *px_cache_block = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-   uint32_t ui_fetch_index = 0;
+   FILE *px_file = NULL;
+   char *pc_spec = NULL;
+   long l_size = 0;
 
-   if ((NULL == px_cache) || (NULL == pui_cache_set))
+   if ('@' != pc_workload [0])
    {
-      goto CLEAN_RETURN;
+      pc_spec = (char *) malloc (strlen (pc_workload) + 1);
+      if (NULL != pc_spec)
+      {
+         (void) strcpy (pc_spec, pc_workload);
+      }
+      return pc_spec;
+   }
+   px_file = fopen (pc_workload + 1, "rb");
+   if (NULL == px_file)
+   {
+      fprintf (stderr, "Unable to open %s: %s\n", pc_workload + 1,
+         strerror (errno));
+      return NULL;
+   }
+   if ((0 == fseek (px_file, 0, SEEK_END)) && ((l_size = ftell (px_file)) >= 0)
+      && (0 == fseek (px_file, 0, SEEK_SET)))
+   {
+      pc_spec = (char *) malloc ((size_t) l_size + 1);
    }
+   if ((NULL != pc_spec)
+      && ((size_t) l_size != fread (pc_spec, 1, (size_t) l_size, px_file)))
+   {
+      free (pc_spec);
+      pc_spec = NULL;
+   }
+   if (NULL == pc_spec)
+   {
+      fprintf (stderr, "Unable to read %s\n", pc_workload + 1);
+   }
+   else
+   {
+      pc_spec [l_size] = '\0';
+   }
+   (void) fclose (px_file);
+   return pc_spec;
+}
 
-   /*
-    * Map the memory word given the index to the block in the RAM. The RAM block
-    * for this dataset is assumed to start from 0th index.
-    */
-   ui_ram_block = CACHESIM_DIRECT_MAP_MEMORY_TO_RAM_BLOCK (ui_data_index,
-      px_cache->x_cache_params.ui_block_size_words);
+/*
+ * Linux restarts the peak resident set size of a process when "5" is written
+ * to its clear_refs. Elsewhere the peak stays that of the whole run.
+ */
+static void cachesim_bench_reset_peak_rss (void)
+{
+#ifndef _WIN32
+   FILE *px_file = fopen ("/proc/self/clear_refs", "w");
 
-   /*
-    * Map the RAM block to the corresponding cache set. This will only determine
-    * cache set in the cache. The code follows for the FIFO implementation
-    * to kick-out the first block which had come into the cache set.
-    */
-   ui_cache_set = CACHESIM_SET_MAP_RAM_BLOCK_TO_CACHE_SET(ui_ram_block,
-      px_cache->ui_configured_no_of_sets);
+   if (NULL != px_file)
+   {
+      (void) fputs ("5", px_file);
+      (void) fclose (px_file);
+   }
+#endif
+}
 
-   px_cache_set_data = &(px_cache->xa_sets[ui_cache_set]);
+static uint64_t cachesim_bench_peak_rss_kb (void)
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS x_counters = {0};
 
-   /*
-    * The last fetched block keeps track of the head of the FIFO queue. Module
-    * arithmetic is used simulate FIFO. So if its a 4-way associative then the
-    * following is the sequence of blocks in the set that will be replaced:
-    * (initial) 0 - 1 - 2 - 3 - 0 - 1 - 2 - 3 - 0 - ...
-    */
-   if (CACHESIM_MAX_INDEX_VALUE == px_cache_set_data->ui_last_fetched_block)
+   if (FALSE == GetProcessMemoryInfo (GetCurrentProcess (), &x_counters,
+      sizeof(x_counters)))
    {
-      px_cache_set_data->ui_last_fetched_block = 0;
+      return 0;
    }
-   else
+   return (uint64_t) x_counters.PeakWorkingSetSize / 1024;
+#else
+   FILE *px_file = fopen ("/proc/self/status", "r");
+   char ca_line [128];
+   uint64_t ull_peak_kb = 0;
+   struct rusage x_usage;
+
+   if (NULL != px_file)
+   {
+      while (NULL != fgets (ca_line, sizeof(ca_line), px_file))
+      {
+         if (1 == sscanf (ca_line, "VmHWM: %" SCNu64, &ull_peak_kb))
+         {
+            break;
+         }
+      }
+      (void) fclose (px_file);
+   }
+   if ((0 == ull_peak_kb) && (0 == getrusage (RUSAGE_SELF, &x_usage)))
    {
-      px_cache_set_data->ui_last_fetched_block++;
-      px_cache_set_data->ui_last_fetched_block %=
-            px_cache->ui_no_of_blocks_per_set;
+      ull_peak_kb = (uint64_t) x_usage.ru_maxrss;
    }
+   return ull_peak_kb;
+#endif
+}
 
-   /*
-    * Temp variable.
-    */
-   ui_fetch_index = px_cache_set_data->ui_last_fetched_block;
-
-   px_cache_block = &(px_cache_set_data->xa_blocks[ui_fetch_index]);
-   px_metadata = &(px_cache_block->x_metadata);
+/*
+ * Throughput benchmark of the cache engine: every synthetic workload is
+ * replayed through the batched access path of every geometry of the matrix,
+ * once to warm the cache up and once timed. The block size, word size and
+ * engine options come from the command line, so runs with different options
+ * can be compared row by row.
+ */
+CACHESIM_RET_E cachesim_simulate_bench (
+   CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_WORKLOAD_X x_workload = {0};
+   CACHESIM_TRACE_RECORD_X *px_records = NULL;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+   CACHESIM_TRACE_STATS_X x_trace_stats = {0};
+   CACHE_SET_X *px_cache = NULL;
+   FILE *px_file = NULL;
+   uint32_t ui_workload = 0;
+   uint32_t ui_s = 0;
+   uint32_t ui_a = 0;
+   uint32_t ui_block_size_bytes = 0;
+   uint64_t ull_peak_rss_kb = 0;
+   double d_start = 0.0;
+   double d_seconds = 0.0;
+
+   px_records = malloc (CACHESIM_BENCH_ACCESSES * sizeof(CACHESIM_TRACE_RECORD_X));
+   if (NULL == px_records)
+   {
+      goto CLEAN_RETURN;
+   }
+   px_file = (0 == strcmp (px_cache_args->pc_bench_file, "-")) ? stdout :
+      fopen (px_cache_args->pc_bench_file, "w");
+   if (NULL == px_file)
+   {
+      fprintf (stderr, "Unable to open %s: %s\n", px_cache_args->pc_bench_file,
+         strerror (errno));
+      goto CLEAN_RETURN;
+   }
 
-   /*
-    * Set the metadata for the current indices of the RAM words.
-    */
-   ui_ram_block_start_idx = ui_ram_block
-      * px_cache->x_cache_params.ui_block_size_words;
-   ui_ram_block_end_idx = ui_ram_block_start_idx
-      + px_cache->x_cache_params.ui_block_size_words - 1;
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   ui_block_size_bytes = x_cache_param.ui_block_size_words
+      * x_cache_param.ui_word_size_bytes;
 
-   px_metadata->ui_data_start_idx = ui_ram_block_start_idx;
-   px_metadata->ui_data_end_idx = ui_ram_block_end_idx;
-   *pui_cache_set = ui_cache_set;
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("++++++++++++++++Bench Simulator+++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("Bench:\n"
+      "\t ull_accesses_per_run      : %" PRIu64 "\n"
+      "\t ull_footprint_bytes       : %" PRIu64 "\n"
+      "\t ui_block_size_bytes       : %u\n\n",
+      (uint64_t) CACHESIM_BENCH_ACCESSES,
+      (uint64_t) CACHESIM_BENCH_FOOTPRINT_BYTES, ui_block_size_bytes);
+   fflush (stdout);
+
+   fprintf (px_file, "workload,sets,associativity,block_bytes,replacement,"
+      "prefetcher,accesses,seconds,accesses_per_sec,ns_per_access,hit_rate,"
+      "peak_rss_kb\n");
+   for (ui_workload = 0; ui_workload < eCACHESIM_WORKLOAD_MAX; ui_workload++)
+   {
+      cachesim_workload_init (&x_workload, (CACHESIM_WORKLOAD_E) ui_workload,
+         x_cache_param.ui_word_size_bytes, ui_block_size_bytes,
+         CACHESIM_BENCH_FOOTPRINT_BYTES);
+      cachesim_workload_generate (&x_workload, px_records,
+         CACHESIM_BENCH_ACCESSES);
+      for (ui_s = 0; ui_s < (sizeof(gua_bench_sets) / sizeof(gua_bench_sets [0]));
+         ui_s++)
+      {
+         for (ui_a = 0;
+            ui_a < (sizeof(gua_bench_assoc) / sizeof(gua_bench_assoc [0]));
+            ui_a++)
+         {
+            x_cache_param.ui_associativity = gua_bench_assoc [ui_a];
+            x_cache_param.ui_cache_size_words = gua_bench_sets [ui_s]
+               * gua_bench_assoc [ui_a] * x_cache_param.ui_block_size_words;
+            e_ret_val = cachesim_set_alloc_cache (&px_cache, &x_cache_param);
+            if (eCACHESIM_RET_SUCCESS != e_ret_val)
+            {
+               fprintf (stderr, "Unable to allocate a %u set %u way cache\n",
+                  gua_bench_sets [ui_s], gua_bench_assoc [ui_a]);
+               goto CLEAN_RETURN;
+            }
+
+            cachesim_set_mapped_cache_access_records (px_cache, px_records,
+               CACHESIM_BENCH_ACCESSES, &x_stats, &x_trace_stats, NULL);
+            cachesim_sim_stats_deinit (&x_stats);
+            memset (&x_stats, 0x00, sizeof(x_stats));
+
+            cachesim_bench_reset_peak_rss ();
+            d_start = cachesim_now_seconds ();
+            cachesim_set_mapped_cache_access_records (px_cache, px_records,
+               CACHESIM_BENCH_ACCESSES, &x_stats, &x_trace_stats, NULL);
+            d_seconds = cachesim_now_seconds () - d_start;
+            ull_peak_rss_kb = cachesim_bench_peak_rss_kb ();
+
+            fprintf (px_file, "%s,%u,%u,%u,%s,%s,%u,%f,%.0f,%.3f,%f,%" PRIu64 "\n",
+               cachesim_workload_name ((CACHESIM_WORKLOAD_E) ui_workload),
+               gua_bench_sets [ui_s], gua_bench_assoc [ui_a],
+               ui_block_size_bytes,
+               cachesim_replacement_policy (
+                  x_cache_param.e_replacement_policy)->pc_name,
+               cachesim_prefetcher (x_cache_param.e_prefetcher)->pc_name,
+               CACHESIM_BENCH_ACCESSES, d_seconds,
+               (d_seconds > 0.0) ? (CACHESIM_BENCH_ACCESSES / d_seconds) : 0.0,
+               (d_seconds * 1e9) / CACHESIM_BENCH_ACCESSES,
+               (0 == x_stats.ull_total_accesses) ? 0.0 :
+                  (double) x_stats.ull_hit_count
+                  / (double) x_stats.ull_total_accesses,
+               ull_peak_rss_kb);
+            fflush (px_file);
+
+            cachesim_sim_stats_deinit (&x_stats);
+            memset (&x_stats, 0x00, sizeof(x_stats));
+            (void) cachesim_set_free_cache (px_cache);
+            px_cache = NULL;
+         }
+      }
+   }
    e_ret_val = eCACHESIM_RET_SUCCESS;
 CLEAN_RETURN:
+   if (NULL != px_cache)
+   {
+      (void) cachesim_set_free_cache (px_cache);
+   }
+   if ((NULL != px_file) && (stdout != px_file))
+   {
+      (void) fclose (px_file);
+   }
+   free (px_records);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Benchmark failed\n");
+   }
    return e_ret_val;
 }
 
-static CACHESIM_RET_E cachesim_set_fetch_data_to_cache_v2(
+/*
+ * Runs the synthetic workload of px_mix through the batched access path,
+ * a batch at a time, so that the stream is never held in memory whatever its
+ * length. The first ull_warmup accesses only warm the cache up.
+ */
+static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_workload (
    CACHE_SET_X *px_cache,
-   uint32_t ui_data_index,
-   bool b_pin_block,
-   uint32_t *pui_cache_set,
-   uint32_t *pui_block_idx)
+   bool b_silent,
+   CACHESIM_WORKLOAD_MIX_X *px_mix,
+   uint64_t ull_warmup)
 {
    CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_ram_block = 0;
-   uint32_t ui_cache_set = 0;
-   uint32_t ui_ram_block_start_idx = 0;
-   uint32_t ui_ram_block_end_idx = 0;
-   CACHE_SET_DATA_X *px_cache_set_data = NULL;
-   CACHE_BLOCK_X *px_cache_block = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-   uint32_t ui_fetch_index = 0;
+   CACHESIM_SIM_STATS_X x_stats = {0};
+   CACHESIM_TRACE_STATS_X x_trace_stats = {0};
+   CACHESIM_TRACE_RECORD_X xa_records [CACHESIM_TRACE_BATCH_RECORDS];
+   const CACHESIM_WORKLOAD_X *px_workload = NULL;
+   uint64_t ull_total = 0;
+   uint64_t ull_generated = 0;
+   uint64_t ull_batch = 0;
+   uint32_t ui_i = 0;
+   char ca_label [32];
+   clock_t x_start = 0;
+   double d_elapsed = 0.0;
 
-   if ((NULL == px_cache) || (NULL == pui_cache_set))
+   if ((NULL == px_cache) || (NULL == px_mix))
    {
       goto CLEAN_RETURN;
    }
+   cachesim_workload_mix_start (px_mix, px_cache->x_cache_params.ui_word_size_bytes,
+      px_cache->x_cache_params.ui_block_size_words
+      * px_cache->x_cache_params.ui_word_size_bytes);
 
-   /*
-    * Map the memory word given the index to the block in the RAM. The RAM block
-    * for this dataset is assumed to start from 0th index.
-    */
-   ui_ram_block = CACHESIM_DIRECT_MAP_MEMORY_TO_RAM_BLOCK (ui_data_index,
-      px_cache->x_cache_params.ui_block_size_words);
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("++++++++++++++Workload Simulator++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_cache_params (px_cache);
+   printf ("Workload:\n"
+      "\t ull_accesses              : %" PRIu64 "\n"
+      "\t ull_warmup                : %" PRIu64 "\n"
+      "\t ull_seed                  : 0x%" PRIx64 "\n",
+      px_mix->ull_accesses, ull_warmup, px_mix->ull_seed);
+   for (ui_i = 0; ui_i < px_mix->ui_no_of_streams; ui_i++)
+   {
+      px_workload = &(px_mix->xa_streams [ui_i]);
+      (void) snprintf (ca_label, sizeof(ca_label), "stream %u", ui_i);
+      printf ("\t %-25s : %s, %" PRIu64 " bytes at 0x%" PRIx64 ", weight %u, "
+         "%u%% writes", ca_label, cachesim_workload_name (px_workload->e_workload),
+         px_workload->ull_footprint_blocks * px_workload->ui_block_size_bytes,
+         px_workload->ull_base, px_workload->ui_weight,
+         px_workload->ui_write_percent);
+      if (eCACHESIM_WORKLOAD_STRIDED == px_workload->e_workload)
+      {
+         printf (", stride %" PRIu64 " blocks", px_workload->ull_stride_blocks);
+      }
+      else if (eCACHESIM_WORKLOAD_ZIPFIAN == px_workload->e_workload)
+      {
+         printf (", theta %.2f", px_workload->d_zipf_theta);
+      }
+      printf ("\n");
+   }
+   printf ("\n");
+   fflush (stdout);
+
+   if ((false == b_silent)
+      && (eCACHESIM_RET_SUCCESS != cachesim_event_log_open (px_cache)))
+   {
+      goto CLEAN_RETURN;
+   }
 
    /*
-    * Map the RAM block to the corresponding cache set. This will only determine
-    * cache set in the cache. The code follows for the FIFO implementation
-    * to kick-out the first block which had come into the cache set.
+    * A batch holds warmup accesses or measured ones, never both.
     */
-   ui_cache_set = CACHESIM_SET_MAP_RAM_BLOCK_TO_CACHE_SET(ui_ram_block,
-      px_cache->ui_configured_no_of_sets);
+   ull_total = ull_warmup + px_mix->ull_accesses;
+   x_start = clock ();
+   while (ull_generated < ull_total)
+   {
+      ull_batch = ((ull_generated < ull_warmup) ? ull_warmup : ull_total)
+         - ull_generated;
+      if (ull_batch > CACHESIM_TRACE_BATCH_RECORDS)
+      {
+         ull_batch = CACHESIM_TRACE_BATCH_RECORDS;
+      }
+      cachesim_workload_mix_generate (px_mix, xa_records, ull_batch);
+      if (ull_generated < ull_warmup)
+      {
+         cachesim_set_mapped_cache_warm_records (px_cache, xa_records,
+            ull_batch, &x_stats, &x_trace_stats);
+      }
+      else
+      {
+         cachesim_set_mapped_cache_access_records (px_cache, xa_records,
+            ull_batch, &x_stats, &x_trace_stats, NULL);
+      }
+      ull_generated += ull_batch;
+   }
+   d_elapsed = (double) (clock () - x_start) / CLOCKS_PER_SEC;
+   cachesim_event_log_close (px_cache);
+
+   printf ("Trace:\n"
+      "\t ull_records               : %" PRIu64 "\n"
+      "\t ull_reads                 : %" PRIu64 "\n"
+      "\t ull_writes                : %" PRIu64 "\n"
+      "\t ull_skipped               : %" PRIu64 "\n",
+      x_trace_stats.ull_records, x_trace_stats.ull_reads,
+      x_trace_stats.ull_writes, x_trace_stats.ull_skipped);
+   if (0 != x_trace_stats.ull_warmup_records)
+   {
+      printf ("\t ull_warmup_records        : %" PRIu64 "\n",
+         x_trace_stats.ull_warmup_records);
+   }
+   if (d_elapsed > 0.0)
+   {
+      printf ("\t\t d_accesses_per_sec       : %f\n",
+         (double) (x_stats.ull_total_accesses + px_cache->ull_sample_skipped)
+            / d_elapsed);
+   }
+   cache_sim_log_summary (&x_stats);
+   cachesim_set_log_sample_summary (px_cache, &x_stats);
+   cachesim_set_log_prefetch_summary (px_cache, &x_stats);
+   cachesim_set_log_mshr_summary (px_cache, &x_stats);
+   cachesim_set_log_heatmap (px_cache);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   cachesim_sim_stats_deinit (&x_stats);
+   return e_ret_val;
+}
 
-   px_cache_set_data = &(px_cache->xa_sets[ui_cache_set]);
+CACHESIM_RET_E cachesim_simulate_workload (CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_WORKLOAD_MIX_X x_mix;
+   CACHE_SET_X *px_set_cache = NULL;
+   char *pc_spec = NULL;
 
-   /*
-    * The last fetched block keeps track of the head of the FIFO queue. Module
-    * arithmetic is used simulate FIFO. So if its a 4-way associative then the
-    * following is the sequence of blocks in the set that will be replaced:
-    * (initial) 0 - 1 - 2 - 3 - 0 - 1 - 2 - 3 - 0 - ...
-    */
-   if (CACHESIM_MAX_INDEX_VALUE == px_cache_set_data->ui_last_fetched_block)
+   if ((NULL != px_cache_args->pc_checkpoint_file)
+      || (NULL != px_cache_args->pc_restore_file))
    {
-      px_cache_set_data->ui_last_fetched_block = 0;
+      fprintf (stderr, "--checkpoint and --restore are not supported with "
+         "--workload\n");
+      goto CLEAN_RETURN;
    }
-   else
+   if ((px_cache_args->ui_sample_sets > 1) && (0 != px_cache_args->ui_mshrs))
    {
-	   uint32_t ui_try_counter = 0;
-	   bool b_cacheable_block_found = false;
-	  while (1)
-	  {
-		  px_cache_set_data->ui_last_fetched_block++;
-		  px_cache_set_data->ui_last_fetched_block %=
-				  px_cache->ui_no_of_blocks_per_set;
-		  ui_fetch_index = px_cache_set_data->ui_last_fetched_block;
-		  px_cache_block = &(px_cache_set_data->xa_blocks[ui_fetch_index]);
-		  px_metadata = &(px_cache_block->x_metadata);
-		  if (false == px_metadata->b_is_pinned)
-		  {
-			  b_cacheable_block_found = true;
-			  break;
-		  }
-		  // printf ("Skipping pinned block");
-		  ui_try_counter++;
-		  if (ui_try_counter >= px_cache->ui_no_of_blocks_per_set)
-		  {
-			  printf ("Tried all blocks in the set. Cannot be cached");
-			  b_cacheable_block_found = false;
-			  break;
-		  }
-	  }
-	  if (false == b_cacheable_block_found)
-	  {
-		  e_ret_val = eCACHESIM_RET_FAILURE;
-		  goto CLEAN_RETURN;
-	  }
-   }
-
-   /*
-    * Temp variable.
-    */
-   ui_fetch_index = px_cache_set_data->ui_last_fetched_block;
-
-   px_cache_block = &(px_cache_set_data->xa_blocks[ui_fetch_index]);
-   px_metadata = &(px_cache_block->x_metadata);
+      fprintf (stderr, "--mshrs is not supported with --sample-sets\n");
+      goto CLEAN_RETURN;
+   }
+   pc_spec = cachesim_workload_read_spec (px_cache_args->pc_workload);
+   if (NULL == pc_spec)
+   {
+      goto CLEAN_RETURN;
+   }
+   if (eCACHESIM_RET_SUCCESS != cachesim_workload_mix_parse (pc_spec, &x_mix))
+   {
+      fprintf (stderr, "Invalid --workload, expected up to %d "
+         "<pattern>[:<key>=<value>,...] streams separated by ';', with "
+         "patterns sequential|strided|uniform|zipfian|pointer-chase\n",
+         CACHESIM_WORKLOAD_MAX_STREAMS);
+      goto CLEAN_RETURN;
+   }
 
-   /*
-    * Set the metadata for the current indices of the RAM words.
-    */
-   ui_ram_block_start_idx = ui_ram_block
-      * px_cache->x_cache_params.ui_block_size_words;
-   ui_ram_block_end_idx = ui_ram_block_start_idx
-      + px_cache->x_cache_params.ui_block_size_words - 1;
+   cachesim_params_from_args (px_cache_args, &x_cache_param);
+   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Unable to allocate the cache\n");
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_set_mapped_cache_simulate_workload (px_set_cache,
+      px_cache_args->b_silent, &x_mix, px_cache_args->ull_warmup);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Workload simulation failed\n");
+   }
+   (void) cachesim_set_free_cache (px_set_cache);
+CLEAN_RETURN:
+   free (pc_spec);
+   return e_ret_val;
+}
 
-   px_metadata->ui_data_start_idx = ui_ram_block_start_idx;
-   px_metadata->ui_data_end_idx = ui_ram_block_end_idx;
-   if (px_cache->x_cache_params.ui_associativity >= 2 && 0 == ui_fetch_index && true == b_pin_block)
+/*
+ * Fenwick (binary indexed) tree over positions 1..ull_size.
+ */
+static inline void cachesim_fenwick_add (
+   uint32_t *pui_tree,
+   uint64_t ull_size,
+   uint64_t ull_pos,
+   int32_t i_delta)
+{
+   for (; ull_pos <= ull_size; ull_pos += (ull_pos & (~ull_pos + 1)))
+   {
+      pui_tree [ull_pos] += (uint32_t) i_delta;
+   }
+}
+
+static inline uint32_t cachesim_fenwick_prefix (
+   const uint32_t *pui_tree,
+   uint64_t ull_pos)
+{
+   uint32_t ui_sum = 0;
+
+   for (; ull_pos > 0; ull_pos &= (ull_pos - 1))
+   {
+      ui_sum += pui_tree [ull_pos];
+   }
+   return ui_sum;
+}
+
+/*
+ * Expands the trace into the sequence of block numbers the cache sees for
+ * the given block size, splitting records exactly as
+ * cachesim_set_mapped_cache_access_records does.
+ */
+static CACHESIM_RET_E cachesim_mrc_expand (
+   const CACHESIM_TRACE_BUFFER_X *px_trace,
+   uint32_t ui_word_size,
+   uint32_t ui_address_bits,
+   uint32_t ui_block_size_words,
+   uint64_t **ppull_blocks,
+   uint64_t *pull_count)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_STATS_X x_trace_stats = {0};
+   uint64_t *pull_blocks = NULL;
+   uint64_t *pull_new_blocks = NULL;
+   uint64_t ull_capacity = 0;
+   uint64_t ull_count = 0;
+   uint64_t ull_i = 0;
+   uint64_t ull_first_word = 0;
+   uint64_t ull_last_word = 0;
+   uint64_t ull_block = 0;
+
+   for (ull_i = 0; ull_i < px_trace->ull_count; ull_i++)
+   {
+      if (false == cachesim_trace_record_words (&(px_trace->px_records [ull_i]),
+         ui_word_size, ui_address_bits, &ull_first_word, &ull_last_word,
+         &x_trace_stats))
+      {
+         continue;
+      }
+      for (ull_block = ull_first_word / ui_block_size_words;
+         ull_block <= (ull_last_word / ui_block_size_words); ull_block++)
+      {
+         if (ull_count == ull_capacity)
+         {
+            ull_capacity = (0 == ull_capacity) ?
+               CACHESIM_TRACE_BUFFER_MIN_RECORDS : (ull_capacity * 2);
+            pull_new_blocks = realloc (pull_blocks,
+               (size_t) ull_capacity * sizeof(uint64_t));
+            if (NULL == pull_new_blocks)
+            {
+               goto CLEAN_RETURN;
+            }
+            pull_blocks = pull_new_blocks;
+         }
+         pull_blocks [ull_count++] = ull_block;
+      }
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      free (pull_blocks);
+      pull_blocks = NULL;
+      ull_count = 0;
+   }
+   *ppull_blocks = pull_blocks;
+   *pull_count = ull_count;
+   return e_ret_val;
+}
+
+/*
+ * Mattson's LRU stack distances of a block sequence in O(log n) per access.
+ * Position i holds a mark while the block accessed at i has not been
+ * accessed again, so the number of marks strictly between the previous
+ * access to a block and the current one is the number of distinct blocks
+ * touched in between: the stack distance. An LRU cache of C blocks hits
+ * exactly the accesses with a distance below C.
+ *
+ * Distances at or above ull_max_distance are counted in the last bucket of
+ * the histogram, first accesses in ull_cold.
+ */
+static CACHESIM_RET_E cachesim_mrc_stack_distances (
+   const uint64_t *pull_blocks,
+   uint64_t ull_count,
+   uint64_t ull_max_distance,
+   CACHESIM_MRC_X *px_mrc)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_HASH_MAP_X x_last_access = {0};
+   uint32_t *pui_tree = NULL;
+   uint64_t *pull_last_pos = NULL;
+   uint64_t *pull_histogram = NULL;
+   uint64_t ull_pos = 0;
+   uint64_t ull_distance = 0;
+   uint64_t ull_len = 0;
+   bool b_inserted = false;
+
+   if (ull_count >= UINT32_MAX)
+   {
+      fprintf (stderr, "Too many accesses for the stack distance analysis\n");
+      goto CLEAN_RETURN;
+   }
+   pui_tree = calloc ((size_t) ull_count + 1, sizeof(uint32_t));
+   if (NULL == pui_tree)
+   {
+      goto CLEAN_RETURN;
+   }
+   memset (px_mrc, 0x00, sizeof(*px_mrc));
+   for (ull_pos = 1; ull_pos <= ull_count; ull_pos++)
+   {
+      pull_last_pos = cachesim_hash_map_insert (&x_last_access,
+         pull_blocks [ull_pos - 1], &b_inserted);
+      if (NULL == pull_last_pos)
+      {
+         goto CLEAN_RETURN;
+      }
+      if (true == b_inserted)
+      {
+         px_mrc->ull_cold++;
+      }
+      else
+      {
+         ull_distance = cachesim_fenwick_prefix (pui_tree, ull_pos - 1)
+            - cachesim_fenwick_prefix (pui_tree, *pull_last_pos);
+         if (ull_distance > ull_max_distance)
+         {
+            ull_distance = ull_max_distance;
+         }
+         if (ull_distance >= px_mrc->ull_histogram_len)
+         {
+            ull_len = (0 == px_mrc->ull_histogram_len) ?
+               64 : px_mrc->ull_histogram_len;
+            while (ull_len <= ull_distance)
+            {
+               ull_len *= 2;
+            }
+            pull_histogram = realloc (px_mrc->pull_histogram,
+               (size_t) ull_len * sizeof(uint64_t));
+            if (NULL == pull_histogram)
+            {
+               goto CLEAN_RETURN;
+            }
+            memset (pull_histogram + px_mrc->ull_histogram_len, 0x00,
+               (size_t) (ull_len - px_mrc->ull_histogram_len) * sizeof(uint64_t));
+            px_mrc->pull_histogram = pull_histogram;
+            px_mrc->ull_histogram_len = ull_len;
+         }
+         px_mrc->pull_histogram [ull_distance]++;
+         cachesim_fenwick_add (pui_tree, ull_count, *pull_last_pos, -1);
+      }
+      cachesim_fenwick_add (pui_tree, ull_count, ull_pos, 1);
+      *pull_last_pos = ull_pos;
+   }
+   px_mrc->ull_accesses = ull_count;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      free (px_mrc->pull_histogram);
+      memset (px_mrc, 0x00, sizeof(*px_mrc));
+   }
+   cachesim_hash_map_deinit (&x_last_access);
+   free (pui_tree);
+   return e_ret_val;
+}
+
+/*
+ * Misses of an LRU cache of ull_capacity blocks (per set for a set
+ * associative cache) given the stack distance histogram.
+ */
+static uint64_t cachesim_mrc_misses (
+   const CACHESIM_MRC_X *px_mrc,
+   uint64_t ull_capacity)
+{
+   uint64_t ull_misses = px_mrc->ull_cold;
+   uint64_t ull_d = 0;
+
+   for (ull_d = ull_capacity; ull_d < px_mrc->ull_histogram_len; ull_d++)
+   {
+      ull_misses += px_mrc->pull_histogram [ull_d];
+   }
+   return ull_misses;
+}
+
+/*
+ * Stable counting sort of the block sequence by set. Every reuse of a block
+ * stays within its set, so the stack distances of the reordered sequence
+ * are the per-set stack distances of a cache with ui_no_of_sets sets.
+ */
+static void cachesim_mrc_group_by_set (
+   const uint64_t *pull_blocks,
+   uint64_t ull_count,
+   uint32_t ui_no_of_sets,
+   uint64_t *pull_offsets,
+   uint64_t *pull_grouped)
+{
+   uint64_t ull_i = 0;
+   uint64_t ull_sum = 0;
+   uint64_t ull_set_count = 0;
+
+   memset (pull_offsets, 0x00, (size_t) ui_no_of_sets * sizeof(uint64_t));
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      pull_offsets [pull_blocks [ull_i] % ui_no_of_sets]++;
+   }
+   for (ull_i = 0; ull_i < ui_no_of_sets; ull_i++)
    {
-	   px_metadata->b_is_pinned = true;
+      ull_set_count = pull_offsets [ull_i];
+      pull_offsets [ull_i] = ull_sum;
+      ull_sum += ull_set_count;
+   }
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
+   {
+      pull_grouped [pull_offsets [pull_blocks [ull_i] % ui_no_of_sets]++] =
+         pull_blocks [ull_i];
    }
-   *pui_cache_set = ui_cache_set;
-   *pui_block_idx = ui_fetch_index;
-   e_ret_val = eCACHESIM_RET_SUCCESS;
-CLEAN_RETURN:
-   return e_ret_val;
 }
 
-static bool cachesim_set_lookup_cache(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_array_idx,
-   uint32_t *pui_cache_set)
+/*
+ * Miss ratio curve of one block size. Rows are the power of 2 cache sizes
+ * from one block up to the first size that only takes compulsory misses;
+ * columns are the fully associative cache and one set associative cache per
+ * associativity in pui_assoc.
+ */
+static CACHESIM_RET_E cachesim_mrc_block_size (
+   const CACHESIM_TRACE_BUFFER_X *px_trace,
+   uint32_t ui_word_size,
+   uint32_t ui_address_bits,
+   uint32_t ui_block_size_words,
+   const uint32_t *pui_assoc,
+   uint32_t ui_no_of_assoc)
 {
-   bool b_cache_hit = false;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   CACHE_BLOCK_X *px_cache_block = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-   CACHE_SET_DATA_X *px_set_data = NULL;
-
-   if ((NULL == px_cache) || (NULL == pui_cache_set))
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_MRC_X x_full = {0};
+   CACHESIM_MRC_X x_set = {0};
+   uint64_t *pull_blocks = NULL;
+   uint64_t *pull_grouped = NULL;
+   uint64_t *pull_offsets = NULL;
+   uint64_t *pull_set_misses = NULL;
+   uint64_t ull_count = 0;
+   uint64_t ull_max_capacity = 1;
+   uint64_t ull_capacity = 0;
+   uint64_t ull_sets = 0;
+   uint32_t ui_row = 0;
+   uint32_t ui_no_of_rows = 0;
+   uint32_t ui_max_assoc = 0;
+   uint32_t ui_a = 0;
+   double d_start = cachesim_now_seconds ();
+
+   e_ret_val = cachesim_mrc_expand (px_trace, ui_word_size, ui_address_bits,
+      ui_block_size_words, &pull_blocks, &ull_count);
+   if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (0 == ull_count))
+   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_mrc_stack_distances (pull_blocks, ull_count,
+      ull_count, &x_full);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
    {
       goto CLEAN_RETURN;
    }
 
    /*
-    * Loop through all the sets to find the data word in the cache.
+    * Past the largest stack distance seen every cache size takes only the
+    * compulsory misses.
     */
-   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   for (ull_capacity = x_full.ull_histogram_len; ull_capacity > 0; ull_capacity--)
    {
-      /*
-       * Loop through all the blocks in the set to find the data word in
-       * the cache.
-       */
-      px_set_data = &(px_cache->xa_sets[ui_i]);
-      for (ui_j = 0; ui_j < px_cache->ui_no_of_blocks_per_set; ui_j++)
+      if (0 != x_full.pull_histogram [ull_capacity - 1])
       {
-         px_cache_block = &(px_set_data->xa_blocks[ui_j]);
-         px_metadata = &(px_cache_block->x_metadata);
-
-         /*
-          * If the array index is between the start and end indices in the cache
-          * block then it is a cache hit.
-          */
-         if ((px_metadata->ui_data_start_idx <= ui_array_idx)
-            && (px_metadata->ui_data_end_idx >= ui_array_idx))
-         {
-            *pui_cache_set = ui_i;
-            b_cache_hit = true;
-            break;
-         }
+         break;
       }
-      if (true == b_cache_hit)
+   }
+   while (ull_max_capacity <= ull_capacity)
+   {
+      ull_max_capacity *= 2;
+   }
+   for (ull_capacity = 1; ull_capacity <= ull_max_capacity; ull_capacity *= 2)
+   {
+      ui_no_of_rows++;
+   }
+   for (ui_a = 0; ui_a < ui_no_of_assoc; ui_a++)
+   {
+      if (pui_assoc [ui_a] > ui_max_assoc)
       {
-         break;
+         ui_max_assoc = pui_assoc [ui_a];
       }
    }
+
    /*
-    * If the loop ends without setting b_cache_hit, then it is a miss.
+    * One pass per number of sets yields the per-set stack distances, and
+    * with them the misses for every associativity at that number of sets.
     */
-CLEAN_RETURN:
-   return b_cache_hit;
-}
-
-static bool cachesim_set_lookup_cache_v2(
-   CACHE_SET_X *px_cache,
-   uint32_t ui_array_idx,
-   uint32_t *pui_cache_set,
-   uint32_t *pui_block_idx)
-{
-   bool b_cache_hit = false;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   CACHE_BLOCK_X *px_cache_block = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-   CACHE_SET_DATA_X *px_set_data = NULL;
-
-   if ((NULL == px_cache) || (NULL == pui_cache_set))
+   pull_grouped = malloc ((size_t) ull_count * sizeof(uint64_t));
+   pull_offsets = malloc ((size_t) ull_max_capacity * sizeof(uint64_t));
+   pull_set_misses = malloc ((size_t) ui_no_of_rows * ui_no_of_assoc
+      * sizeof(uint64_t));
+   if ((NULL == pull_grouped) || (NULL == pull_offsets) || (NULL == pull_set_misses))
    {
+      e_ret_val = eCACHESIM_RET_FAILURE;
       goto CLEAN_RETURN;
    }
-
    /*
-    * Loop through all the sets to find the data word in the cache.
+    * UINT64_MAX marks a cache smaller than one set of the associativity.
     */
-   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
+   memset (pull_set_misses, 0xFF,
+      (size_t) ui_no_of_rows * ui_no_of_assoc * sizeof(uint64_t));
+   for (ull_sets = 1; ull_sets <= ull_max_capacity; ull_sets *= 2)
    {
-      /*
-       * Loop through all the blocks in the set to find the data word in
-       * the cache.
-       */
-      px_set_data = &(px_cache->xa_sets[ui_i]);
-      for (ui_j = 0; ui_j < px_cache->ui_no_of_blocks_per_set; ui_j++)
+      cachesim_mrc_group_by_set (pull_blocks, ull_count, (uint32_t) ull_sets,
+         pull_offsets, pull_grouped);
+      e_ret_val = cachesim_mrc_stack_distances (pull_grouped, ull_count,
+         ui_max_assoc, &x_set);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
       {
-         px_cache_block = &(px_set_data->xa_blocks[ui_j]);
-         px_metadata = &(px_cache_block->x_metadata);
-
-         /*
-          * If the array index is between the start and end indices in the cache
-          * block then it is a cache hit.
-          */
-         if ((px_metadata->ui_data_start_idx <= ui_array_idx)
-            && (px_metadata->ui_data_end_idx >= ui_array_idx))
-         {
-            *pui_cache_set = ui_i;
-            *pui_block_idx = ui_j;
-            b_cache_hit = true;
-            break;
-         }
+         goto CLEAN_RETURN;
       }
-      if (true == b_cache_hit)
+      for (ui_a = 0; ui_a < ui_no_of_assoc; ui_a++)
       {
-         break;
+         ull_capacity = ull_sets * pui_assoc [ui_a];
+         for (ui_row = 0; ui_row < ui_no_of_rows; ui_row++)
+         {
+            if (ull_capacity == (1ULL << ui_row))
+            {
+               pull_set_misses [(ui_row * ui_no_of_assoc) + ui_a] =
+                  cachesim_mrc_misses (&x_set, pui_assoc [ui_a]);
+            }
+         }
       }
+      free (x_set.pull_histogram);
+      memset (&x_set, 0x00, sizeof(x_set));
    }
-   /*
-    * If the loop ends without setting b_cache_hit, then it is a miss.
-    */
-CLEAN_RETURN:
-   return b_cache_hit;
-}
-
-static void cachesim_print_log_header (
-   CACHE_SET_X *px_cache)
-{
-   uint32_t ui_i = 0;
-   uint32_t ui_l = 0;
-   CACHE_SET_DATA_X *px_cache_set = NULL;
-   char uca_format_string [256] = { '\0' };
-   char uca_line_str[256] = { '\0' };
-   uint32_t ui_line_str_len = 0;
-   uint32_t ui_width_qualifier = 0;
-
-   ui_width_qualifier = px_cache->ui_no_of_blocks_per_set * 9; //strlen ("%4d-%4d");
-   ui_width_qualifier += (px_cache->ui_no_of_blocks_per_set - 1);
-
-   printf ("%7s |", " RAM Idx");
-
-   snprintf ((uca_format_string), sizeof(uca_format_string), " %%%dd |",
-      ui_width_qualifier);
-
-   for (ui_i = 0; ui_i < px_cache->ui_configured_no_of_sets; ui_i++)
-   {
-      px_cache_set = &(px_cache->xa_sets[ui_i]);
-      printf (uca_format_string, px_cache_set->ui_set_idx);
-
-   }
-
-   printf (" Hit/Miss | Set/Blk Idx |\n");
 
-
-   printf ("%8s-+", "--------");
-
-   (void) memset (uca_format_string, 0x00, sizeof(uca_format_string));
-
-   snprintf ((uca_format_string), sizeof(uca_format_string), "-%%%ds-",
-      ui_width_qualifier);
-   for (ui_l = 0; ui_l < ui_width_qualifier; ui_l++)
+   printf ("MRC:\n"
+      "\t ui_block_size_words       : %u\n"
+      "\t ull_accesses              : %" PRIu64 "\n"
+      "\t ull_compulsory_miss       : %" PRIu64 "\n"
+      "\t\t d_seconds                : %f\n\n",
+      ui_block_size_words, x_full.ull_accesses, x_full.ull_cold,
+      cachesim_now_seconds () - d_start);
+   printf ("%11s | %9s | %10s", "cache_words", "blocks", "full_assoc");
+   for (ui_a = 0; ui_a < ui_no_of_assoc; ui_a++)
    {
-      ui_line_str_len = strnlen ((uca_line_str), sizeof(uca_line_str));
-      snprintf ((uca_line_str + ui_line_str_len), sizeof(uca_line_str), "-");
+      printf (" | %7u-way", pui_assoc [ui_a]);
    }
-   for (ui_l = 0; ui_l < px_cache->ui_configured_no_of_sets; ui_l++)
+   printf ("\n");
+   for (ui_row = 0; ui_row < ui_no_of_rows; ui_row++)
    {
-      printf (uca_format_string, uca_line_str);
-
-      if (ui_l < (px_cache->ui_configured_no_of_sets - 1))
+      ull_capacity = 1ULL << ui_row;
+      printf ("%11" PRIu64 " | %9" PRIu64 " | %10f",
+         ull_capacity * ui_block_size_words, ull_capacity,
+         (double) cachesim_mrc_misses (&x_full, ull_capacity)
+            / (double) x_full.ull_accesses);
+      for (ui_a = 0; ui_a < ui_no_of_assoc; ui_a++)
       {
-         printf ("+");
+         if (UINT64_MAX == pull_set_misses [(ui_row * ui_no_of_assoc) + ui_a])
+         {
+            printf (" | %11s", "-");
+            continue;
+         }
+         printf (" | %11f",
+            (double) pull_set_misses [(ui_row * ui_no_of_assoc) + ui_a]
+            / (double) x_full.ull_accesses);
       }
+      printf ("\n");
    }
-
-   printf ("+-%8s-+", "--------");
-   printf ("-%11s-+", "-----------");
-
    printf ("\n");
-}
-
-static CACHESIM_RET_E cachesim_set_handle_cache_hit (
-	CACHE_SET_X *px_cache,
-	CACHESIM_SIM_STATS_X *px_stats)
-{
-	CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-
-	if ((NULL == px_cache) || (NULL == px_stats))
-    {
-	    goto CLEAN_RETURN;
-    }
-	px_stats->ui_hit_count++;
-	e_ret_val = eCACHESIM_RET_SUCCESS;
-CLEAN_RETURN:
-    return e_ret_val;
-}
-
-static CACHESIM_RET_E cachesim_set_handle_cache_miss (
-	CACHE_SET_X *px_cache,
-	uint32_t ui_index,
-	bool b_use_pinning,
-	bool *pb_compulsory,
-    uint32_t *pui_cache_set,
-    uint32_t *pui_block_idx,
-	CACHESIM_SIM_STATS_X *px_stats)
-{
-	CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-    uint32_t ui_ram_block = CACHESIM_MAX_INDEX_VALUE;
-
-	if ((NULL == px_cache) || (NULL == px_stats) || (NULL == pb_compulsory) ||
-			(NULL == pui_cache_set) || (NULL == pui_block_idx))
-    {
-	    goto CLEAN_RETURN;
-    }
-    /*
-     * Get a mapping of the current memory referenced index to the block in
-     * the RAM.
-     */
-    ui_ram_block =
-       (ui_index
-          / (px_cache->x_cache_params.ui_block_size_words));
-    if (ui_ram_block >= CACHESIM_MAX_RAM_BLOCKS)
-    {
-       printf ("\n\n!!!!!!!!!!!FATAL ERROR!!!!!!!!!!!!\n\n");
-       exit (-1);
-    }
-
-    /*
-     * The ba_first_access_to_ram_blk array holds a flag to tell whether the
-     * access to the RAM block was for the first time or not. Therefore for
-     * each RAM block check the status, if it false, then it is the first
-     * access to that block and a compulsory miss is noted. Otherwise it is a
-     * capacity miss. Conflict misses are not being tracked for obvious
-     * reasons.
-     */
-    if (false == px_stats->ba_first_access_to_ram_blk [ui_ram_block])
-    {
-       px_stats->ba_first_access_to_ram_blk [ui_ram_block] = true;
-       px_stats->ui_compulsory_miss++;
-       *pb_compulsory = true;
-    }
-    else
-    {
-       px_stats->ui_capacity_miss++;
-    }
-
-    px_stats->ui_miss_count++;
-
-    /*
-     * Word not present in the cache. Fetch from block from RAM.
-     */
-    e_ret_val = cachesim_set_fetch_data_to_cache_v2 (px_cache, ui_index, b_use_pinning,
-       pui_cache_set, pui_block_idx);
 CLEAN_RETURN:
-    return e_ret_val;
+   free (x_full.pull_histogram);
+   free (x_set.pull_histogram);
+   free (pull_set_misses);
+   free (pull_offsets);
+   free (pull_grouped);
+   free (pull_blocks);
+   return e_ret_val;
 }
 
-static void cachesim_set_log_cache_access (
-   CACHE_SET_X *px_cache,
-   uint32_t ui_cache_set,
-   uint32_t ui_block_idx,
-   bool b_cache_hit,
-   bool b_compulsory,
-   bool b_silent)
+/*
+ * Miss ratio curves of LRU caches for every block size listed with -b, from
+ * a single decode of the trace.
+ */
+CACHESIM_RET_E cachesim_simulate_mrc (CACHESIM_CACHE_ARGS_X *px_cache_args)
 {
-   uint32_t ui_k = 0;
-   uint32_t ui_l = 0;
-   CACHE_SET_DATA_X *px_cache_set = NULL;
-   CACHE_BLOCK_X *px_cache_block = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-
-   if (NULL == px_cache)
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_BUFFER_X x_trace = {0};
+   uint32_t ua_assoc [CACHESIM_SWEEP_MAX_VALUES] = {0};
+   uint32_t ua_block [CACHESIM_SWEEP_MAX_VALUES] = {0};
+   uint32_t ui_no_of_assoc = 0;
+   uint32_t ui_no_of_block = 0;
+   uint32_t ui_b = 0;
+
+   if (NULL == px_cache_args->pc_trace_file)
    {
-	goto CLEAN_RETURN;
-   }
-
-   if (false == b_silent)
-   {
-	  /*
-	   * Just for logging purpose.
-	   */
-	  for (ui_l = 0; ui_l < px_cache->ui_configured_no_of_sets; ui_l++)
-	  {
-		 px_cache_set = &(px_cache->xa_sets [ui_l]);
-		 for (ui_k = 0; ui_k < px_cache->ui_no_of_blocks_per_set; ui_k++)
-		 {
-			px_cache_block = &(px_cache_set->xa_blocks [ui_k]);
-			px_metadata = &(px_cache_block->x_metadata);
-
-			printf ("%4d-%4d",
-			   (CACHESIM_MAX_INDEX_VALUE == px_metadata->ui_data_start_idx) ?
-					 9999 : px_metadata->ui_data_start_idx,
-			   (CACHESIM_MAX_INDEX_VALUE == px_metadata->ui_data_end_idx) ?
-					 9999 : px_metadata->ui_data_end_idx);
-			if (ui_k < px_cache->ui_no_of_blocks_per_set - 1)
-			   printf ("/");
-		 }
-		 printf (" | ");
-	  }
-
-	  if (true == b_cache_hit)
-	  {
-		 printf ("%8s | %5d/%5d |\n", "Hit", ui_cache_set, ui_block_idx);
-	  }
-	  else
-	  {
-		 printf ("%8s | %5d/%5d |\n",
-			(true == b_compulsory) ? "Com Miss" : "Cap Miss", ui_cache_set, ui_block_idx);
-	  }
+      fprintf (stderr, "--mrc needs a trace to analyse (--trace)\n");
+      goto CLEAN_RETURN;
    }
-CLEAN_RETURN:
-   return;
-}
-
-static CACHESIM_RET_E cachesim_set_mapped_cache_access (
-   CACHE_SET_X *px_cache,
-   uint32_t ui_index,
-   bool b_use_pinning,
-   uint32_t ui_total_data_words,
-   bool b_silent,
-   CACHESIM_SIM_STATS_X *px_stats)
-{
-   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_k = 0;
-   uint32_t ui_l = 0;
-   CACHE_SET_DATA_X *px_cache_set = NULL;
-   CACHE_BLOCK_METADATA_X  *px_metadata = NULL;
-   bool b_cache_hit = false;
-   uint32_t ui_cache_set = 0;
-   uint32_t ui_block_idx = 0;
-   CACHE_BLOCK_X *px_cache_block = NULL;
-   uint32_t ui_ram_block = CACHESIM_MAX_INDEX_VALUE;
-   bool b_compulsory = false;
-
-   if ((NULL == px_cache) || (NULL == px_stats))
+   if ((eCACHESIM_RET_SUCCESS != cachesim_sweep_parse_list (
+         (NULL != px_cache_args->pc_associativity_list) ?
+            px_cache_args->pc_associativity_list : CACHESIM_MRC_DEFAULT_ASSOC,
+         0, ua_assoc, &ui_no_of_assoc))
+      || (eCACHESIM_RET_SUCCESS != cachesim_sweep_parse_list (
+         px_cache_args->pc_block_size_list, px_cache_args->ui_block_size_words,
+         ua_block, &ui_no_of_block)))
    {
+      fprintf (stderr, "Invalid -a or -b list, expected values like \"2,4\" or "
+         "\"1-16\" (at most %d values)\n", CACHESIM_SWEEP_MAX_VALUES);
       goto CLEAN_RETURN;
    }
 
-   if (false == b_silent)
+   e_ret_val = cachesim_trace_load (&x_trace, px_cache_args->pc_trace_file,
+      px_cache_args->ull_fast_forward, px_cache_args->ull_max_records);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
    {
-      printf ("%8d | ", ui_index);
+      goto CLEAN_RETURN;
    }
 
-   px_stats->ui_total_accesses++;
-
-   /*
-    * Check is the data word is present in the cache.
-    */
-   b_cache_hit = cachesim_set_lookup_cache_v2 (px_cache, ui_index, &ui_cache_set, &ui_block_idx);
-   if (true == b_cache_hit)
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("+++++++++++++++Miss Ratio Curves++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   for (ui_b = 0; ui_b < ui_no_of_block; ui_b++)
    {
-      e_ret_val = cachesim_set_handle_cache_hit (px_cache, px_stats);
+      e_ret_val = cachesim_mrc_block_size (&x_trace,
+         px_cache_args->ui_word_size_bytes, px_cache_args->ui_address_bits,
+         ua_block [ui_b], ua_assoc, ui_no_of_assoc);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         break;
+      }
    }
-   else
+CLEAN_RETURN:
+   cachesim_trace_buffer_free (&x_trace);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
    {
-	   e_ret_val = cachesim_set_handle_cache_miss (px_cache, ui_index, b_use_pinning,&b_compulsory, &ui_cache_set,
-	    &ui_block_idx, px_stats);
+      fprintf (stderr, "Miss ratio curve analysis failed\n");
    }
-   cachesim_set_log_cache_access (px_cache, ui_cache_set, ui_block_idx, b_cache_hit, b_compulsory,
-      b_silent);
-CLEAN_RETURN:
    return e_ret_val;
 }
 
-static void cache_sim_log_summary (
-	CACHESIM_SIM_STATS_X *px_stats)
+/****************************** GLOBAL FUNCTIONS ******************************/
+void cachesim_config_init (
+   CACHESIM_CONFIG_X *px_config)
 {
-	   printf ("Stats:\n"
-	      "\t ui_total_accesses         : %d\n"
-	      "\t ui_hit_count              : %d\n"
-	      "\t ui_miss_count             : %d\n"
-	      "\t ui_capacity_miss          : %d\n"
-	      "\t ui_compulsory_miss        : %d\n"
-	      "\t ui_conflict_miss          : %d\n", px_stats->ui_total_accesses,
-	      px_stats->ui_hit_count, px_stats->ui_miss_count, px_stats->ui_capacity_miss,
-	      px_stats->ui_compulsory_miss, px_stats->ui_conflict_miss);
-
-	   double d_hit_time = 1.0;
-	   double d_miss_penalty = 1.5;
-	   double d_hit_rate = (double) px_stats->ui_hit_count / (double) px_stats->ui_total_accesses;
-	   double d_miss_rate = (double) px_stats->ui_miss_count / (double) px_stats->ui_total_accesses;
-	   double d_avg_memory_access_time = d_hit_time + (d_miss_rate * d_miss_penalty);
-	   printf ("\t\t d_hit_rate               : %f\n", d_hit_rate);
-	   printf ("\t\t d_miss_rate              : %f\n", d_miss_rate);
-	   printf ("\t\t d_avg_memory_access_time : %f\n", d_avg_memory_access_time);
-	   printf ("\n");
+   if (NULL == px_config)
+   {
+      return;
+   }
+   memset (px_config, 0x00, sizeof(*px_config));
+   px_config->ui_cache_size_words = 64;
+   px_config->ui_associativity = 2;
+   px_config->ui_block_size_words = 8;
+   px_config->ui_word_size_bytes = sizeof(uint32_t);
+   px_config->ui_address_bits = CACHESIM_DEFAULT_ADDRESS_BITS;
+   px_config->pc_replacement_policy = cachesim_replacement_policy (
+      eCACHESIM_REPLACEMENT_POLICY_FIFO)->pc_name;
+   px_config->b_write_back = true;
+   px_config->b_write_allocate = true;
+   px_config->b_classify_misses = true;
+   px_config->pc_prefetcher = cachesim_prefetcher (
+      eCACHESIM_PREFETCHER_NONE)->pc_name;
+   px_config->ui_prefetch_degree = CACHESIM_PREFETCH_DEFAULT_DEGREE;
+   px_config->ui_prefetch_latency = CACHESIM_PREFETCH_DEFAULT_LATENCY;
+   px_config->ui_hit_latency = gua_default_hit_latencies [0];
+   px_config->ui_memory_latency = CACHESIM_DEFAULT_MEMORY_LATENCY;
+   px_config->ui_issue_rate = CACHESIM_DEFAULT_ISSUE_RATE;
 }
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_simulate(
-   CACHE_SET_X *px_cache,
-   bool b_use_pinning,
-   bool b_silent)
+CACHESIM_RET_E cachesim_create (
+   const CACHESIM_CONFIG_X *px_config,
+   CACHESIM_X **ppx_sim)
 {
    CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   CACHESIM_SIM_STATS_X x_stats = {0};
+   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
+   CACHESIM_X *px_sim = NULL;
 
-   if (NULL == px_cache)
+   if ((NULL == px_config) || (NULL == ppx_sim))
    {
       goto CLEAN_RETURN;
    }
-   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   printf ("+++++++++++++General Simulator++++++++++++++++++\n");
-   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   cachesim_print_cache_params (px_cache);
-   if (false == b_silent)
-     cachesim_print_log_header (px_cache);
-#if 0
-   for (ui_i = 0; ui_i < 6; ui_i++)
+   *ppx_sim = NULL;
+
+   x_cache_param.ui_cache_size_words = px_config->ui_cache_size_words;
+   x_cache_param.ui_associativity = px_config->ui_associativity;
+   x_cache_param.ui_block_size_words = px_config->ui_block_size_words;
+   x_cache_param.ui_word_size_bytes = px_config->ui_word_size_bytes;
+   x_cache_param.ui_address_bits = px_config->ui_address_bits;
+   x_cache_param.b_huge_pages = px_config->b_huge_pages;
+   x_cache_param.b_classify_misses = px_config->b_classify_misses;
+   x_cache_param.e_write_policy = (true == px_config->b_write_back) ?
+      eCACHESIM_WRITE_POLICY_WRITE_BACK : eCACHESIM_WRITE_POLICY_WRITE_THROUGH;
+   x_cache_param.b_write_allocate = px_config->b_write_allocate;
+   x_cache_param.ui_sample_sets = px_config->ui_sample_sets;
+   x_cache_param.ui_prefetch_degree = px_config->ui_prefetch_degree;
+   x_cache_param.ui_prefetch_latency = px_config->ui_prefetch_latency;
+   x_cache_param.ui_hit_latency = px_config->ui_hit_latency;
+   x_cache_param.ui_miss_penalty = px_config->ui_miss_penalty;
+   x_cache_param.ui_memory_latency = px_config->ui_memory_latency;
+   x_cache_param.ui_mshrs = px_config->ui_mshrs;
+   x_cache_param.ui_issue_rate = px_config->ui_issue_rate;
+   if ((0 == x_cache_param.ui_word_size_bytes)
+      || (0 == x_cache_param.ui_address_bits)
+      || (x_cache_param.ui_address_bits > 64)
+      || (x_cache_param.ui_mshrs > CACHESIM_MAX_MSHRS)
+      || ((0 != x_cache_param.ui_mshrs) && (0 == x_cache_param.ui_issue_rate))
+      || ((0 != x_cache_param.ui_mshrs) && (x_cache_param.ui_sample_sets > 1)))
    {
-      for (ui_j = ui_i; ui_j < 64; ui_j += 6)
-      {
-         usleep (250);
-         cachesim_set_mapped_cache_access (px_cache, ui_j, 64, b_silent, &x_stats);
-      }
+      e_ret_val = eCACHESIM_RET_FAILURE;
+      goto CLEAN_RETURN;
    }
-#endif
-   for (ui_i = 0; ui_i < 32; ui_i++)
+   if ((NULL != px_config->pc_replacement_policy)
+      && (eCACHESIM_RET_SUCCESS != cachesim_replacement_policy_from_name (
+         px_config->pc_replacement_policy,
+         &(x_cache_param.e_replacement_policy))))
    {
-	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
+      e_ret_val = eCACHESIM_RET_FAILURE;
+      goto CLEAN_RETURN;
    }
-   for (ui_i = 33; ui_i < 128; ui_i++)
+   if ((NULL != px_config->pc_prefetcher)
+      && (eCACHESIM_RET_SUCCESS != cachesim_prefetcher_from_name (
+         px_config->pc_prefetcher, &(x_cache_param.e_prefetcher))))
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+      goto CLEAN_RETURN;
+   }
+
+   px_sim = (CACHESIM_X *) calloc (1, sizeof(*px_sim));
+   if (NULL == px_sim)
+   {
+      e_ret_val = eCACHESIM_RET_FAILURE;
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_set_alloc_cache (&(px_sim->px_cache), &x_cache_param);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
    {
-       usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-       cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
+      free (px_sim);
+      goto CLEAN_RETURN;
    }
-   for (ui_i = 0; ui_i < 32; ui_i++)
-      {
-   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-      }
-   for (ui_i = 33; ui_i < 128; ui_i++)
-      {
-          usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-      }
-   for (ui_i = 0; ui_i < 32; ui_i++)
-      {
-   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-      }
-   cache_sim_log_summary (&x_stats);
+   *ppx_sim = px_sim;
 CLEAN_RETURN:
    return e_ret_val;
 }
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_pinning(
-   CACHE_SET_X *px_cache,
-   bool b_use_pinning,
-   bool b_silent,
-   uint32_t ui_loop_iterations)
+CACHESIM_RET_E cachesim_destroy (
+   CACHESIM_X *px_sim)
 {
    CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_k = 0;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   CACHESIM_SIM_STATS_X x_stats = {0};
 
-   if (NULL == px_cache)
+   if (NULL == px_sim)
    {
       goto CLEAN_RETURN;
    }
-   printf ("\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   printf ("+++++++++++++General Simulator++++++++++++++++++\n");
-   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   cachesim_print_cache_params (px_cache);
-   if (false == b_silent)
-     cachesim_print_log_header (px_cache);
-#if 0
-   for (ui_i = 0; ui_i < 6; ui_i++)
-   {
-      for (ui_j = ui_i; ui_j < 64; ui_j += 6)
-      {
-         usleep (250);
-         cachesim_set_mapped_cache_access (px_cache, ui_j, 64, b_silent, &x_stats);
-      }
-   }
-#endif
+   e_ret_val = cachesim_set_free_cache (px_sim->px_cache);
+   cachesim_sim_stats_deinit (&(px_sim->x_stats));
+   free (px_sim);
+CLEAN_RETURN:
+   return e_ret_val;
+}
 
-   for (ui_k = 0; ui_k < ui_loop_iterations; ui_k++)
+CACHESIM_RET_E cachesim_access (
+   CACHESIM_X *px_sim,
+   uint64_t ull_address,
+   uint32_t ui_size_bytes,
+   CACHESIM_ACCESS_TYPE_E e_type,
+   bool *pb_hit)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_RECORD_X x_record = {0};
+
+   if ((NULL == px_sim) || (e_type >= eCACHESIM_ACCESS_TYPE_MAX))
    {
-	   for (ui_i = 0; ui_i < 32; ui_i++)
-	      {
-	   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	      }
-	   for (ui_i = 32 + ui_k; ui_i < (64 + ui_k); ui_i++)
-	      {
-	          usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	      }
-	   for (ui_i = 0; ui_i < 32; ui_i++)
-	      {
-	   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	      }
-	   for (ui_i = 65 + ui_k; ui_i < (96 + ui_k); ui_i++)
-	   	      {
-	   	          usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   	          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	   	      }
-	   for (ui_i = 0; ui_i < 32; ui_i++)
-	      {
-	   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	      }
-	   for (ui_i = 97 + ui_k; ui_i < (128 + ui_k); ui_i++)
-	   	   	      {
-	   	   	          usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   	   	          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	   	   	      }
-	   for (ui_i = 0; ui_i < 32; ui_i++)
-	      {
-	   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-	      }
+      goto CLEAN_RETURN;
    }
+   x_record.ull_address = ull_address;
+   x_record.ui_size_bytes = ui_size_bytes;
+   x_record.e_type = e_type;
+   cachesim_set_mapped_cache_access_records (px_sim->px_cache, &x_record, 1,
+      &(px_sim->x_stats), &(px_sim->x_trace_stats), pb_hit);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
 
+CACHESIM_RET_E cachesim_access_batch (
+   CACHESIM_X *px_sim,
+   const CACHESIM_RECORD_X *px_records,
+   uint64_t ull_count)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_RECORD_X xa_records [CACHESIM_TRACE_BATCH_RECORDS];
+   uint32_t ui_no_of_records = 0;
+   uint64_t ull_i = 0;
 
-#if 0
-   for (ui_i = 0; ui_i < 32; ui_i++)
+   if ((NULL == px_sim) || ((NULL == px_records) && (0 != ull_count)))
    {
-	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
+      goto CLEAN_RETURN;
    }
-   for (ui_i = 33; ui_i < 128; ui_i++)
+   memset (xa_records, 0x00, sizeof(xa_records));
+   for (ull_i = 0; ull_i < ull_count; ull_i++)
    {
-       usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-       cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-   }
-   for (ui_i = 0; ui_i < 32; ui_i++)
+      if (px_records [ull_i].e_type >= eCACHESIM_ACCESS_TYPE_MAX)
       {
-   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
+         goto CLEAN_RETURN;
       }
-   for (ui_i = 33; ui_i < 128; ui_i++)
-      {
-          usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-          cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
-      }
-   for (ui_i = 0; ui_i < 32; ui_i++)
+      xa_records [ui_no_of_records].ull_address = px_records [ull_i].ull_address;
+      xa_records [ui_no_of_records].ui_size_bytes = px_records [ull_i].ui_size_bytes;
+      xa_records [ui_no_of_records].e_type = px_records [ull_i].e_type;
+      ui_no_of_records++;
+      if (CACHESIM_TRACE_BATCH_RECORDS == ui_no_of_records)
       {
-   	   usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-   	   cachesim_set_mapped_cache_access (px_cache, ui_i, b_use_pinning, 64, b_silent, &x_stats);
+         cachesim_set_mapped_cache_access_records (px_sim->px_cache, xa_records,
+            ui_no_of_records, &(px_sim->x_stats), &(px_sim->x_trace_stats),
+            NULL);
+         ui_no_of_records = 0;
       }
-#endif
-   cache_sim_log_summary (&x_stats);
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
 CLEAN_RETURN:
+   /*
+    * The records before an invalid one have been accepted; run them.
+    */
+   if (0 != ui_no_of_records)
+   {
+      cachesim_set_mapped_cache_access_records (px_sim->px_cache, xa_records,
+         ui_no_of_records, &(px_sim->x_stats), &(px_sim->x_trace_stats), NULL);
+   }
    return e_ret_val;
 }
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_bubble_sort(
-   CACHE_SET_X *px_cache,
-   bool b_silent,
-   uint32_t ui_n)
+CACHESIM_RET_E cachesim_get_stats (
+   const CACHESIM_X *px_sim,
+   CACHESIM_STATS_X *px_stats)
 {
    CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   // uint32_t ui_n = 4096;
-   uint32_t ui_prev_miss_count = 0;
-   CACHESIM_SIM_STATS_X x_stats = {0};
+   const CACHESIM_PREFETCH_X *px_prefetch = NULL;
+   const CACHESIM_MSHR_X *px_mshr = NULL;
 
-   if (NULL == px_cache)
+   if ((NULL == px_sim) || (NULL == px_stats))
    {
       goto CLEAN_RETURN;
    }
+   memset (px_stats, 0x00, sizeof(*px_stats));
+   px_stats->ull_records = px_sim->x_trace_stats.ull_records;
+   px_stats->ull_skipped_records = px_sim->x_trace_stats.ull_skipped;
+   px_stats->ull_accesses = px_sim->x_stats.ull_total_accesses;
+   px_stats->ull_hits = px_sim->x_stats.ull_hit_count;
+   px_stats->ull_misses = px_sim->x_stats.ull_miss_count;
+   px_stats->ull_compulsory_misses = px_sim->x_stats.ull_compulsory_miss;
+   px_stats->ull_capacity_misses = px_sim->x_stats.ull_capacity_miss;
+   px_stats->ull_conflict_misses = px_sim->x_stats.ull_conflict_miss;
+   px_stats->ull_writes = px_sim->x_stats.ull_writes;
+   px_stats->ull_write_misses = px_sim->x_stats.ull_write_misses;
+   px_stats->ull_dirty_evictions = px_sim->x_stats.ull_dirty_evictions;
+   px_stats->ull_bytes_from_memory = px_sim->x_stats.ull_bytes_from_memory;
+   px_stats->ull_bytes_to_memory = px_sim->x_stats.ull_bytes_to_memory;
+   px_stats->ull_sample_skipped = px_sim->px_cache->ull_sample_skipped;
+   px_prefetch = px_sim->px_cache->px_prefetch;
+   if (NULL != px_prefetch)
+   {
+      px_stats->ull_prefetches_issued = px_prefetch->ull_issued;
+      px_stats->ull_prefetches_useful = px_prefetch->ull_useful;
+      px_stats->ull_prefetches_late = px_prefetch->ull_late;
+   }
+   px_stats->ull_cycles = px_sim->x_stats.ull_cycles;
+   px_stats->ull_stall_cycles = px_sim->x_stats.ull_stall_cycles;
+   memcpy (px_stats->ulla_latency_histogram,
+      px_sim->x_stats.ulla_latency_histogram,
+      sizeof(px_stats->ulla_latency_histogram));
+   px_mshr = px_sim->px_cache->px_mshr;
+   if (NULL != px_mshr)
+   {
+      px_stats->ull_elapsed_cycles = cachesim_mshr_elapsed (px_mshr);
+      px_stats->ull_primary_misses = px_mshr->ull_primary_misses;
+      px_stats->ull_merged_misses = px_mshr->ull_merged_misses;
+      px_stats->ull_mshr_full_stalls = px_mshr->ull_full_stalls;
+      px_stats->ull_mshr_stall_cycles = px_mshr->ull_full_stall_cycles;
+      px_stats->ull_miss_cycles = px_mshr->ull_miss_cycles;
+      px_stats->ull_miss_busy_cycles = px_mshr->ull_busy_cycles;
+   }
+   px_stats->ull_read_records = px_sim->x_trace_stats.ull_reads;
+   px_stats->ull_write_records = px_sim->x_trace_stats.ull_writes;
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
 
-   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   printf ("+++++++++++++++Bubble Sort Simulator++++++++++++\n");
-   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   cachesim_print_cache_params (px_cache);
-
-   if (false == b_silent)
-     cachesim_print_log_header (px_cache);
+CACHESIM_RET_E cachesim_reset_stats (
+   CACHESIM_X *px_sim)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_FIRST_TOUCH_X x_first_touch = {0};
+   CACHESIM_PREFETCH_X *px_prefetch = NULL;
+   CACHESIM_MSHR_X *px_mshr = NULL;
 
-   for (ui_i = 0; ui_i < ui_n; ui_i++)
+   if (NULL == px_sim)
    {
-      for (ui_j = 0; ui_j < ui_n - ui_i - 1; ui_j++)
-      {
-         usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-         cachesim_set_mapped_cache_access (px_cache, ui_j, false, ui_n, b_silent, &x_stats);
-         cachesim_set_mapped_cache_access (px_cache, ui_j + 1, false, ui_n, b_silent, &x_stats);
-      }
-      if (false == b_silent)
-      {
-         printf ("%d \nStats:\n"
-            "\t ui_total_accesses         : %d\n"
-            "\t ui_hit_count              : %d\n"
-            "\t ui_miss_count             : %d\n"
-            "\t ui_capacity_miss          : %d\n"
-            "\t ui_compulsory_miss        : %d\n"
-            "\t ui_conflict_miss          : %d\n", ui_i,
-            x_stats.ui_total_accesses, x_stats.ui_hit_count,
-            x_stats.ui_miss_count, x_stats.ui_capacity_miss,
-            x_stats.ui_compulsory_miss, x_stats.ui_conflict_miss);
-
-         printf ("Outer Loop: %d, Diff Miss Count: %d\n", ui_i,
-            x_stats.ui_miss_count - ui_prev_miss_count);
-      }
-      ui_prev_miss_count = x_stats.ui_miss_count;
+      goto CLEAN_RETURN;
    }
-   cache_sim_log_summary (&x_stats);
+   x_first_touch = px_sim->x_stats.x_first_touch;
+   memset (&(px_sim->x_stats), 0x00, sizeof(px_sim->x_stats));
+   px_sim->x_stats.x_first_touch = x_first_touch;
+   memset (&(px_sim->x_trace_stats), 0x00, sizeof(px_sim->x_trace_stats));
+   px_sim->px_cache->ull_sample_skipped = 0;
+   px_prefetch = px_sim->px_cache->px_prefetch;
+   if (NULL != px_prefetch)
+   {
+      px_prefetch->ull_issued = 0;
+      px_prefetch->ull_useful = 0;
+      px_prefetch->ull_late = 0;
+      px_prefetch->ull_useless = 0;
+      px_prefetch->ull_pollution = 0;
+   }
+   /*
+    * Misses in flight stay in flight; only the counters start over.
+    */
+   px_mshr = px_sim->px_cache->px_mshr;
+   if (NULL != px_mshr)
+   {
+      px_mshr->ull_start = px_mshr->ull_now;
+      px_mshr->ull_end = px_mshr->ull_now;
+      px_mshr->ull_busy_until = px_mshr->ull_now;
+      px_mshr->ull_primary_misses = 0;
+      px_mshr->ull_merged_misses = 0;
+      px_mshr->ull_full_stalls = 0;
+      px_mshr->ull_full_stall_cycles = 0;
+      px_mshr->ull_miss_cycles = 0;
+      px_mshr->ull_busy_cycles = 0;
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
 CLEAN_RETURN:
    return e_ret_val;
 }
 
-static CACHESIM_RET_E cachesim_set_mapped_cache_simulate_max_in_matrix (
-   CACHE_SET_X *px_cache,
-   bool b_silent,
-   uint32_t ui_n)
+CACHESIM_RET_E cachesim_start_log (
+   CACHESIM_X *px_sim,
+   const char *pc_event_log_file)
 {
    CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   uint32_t ui_i = 0;
-   uint32_t ui_j = 0;
-   uint32_t ui_k = 0;
-   // uint32_t ui_n = 4096;
-   CACHESIM_SIM_STATS_X x_stats = {0};
 
-   if (NULL == px_cache)
+   if ((NULL == px_sim) || (NULL != px_sim->px_cache->px_event_log))
    {
       goto CLEAN_RETURN;
    }
+   px_sim->px_cache->x_cache_params.pc_event_log_file = pc_event_log_file;
+   e_ret_val = cachesim_event_log_open (px_sim->px_cache);
+CLEAN_RETURN:
+   return e_ret_val;
+}
 
-   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   printf ("+++++++++++++Max In Matrix Simulator++++++++++++\n");
-   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
-   cachesim_print_cache_params (px_cache);
-
-   if (false == b_silent)
-     cachesim_print_log_header (px_cache);
+CACHESIM_RET_E cachesim_stop_log (
+   CACHESIM_X *px_sim)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
 
-#if 0
-   for (ui_i = 0; ui_i < ui_n; ui_i++)
+   if (NULL == px_sim)
    {
-      for (ui_j = 0; ui_j < ui_n; ui_j++)
-      {
-         // usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-      }
+      goto CLEAN_RETURN;
    }
-#endif
+   cachesim_event_log_close (px_sim->px_cache);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
 
-   for (ui_k = 0; ui_k < ui_n / 4; ui_k++)
+void cachesim_print_config (
+   const CACHESIM_X *px_sim)
+{
+   if (NULL == px_sim)
    {
-      for (ui_i = ((ui_k / 2) * (ui_n / 2));
-            ui_i < ((ui_n / 2) + ((ui_k / 2) * (ui_n / 2))); ui_i++)
-      {
-         for (ui_j = ((ui_k % 2) * (ui_n / 2));
-               ui_j < (ui_n / 2) + ((ui_k % 2) * (ui_n / 2)); ui_j++)
-         {
-            usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-            cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j), false,
-               (ui_n * ui_n), b_silent, &x_stats);
-            cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j), false,
-               (ui_n * ui_n), b_silent, &x_stats);
-         }
-      }
+      return;
    }
+   cachesim_print_cache_params (px_sim->px_cache);
+}
 
-#if 0
-   for (ui_i = 0; ui_i < ui_n / 2; ui_i++)
+void cachesim_print_stats (
+   const CACHESIM_X *px_sim)
+{
+   if (NULL == px_sim)
    {
-      for (ui_j = 0; ui_j < ui_n / 2; ui_j++)
-      {
-         // usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-      }
+      return;
    }
+   cache_sim_log_summary (&(px_sim->x_stats));
+   cachesim_set_log_sample_summary (px_sim->px_cache, &(px_sim->x_stats));
+   cachesim_set_log_prefetch_summary (px_sim->px_cache, &(px_sim->x_stats));
+   cachesim_set_log_mshr_summary (px_sim->px_cache, &(px_sim->x_stats));
+}
 
-   for (ui_i = 0; ui_i < ui_n / 2; ui_i++)
+CACHESIM_RET_E cachesim_open_trace (
+   const char *pc_trace_file,
+   CACHESIM_TRACE_X **ppx_trace)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_TRACE_X *px_trace = NULL;
+
+   if ((NULL == pc_trace_file) || (NULL == ppx_trace))
    {
-      for (ui_j = ui_n / 2; ui_j < ui_n; ui_j++)
-      {
-         // usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-      }
+      goto CLEAN_RETURN;
    }
+   *ppx_trace = NULL;
 
-   for (ui_i = ui_n / 2; ui_i < ui_n; ui_i++)
+   px_trace = (CACHESIM_TRACE_X *) calloc (1, sizeof(*px_trace));
+   if (NULL == px_trace)
    {
-      for (ui_j = 0; ui_j < ui_n / 2; ui_j++)
-      {
-         // usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-      }
+      goto CLEAN_RETURN;
    }
-
-   for (ui_i = ui_n / 2; ui_i < ui_n; ui_i++)
+   e_ret_val = cachesim_trace_open (&(px_trace->x_reader), pc_trace_file);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
    {
-      for (ui_j = ui_n / 2; ui_j < ui_n; ui_j++)
-      {
-         // usleep (CACHESIM_PAUSE_TIME_BW_ACCESSES);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-         cachesim_set_mapped_cache_access (px_cache, ((ui_i * ui_n) + ui_j),
-            (ui_n * ui_n), b_silent, &x_stats);
-      }
+      cachesim_trace_close (&(px_trace->x_reader));
+      free (px_trace);
+      goto CLEAN_RETURN;
    }
-#endif
-
-   cache_sim_log_summary (&x_stats);
+   *ppx_trace = px_trace;
 CLEAN_RETURN:
    return e_ret_val;
 }
 
-static void cachesim_simulate_pinning (CACHESIM_CACHE_ARGS_X *px_cache_args)
+CACHESIM_RET_E cachesim_seek_trace (
+   CACHESIM_TRACE_X *px_trace,
+   uint64_t ull_record)
 {
-	CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-	CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
-	CACHE_SET_X    *px_set_cache = NULL;
-	bool b_silent = px_cache_args->b_silent;
-
-	   x_cache_param.ui_associativity = px_cache_args->ui_associativity;
-	   x_cache_param.ui_block_size_words = px_cache_args->ui_block_size_words;
-	   x_cache_param.ui_cache_size_words = px_cache_args->ui_cache_size_words;
-	   x_cache_param.ui_word_size_bytes = px_cache_args->ui_word_size_bytes;
-	   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   e_ret_val = cachesim_set_mapped_cache_simulate_pinning (px_set_cache, false, b_silent,
-			   px_cache_args->ui_loop_iterations);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   e_ret_val = cachesim_set_free_cache (px_set_cache);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   if (true == px_cache_args->b_simulate_pinning)
-	   {
-		   x_cache_param.ui_associativity = px_cache_args->ui_associativity;
-		   x_cache_param.ui_block_size_words = px_cache_args->ui_block_size_words;
-		   x_cache_param.ui_cache_size_words = px_cache_args->ui_cache_size_words;
-		   x_cache_param.ui_word_size_bytes = px_cache_args->ui_word_size_bytes;
-		   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
-		   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-		   {
-
-		   }
-
-		   e_ret_val = cachesim_set_mapped_cache_simulate_pinning (px_set_cache, true, b_silent,
-				   px_cache_args->ui_loop_iterations);
-		   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-		   {
-
-		   }
-
-		   e_ret_val = cachesim_set_free_cache (px_set_cache);
-		   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-		   {
-
-		   }
-	   }
-}
-
-static void cachesim_get_opts_from_args (int argc, char **argv,
-		CACHESIM_CACHE_ARGS_X *px_cache_args)
-{
-	uint32_t ui_opts_idx = 0;
-	uint32_t ui_opts_count = 0;
-	   int             c;
-	   const char    * short_opt = "ha:b:c:w:s:p:l:";
-	   struct option   long_opt[] =
-	   {
-	      {"help",          no_argument,       NULL, 'h'},
-	      {"associativity",          required_argument, NULL, 'a'},
-		  {"block-size",          required_argument, NULL, 'b'},
-		  {"cache-size",          required_argument, NULL, 'c'},
-		  {"word-size",          required_argument, NULL, 'w'},
-		  {"simulate-algorithm",          required_argument, NULL, 's'},
-		  {"simulate-pinning",          required_argument, NULL, 'p'},
-		  {"silent",          required_argument, NULL, 'l'},
-		  {"loop-iterations",          required_argument, NULL, 'i'},
-	      {NULL,            0,                 NULL, 0  }
-	   };
-	   const char *long_opt_description[] =
-	   {
-			   "Print this help and exit.",
-			   "(default=2) Associativity",
-			   "(default=8) Block Size",
-			   "(default=64) Cache Size",
-			   "(default=4) Word Size",
-			   "(default=general)Simulation Algorithm - general|bubble-sort|max-in-matrix",
-			   "(default=false) Simulate Pinning (works only with general simulation algorithm",
-			   "(defatul=true) Log each memory access and cache details as one line",
-			   "(default=1) Number iterations of the general simulation"
-	   };
-	   ui_opts_count = sizeof(long_opt) / sizeof (struct option);
-	while ((c = getopt_long(argc, argv, short_opt, long_opt, NULL)) != -1) {
-		switch (c) {
-		case -1: /* no more arguments */
-		case 0: /* long options toggles */
-			break;
-
-		case 'h':
-			printf("Usage: %s [OPTIONS]\n", argv[0]);
-			for (ui_opts_idx = 0; ui_opts_idx < ui_opts_count; ui_opts_idx++)
-			{
-				if (NULL == long_opt[ui_opts_idx].name)
-				{
-					break;
-				}
-				char temp[20] = {0};
-				strcat(temp, "--");
-				strcat(temp, long_opt[ui_opts_idx].name);
-
-				printf("  -%c %-20s (OR %22s=%-20s) - %s\n",
-						long_opt[ui_opts_idx].val,
-						long_opt[ui_opts_idx].name,
-						temp,
-						long_opt[ui_opts_idx].name,
-						long_opt_description[ui_opts_idx]);
-			}
-			printf("\n");
-			exit (0);
-			break;
-		case 'a':
-			printf("you entered \"%s\"\n", optarg);
-			px_cache_args->ui_associativity = atoi(optarg);
-			break;
-		case 'b':
-			printf("you entered \"%s\"\n", optarg);
-			px_cache_args->ui_block_size_words = atoi(optarg);
-			break;
-		case 'c':
-			printf("you entered \"%s\"\n", optarg);
-			px_cache_args->ui_cache_size_words = atoi(optarg);
-			break;
-		case 'w':
-			printf("you entered \"%s\"\n", optarg);
-			px_cache_args->ui_word_size_bytes = atoi(optarg);
-			break;
-		case 's':
-			printf("you entered \"%s\"\n", optarg);
-			if (0 == strcmp(optarg, "general")) {
-				px_cache_args->e_algorithm =
-						eCACHESIM_SIMULATION_ALGORITHM_GENERAL;
-			} else if (0 == strcmp(optarg, "bubble-sort")) {
-				px_cache_args->e_algorithm =
-						eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT;
-			} else if (0 == strcmp(optarg, "max-in-matrix")) {
-				px_cache_args->e_algorithm =
-						eCACHESIM_SIMULATION_ALGORITHM_MAX_IN_MATRIX;
-			} else {
-				px_cache_args->e_algorithm =
-						eCACHESIM_SIMULATION_ALGORITHM_GENERAL;
-			}
-			break;
-		case 'p':
-			printf("you entered \"%s\"\n", optarg);
-			if (0 == strcmp(optarg, "true")) {
-							px_cache_args->b_simulate_pinning =
-									true;
-						} else {
-							px_cache_args->b_simulate_pinning =
-									false;
-						}
-			break;
-		case 'l':
-			if (0 == strcmp(optarg, "false")) {
-										px_cache_args->b_silent =
-												false;
-									} else {
-										px_cache_args->b_silent =
-												true;
-									}
-			break;
-		case 'i':
-			printf("you entered \"%s\"\n", optarg);
-						px_cache_args->ui_loop_iterations = atoi(optarg);
-						break;
-			break;
-		default:
-			fprintf(stderr, "%s: invalid option -- %c\n", argv[0], c);
-			fprintf(stderr, "Try `%s --help' for more information.\n", argv[0]);
-		};
-	};
-
-	printf("Usage: %s [OPTIONS]\n", argv[0]);
-	for (ui_opts_idx = 0; ui_opts_idx < ui_opts_count; ui_opts_idx++)
-	{
-		if (NULL == long_opt[ui_opts_idx].name)
-		{
-			break;
-		}
-		char temp[20] = {0};
-		strcat(temp, "--");
-		strcat(temp, long_opt[ui_opts_idx].name);
-
-		printf("  -%c %-20s (OR %22s=%-20s) - %s\n",
-				long_opt[ui_opts_idx].val,
-				long_opt[ui_opts_idx].name,
-				temp,
-				long_opt[ui_opts_idx].name,
-				long_opt_description[ui_opts_idx]);
-	}
-	printf("\n");
-
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
 
-	if (0 == px_cache_args->ui_associativity)
-		px_cache_args->ui_associativity = 2;
-	if (0 == px_cache_args->ui_block_size_words)
-		px_cache_args->ui_block_size_words = 8;
-	if (0 == px_cache_args->ui_cache_size_words)
-		px_cache_args->ui_cache_size_words = 64;
-	if (0 == px_cache_args->ui_word_size_bytes)
-		px_cache_args->ui_word_size_bytes = sizeof(uint32_t);
-	if (eCACHESIM_SIMULATION_ALGORITHM_INVALID == px_cache_args->e_algorithm)
-		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_GENERAL;
-	if (0 == px_cache_args->ui_loop_iterations)
-			px_cache_args->ui_loop_iterations = 1;
+   if (NULL == px_trace)
+   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = cachesim_trace_seek (&(px_trace->x_reader), ull_record);
+CLEAN_RETURN:
+   return e_ret_val;
 }
 
-int main (int argc, char **argv)
+CACHESIM_RET_E cachesim_read_trace (
+   CACHESIM_TRACE_X *px_trace,
+   CACHESIM_RECORD_X *px_records,
+   uint64_t ull_max_records,
+   uint64_t *pull_records)
 {
-   int i_ret_val = -1;
    CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
-   CACHESIM_CACHE_PARAMS_X x_cache_param = {0};
-   CACHESIM_CACHE_ARGS_X x_cache_args = {0};
-   CACHE_SET_X    *px_set_cache = NULL;
-   bool b_silent = true;
+   CACHESIM_TRACE_RECORD_X x_record = {0};
+   uint64_t ull_no_of_records = 0;
+   bool b_end_of_trace = false;
 
-   cachesim_get_opts_from_args (argc, argv, &x_cache_args);
-
-   b_silent = x_cache_args.b_silent;
-
-   switch (x_cache_args.e_algorithm)
+   if ((NULL == px_trace) || (NULL == pull_records)
+      || ((NULL == px_records) && (0 != ull_max_records)))
    {
-   case eCACHESIM_SIMULATION_ALGORITHM_GENERAL:
-	   cachesim_simulate_pinning (&x_cache_args);
-	   break;
-   case eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT:
-#if 0
-	   x_cache_param.ui_associativity = 1;
-	   x_cache_param.ui_block_size_words = 16;
-	   x_cache_param.ui_cache_size_words = (16 * 64);
-	   x_cache_param.ui_word_size_bytes = sizeof(uint32_t);
-#endif
-	   x_cache_param.ui_associativity = x_cache_args.ui_associativity;
-	   	   x_cache_param.ui_block_size_words = x_cache_args.ui_block_size_words;
-	   	   x_cache_param.ui_cache_size_words = x_cache_args.ui_cache_size_words;
-	   	   x_cache_param.ui_word_size_bytes = x_cache_args.ui_word_size_bytes;
-	   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   e_ret_val = cachesim_set_mapped_cache_simulate_bubble_sort (px_set_cache,
-			   b_silent, 128);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   e_ret_val = cachesim_set_free_cache (px_set_cache);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-   	   break;
-   case eCACHESIM_SIMULATION_ALGORITHM_MAX_IN_MATRIX:
-#if 0
-	   x_cache_param.ui_associativity = 1;
-	   x_cache_param.ui_block_size_words = 8;
-	   x_cache_param.ui_cache_size_words = (16 * 8);
-	   x_cache_param.ui_word_size_bytes = sizeof(uint32_t);
-#endif
-	   x_cache_param.ui_associativity = x_cache_args.ui_associativity;
-	   	   	   x_cache_param.ui_block_size_words = x_cache_args.ui_block_size_words;
-	   	   	   x_cache_param.ui_cache_size_words = x_cache_args.ui_cache_size_words;
-	   	   	   x_cache_param.ui_word_size_bytes = x_cache_args.ui_word_size_bytes;
-	   e_ret_val = cachesim_set_alloc_cache (&px_set_cache, &x_cache_param);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   e_ret_val = cachesim_set_mapped_cache_simulate_max_in_matrix (px_set_cache,
-			   b_silent, 16);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
-
-	   }
-
-	   e_ret_val = cachesim_set_free_cache (px_set_cache);
-	   if (eCACHESIM_RET_SUCCESS != e_ret_val)
-	   {
+      goto CLEAN_RETURN;
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+   for (; ull_no_of_records < ull_max_records; ull_no_of_records++)
+   {
+      e_ret_val = cachesim_trace_read_record (&(px_trace->x_reader), &x_record,
+         &b_end_of_trace);
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (true == b_end_of_trace))
+      {
+         break;
+      }
+      px_records [ull_no_of_records].ull_address = x_record.ull_address;
+      px_records [ull_no_of_records].ui_size_bytes = x_record.ui_size_bytes;
+      px_records [ull_no_of_records].e_type = x_record.e_type;
+   }
+   *pull_records = ull_no_of_records;
+CLEAN_RETURN:
+   return e_ret_val;
+}
 
-	   }
-   	   break;
+CACHESIM_RET_E cachesim_close_trace (
+   CACHESIM_TRACE_X *px_trace)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
 
+   if (NULL == px_trace)
+   {
+      goto CLEAN_RETURN;
    }
-   return i_ret_val;
+   cachesim_trace_close (&(px_trace->x_reader));
+   free (px_trace);
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
 }
@@ -0,0 +1,767 @@
+/*******************************************************************************
+ * Copyright (c) 2013, Sandeep Prakash <123sandy@gmail.com>
+ * All rights reserved.
+ *
+ * \file   main.c
+ * \author sandeepprakash
+ *
+ * \date   Feb 4, 2013
+ *
+ * \brief  The ch-ca-cache-simulator program: its command line, and the
+ *         trace replay on the libcachesim interface. The other simulation
+ *         modes run on the engine through cachesim-cli.h.
+ *
+ ******************************************************************************/
+
+/********************************** INCLUDES **********************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "cachesim.h"
+#include "cachesim-cli.h"
+
+/********************************* CONSTANTS **********************************/
+
+/*********************************** MACROS ***********************************/
+#define CACHESIM_REPLAY_BATCH_RECORDS                    (1024)
+
+/****************************** LOCAL FUNCTIONS *******************************/
+/*
+ * Parses a comma separated list of up to CACHESIM_MAX_CACHE_LEVELS cycle
+ * counts.
+ */
+static CACHESIM_RET_E cachesim_latency_parse_list (
+   const char *pc_list,
+   uint32_t *pui_values,
+   uint32_t *pui_count)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   const char *pc_pos = pc_list;
+   char *pc_end = NULL;
+   unsigned long ul_value = 0;
+
+   *pui_count = 0;
+   while (1)
+   {
+      ul_value = strtoul (pc_pos, &pc_end, 0);
+      if ((pc_end == pc_pos) || (ul_value > UINT32_MAX)
+         || (*pui_count >= CACHESIM_MAX_CACHE_LEVELS))
+      {
+         goto CLEAN_RETURN;
+      }
+      pui_values [(*pui_count)++] = (uint32_t) ul_value;
+      pc_pos = pc_end;
+      if ('\0' == *pc_pos)
+      {
+         break;
+      }
+      if (',' != *pc_pos++)
+      {
+         goto CLEAN_RETURN;
+      }
+   }
+   e_ret_val = eCACHESIM_RET_SUCCESS;
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+static void cachesim_get_opts_from_args (int argc, char **argv,
+		CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+	uint32_t ui_opts_idx = 0;
+	uint32_t ui_opts_count = 0;
+	unsigned long ul_value = 0;
+	char *pc_end = NULL;
+	CACHESIM_CONFIG_X x_defaults = {0};
+	   int             c;
+	   const char    * short_opt = "ha:b:c:w:s:p:l:i:t:g:m:r:x:j:y:L:n:W:A:C:f:e:d:R:S:N:P:F:D:T:B:k:o:O:E:K:J:I:u:U:G:H:M:Q:V:X:";
+	   struct option   long_opt[] =
+	   {
+	      {"help",          no_argument,       NULL, 'h'},
+	      {"associativity",          required_argument, NULL, 'a'},
+		  {"block-size",          required_argument, NULL, 'b'},
+		  {"cache-size",          required_argument, NULL, 'c'},
+		  {"word-size",          required_argument, NULL, 'w'},
+		  {"simulate-algorithm",          required_argument, NULL, 's'},
+		  {"simulate-pinning",          required_argument, NULL, 'p'},
+		  {"silent",          required_argument, NULL, 'l'},
+		  {"loop-iterations",          required_argument, NULL, 'i'},
+		  {"trace",          required_argument, NULL, 't'},
+		  {"huge-pages",          required_argument, NULL, 'g'},
+		  {"classify-misses",          required_argument, NULL, 'm'},
+		  {"replacement",          required_argument, NULL, 'r'},
+		  {"sweep",          required_argument, NULL, 'x'},
+		  {"threads",          required_argument, NULL, 'j'},
+		  {"mrc",          required_argument, NULL, 'y'},
+		  {"levels",          required_argument, NULL, 'L'},
+		  {"inclusion",          required_argument, NULL, 'n'},
+		  {"write-policy",          required_argument, NULL, 'W'},
+		  {"write-allocate",          required_argument, NULL, 'A'},
+		  {"convert",          required_argument, NULL, 'C'},
+		  {"fast-forward",          required_argument, NULL, 'f'},
+		  {"event-log",          required_argument, NULL, 'e'},
+		  {"demo",          required_argument, NULL, 'd'},
+		  {"render-events",          required_argument, NULL, 'R'},
+		  {"sample-sets",          required_argument, NULL, 'S'},
+		  {"cores",          required_argument, NULL, 'N'},
+		  {"coherence",          required_argument, NULL, 'P'},
+		  {"prefetcher",          required_argument, NULL, 'F'},
+		  {"prefetch-degree",          required_argument, NULL, 'D'},
+		  {"prefetch-latency",          required_argument, NULL, 'T'},
+		  {"address-bits",          required_argument, NULL, 'B'},
+		  {"bench",          required_argument, NULL, 'k'},
+		  {"heatmap",          required_argument, NULL, 'o'},
+		  {"heatmap-blocks",          required_argument, NULL, 'O'},
+		  {"heatmap-format",          required_argument, NULL, 'E'},
+		  {"checkpoint",          required_argument, NULL, 'K'},
+		  {"restore",          required_argument, NULL, 'J'},
+		  {"max-records",          required_argument, NULL, 'I'},
+		  {"warmup",          required_argument, NULL, 'u'},
+		  {"roi-markers",          required_argument, NULL, 'U'},
+		  {"hit-latency",          required_argument, NULL, 'G'},
+		  {"miss-penalty",          required_argument, NULL, 'H'},
+		  {"memory-latency",          required_argument, NULL, 'M'},
+		  {"mshrs",          required_argument, NULL, 'Q'},
+		  {"issue-rate",          required_argument, NULL, 'V'},
+		  {"workload",          required_argument, NULL, 'X'},
+	      {NULL,            0,                 NULL, 0  }
+	   };
+	   const char *long_opt_description[] =
+	   {
+			   "Print this help and exit.",
+			   "(default=2) Associativity",
+			   "(default=8) Block Size",
+			   "(default=64) Cache Size",
+			   "(default=4) Word Size",
+			   "(default=general)Simulation Algorithm - general|bubble-sort|max-in-matrix",
+			   "(default=false) Simulate Pinning (works only with general simulation algorithm",
+			   "(defatul=true) Log each memory access and cache details as one line",
+			   "(default=1) Number iterations of the general simulation",
+			   "Simulate the accesses in a trace file (\"-\" for stdin) instead of an algorithm",
+			   "(default=false) Back the cache metadata with huge pages",
+			   "(default=true) Split misses into capacity and conflict misses with a fully associative shadow cache",
+			   "(default=fifo) Replacement policy - fifo|lru|plru|srrip|brrip|random|lfu",
+			   "(default=false) Replay the trace for every combination of -a, -b and -c, each a list like 2,4 or a range like 1-16",
+			   "(default=0) Sweep worker threads, 0 for one per online CPU",
+			   "(default=false) Print LRU miss ratio curves of the trace for the -b block sizes and -a associativities (default 1-16)",
+			   "Replay the trace through a cache hierarchy, e.g. 512:2:8,8192:8:8 (<cache words>:<associativity>:<block words> per level, innermost first)",
+			   "(default=inclusive) Inclusion policy of the hierarchy - inclusive|exclusive|nine",
+			   "(default=write-back) Write hit policy - write-back|write-through",
+			   "(default=true) Fetch the block on a write miss",
+			   "Write the trace to this file in the binary format instead of simulating it",
+			   "(default=0) Trace records to skip before simulating",
+			   "Log the accesses to this file in the binary event log format instead of printing the table (implies -l false)",
+			   "(default=0) Microseconds to pause between the accesses of the built-in algorithms, to watch the log grow",
+			   "Print the table view of an event log written with --event-log and exit",
+			   "(default=1) Simulate only about 1 in this many sets and report estimates for the whole cache",
+			   "Replay the trace on this many cores, each with a private cache of the -c/-a/-b geometry kept coherent by snooping (records are \"<core>: <type> <address> [<size>]\")",
+			   "(default=mesi) Coherence protocol of --cores - mesi|moesi",
+			   "(default=none) Hardware prefetcher - none|next-line|ip-stride|stream",
+			   "(default=2) Blocks each prefetcher trigger fetches ahead",
+			   "(default=16) Accesses a prefetch takes to arrive; a block used sooner counts as a late prefetch",
+			   "(default=64) Width of the trace byte addresses; accesses beyond it are skipped",
+			   "Time the cache engine on synthetic access streams over a matrix of geometries (with the -b, -w, -r and other engine options) and write the results as CSV to this file (\"-\" for stdout)",
+			   "Write the hits, misses and evictions of every set to this file at the end of the run",
+			   "Write the misses of every block that missed to this file at the end of the run",
+			   "(default=csv) Format of the heatmap files - csv|json",
+			   "Write the state of the cache (tags, replacement state and statistics) to this file at the end of the trace run",
+			   "Start the trace run from the state in this checkpoint file, resuming the trace after the records it had consumed",
+			   "(default=0) Stop reading the trace after this many records, 0 for the whole trace",
+			   "(default=0) Trace records after the fast-forward that only warm the cache up, without being counted",
+			   "(default=false) Measure only the trace records between roi-begin and roi-end lines and warm the cache up with the others",
+			   "(default=4,12,40,...) Cycles of a lookup, one value per level (innermost first) with --levels",
+			   "(default=0) Cycles a miss adds on top of the latency of the level below, one value per level",
+			   "(default=200) Cycles of an access to memory",
+			   "(default=0) Time the cache as non-blocking, with this many miss status holding registers, and report the memory-level parallelism; 0 for blocking",
+			   "(default=1) Accesses the core issues per cycle with --mshrs",
+			   "Simulate a synthetic workload: streams like zipfian:footprint=4G,theta=0.9 (sequential|strided|uniform|zipfian|pointer-chase) and settings like accesses=100M, separated by ';', or @<file> with one per line"
+	   };
+	   ui_opts_count = sizeof(long_opt) / sizeof (struct option);
+	cachesim_config_init (&x_defaults);
+	px_cache_args->ui_prefetch_latency = x_defaults.ui_prefetch_latency;
+	px_cache_args->ui_memory_latency = x_defaults.ui_memory_latency;
+	while ((c = getopt_long(argc, argv, short_opt, long_opt, NULL)) != -1) {
+		switch (c) {
+		case -1: /* no more arguments */
+		case 0: /* long options toggles */
+			break;
+
+		case 'h':
+			printf("Usage: %s [OPTIONS]\n", argv[0]);
+			for (ui_opts_idx = 0; ui_opts_idx < ui_opts_count; ui_opts_idx++)
+			{
+				if (NULL == long_opt[ui_opts_idx].name)
+				{
+					break;
+				}
+				char temp[64] = {0};
+				strcat(temp, "--");
+				strcat(temp, long_opt[ui_opts_idx].name);
+
+				printf("  -%c %-20s (OR %22s=%-20s) - %s\n",
+						long_opt[ui_opts_idx].val,
+						long_opt[ui_opts_idx].name,
+						temp,
+						long_opt[ui_opts_idx].name,
+						long_opt_description[ui_opts_idx]);
+			}
+			printf("\n");
+			exit (0);
+			break;
+		case 'a':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_associativity = atoi(optarg);
+			px_cache_args->pc_associativity_list = optarg;
+			break;
+		case 'b':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_block_size_words = atoi(optarg);
+			px_cache_args->pc_block_size_list = optarg;
+			break;
+		case 'c':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_cache_size_words = atoi(optarg);
+			px_cache_args->pc_cache_size_list = optarg;
+			break;
+		case 'w':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_word_size_bytes = atoi(optarg);
+			break;
+		case 's':
+			printf("you entered \"%s\"\n", optarg);
+			if (0 == strcmp(optarg, "general")) {
+				px_cache_args->e_algorithm =
+						eCACHESIM_SIMULATION_ALGORITHM_GENERAL;
+			} else if (0 == strcmp(optarg, "bubble-sort")) {
+				px_cache_args->e_algorithm =
+						eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT;
+			} else if (0 == strcmp(optarg, "max-in-matrix")) {
+				px_cache_args->e_algorithm =
+						eCACHESIM_SIMULATION_ALGORITHM_MAX_IN_MATRIX;
+			} else {
+				px_cache_args->e_algorithm =
+						eCACHESIM_SIMULATION_ALGORITHM_GENERAL;
+			}
+			break;
+		case 'p':
+			printf("you entered \"%s\"\n", optarg);
+			if (0 == strcmp(optarg, "true")) {
+							px_cache_args->b_simulate_pinning =
+									true;
+						} else {
+							px_cache_args->b_simulate_pinning =
+									false;
+						}
+			break;
+		case 'l':
+			if (0 == strcmp(optarg, "false")) {
+										px_cache_args->b_silent =
+												false;
+									} else {
+										px_cache_args->b_silent =
+												true;
+									}
+			break;
+		case 'i':
+			printf("you entered \"%s\"\n", optarg);
+						px_cache_args->ui_loop_iterations = atoi(optarg);
+						break;
+			break;
+		case 't':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_trace_file = optarg;
+			break;
+		case 'g':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->b_huge_pages = (0 == strcmp(optarg, "true"));
+			break;
+		case 'm':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->b_no_miss_classification = (0 == strcmp(optarg, "false"));
+			break;
+		case 'r':
+			printf("you entered \"%s\"\n", optarg);
+			if (eCACHESIM_RET_SUCCESS != cachesim_replacement_policy_from_name (optarg,
+					&(px_cache_args->e_replacement_policy))) {
+				fprintf(stderr, "%s: unknown replacement policy -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'x':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->b_sweep = (0 == strcmp(optarg, "true"));
+			break;
+		case 'j':
+			printf("you entered \"%s\"\n", optarg);
+			ul_value = strtoul(optarg, &pc_end, 0);
+			if ((pc_end == optarg) || ('\0' != *pc_end) || (ul_value > UINT32_MAX)) {
+				fprintf(stderr, "%s: invalid thread count -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			px_cache_args->ui_threads = (uint32_t) ul_value;
+			break;
+		case 'y':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->b_mrc = (0 == strcmp(optarg, "true"));
+			break;
+		case 'L':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_levels = optarg;
+			break;
+		case 'n':
+			printf("you entered \"%s\"\n", optarg);
+			if (0 == strcmp(optarg, "inclusive")) {
+				px_cache_args->e_inclusion = eCACHESIM_INCLUSION_POLICY_INCLUSIVE;
+			} else if (0 == strcmp(optarg, "exclusive")) {
+				px_cache_args->e_inclusion = eCACHESIM_INCLUSION_POLICY_EXCLUSIVE;
+			} else if (0 == strcmp(optarg, "nine")) {
+				px_cache_args->e_inclusion = eCACHESIM_INCLUSION_POLICY_NINE;
+			} else {
+				fprintf(stderr, "%s: unknown inclusion policy -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'W':
+			printf("you entered \"%s\"\n", optarg);
+			if (0 == strcmp(optarg, "write-back")) {
+				px_cache_args->e_write_policy = eCACHESIM_WRITE_POLICY_WRITE_BACK;
+			} else if (0 == strcmp(optarg, "write-through")) {
+				px_cache_args->e_write_policy = eCACHESIM_WRITE_POLICY_WRITE_THROUGH;
+			} else {
+				fprintf(stderr, "%s: unknown write policy -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'A':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->b_no_write_allocate = (0 == strcmp(optarg, "false"));
+			break;
+		case 'C':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_convert_file = optarg;
+			break;
+		case 'f':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ull_fast_forward = strtoull(optarg, NULL, 10);
+			break;
+		case 'e':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_event_log_file = optarg;
+			break;
+		case 'd':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_demo_pause_us = atoi(optarg);
+			break;
+		case 'R':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_render_file = optarg;
+			break;
+		case 'S':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_sample_sets = atoi(optarg);
+			break;
+		case 'N':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_cores = atoi(optarg);
+			break;
+		case 'P':
+			printf("you entered \"%s\"\n", optarg);
+			if (0 == strcmp(optarg, "mesi")) {
+				px_cache_args->e_coherence = eCACHESIM_COHERENCE_PROTOCOL_MESI;
+			} else if (0 == strcmp(optarg, "moesi")) {
+				px_cache_args->e_coherence = eCACHESIM_COHERENCE_PROTOCOL_MOESI;
+			} else {
+				fprintf(stderr, "%s: unknown coherence protocol -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'F':
+			printf("you entered \"%s\"\n", optarg);
+			if (eCACHESIM_RET_SUCCESS != cachesim_prefetcher_from_name (optarg,
+					&(px_cache_args->e_prefetcher))) {
+				fprintf(stderr, "%s: unknown prefetcher -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'D':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_prefetch_degree = atoi(optarg);
+			break;
+		case 'T':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_prefetch_latency = atoi(optarg);
+			break;
+		case 'B':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_address_bits = atoi(optarg);
+			if ((px_cache_args->ui_address_bits < 1)
+					|| (px_cache_args->ui_address_bits > 64)) {
+				fprintf(stderr, "%s: address bits must be 1-64 -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'k':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_bench_file = optarg;
+			break;
+		case 'o':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_heatmap_file = optarg;
+			break;
+		case 'O':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_heatmap_blocks_file = optarg;
+			break;
+		case 'E':
+			printf("you entered \"%s\"\n", optarg);
+			if (0 == strcmp(optarg, "csv")) {
+				px_cache_args->e_heatmap_format = eCACHESIM_HEATMAP_FORMAT_CSV;
+			} else if (0 == strcmp(optarg, "json")) {
+				px_cache_args->e_heatmap_format = eCACHESIM_HEATMAP_FORMAT_JSON;
+			} else {
+				fprintf(stderr, "%s: unknown heatmap format -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'K':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_checkpoint_file = optarg;
+			break;
+		case 'J':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_restore_file = optarg;
+			break;
+		case 'I':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ull_max_records = strtoull(optarg, NULL, 10);
+			break;
+		case 'u':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ull_warmup = strtoull(optarg, NULL, 10);
+			break;
+		case 'U':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->b_roi_markers = (0 == strcmp(optarg, "true"));
+			break;
+		case 'G':
+			printf("you entered \"%s\"\n", optarg);
+			if (eCACHESIM_RET_SUCCESS != cachesim_latency_parse_list (optarg,
+					px_cache_args->uia_hit_latency,
+					&(px_cache_args->ui_no_of_hit_latencies))) {
+				fprintf(stderr, "%s: invalid hit latencies -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'H':
+			printf("you entered \"%s\"\n", optarg);
+			if (eCACHESIM_RET_SUCCESS != cachesim_latency_parse_list (optarg,
+					px_cache_args->uia_miss_penalty,
+					&(px_cache_args->ui_no_of_miss_penalties))) {
+				fprintf(stderr, "%s: invalid miss penalties -- %s\n", argv[0], optarg);
+				exit (1);
+			}
+			break;
+		case 'M':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_memory_latency = atoi(optarg);
+			break;
+		case 'Q':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_mshrs = atoi(optarg);
+			if (px_cache_args->ui_mshrs > CACHESIM_MAX_MSHRS) {
+				fprintf(stderr, "%s: at most %u MSHRs -- %s\n", argv[0],
+						CACHESIM_MAX_MSHRS, optarg);
+				exit (1);
+			}
+			break;
+		case 'V':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->ui_issue_rate = atoi(optarg);
+			break;
+		case 'X':
+			printf("you entered \"%s\"\n", optarg);
+			px_cache_args->pc_workload = optarg;
+			break;
+		default:
+			fprintf(stderr, "%s: invalid option -- %c\n", argv[0], c);
+			fprintf(stderr, "Try `%s --help' for more information.\n", argv[0]);
+		};
+	};
+
+	printf("Usage: %s [OPTIONS]\n", argv[0]);
+	for (ui_opts_idx = 0; ui_opts_idx < ui_opts_count; ui_opts_idx++)
+	{
+		if (NULL == long_opt[ui_opts_idx].name)
+		{
+			break;
+		}
+		char temp[64] = {0};
+		strcat(temp, "--");
+		strcat(temp, long_opt[ui_opts_idx].name);
+
+		printf("  -%c %-20s (OR %22s=%-20s) - %s\n",
+				long_opt[ui_opts_idx].val,
+				long_opt[ui_opts_idx].name,
+				temp,
+				long_opt[ui_opts_idx].name,
+				long_opt_description[ui_opts_idx]);
+	}
+	printf("\n");
+
+
+	if (0 == px_cache_args->ui_associativity)
+		px_cache_args->ui_associativity = 2;
+	if (0 == px_cache_args->ui_block_size_words)
+		px_cache_args->ui_block_size_words = 8;
+	if (0 == px_cache_args->ui_cache_size_words)
+		px_cache_args->ui_cache_size_words = 64;
+	if (0 == px_cache_args->ui_word_size_bytes)
+		px_cache_args->ui_word_size_bytes = sizeof(uint32_t);
+	if (0 == px_cache_args->ui_prefetch_degree)
+		px_cache_args->ui_prefetch_degree = x_defaults.ui_prefetch_degree;
+	if (0 == px_cache_args->ui_address_bits)
+		px_cache_args->ui_address_bits = x_defaults.ui_address_bits;
+	if (0 == px_cache_args->ui_issue_rate)
+		px_cache_args->ui_issue_rate = x_defaults.ui_issue_rate;
+	if ((NULL != px_cache_args->pc_trace_file)
+			&& (NULL != px_cache_args->pc_workload)) {
+		fprintf(stderr, "%s: --workload is not supported with --trace\n",
+				argv[0]);
+		exit (1);
+	}
+	if (NULL != px_cache_args->pc_trace_file)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_TRACE;
+	if (NULL != px_cache_args->pc_workload)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_WORKLOAD;
+	if (true == px_cache_args->b_sweep)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_SWEEP;
+	if (true == px_cache_args->b_mrc)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_MRC;
+	if (NULL != px_cache_args->pc_levels)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_HIERARCHY;
+	if (0 != px_cache_args->ui_cores)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_MULTICORE;
+	if (NULL != px_cache_args->pc_convert_file)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_CONVERT;
+	if (NULL != px_cache_args->pc_render_file)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_RENDER;
+	if (NULL != px_cache_args->pc_bench_file)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_BENCH;
+	if (NULL != px_cache_args->pc_event_log_file)
+		px_cache_args->b_silent = false;
+	if (eCACHESIM_SIMULATION_ALGORITHM_INVALID == px_cache_args->e_algorithm)
+		px_cache_args->e_algorithm = eCACHESIM_SIMULATION_ALGORITHM_GENERAL;
+	if (0 == px_cache_args->ui_loop_iterations)
+			px_cache_args->ui_loop_iterations = 1;
+}
+
+/*
+ * Whether the trace run can go through the library interface. Checkpoints,
+ * heatmaps, warm-up and regions of interest are only in the trace mode of
+ * the engine.
+ */
+static bool cachesim_replay_on_library (
+   const CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   return ((NULL == px_cache_args->pc_checkpoint_file)
+      && (NULL == px_cache_args->pc_restore_file)
+      && (NULL == px_cache_args->pc_heatmap_file)
+      && (NULL == px_cache_args->pc_heatmap_blocks_file)
+      && (0 == px_cache_args->ull_warmup)
+      && (false == px_cache_args->b_roi_markers));
+}
+
+static CACHESIM_RET_E cachesim_replay_trace_records (
+   CACHESIM_X *px_sim,
+   CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_STATS_X x_stats = {0};
+   CACHESIM_TRACE_X *px_trace = NULL;
+   CACHESIM_RECORD_X xa_records [CACHESIM_REPLAY_BATCH_RECORDS];
+   uint64_t ull_max_records = px_cache_args->ull_max_records;
+   uint64_t ull_records_read = 0;
+   uint64_t ull_batch_records = 0;
+   uint64_t ull_no_of_records = 0;
+   clock_t x_start = 0;
+   double d_elapsed = 0.0;
+
+   e_ret_val = cachesim_open_trace (px_cache_args->pc_trace_file, &px_trace);
+   if (eCACHESIM_RET_SUCCESS == e_ret_val)
+   {
+      e_ret_val = cachesim_seek_trace (px_trace,
+         px_cache_args->ull_fast_forward);
+   }
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      goto CLEAN_RETURN;
+   }
+
+   printf ("\n\n++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   printf ("++++++++++++++++Trace Simulator+++++++++++++++++\n");
+   printf ("++++++++++++++++++++++++++++++++++++++++++++++++\n");
+   cachesim_print_config (px_sim);
+
+   if (false == px_cache_args->b_silent)
+   {
+      e_ret_val = cachesim_start_log (px_sim, px_cache_args->pc_event_log_file);
+      if (eCACHESIM_RET_SUCCESS != e_ret_val)
+      {
+         goto CLEAN_RETURN;
+      }
+   }
+
+   x_start = clock ();
+   while ((0 == ull_max_records) || (ull_records_read < ull_max_records))
+   {
+      ull_batch_records = CACHESIM_REPLAY_BATCH_RECORDS;
+      if ((0 != ull_max_records)
+         && ((ull_max_records - ull_records_read) < ull_batch_records))
+      {
+         ull_batch_records = ull_max_records - ull_records_read;
+      }
+      /*
+       * The records read before a malformed one are still simulated.
+       */
+      e_ret_val = cachesim_read_trace (px_trace, xa_records, ull_batch_records,
+         &ull_no_of_records);
+      if (eCACHESIM_RET_SUCCESS != cachesim_access_batch (px_sim, xa_records,
+         ull_no_of_records))
+      {
+         e_ret_val = eCACHESIM_RET_FAILURE;
+      }
+      ull_records_read += ull_no_of_records;
+      if ((eCACHESIM_RET_SUCCESS != e_ret_val) || (0 == ull_no_of_records))
+      {
+         break;
+      }
+   }
+   d_elapsed = (double) (clock () - x_start) / CLOCKS_PER_SEC;
+   (void) cachesim_stop_log (px_sim);
+
+   (void) cachesim_get_stats (px_sim, &x_stats);
+   printf ("Trace:\n"
+      "\t ull_records               : %" PRIu64 "\n"
+      "\t ull_reads                 : %" PRIu64 "\n"
+      "\t ull_writes                : %" PRIu64 "\n"
+      "\t ull_skipped               : %" PRIu64 "\n",
+      x_stats.ull_records, x_stats.ull_read_records,
+      x_stats.ull_write_records, x_stats.ull_skipped_records);
+   if (d_elapsed > 0.0)
+   {
+      printf ("\t\t d_accesses_per_sec       : %f\n",
+         (double) (x_stats.ull_accesses + x_stats.ull_sample_skipped)
+            / d_elapsed);
+   }
+   cachesim_print_stats (px_sim);
+CLEAN_RETURN:
+   if (NULL != px_trace)
+   {
+      (void) cachesim_close_trace (px_trace);
+   }
+   return e_ret_val;
+}
+
+/*
+ * The trace run on the library interface: the same report as the trace mode
+ * of the engine.
+ */
+static CACHESIM_RET_E cachesim_replay_trace (
+   CACHESIM_CACHE_ARGS_X *px_cache_args)
+{
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CONFIG_X x_config = {0};
+   CACHESIM_X *px_sim = NULL;
+
+   /*
+    * Only accesses to the sampled sets would advance the clock and take a
+    * register, and the timing is not scaled like the counts.
+    */
+   if ((px_cache_args->ui_sample_sets > 1) && (0 != px_cache_args->ui_mshrs))
+   {
+      fprintf (stderr, "--mshrs is not supported with --sample-sets\n");
+      goto CLEAN_RETURN;
+   }
+   cachesim_config_from_args (px_cache_args, &x_config);
+   e_ret_val = cachesim_create (&x_config, &px_sim);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Unable to allocate the cache\n");
+      goto CLEAN_RETURN;
+   }
+
+   e_ret_val = cachesim_replay_trace_records (px_sim, px_cache_args);
+   if (eCACHESIM_RET_SUCCESS != e_ret_val)
+   {
+      fprintf (stderr, "Trace simulation failed\n");
+   }
+
+   (void) cachesim_destroy (px_sim);
+CLEAN_RETURN:
+   return e_ret_val;
+}
+
+/****************************** GLOBAL FUNCTIONS ******************************/
+int main (int argc, char **argv)
+{
+   int i_ret_val = -1;
+   CACHESIM_RET_E e_ret_val = eCACHESIM_RET_FAILURE;
+   CACHESIM_CACHE_ARGS_X x_cache_args = {0};
+
+   cachesim_get_opts_from_args (argc, argv, &x_cache_args);
+
+   switch (x_cache_args.e_algorithm)
+   {
+   case eCACHESIM_SIMULATION_ALGORITHM_GENERAL:
+      e_ret_val = cachesim_simulate_pinning (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_BUBBLE_SORT:
+   case eCACHESIM_SIMULATION_ALGORITHM_MAX_IN_MATRIX:
+      e_ret_val = cachesim_simulate_algorithm (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_TRACE:
+      if (true == cachesim_replay_on_library (&x_cache_args))
+      {
+         e_ret_val = cachesim_replay_trace (&x_cache_args);
+      }
+      else
+      {
+         e_ret_val = cachesim_simulate_trace (&x_cache_args);
+      }
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_SWEEP:
+      e_ret_val = cachesim_simulate_sweep (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_MRC:
+      e_ret_val = cachesim_simulate_mrc (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_HIERARCHY:
+      e_ret_val = cachesim_simulate_hierarchy (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_CONVERT:
+      e_ret_val = cachesim_convert_trace (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_RENDER:
+      e_ret_val = cachesim_render_events (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_MULTICORE:
+      e_ret_val = cachesim_simulate_multicore (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_BENCH:
+      e_ret_val = cachesim_simulate_bench (&x_cache_args);
+      break;
+   case eCACHESIM_SIMULATION_ALGORITHM_WORKLOAD:
+      e_ret_val = cachesim_simulate_workload (&x_cache_args);
+      break;
+   default:
+      break;
+   }
+   i_ret_val = (eCACHESIM_RET_SUCCESS == e_ret_val) ? 0 : 1;
+   return i_ret_val;
+}